@@ -0,0 +1,111 @@
+// Compares strategies for scatter-adding forces from multiple threads:
+// atomic accumulation into a shared array and per-thread buffers reduced
+// afterwards. Contention is controlled by the number of target particles.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_atomic.hpp>
+
+namespace
+{
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using atomic_force_t = dim::atomic_vector<double, dim::mech::force, 3>;
+
+    constexpr std::size_t updates_per_thread = 1 << 20;
+
+    template<typename F>
+    double measure(F fn)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        fn();
+        auto const end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    template<typename F>
+    void run_threads(unsigned threads, F fn)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back(fn, t);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::vector<std::size_t> make_targets(std::size_t particles, unsigned seed)
+    {
+        std::mt19937 random{seed};
+        std::uniform_int_distribution<std::size_t> pick{0, particles - 1};
+        std::vector<std::size_t> targets(updates_per_thread);
+        for (auto& target : targets) {
+            target = pick(random);
+        }
+        return targets;
+    }
+
+    double bench_atomic(unsigned threads,
+        std::size_t particles,
+        std::vector<std::vector<std::size_t>> const& targets)
+    {
+        std::vector<atomic_force_t> forces(particles);
+        force_t const delta{1, 2, 3};
+        return measure([&] {
+            run_threads(threads, [&](unsigned t) {
+                for (auto const target : targets[t]) {
+                    forces[target] += delta;
+                }
+            });
+        });
+    }
+
+    double bench_buffers(unsigned threads,
+        std::size_t particles,
+        std::vector<std::vector<std::size_t>> const& targets)
+    {
+        std::vector<force_t> forces(particles);
+        force_t const delta{1, 2, 3};
+        return measure([&] {
+            std::vector<std::vector<force_t>> buffers(threads);
+            run_threads(threads, [&](unsigned t) {
+                buffers[t].assign(particles, force_t{});
+                for (auto const target : targets[t]) {
+                    buffers[t][target] += delta;
+                }
+            });
+            for (std::size_t i = 0; i < particles; ++i) {
+                force_t sum;
+                for (auto const& buffer : buffers) {
+                    sum += buffer[i];
+                }
+                forces[i] = sum;
+            }
+        });
+    }
+}
+
+int main()
+{
+    unsigned const hardware = std::thread::hardware_concurrency();
+    unsigned const max_threads = hardware > 1 ? hardware : 2;
+
+    std::printf("%8s %10s %12s %12s\n", "threads", "particles", "atomic_ms", "buffers_ms");
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        for (std::size_t particles : {16u, 1024u, 65536u, 1048576u}) {
+            std::vector<std::vector<std::size_t>> targets;
+            for (unsigned t = 0; t < threads; ++t) {
+                targets.push_back(make_targets(particles, t));
+            }
+            double const atomic_ms = bench_atomic(threads, particles, targets);
+            double const buffers_ms = bench_buffers(threads, particles, targets);
+            std::printf("%8u %10zu %12.2f %12.2f\n", threads, particles, atomic_ms, buffers_ms);
+        }
+    }
+}
@@ -0,0 +1,191 @@
+// Compares the 4x4 and 8x8 cluster-pair kernels of dim_cluster_pair.hpp with
+// a per-particle half neighbor list on a Lennard-Jones liquid. Both use the
+// same threads, buffered list radius and potential. Build with AVX2 enabled
+// (e.g. -march=native) to let the compiler vectorize the tile kernels.
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_cluster_pair.hpp>
+#include <dim_parallel.hpp>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using box_t = dim::vector<double, dim::mech::length, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using area_t = dim::scalar<double, dim::power_dimension_t<dim::mech::length, 2>>;
+
+    constexpr int lattice = 32;
+    constexpr double spacing = 1.08;
+    constexpr double box = lattice * spacing;
+    constexpr double cutoff = 2.5;
+    constexpr double list_radius = 2.8;
+    constexpr int repeats = 20;
+
+    std::vector<point_t> make_liquid()
+    {
+        std::mt19937 random{1};
+        std::uniform_real_distribution<double> jitter{-0.1, 0.1};
+        std::vector<point_t> points;
+        for (int x = 0; x < lattice; ++x) {
+            for (int y = 0; y < lattice; ++y) {
+                for (int z = 0; z < lattice; ++z) {
+                    points.push_back(point_t{(x + jitter(random)) * spacing,
+                        (y + jitter(random)) * spacing, (z + jitter(random)) * spacing});
+                }
+            }
+        }
+        return points;
+    }
+
+    // Half neighbor list: neighbors[start[i], start[i + 1]) are j > i.
+    struct neighbor_list
+    {
+        std::vector<std::size_t> start;
+        std::vector<std::size_t> neighbors;
+    };
+
+    neighbor_list build_neighbor_list(std::vector<point_t> const& points)
+    {
+        std::size_t const cells = std::size_t(box / list_radius);
+        double const width = box / double(cells);
+        std::vector<std::vector<std::size_t>> members(cells * cells * cells);
+        auto const cell_of = [&](point_t const& p, unsigned k) {
+            return std::size_t(p[k].value() / width) % cells;
+        };
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            members[(cell_of(points[i], 0) * cells + cell_of(points[i], 1)) * cells + cell_of(points[i], 2)]
+                .push_back(i);
+        }
+
+        neighbor_list list;
+        list.start.push_back(0);
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            for (std::size_t dx = 0; dx < 3; ++dx) {
+                for (std::size_t dy = 0; dy < 3; ++dy) {
+                    for (std::size_t dz = 0; dz < 3; ++dz) {
+                        std::size_t const nx = (cell_of(points[i], 0) + cells + dx - 1) % cells;
+                        std::size_t const ny = (cell_of(points[i], 1) + cells + dy - 1) % cells;
+                        std::size_t const nz = (cell_of(points[i], 2) + cells + dz - 1) % cells;
+                        for (std::size_t const j : members[(nx * cells + ny) * cells + nz]) {
+                            double r2 = 0;
+                            for (unsigned k = 0; k < 3; ++k) {
+                                double d = points[i][k].value() - points[j][k].value();
+                                d -= box * std::round(d / box);
+                                r2 += d * d;
+                            }
+                            if (j > i && r2 < list_radius * list_radius) {
+                                list.neighbors.push_back(j);
+                            }
+                        }
+                    }
+                }
+            }
+            list.start.push_back(list.neighbors.size());
+        }
+        return list;
+    }
+
+    double compute_neighbor_list(std::vector<point_t> const& points,
+        neighbor_list const& list,
+        dim::lennard_jones<double> const& lj,
+        std::vector<force_t>& forces)
+    {
+        std::size_t const count = points.size();
+        std::size_t const chunks = dim::detail::chunk_count(count, 512);
+        std::vector<std::vector<double>> buffers(chunks);
+        std::vector<double> energies(chunks, 0);
+
+        dim::detail::parallel_chunks(count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto& buffer = buffers[chunk];
+            buffer.assign(count * 3, 0);
+            double energy = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                double fi[3] = {};
+                for (std::size_t n = list.start[i]; n < list.start[i + 1]; ++n) {
+                    std::size_t const j = list.neighbors[n];
+                    double d[3];
+                    double r2 = 0;
+                    for (unsigned k = 0; k < 3; ++k) {
+                        d[k] = points[i][k].value() - points[j][k].value();
+                        d[k] -= box * std::round(d[k] / box);
+                        r2 += d[k] * d[k];
+                    }
+                    if (r2 < cutoff * cutoff) {
+                        auto const sample = lj.evaluate(area_t{r2});
+                        energy += sample.value.value();
+                        for (unsigned k = 0; k < 3; ++k) {
+                            double const f = sample.force_factor.value() * d[k];
+                            fi[k] += f;
+                            buffer[j * 3 + k] -= f;
+                        }
+                    }
+                }
+                for (unsigned k = 0; k < 3; ++k) {
+                    buffer[i * 3 + k] += fi[k];
+                }
+            }
+            energies[chunk] = energy;
+        });
+
+        double total = 0;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            total += energies[chunk];
+            for (std::size_t i = 0; i < count; ++i) {
+                for (unsigned k = 0; k < 3; ++k) {
+                    forces[i][k] += dim::scalar<double, dim::mech::force>{buffers[chunk][i * 3 + k]};
+                }
+            }
+        }
+        return total;
+    }
+
+    // Returns milliseconds per evaluation and stores the energy.
+    template<typename F>
+    double measure(F fn, double& energy)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            energy = fn();
+        }
+        auto const end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+    }
+
+    template<unsigned M>
+    void run_clusters(std::vector<point_t> const& points, dim::lennard_jones<double> const& lj)
+    {
+        dim::cluster_pair_list<double, M> list{box_t{box, box, box}, length_t{list_radius}};
+        list.build(points);
+        std::vector<force_t> forces(points.size());
+        double energy = 0;
+        double const ms = measure([&] { return list.compute(lj, length_t{cutoff}, forces).value(); }, energy);
+        std::printf("cluster %ux%u    %10.2f %14.6f %10.3f\n", M, M, ms, energy / double(points.size()),
+            double(list.fill_ratio()));
+    }
+}
+
+int main()
+{
+    auto const points = make_liquid();
+    dim::lennard_jones<double> const lj{energy_t{1}, length_t{1}};
+
+    std::printf("%-14s %10s %14s %10s\n", "kernel", "ms", "energy/N", "fill");
+
+    auto const list = build_neighbor_list(points);
+    std::vector<force_t> forces(points.size());
+    double energy = 0;
+    double const ms = measure([&] { return compute_neighbor_list(points, list, lj, forces); }, energy);
+    std::printf("%-14s %10.2f %14.6f %10s\n", "neighbor list", ms, energy / double(points.size()), "-");
+
+    run_clusters<4>(points, lj);
+    run_clusters<8>(points, lj);
+}
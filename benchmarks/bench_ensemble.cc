@@ -0,0 +1,157 @@
+// Integrates many replicas of a small Lennard-Jones cluster, one replica at a
+// time with dim::point and dim::vector and in lockstep batches with
+// dim::ensemble. Build with AVX2 enabled (e.g. -march=native) to let the
+// compiler vectorize the lane loops.
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_ensemble.hpp>
+#include <dim_parallel.hpp>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using mass_t = dim::scalar<double, dim::mech::mass>;
+    using time_t_ = dim::scalar<double, dim::mech::time>;
+    using area_t = dim::scalar<double, dim::power_dimension_t<dim::mech::length, 2>>;
+    using factor_t = dim::scalar<double, dim::quotient_dimension_t<dim::mech::force, dim::mech::length>>;
+
+    using ensemble_t = dim::ensemble<double>;
+    constexpr unsigned width = ensemble_t::width;
+    using points_t = ensemble_t::batch_point;
+    using forces_t = ensemble_t::batch_force;
+    using areas_t = dim::ensemble_scalar<double, area_t::dimension, width>;
+    using factors_t = dim::ensemble_scalar<double, factor_t::dimension, width>;
+
+    constexpr std::size_t replicas = 4096;
+    constexpr std::size_t particles = 16;
+    constexpr int steps = 100;
+    time_t_ const dt{0.002};
+
+    // Lennard-Jones force factor 24 (2 r^-14 - r^-8) with epsilon = sigma = 1.
+    double lj_factor(double r2)
+    {
+        double const inverse = 1 / r2;
+        double const s6 = inverse * inverse * inverse;
+        return 24 * s6 * (2 * s6 - 1) * inverse;
+    }
+
+    factors_t lj_factor(areas_t const& r2)
+    {
+        factors_t factor;
+        for (unsigned l = 0; l < width; ++l) {
+            factor.data()[l] = lj_factor(r2.data()[l]);
+        }
+        return factor;
+    }
+
+    std::vector<std::vector<point_t>> make_clusters()
+    {
+        std::mt19937 random{1};
+        std::uniform_real_distribution<double> jitter{-0.05, 0.05};
+        std::vector<std::vector<point_t>> clusters(replicas);
+        for (auto& cluster : clusters) {
+            for (std::size_t i = 0; i < particles; ++i) {
+                double const x = double(i % 4) * 1.12 + jitter(random);
+                double const y = double(i / 4 % 4) * 1.12 + jitter(random);
+                cluster.push_back(point_t{x, y, jitter(random)});
+            }
+        }
+        return clusters;
+    }
+
+    void replica_forces(std::vector<point_t> const& p, std::vector<force_t>& f)
+    {
+        for (auto& fi : f) {
+            fi = force_t{0, 0, 0};
+        }
+        for (std::size_t i = 0; i < p.size(); ++i) {
+            for (std::size_t j = i + 1; j < p.size(); ++j) {
+                auto const d = p[i] - p[j];
+                force_t const fij = factor_t{lj_factor(squared_norm(d).value())} * d;
+                f[i] += fij;
+                f[j] -= fij;
+            }
+        }
+    }
+
+    double run_replicas(std::vector<std::vector<point_t>> positions)
+    {
+        std::vector<std::vector<velocity_t>> velocities(replicas, std::vector<velocity_t>(particles));
+        mass_t const mass{1};
+        std::size_t const chunks = dim::detail::chunk_count(replicas * particles, 256);
+
+        auto const start = std::chrono::steady_clock::now();
+        dim::detail::parallel_chunks(replicas, chunks, [&](std::size_t, std::size_t begin, std::size_t end) {
+            std::vector<force_t> f(particles);
+            for (std::size_t r = begin; r < end; ++r) {
+                replica_forces(positions[r], f);
+                for (int s = 0; s < steps; ++s) {
+                    for (std::size_t i = 0; i < particles; ++i) {
+                        velocities[r][i] += dt / 2 * (f[i] / mass);
+                        positions[r][i] += dt * velocities[r][i];
+                    }
+                    replica_forces(positions[r], f);
+                    for (std::size_t i = 0; i < particles; ++i) {
+                        velocities[r][i] += dt / 2 * (f[i] / mass);
+                    }
+                }
+            }
+        });
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        std::printf("  check %.6f\n", positions[replicas - 1][particles - 1][0].value());
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+    double run_ensemble(std::vector<std::vector<point_t>> const& positions)
+    {
+        ensemble_t system(replicas, particles);
+        for (std::size_t r = 0; r < replicas; ++r) {
+            for (std::size_t i = 0; i < particles; ++i) {
+                system.set_position(r, i, positions[r][i]);
+            }
+        }
+
+        auto const forces = [](std::size_t, points_t const* p, forces_t* f, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                f[i] = forces_t{};
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = i + 1; j < n; ++j) {
+                    auto const d = p[i] - p[j];
+                    forces_t const fij = lj_factor(squared_norm(d)) * d;
+                    f[i] += fij;
+                    f[j] -= fij;
+                }
+            }
+        };
+
+        auto const start = std::chrono::steady_clock::now();
+        system.step(dt, forces, steps);
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        std::printf("  check %.6f\n", system.position(replicas - 1, particles - 1)[0].value());
+        return std::chrono::duration<double>(elapsed).count();
+    }
+}
+
+int main()
+{
+    auto const clusters = make_clusters();
+    std::printf("%zu replicas x %zu particles, %d steps\n", replicas, particles, steps);
+
+    double const one_by_one = run_replicas(clusters);
+    std::printf("replica by replica  %8.2f ms\n", one_by_one * 1e3);
+
+    double const lockstep = run_ensemble(clusters);
+    std::printf("ensemble (W = %u)    %8.2f ms  (x%.2f)\n", width, lockstep * 1e3, one_by_one / lockstep);
+}
@@ -0,0 +1,84 @@
+// Compares the batch transcendental functions of dim_math.hpp, in both
+// accuracy tiers, with calling the standard library on each element. Build
+// with AVX2 enabled (e.g. -march=native) to measure the four-lane kernels.
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_math.hpp>
+
+namespace
+{
+    using number_t = dim::scalar<double, dim::mech::number>;
+
+    constexpr std::size_t array_size = 4096;
+    constexpr int repeats = 2000;
+
+    // Returns nanoseconds per element.
+    template<typename F>
+    double measure(std::vector<number_t> const& x, std::vector<number_t>& y, F fn)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            fn(x.data(), y.data(), x.size());
+        }
+        auto const end = std::chrono::steady_clock::now();
+        double const ns = std::chrono::duration<double, std::nano>(end - start).count();
+        return ns / double(repeats) / double(x.size());
+    }
+
+    std::vector<number_t> make_inputs(double lower, double upper)
+    {
+        std::mt19937 random{1};
+        std::uniform_real_distribution<double> uniform{lower, upper};
+        std::vector<number_t> x(array_size);
+        for (auto& value : x) {
+            value = number_t{uniform(random)};
+        }
+        return x;
+    }
+
+    template<typename Libm, typename Accurate, typename Fast>
+    void run(char const* name, double lower, double upper, Libm libm, Accurate accurate, Fast fast)
+    {
+        std::vector<number_t> const x = make_inputs(lower, upper);
+        std::vector<number_t> y(x.size());
+
+        double const libm_ns = measure(x, y, [&](number_t const* in, number_t* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = number_t{libm(in[i].value())};
+            }
+        });
+        double const accurate_ns = measure(x, y, accurate);
+        double const fast_ns = measure(x, y, fast);
+
+        std::printf("%-6s %10.2f %12.2f %10.2f\n", name, libm_ns, accurate_ns, fast_ns);
+    }
+}
+
+int main()
+{
+    std::printf("%-6s %10s %12s %10s  (ns per element)\n", "func", "libm", "accurate", "fast");
+
+    run(
+        "exp", -50, 50, [](double v) { return std::exp(v); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::exp(x, y, n); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::fast::exp(x, y, n); });
+    run(
+        "log", 1e-3, 1e3, [](double v) { return std::log(v); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::log(x, y, n); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::fast::log(x, y, n); });
+    run(
+        "tanh", -5, 5, [](double v) { return std::tanh(v); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::tanh(x, y, n); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::fast::tanh(x, y, n); });
+    run(
+        "erfc", -1, 6, [](double v) { return std::erfc(v); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::erfc(x, y, n); },
+        [](number_t const* x, number_t* y, std::size_t n) { dim::fast::erfc(x, y, n); });
+}
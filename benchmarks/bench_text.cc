@@ -0,0 +1,86 @@
+// Writes and reads an XYZ frame of a million points with iostreams at full
+// precision and with the block-buffered, parallel writer and parser of
+// dim_text.hpp.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_text.hpp>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+
+    constexpr std::size_t count = 1000000;
+
+    std::vector<point_t> make_points()
+    {
+        std::mt19937 random{1};
+        std::uniform_real_distribution<double> uniform{0, 100};
+        std::vector<point_t> points;
+        for (std::size_t i = 0; i < count; ++i) {
+            points.push_back(point_t{uniform(random), uniform(random), uniform(random)});
+        }
+        return points;
+    }
+
+    template<typename F>
+    double time(F fn)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main()
+{
+    auto const points = make_points();
+    std::printf("%zu points\n", count);
+
+    std::string iostream_text;
+    double const iostream_write = time([&] {
+        std::ostringstream stream;
+        stream << std::setprecision(17) << count << "\n\n";
+        for (auto const& p : points) {
+            stream << "X " << p[0].value() << ' ' << p[1].value() << ' ' << p[2].value() << '\n';
+        }
+        iostream_text = stream.str();
+    });
+    std::printf("iostream write  %8.2f ms  %zu bytes\n", iostream_write * 1e3, iostream_text.size());
+
+    std::string text;
+    double const text_write = time([&] {
+        std::ostringstream stream;
+        dim::write_xyz(stream, points.data(), points.size());
+        text = stream.str();
+    });
+    std::printf("write_xyz       %8.2f ms  %zu bytes  (x%.2f)\n", text_write * 1e3, text.size(),
+        iostream_write / text_write);
+
+    std::vector<point_t> read(count);
+    double const iostream_read = time([&] {
+        std::istringstream stream(iostream_text);
+        std::size_t n;
+        std::string symbol;
+        stream >> n;
+        for (auto& p : read) {
+            double x, y, z;
+            stream >> symbol >> x >> y >> z;
+            p = point_t{x, y, z};
+        }
+    });
+    std::printf("iostream read   %8.2f ms\n", iostream_read * 1e3);
+
+    dim::xyz_frame<double> frame;
+    double const text_read = time([&] { dim::parse_xyz(text, frame); });
+    std::printf("parse_xyz       %8.2f ms  (x%.2f)  %s\n", text_read * 1e3, iostream_read / text_read,
+        frame.positions == points && read == points ? "exact" : "MISMATCH");
+}
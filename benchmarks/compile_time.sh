@@ -0,0 +1,132 @@
+#!/bin/sh
+# Measures compile time of generated translation units to track the template
+# instantiation cost of the headers.
+#
+# Usage: compile_time.sh <case> [compiler]
+#
+# Cases:
+#   vector      dim::vector<double, length, N> arithmetic for increasing N
+#   dimensions  scalar and vector operators over N distinct dimensions
+#   extern      common quantity types with and without DIM_EXTERN_TEMPLATES
+#
+# Prints CSV lines of the case parameter and the compile time in
+# milliseconds. Set CXXFLAGS to override the default flags.
+
+set -eu
+
+case_name="${1:-vector}"
+cxx="${2:-${CXX:-c++}}"
+flags="${CXXFLAGS:--std=c++11 -O2}"
+include_dir="$(cd "$(dirname "$0")/../dim" && pwd)"
+work_dir="$(mktemp -d)"
+trap 'rm -rf "${work_dir}"' EXIT
+
+now_ms() {
+    date +%s%N | cut -b1-13
+}
+
+compile() {
+    start=$(now_ms)
+    # shellcheck disable=SC2086
+    "${cxx}" ${flags} -I"${include_dir}" -c "${work_dir}/tu.cc" -o "${work_dir}/tu.o"
+    end=$(now_ms)
+    echo "$1,$((end - start))"
+}
+
+generate_vector() {
+    cat > "${work_dir}/tu.cc" << END
+#include <dim.hpp>
+using config_t = dim::vector<double, dim::mech::length, $1>;
+double kernel(config_t const& x, config_t const& v, double dt)
+{
+    config_t const y = x + v * dt;
+    config_t const z{y.data()};
+    return dim::squared_norm(z - x).value();
+}
+END
+}
+
+generate_dimensions() {
+    cat > "${work_dir}/tu.cc" << END
+#include <dim.hpp>
+template<int I>
+using dim_t = dim::mechanical_dimension<I % 7 - 3, I / 7 % 5 - 2, I / 35 % 5 - 2, I / 175>;
+
+template<int I>
+double term(double x)
+{
+    dim::scalar<double, dim_t<I>> const a{x};
+    dim::scalar<double, dim_t<I + 1>> const b{x};
+    dim::vector<double, dim_t<I>, 3> const v{x, x, x};
+    auto const c = a * b / a;
+    auto const w = v * b;
+    auto const p = dim::point<double, dim_t<I>, 3>{} + v;
+    return (c * dim::dot(w, v)).value() + dim::norm(v).value() + (b / c).value()
+        + dim::squared_distance(p, p).value();
+}
+
+double kernel(double x)
+{
+    double sum = 0;
+END
+    i=0
+    while [ "${i}" -lt "$1" ]; do
+        echo "    sum += term<${i}>(x);" >> "${work_dir}/tu.cc"
+        i=$((i + 1))
+    done
+    echo "    return sum;" >> "${work_dir}/tu.cc"
+    echo "}" >> "${work_dir}/tu.cc"
+}
+
+generate_common() {
+    cat > "${work_dir}/tu.cc" << END
+#define $1
+#include <dim.hpp>
+using position_t = dim::point<double, dim::mech::length, 3>;
+using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+using force_t = dim::vector<double, dim::mech::force, 3>;
+using mass_t = dim::scalar<double, dim::mech::mass>;
+using duration_t = dim::scalar<double, dim::mech::time>;
+using energy_t = dim::scalar<double, dim::mech::energy>;
+
+energy_t step(position_t* x, velocity_t* v, force_t const* f, mass_t m, duration_t dt, unsigned n)
+{
+    energy_t kinetic{0};
+    for (unsigned i = 0; i < n; ++i) {
+        v[i] += f[i] / m * dt;
+        x[i] += v[i] * dt;
+        kinetic += m * dim::squared_norm(v[i]) / 2.0;
+        kinetic += dim::dot(f[i], x[i] - x[0]) + dim::distance(x[i], x[0]) * dim::abs(f[i][0]);
+    }
+    return kinetic;
+}
+END
+}
+
+case "${case_name}" in
+vector)
+    echo "n,milliseconds"
+    for n in 3 16 64 256 1024 4096; do
+        generate_vector "${n}"
+        compile "${n}"
+    done
+    ;;
+dimensions)
+    echo "n,milliseconds"
+    for n in 50 100 200 400; do
+        generate_dimensions "${n}"
+        compile "${n}"
+    done
+    ;;
+extern)
+    echo "mode,milliseconds"
+    generate_common DIM_IMPLICIT_TEMPLATES
+    compile implicit
+    generate_common DIM_EXTERN_TEMPLATES
+    compile extern
+    ;;
+*)
+    echo "unknown case: ${case_name}" >&2
+    exit 1
+    ;;
+esac
@@ -31,6 +31,8 @@
 #define INCLUDED_DIM_HPP
 
 #include <cmath>
+#include <type_traits>
+#include <utility>
 
 namespace dim
 {
@@ -69,62 +71,90 @@ namespace dim
     // Scalar quantity with dimensional analysis
     //----------------------------------------------------------------
 
+    template<typename T, typename D>
+    class scalar;
+
     namespace detail // for dim::scalar
     {
-        // This class mixes in (1) member variable value_ and (2) proper
-        // constructors and convertion operator.
-        template<typename T, typename D, bool AllowConversion = dimension_traits<D>::is_zero>
-        class scalar_mixin;
-
-        template<typename T, typename D>
-        class scalar_mixin<T, D, false>
+        // Placeholder parameter type of the constructor that does not apply
+        // to a scalar. Nothing constructs it, so no argument converts to it.
+        // Its conversion to T only lets the constructor body compile when
+        // the class is explicitly instantiated.
+        template<typename T>
+        class disabled_constructor
         {
-          public:
-            scalar_mixin() = default;
+            template<typename, typename>
+            friend class dim::scalar;
 
-            explicit scalar_mixin(T value)
-                : value_{value}
+            // User-provided and private, so that the class is not an
+            // aggregate and {} cannot create it either.
+            disabled_constructor()
             {
             }
 
-          protected:
-            T value_{};
+            operator T() const
+            {
+                return T{};
+            }
         };
 
-        template<typename T, typename D>
-        class scalar_mixin<T, D, true>
+        // Placeholder result type of the conversion operator that does not
+        // apply to a scalar. Only scalar constructs it, and it converts to
+        // nothing, so a dimensionful scalar does not convert to a number or
+        // to a scalar of another dimension.
+        template<typename T>
+        class disabled_conversion
         {
-          public:
-            scalar_mixin() = default;
+            template<typename, typename>
+            friend class dim::scalar;
 
-            scalar_mixin(T value) // NOLINT
-                : value_{value}
+            explicit disabled_conversion(T)
             {
             }
+        };
 
-            operator T() const // NOLINT
-            {
-                return value_;
-            }
+        template<bool Cond, typename T>
+        using enable_constructor =
+            typename std::conditional<Cond, T, disabled_constructor<T>>::type;
 
-          protected:
-            T value_{};
-        };
+        template<bool Cond, typename T>
+        using enable_conversion =
+            typename std::conditional<Cond, T, disabled_conversion<T>>::type;
     } // namespace detail
 
     /*
      * Scalar quantity with dimensional analysis.
      */
     template<typename T, typename D>
-    class scalar : public detail::scalar_mixin<T, D>
+    class scalar
     {
-        using scalar_mixin = detail::scalar_mixin<T, D>;
-        using scalar_mixin::value_;
+        static constexpr bool is_number = dimension_traits<D>::is_zero;
 
       public:
         using number_type = T;
         using dimension = D;
-        using scalar_mixin::scalar_mixin;
+
+        scalar() = default;
+
+        // Dimensionful scalars are explicitly constructed from a number,
+        // while dimensionless ones implicitly convert from and to a number.
+        // The constructor and the conversion operator that do not apply to D
+        // use placeholder types from detail in place of T. This is cheaper to
+        // instantiate than constructors inherited from a mixin class.
+        explicit scalar(detail::enable_constructor<!is_number, T> value)
+            : value_{value}
+        {
+        }
+
+        scalar(detail::enable_constructor<is_number, T> value) // NOLINT
+            : value_{value}
+        {
+        }
+
+        operator detail::enable_conversion<is_number, T>() const // NOLINT
+        {
+            return detail::enable_conversion<is_number, T>(value_);
+        }
 
         number_type value() const
         {
@@ -154,6 +184,9 @@ namespace dim
             value_ /= scale;
             return *this;
         }
+
+      private:
+        T value_{};
     };
 
     template<typename T, typename D>
@@ -234,52 +267,62 @@ namespace dim
         return scalar<T, D>{x} /= y;
     }
 
-    template<typename T, typename D, typename RD = power_dimension_t<D, -1>>
-    scalar<T, RD> operator/(typename scalar<T, D>::number_type x, scalar<T, D> const& y)
+    template<typename T, typename D>
+    scalar<T, power_dimension_t<D, -1>> operator/(
+        typename scalar<T, D>::number_type x, scalar<T, D> const& y)
     {
-        return scalar<T, RD>{x / y.value()};
+        return scalar<T, power_dimension_t<D, -1>>{x / y.value()};
     }
 
-    template<typename T, typename DX, typename DY, typename RD = product_dimension_t<DX, DY>>
-    scalar<T, RD> operator*(scalar<T, DX> const& x, scalar<T, DY> const& y)
+    template<typename T, typename DX, typename DY>
+    scalar<T, product_dimension_t<DX, DY>> operator*(scalar<T, DX> const& x, scalar<T, DY> const& y)
     {
-        return scalar<T, RD>{x.value() * y.value()};
+        return scalar<T, product_dimension_t<DX, DY>>{x.value() * y.value()};
     }
 
-    template<typename T, typename DX, typename DY, typename RD = quotient_dimension_t<DX, DY>>
-    scalar<T, RD> operator/(scalar<T, DX> const& x, scalar<T, DY> const& y)
+    template<typename T, typename DX, typename DY>
+    scalar<T, quotient_dimension_t<DX, DY>> operator/(
+        scalar<T, DX> const& x, scalar<T, DY> const& y)
     {
-        return scalar<T, RD>{x.value() / y.value()};
+        return scalar<T, quotient_dimension_t<DX, DY>>{x.value() / y.value()};
     }
 
+    // Math functions below call unqualified names after using-declarations
+    // so that custom number types can provide overloads found by ADL.
+
     template<typename T, typename D>
     scalar<T, D> abs(scalar<T, D> const& x)
     {
-        return scalar<T, D>{std::fabs(x.value())};
+        using std::fabs;
+        return scalar<T, D>{fabs(x.value())};
     }
 
     template<typename T, typename D>
     scalar<T, D> hypot(scalar<T, D> const& x, scalar<T, D> const& y)
     {
-        return scalar<T, D>{std::hypot(x.value(), y.value())};
+        using std::hypot;
+        return scalar<T, D>{hypot(x.value(), y.value())};
     }
 
-    template<int N, typename T, typename D, typename RD = power_dimension_t<D, N>>
-    scalar<T, RD> pow(scalar<T, D> const& x)
+    template<int N, typename T, typename D>
+    scalar<T, power_dimension_t<D, N>> pow(scalar<T, D> const& x)
     {
-        return scalar<T, RD>{std::pow(x.value(), N)};
+        using std::pow;
+        return scalar<T, power_dimension_t<D, N>>{pow(x.value(), N)};
     }
 
-    template<typename T, typename D, typename RD = root_dimension_t<D, 2>>
-    scalar<T, RD> sqrt(scalar<T, D> const& x)
+    template<typename T, typename D>
+    scalar<T, root_dimension_t<D, 2>> sqrt(scalar<T, D> const& x)
     {
-        return scalar<T, RD>{std::sqrt(x.value())};
+        using std::sqrt;
+        return scalar<T, root_dimension_t<D, 2>>{sqrt(x.value())};
     }
 
-    template<typename T, typename D, typename RD = root_dimension_t<D, 3>>
-    scalar<T, RD> cbrt(scalar<T, D> const& x)
+    template<typename T, typename D>
+    scalar<T, root_dimension_t<D, 3>> cbrt(scalar<T, D> const& x)
     {
-        return scalar<T, RD>{std::cbrt(x.value())};
+        using std::cbrt;
+        return scalar<T, root_dimension_t<D, 3>>{cbrt(x.value())};
     }
 
     //----------------------------------------------------------------
@@ -295,19 +338,43 @@ namespace dim
         {
         };
 
-        // Creates type_sequence of T repeated N times.
-        template<typename T, unsigned N, typename... Seq>
+        template<typename Seq1, typename Seq2>
+        struct concat_sequence;
+
+        template<typename... Seq1, typename... Seq2>
+        struct concat_sequence<type_sequence<Seq1...>, type_sequence<Seq2...>>
+        {
+            using type = type_sequence<Seq1..., Seq2...>;
+        };
+
+        // Creates type_sequence of T repeated N times. N is halved at each
+        // step, so the instantiation depth grows as log N and large vectors
+        // stay within the template depth limit.
+        template<typename T, unsigned N>
         struct repeat_type
         {
-            using type = typename repeat_type<T, N - 1, T, Seq...>::type;
+            using half = typename repeat_type<T, N / 2>::type;
+            using rest = typename concat_sequence<half, typename repeat_type<T, N % 2>::type>::type;
+            using type = typename concat_sequence<half, rest>::type;
         };
 
-        template<typename T, typename... Seq>
-        struct repeat_type<T, 0, Seq...>
+        template<typename T>
+        struct repeat_type<T, 0>
         {
-            using type = type_sequence<Seq...>;
+            using type = type_sequence<>;
         };
 
+        template<typename T>
+        struct repeat_type<T, 1>
+        {
+            using type = type_sequence<T>;
+        };
+
+        // Enables a constructor template for input iterators. Numbers and
+        // scalars are not dereferenceable, so they never match.
+        template<typename It>
+        using enable_if_iterator = decltype(*std::declval<It&>(), ++std::declval<It&>(), void());
+
         // This class mixes in (1) member variable coords_ and (2) proper
         // constructors.
         template<typename T, typename D, unsigned N, typename = typename repeat_type<T, N>::type>
@@ -329,17 +396,54 @@ namespace dim
             {
             }
 
+            // Constructs from N numbers or scalars. Loops here and below do
+            // not depend on the size of the parameter pack, so they are the
+            // cheaper way to initialize large vectors.
+            explicit coords_mixin(T const (&coords)[N])
+            {
+                for (unsigned i = 0; i < N; ++i) {
+                    coords_[i] = scalar<T, D>{coords[i]};
+                }
+            }
+
+            explicit coords_mixin(scalar<T, D> const (&coords)[N])
+            {
+                for (unsigned i = 0; i < N; ++i) {
+                    coords_[i] = coords[i];
+                }
+            }
+
+            // Constructs from the N numbers or scalars starting at first.
+            template<typename InputIt, typename = enable_if_iterator<InputIt>>
+            explicit coords_mixin(InputIt first)
+            {
+                for (unsigned i = 0; i < N; ++i, ++first) {
+                    coords_[i] = scalar<T, D>{*first};
+                }
+            }
+
           protected:
             scalar<T, D> coords_[N]{};
         };
     } // namespace detail
 
+    /*
+     * Storage layout tag of dim::vector: the N coordinates are stored back to
+     * back with no padding. dim_padded.hpp provides the alternative layout
+     * dim::padded for three-dimensional vectors.
+     */
+    struct packed
+    {
+    };
+
     /*
      * Vector with dimensional analysis.
      */
-    template<typename T, typename D, unsigned N>
+    template<typename T, typename D, unsigned N, typename Layout = packed>
     class vector : private detail::coords_mixin<T, D, N>
     {
+        static_assert(std::is_same<Layout, packed>::value, "unsupported vector layout");
+
         using coords_mixin = detail::coords_mixin<T, D, N>;
         using coords_mixin::coords_;
 
@@ -360,6 +464,17 @@ namespace dim
             return coords_[index];
         }
 
+        // Contiguous storage of the N coordinates.
+        scalar_type* data()
+        {
+            return coords_;
+        }
+
+        scalar_type const* data() const
+        {
+            return coords_;
+        }
+
         vector& operator+=(vector const& rhs)
         {
             for (unsigned i = 0; i < dimension; ++i) {
@@ -456,52 +571,51 @@ namespace dim
         return vector<T, D, N>(v) /= a;
     }
 
-    template<typename T, typename D1, typename D2, unsigned N,
-        typename RD = product_dimension_t<D1, D2>>
-    vector<T, RD, N> operator*(vector<T, D1, N> const& v, scalar<T, D2> const& a)
+    template<typename T, typename D1, typename D2, unsigned N>
+    vector<T, product_dimension_t<D1, D2>, N> operator*(
+        vector<T, D1, N> const& v, scalar<T, D2> const& a)
     {
-        vector<T, RD, N> result;
+        vector<T, product_dimension_t<D1, D2>, N> result;
         for (unsigned i = 0; i < N; ++i) {
             result[i] = v[i] * a;
         }
         return result;
     }
 
-    template<typename T, typename D1, typename D2, unsigned N,
-        typename RD = product_dimension_t<D1, D2>>
-    vector<T, RD, N> operator*(scalar<T, D1> const& a, vector<T, D2, N> const& v)
+    template<typename T, typename D1, typename D2, unsigned N>
+    vector<T, product_dimension_t<D1, D2>, N> operator*(
+        scalar<T, D1> const& a, vector<T, D2, N> const& v)
     {
-        vector<T, RD, N> result;
+        vector<T, product_dimension_t<D1, D2>, N> result;
         for (unsigned i = 0; i < N; ++i) {
             result[i] = a * v[i];
         }
         return result;
     }
 
-    template<typename T, typename D1, typename D2, unsigned N,
-        typename RD = quotient_dimension_t<D1, D2>>
-    vector<T, RD, N> operator/(vector<T, D1, N> const& v, scalar<T, D2> const& a)
+    template<typename T, typename D1, typename D2, unsigned N>
+    vector<T, quotient_dimension_t<D1, D2>, N> operator/(
+        vector<T, D1, N> const& v, scalar<T, D2> const& a)
     {
-        vector<T, RD, N> result;
+        vector<T, quotient_dimension_t<D1, D2>, N> result;
         for (unsigned i = 0; i < N; ++i) {
             result[i] = v[i] / a;
         }
         return result;
     }
 
-    template<typename T, typename D1, typename D2, unsigned N,
-        typename RD = product_dimension_t<D1, D2>>
-    scalar<T, RD> dot(vector<T, D1, N> const& v, vector<T, D2, N> const& w)
+    template<typename T, typename D1, typename D2, unsigned N>
+    scalar<T, product_dimension_t<D1, D2>> dot(vector<T, D1, N> const& v, vector<T, D2, N> const& w)
     {
-        scalar<T, RD> result{0};
+        scalar<T, product_dimension_t<D1, D2>> result{0};
         for (unsigned i = 0; i < N; ++i) {
             result += v[i] * w[i];
         }
         return result;
     }
 
-    template<typename T, typename D, unsigned N, typename RD = power_dimension_t<D, 2>>
-    scalar<T, RD> squared_norm(vector<T, D, N> const& v)
+    template<typename T, typename D, unsigned N>
+    scalar<T, power_dimension_t<D, 2>> squared_norm(vector<T, D, N> const& v)
     {
         return dot(v, v);
     }
@@ -512,13 +626,14 @@ namespace dim
         return sqrt(squared_norm(v));
     }
 
-    template<typename T, typename D1, typename D2, typename RD = product_dimension_t<D1, D2>>
-    vector<T, RD, 3> cross(vector<T, D1, 3> const& v, vector<T, D2, 3> const& w)
+    template<typename T, typename D1, typename D2>
+    vector<T, product_dimension_t<D1, D2>, 3> cross(
+        vector<T, D1, 3> const& v, vector<T, D2, 3> const& w)
     {
         auto const x = v[1] * w[2] - v[2] * w[1];
         auto const y = v[2] * w[0] - v[0] * w[2];
         auto const z = v[0] * w[1] - v[1] * w[0];
-        return vector<T, RD, 3>{x, y, z};
+        return vector<T, product_dimension_t<D1, D2>, 3>{x, y, z};
     }
 
     //----------------------------------------------------------------
@@ -552,6 +667,17 @@ namespace dim
             return coords_[index];
         }
 
+        // Contiguous storage of the N coordinates.
+        scalar_type* data()
+        {
+            return coords_;
+        }
+
+        scalar_type const* data() const
+        {
+            return coords_;
+        }
+
         point& operator+=(vector_type const& rhs)
         {
             for (unsigned i = 0; i < dimension; ++i) {
@@ -602,8 +728,9 @@ namespace dim
         return result;
     }
 
-    template<typename T, typename D, unsigned N, typename RD = power_dimension_t<D, 2>>
-    scalar<T, RD> squared_distance(point<T, D, N> const& p, point<T, D, N> const& q)
+    template<typename T, typename D, unsigned N>
+    scalar<T, power_dimension_t<D, 2>> squared_distance(
+        point<T, D, N> const& p, point<T, D, N> const& q)
     {
         return squared_norm(p - q);
     }
@@ -618,41 +745,47 @@ namespace dim
     // Reference dimension implementation
     //----------------------------------------------------------------
 
-    template<int L, int M, int T>
+    /*
+     * Dimension tag with integral exponents of length (L), mass (M), time (T)
+     * and electric charge (Q). Q can be omitted for mechanical quantities.
+     */
+    template<int L, int M, int T, int Q = 0>
     struct mechanical_dimension
     {
     };
 
-    template<int L, int M, int T>
-    struct dimension_traits<mechanical_dimension<L, M, T>>
+    template<int L, int M, int T, int Q>
+    struct dimension_traits<mechanical_dimension<L, M, T, Q>>
     {
-        static constexpr bool is_zero = (L == 0 && M == 0 && T == 0);
+        static constexpr bool is_zero = (L == 0 && M == 0 && T == 0 && Q == 0);
     };
 
-    template<int L1, int M1, int T1, int L2, int M2, int T2>
-    struct product_dimension<mechanical_dimension<L1, M1, T1>, mechanical_dimension<L2, M2, T2>>
+    template<int L1, int M1, int T1, int Q1, int L2, int M2, int T2, int Q2>
+    struct product_dimension<mechanical_dimension<L1, M1, T1, Q1>,
+        mechanical_dimension<L2, M2, T2, Q2>>
     {
-        using type = mechanical_dimension<L1 + L2, M1 + M2, T1 + T2>;
+        using type = mechanical_dimension<L1 + L2, M1 + M2, T1 + T2, Q1 + Q2>;
     };
 
-    template<int L1, int M1, int T1, int L2, int M2, int T2>
-    struct quotient_dimension<mechanical_dimension<L1, M1, T1>, mechanical_dimension<L2, M2, T2>>
+    template<int L1, int M1, int T1, int Q1, int L2, int M2, int T2, int Q2>
+    struct quotient_dimension<mechanical_dimension<L1, M1, T1, Q1>,
+        mechanical_dimension<L2, M2, T2, Q2>>
     {
-        using type = mechanical_dimension<L1 - L2, M1 - M2, T1 - T2>;
+        using type = mechanical_dimension<L1 - L2, M1 - M2, T1 - T2, Q1 - Q2>;
     };
 
-    template<int L, int M, int T, int N>
-    struct power_dimension<mechanical_dimension<L, M, T>, N>
+    template<int L, int M, int T, int Q, int N>
+    struct power_dimension<mechanical_dimension<L, M, T, Q>, N>
     {
-        using type = mechanical_dimension<L * N, M * N, T * N>;
+        using type = mechanical_dimension<L * N, M * N, T * N, Q * N>;
     };
 
-    template<int L, int M, int T, int N>
-    struct root_dimension<mechanical_dimension<L, M, T>, N>
+    template<int L, int M, int T, int Q, int N>
+    struct root_dimension<mechanical_dimension<L, M, T, Q>, N>
     {
-        static_assert(
-            L % N == 0 && M % N == 0 && T % N == 0, "fractional dimension is not supported");
-        using type = mechanical_dimension<L / N, M / N, T / N>;
+        static_assert(L % N == 0 && M % N == 0 && T % N == 0 && Q % N == 0,
+            "fractional dimension is not supported");
+        using type = mechanical_dimension<L / N, M / N, T / N, Q / N>;
     };
 
     namespace mech
@@ -667,6 +800,55 @@ namespace dim
         using force = product_dimension_t<acceleration, mass>;
         using energy = product_dimension_t<force, length>;
     } // namespace mech
+
+    namespace elec
+    {
+        using charge = mechanical_dimension<0, 0, 0, 1>;
+        using current = quotient_dimension_t<charge, mech::time>;
+        using electric_potential = quotient_dimension_t<mech::energy, charge>;
+        using electric_field = quotient_dimension_t<mech::force, charge>;
+        using permittivity = quotient_dimension_t<power_dimension_t<charge, 2>,
+            product_dimension_t<mech::energy, mech::length>>;
+    } // namespace elec
 } // namespace dim
 
+//----------------------------------------------------------------
+// Explicit instantiation of common quantity types
+//----------------------------------------------------------------
+
+/*
+ * Defining DIM_EXTERN_TEMPLATES before including this header suppresses
+ * implicit instantiation of the classes of common double-precision
+ * quantities, and defining DIM_INSTANTIATE_TEMPLATES in exactly one
+ * translation unit instantiates them there. This mainly saves time in
+ * unoptimized builds, where member functions would otherwise be emitted in
+ * every translation unit.
+ */
+#if defined(DIM_INSTANTIATE_TEMPLATES)
+#define DIM_TEMPLATE_INSTANTIATION template
+#elif defined(DIM_EXTERN_TEMPLATES)
+#define DIM_TEMPLATE_INSTANTIATION extern template
+#endif
+
+#if defined(DIM_TEMPLATE_INSTANTIATION)
+#define DIM_INSTANTIATE_QUANTITY(D)                                                            \
+    DIM_TEMPLATE_INSTANTIATION class dim::scalar<double, D>;                                   \
+    DIM_TEMPLATE_INSTANTIATION class dim::vector<double, D, 3>;
+
+DIM_INSTANTIATE_QUANTITY(dim::mech::number)
+DIM_INSTANTIATE_QUANTITY(dim::mech::length)
+DIM_INSTANTIATE_QUANTITY(dim::mech::mass)
+DIM_INSTANTIATE_QUANTITY(dim::mech::time)
+DIM_INSTANTIATE_QUANTITY(dim::mech::speed)
+DIM_INSTANTIATE_QUANTITY(dim::mech::acceleration)
+DIM_INSTANTIATE_QUANTITY(dim::mech::momentum)
+DIM_INSTANTIATE_QUANTITY(dim::mech::force)
+DIM_INSTANTIATE_QUANTITY(dim::mech::energy)
+DIM_INSTANTIATE_QUANTITY(dim::elec::charge)
+DIM_TEMPLATE_INSTANTIATION class dim::point<double, dim::mech::length, 3>;
+
+#undef DIM_INSTANTIATE_QUANTITY
+#undef DIM_TEMPLATE_INSTANTIATION
+#endif
+
 #endif // INCLUDED_DIM_HPP
@@ -0,0 +1,319 @@
+/*
+ * dim - Arena and aligned allocators for temporary dimensioned arrays.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_ARENA_HPP
+#define INCLUDED_DIM_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Aligned heap allocator
+    //----------------------------------------------------------------
+
+    /*
+     * Allocator returning memory aligned to Alignment bytes (a power of two),
+     * e.g. a cache line or a SIMD register. Usable with standard containers
+     * such as std::vector<dim::vector<...>, dim::aligned_allocator<...>>.
+     */
+    template<typename T, std::size_t Alignment = 64>
+    class aligned_allocator
+    {
+        static_assert((Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+        static_assert(Alignment >= alignof(T), "alignment must not be weaker than the type's");
+
+      public:
+        using value_type = T;
+        static constexpr std::size_t alignment = Alignment;
+
+        template<typename U>
+        struct rebind
+        {
+            using other = aligned_allocator<U, Alignment>;
+        };
+
+        aligned_allocator() noexcept = default;
+
+        template<typename U>
+        aligned_allocator(aligned_allocator<U, Alignment> const&) noexcept // NOLINT
+        {
+        }
+
+        T* allocate(std::size_t count)
+        {
+            // Over-allocate and keep the original pointer just before the
+            // aligned block.
+            std::size_t const size = count * sizeof(T) + Alignment + sizeof(void*);
+            void* const raw = ::operator new(size);
+            auto const address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+            auto const aligned = (address + Alignment - 1) & ~std::uintptr_t(Alignment - 1);
+            reinterpret_cast<void**>(aligned)[-1] = raw;
+            return reinterpret_cast<T*>(aligned);
+        }
+
+        void deallocate(T* ptr, std::size_t) noexcept
+        {
+            if (ptr) {
+                ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+            }
+        }
+    };
+
+    template<typename T, typename U, std::size_t A>
+    bool operator==(aligned_allocator<T, A> const&, aligned_allocator<U, A> const&) noexcept
+    {
+        return true;
+    }
+
+    template<typename T, typename U, std::size_t A>
+    bool operator!=(aligned_allocator<T, A> const&, aligned_allocator<U, A> const&) noexcept
+    {
+        return false;
+    }
+
+    //----------------------------------------------------------------
+    // Monotonic arena
+    //----------------------------------------------------------------
+
+    /*
+     * Monotonic memory arena for per-step temporaries. Allocation bumps a
+     * pointer, deallocation is a no-op, and reset() releases everything at
+     * once. The arena is not thread-safe; use one arena per thread.
+     *
+     * If the arena had to grow during a step, reset() merges its blocks into
+     * a single block of the total capacity, so that steady-state steps run
+     * within one block and reset in O(1).
+     */
+    class arena
+    {
+      public:
+        /*
+         * Usage statistics for capacity planning.
+         */
+        struct statistics
+        {
+            // Bytes allocated since the last reset (including padding).
+            std::size_t bytes_in_use;
+
+            // Maximum of bytes_in_use ever observed.
+            std::size_t peak_bytes;
+
+            // Total size of memory blocks owned by the arena.
+            std::size_t capacity;
+
+            // Number of blocks owned by the arena.
+            std::size_t block_count;
+
+            // Number of allocations since the last reset.
+            std::size_t allocation_count;
+
+            // Number of resets.
+            std::size_t reset_count;
+        };
+
+        explicit arena(std::size_t initial_capacity = std::size_t(1) << 20)
+        {
+            add_block(initial_capacity > 0 ? initial_capacity : 1);
+        }
+
+        arena(arena const&) = delete;
+        arena& operator=(arena const&) = delete;
+
+        /*
+         * Allocates size bytes aligned to alignment (a power of two). Throws
+         * std::bad_alloc on failure.
+         */
+        void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+        {
+            for (;;) {
+                block& current = blocks_[current_];
+                auto const base = reinterpret_cast<std::uintptr_t>(current.data.get());
+                auto const aligned = (base + offset_ + alignment - 1) & ~std::uintptr_t(alignment - 1);
+                std::size_t const end = std::size_t(aligned - base) + size;
+
+                if (end <= current.size) {
+                    in_use_ += end - offset_;
+                    offset_ = end;
+                    peak_ = in_use_ > peak_ ? in_use_ : peak_;
+                    allocations_++;
+                    return reinterpret_cast<void*>(aligned);
+                }
+
+                // Move on to the next block, adding one if necessary.
+                if (current_ + 1 == blocks_.size()) {
+                    std::size_t const grown = current.size * 2;
+                    std::size_t const needed = size + alignment;
+                    add_block(grown > needed ? grown : needed);
+                }
+                current_++;
+                offset_ = 0;
+            }
+        }
+
+        /*
+         * Allocates and default-constructs count objects of T. T must be
+         * trivially destructible since the arena never runs destructors.
+         */
+        template<typename T>
+        T* allocate_array(std::size_t count)
+        {
+            static_assert(std::is_trivially_destructible<T>::value,
+                "arena objects must be trivially destructible");
+            T* const array = static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+            for (std::size_t i = 0; i < count; ++i) {
+                ::new (static_cast<void*>(array + i)) T();
+            }
+            return array;
+        }
+
+        /*
+         * Releases all allocations at once.
+         */
+        void reset()
+        {
+            if (blocks_.size() > 1) {
+                std::size_t const total = capacity();
+                blocks_.clear();
+                add_block(total);
+            }
+            current_ = 0;
+            offset_ = 0;
+            in_use_ = 0;
+            allocations_ = 0;
+            resets_++;
+        }
+
+        std::size_t bytes_in_use() const
+        {
+            return in_use_;
+        }
+
+        std::size_t peak_bytes() const
+        {
+            return peak_;
+        }
+
+        std::size_t capacity() const
+        {
+            std::size_t total = 0;
+            for (auto const& b : blocks_) {
+                total += b.size;
+            }
+            return total;
+        }
+
+        statistics stats() const
+        {
+            return statistics{in_use_, peak_, capacity(), blocks_.size(), allocations_, resets_};
+        }
+
+      private:
+        struct block
+        {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        std::vector<block> blocks_;
+        std::size_t current_ = 0;
+        std::size_t offset_ = 0;
+        std::size_t in_use_ = 0;
+        std::size_t peak_ = 0;
+        std::size_t allocations_ = 0;
+        std::size_t resets_ = 0;
+
+        void add_block(std::size_t size)
+        {
+            blocks_.push_back(block{std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+        }
+    };
+
+    /*
+     * Standard allocator drawing memory from an arena, e.g. for per-step
+     * std::vector<dim::vector<...>, dim::arena_allocator<...>> buffers.
+     * Deallocation is a no-op; memory is reclaimed by arena::reset().
+     */
+    template<typename T>
+    class arena_allocator
+    {
+        template<typename U>
+        friend class arena_allocator;
+
+      public:
+        using value_type = T;
+
+        explicit arena_allocator(arena& resource) noexcept
+            : arena_{&resource}
+        {
+        }
+
+        template<typename U>
+        arena_allocator(arena_allocator<U> const& other) noexcept // NOLINT
+            : arena_{other.arena_}
+        {
+        }
+
+        T* allocate(std::size_t count)
+        {
+            return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, std::size_t) noexcept
+        {
+        }
+
+        arena& resource() const noexcept
+        {
+            return *arena_;
+        }
+
+      private:
+        arena* arena_;
+    };
+
+    template<typename T, typename U>
+    bool operator==(arena_allocator<T> const& a, arena_allocator<U> const& b) noexcept
+    {
+        return &a.resource() == &b.resource();
+    }
+
+    template<typename T, typename U>
+    bool operator!=(arena_allocator<T> const& a, arena_allocator<U> const& b) noexcept
+    {
+        return !(a == b);
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_ARENA_HPP
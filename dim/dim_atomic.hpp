@@ -0,0 +1,223 @@
+/*
+ * dim - Atomic accumulation of dimensioned scalars and vectors.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_ATOMIC_HPP
+#define INCLUDED_DIM_ATOMIC_HPP
+
+#include <atomic>
+#include <type_traits>
+
+#include "dim.hpp"
+
+namespace dim
+{
+    namespace detail // for dim::atomic_scalar
+    {
+        // Integral numbers (used for fixed-point accumulation) have native
+        // atomic addition.
+        template<typename T>
+        T atomic_fetch_add(std::atomic<T>& target, T delta, std::memory_order order, std::true_type)
+        {
+            return target.fetch_add(delta, order);
+        }
+
+        // Floating-point numbers need a compare-and-swap loop.
+        template<typename T>
+        T atomic_fetch_add(std::atomic<T>& target, T delta, std::memory_order order, std::false_type)
+        {
+            T expected = target.load(std::memory_order_relaxed);
+            while (!target.compare_exchange_weak(
+                expected, expected + delta, order, std::memory_order_relaxed)) {
+            }
+            return expected;
+        }
+    } // namespace detail
+
+    /*
+     * Scalar quantity that can be updated atomically. Addition uses native
+     * fetch_add for integral (fixed-point) number types and a CAS loop for
+     * floating-point number types.
+     *
+     * Accumulation defaults to relaxed memory order, assuming the result is
+     * read after the accumulating threads are joined or synchronized.
+     */
+    template<typename T, typename D>
+    class atomic_scalar
+    {
+      public:
+        using number_type = T;
+        using dimension = D;
+        using value_type = scalar<T, D>;
+
+        atomic_scalar() noexcept
+            : value_{T(0)}
+        {
+        }
+
+        explicit atomic_scalar(value_type value) noexcept
+            : value_{value.value()}
+        {
+        }
+
+        atomic_scalar(atomic_scalar const&) = delete;
+        atomic_scalar& operator=(atomic_scalar const&) = delete;
+
+        bool is_lock_free() const noexcept
+        {
+            return value_.is_lock_free();
+        }
+
+        value_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept
+        {
+            return value_type{value_.load(order)};
+        }
+
+        void store(value_type value, std::memory_order order = std::memory_order_seq_cst) noexcept
+        {
+            value_.store(value.value(), order);
+        }
+
+        /*
+         * Atomically adds delta and returns the previous value.
+         */
+        value_type fetch_add(
+            value_type delta, std::memory_order order = std::memory_order_relaxed) noexcept
+        {
+            return value_type{detail::atomic_fetch_add(
+                value_, delta.value(), order, std::is_integral<T>{})};
+        }
+
+        /*
+         * Atomically subtracts delta and returns the previous value.
+         */
+        value_type fetch_sub(
+            value_type delta, std::memory_order order = std::memory_order_relaxed) noexcept
+        {
+            return fetch_add(-delta, order);
+        }
+
+        value_type operator+=(value_type delta) noexcept
+        {
+            return fetch_add(delta) + delta;
+        }
+
+        value_type operator-=(value_type delta) noexcept
+        {
+            return fetch_sub(delta) - delta;
+        }
+
+      private:
+        std::atomic<T> value_;
+    };
+
+    /*
+     * Vector quantity whose coordinates can be updated atomically. Each
+     * coordinate is updated independently; the vector as a whole is not
+     * updated in a single atomic step.
+     */
+    template<typename T, typename D, unsigned N>
+    class atomic_vector
+    {
+      public:
+        using number_type = T;
+        using value_type = vector<T, D, N>;
+        using scalar_type = atomic_scalar<T, D>;
+        static constexpr unsigned dimension = N;
+
+        atomic_vector() noexcept = default;
+
+        explicit atomic_vector(value_type const& value) noexcept
+        {
+            store(value, std::memory_order_relaxed);
+        }
+
+        atomic_vector(atomic_vector const&) = delete;
+        atomic_vector& operator=(atomic_vector const&) = delete;
+
+        scalar_type& operator[](unsigned index)
+        {
+            return coords_[index];
+        }
+
+        scalar_type const& operator[](unsigned index) const
+        {
+            return coords_[index];
+        }
+
+        value_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept
+        {
+            value_type result;
+            for (unsigned i = 0; i < N; ++i) {
+                result[i] = coords_[i].load(order);
+            }
+            return result;
+        }
+
+        void store(value_type const& value,
+            std::memory_order order = std::memory_order_seq_cst) noexcept
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i].store(value[i], order);
+            }
+        }
+
+        void fetch_add(
+            value_type const& delta, std::memory_order order = std::memory_order_relaxed) noexcept
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i].fetch_add(delta[i], order);
+            }
+        }
+
+        void fetch_sub(
+            value_type const& delta, std::memory_order order = std::memory_order_relaxed) noexcept
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i].fetch_sub(delta[i], order);
+            }
+        }
+
+        atomic_vector& operator+=(value_type const& delta) noexcept
+        {
+            fetch_add(delta);
+            return *this;
+        }
+
+        atomic_vector& operator-=(value_type const& delta) noexcept
+        {
+            fetch_sub(delta);
+            return *this;
+        }
+
+      private:
+        scalar_type coords_[N];
+    };
+} // namespace dim
+
+#endif // INCLUDED_DIM_ATOMIC_HPP
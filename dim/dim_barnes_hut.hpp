@@ -0,0 +1,514 @@
+/*
+ * dim - Barnes-Hut tree for long-range pair forces between dim::point particles.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_BARNES_HUT_HPP
+#define INCLUDED_DIM_BARNES_HUT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    /*
+     * Pair law for forces proportional to the inverse square of distance,
+     * like gravity (with negative coupling) and the Coulomb force. DQ is the
+     * dimension of the source strength such as mass or charge.
+     */
+    template<typename T, typename DQ>
+    struct inverse_square_law
+    {
+        using strength_type = scalar<T, DQ>;
+        using coupling_type = scalar<T,
+            quotient_dimension_t<product_dimension_t<mech::energy, mech::length>,
+                power_dimension_t<DQ, 2>>>;
+
+        coupling_type coupling;
+
+        // Force exerted on the target by the source. r is the displacement
+        // from the source to the target.
+        vector<T, mech::force, 3> force(vector<T, mech::length, 3> const& r,
+            strength_type source,
+            strength_type target) const
+        {
+            auto const distance = norm(r);
+            return coupling * source * target * r / pow<3>(distance);
+        }
+
+        scalar<T, mech::energy> potential(vector<T, mech::length, 3> const& r,
+            strength_type source,
+            strength_type target) const
+        {
+            return coupling * source * target / norm(r);
+        }
+    };
+
+    namespace detail // for dim::barnes_hut
+    {
+        // Spreads the lower 21 bits of x so that there are two zero bits
+        // between each bit.
+        inline std::uint64_t spread_bits_3d(std::uint64_t x)
+        {
+            x &= 0x1fffff;
+            x = (x | x << 32) & 0x1f00000000ffffULL;
+            x = (x | x << 16) & 0x1f0000ff0000ffULL;
+            x = (x | x << 8) & 0x100f00f00f00f00fULL;
+            x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+            x = (x | x << 2) & 0x1249249249249249ULL;
+            return x;
+        }
+
+        inline std::uint64_t morton_key_3d(std::uint64_t x, std::uint64_t y, std::uint64_t z)
+        {
+            return spread_bits_3d(x) << 2 | spread_bits_3d(y) << 1 | spread_bits_3d(z);
+        }
+    } // namespace detail
+
+    /*
+     * Barnes-Hut tree engine computing pairwise long-range interactions in
+     * O(N log N) time. A cell is treated as a single source located at its
+     * center of strength if its size divided by the distance from the target
+     * is smaller than the opening angle.
+     *
+     * The tree is linearized: nodes are stored in depth-first order and each
+     * node records the index following its subtree, so traversal needs no
+     * stack and no child pointers.
+     */
+    template<typename T, typename DQ>
+    class barnes_hut
+    {
+      public:
+        using number_type = T;
+        using point_type = point<T, mech::length, 3>;
+        using displacement_type = vector<T, mech::length, 3>;
+        using strength_type = scalar<T, DQ>;
+
+        explicit barnes_hut(T opening_angle = T(0.5), std::size_t leaf_size = 8)
+            : opening_angle_{opening_angle}, leaf_size_{leaf_size < 1 ? 1 : leaf_size}
+        {
+        }
+
+        T opening_angle() const
+        {
+            return opening_angle_;
+        }
+
+        std::size_t size() const
+        {
+            return positions_.size();
+        }
+
+        std::size_t node_count() const
+        {
+            return nodes_.size();
+        }
+
+        /*
+         * Builds the tree over count particles. The arrays are copied.
+         */
+        void build(point_type const* points, strength_type const* strengths, std::size_t count)
+        {
+            nodes_.clear();
+            positions_.resize(count);
+            strengths_.resize(count);
+            order_.resize(count);
+            if (count == 0) {
+                return;
+            }
+
+            sort_particles(points, strengths, count);
+
+            T const root_size = root_size_;
+            std::size_t const chunks = detail::chunk_count(count, 4096);
+            if (chunks <= 1) {
+                build_node(0, count, 0, root_lower_, root_size, nodes_);
+                return;
+            }
+
+            // Build the subtrees of the root octants concurrently and then
+            // splice them after the root node.
+            std::vector<std::vector<node>> subtrees(8);
+            std::vector<std::thread> workers;
+            node root = make_cell(0, count, root_lower_, root_size);
+            std::size_t begin = 0;
+            for (unsigned octant = 0; octant < 8; ++octant) {
+                std::size_t const end = octant_end(begin, count, 0, octant);
+                if (begin < end) {
+                    T lower[3];
+                    child_lower(root_lower_, root_size, octant, lower);
+                    workers.emplace_back([=, &subtrees] {
+                        build_node(begin, end, 1, lower, root_size / 2, subtrees[octant]);
+                    });
+                }
+                begin = end;
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            nodes_.push_back(root);
+            for (auto const& subtree : subtrees) {
+                std::size_t const offset = nodes_.size();
+                for (auto n : subtree) {
+                    n.next += offset;
+                    nodes_.push_back(n);
+                }
+            }
+            finish_cell(nodes_[0], nodes_.size());
+        }
+
+        void build(std::vector<point_type> const& points,
+            std::vector<strength_type> const& strengths)
+        {
+            build(points.data(), strengths.data(), points.size());
+        }
+
+        /*
+         * Computes the force on each particle. law.force(r, source, target)
+         * gives the force on a target of given strength exerted by a source,
+         * where r is the displacement from the source to the target. forces
+         * must have room for size() elements, which are overwritten.
+         */
+        template<typename Law, typename F>
+        void compute(Law const& law, F* forces) const
+        {
+            compute_impl(law, forces, static_cast<no_potential*>(nullptr));
+        }
+
+        /*
+         * Computes the force and the potential energy of each particle.
+         * law.potential(r, source, target) gives the pair potential. Each
+         * pair is counted once for each particle, so the total energy is the
+         * half of the sum of potentials.
+         */
+        template<typename Law, typename F, typename P>
+        void compute(Law const& law, F* forces, P* potentials) const
+        {
+            compute_impl(law, forces, potentials);
+        }
+
+        template<typename Law, typename F>
+        void compute(Law const& law, std::vector<F>& forces) const
+        {
+            forces.resize(size());
+            compute(law, forces.data());
+        }
+
+        template<typename Law, typename F, typename P>
+        void compute(Law const& law, std::vector<F>& forces, std::vector<P>& potentials) const
+        {
+            forces.resize(size());
+            potentials.resize(size());
+            compute(law, forces.data(), potentials.data());
+        }
+
+      private:
+        // Finest subdivision level allowed by 63-bit Morton keys.
+        static constexpr unsigned max_level = 21;
+
+        struct node
+        {
+            T center[3];      // Center of strength
+            T cell_center[3]; // Geometric center of the cell
+            T half_size;
+            T squared_size;
+            T strength;
+            std::size_t begin;
+            std::size_t end;
+            std::size_t next;
+            bool leaf;
+        };
+
+        struct no_potential
+        {
+        };
+
+        T opening_angle_;
+        std::size_t leaf_size_;
+        T root_lower_[3] = {};
+        T root_size_ = T(0);
+        std::vector<node> nodes_;
+        std::vector<point_type> positions_;
+        std::vector<strength_type> strengths_;
+        std::vector<std::size_t> order_;
+        std::vector<std::uint64_t> keys_;
+
+        void sort_particles(point_type const* points, strength_type const* strengths, std::size_t count)
+        {
+            T lower[3];
+            T upper[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                lower[k] = upper[k] = points[0][k].value();
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const x = points[i][k].value();
+                    lower[k] = x < lower[k] ? x : lower[k];
+                    upper[k] = x > upper[k] ? x : upper[k];
+                }
+            }
+            T size = T(0);
+            for (unsigned k = 0; k < 3; ++k) {
+                size = std::max(size, upper[k] - lower[k]);
+                root_lower_[k] = lower[k];
+            }
+            root_size_ = size > T(0) ? size : T(1);
+
+            std::vector<std::pair<std::uint64_t, std::size_t>> keyed(count);
+            T const scale = T(1 << max_level) / root_size_;
+            detail::parallel_for(count, [&](std::size_t i) {
+                std::uint64_t cell[3];
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const x = (points[i][k].value() - root_lower_[k]) * scale;
+                    T const clamped = std::min(std::max(x, T(0)), T((1 << max_level) - 1));
+                    cell[k] = static_cast<std::uint64_t>(clamped);
+                }
+                keyed[i] = {detail::morton_key_3d(cell[0], cell[1], cell[2]), i};
+            });
+
+            // Sort chunks concurrently and then merge them.
+            std::size_t const chunks = detail::chunk_count(count);
+            detail::parallel_chunks(count, chunks, [&](std::size_t, std::size_t begin, std::size_t end) {
+                std::sort(keyed.begin() + std::ptrdiff_t(begin), keyed.begin() + std::ptrdiff_t(end));
+            });
+            for (std::size_t width = 1; width < chunks; width *= 2) {
+                for (std::size_t first = 0; first + width < chunks; first += 2 * width) {
+                    std::size_t const last = std::min(first + 2 * width, chunks);
+                    auto const base = keyed.begin();
+                    std::inplace_merge(base + std::ptrdiff_t(count * first / chunks),
+                        base + std::ptrdiff_t(count * (first + width) / chunks),
+                        base + std::ptrdiff_t(count * last / chunks));
+                }
+            }
+
+            keys_.resize(count);
+            detail::parallel_for(count, [&](std::size_t i) {
+                keys_[i] = keyed[i].first;
+                order_[i] = keyed[i].second;
+                positions_[i] = points[keyed[i].second];
+                strengths_[i] = strengths[keyed[i].second];
+            });
+        }
+
+        // Returns the end of the particles in the given octant of a cell at
+        // level whose particles start at begin.
+        std::size_t octant_end(
+            std::size_t begin, std::size_t end, unsigned level, unsigned octant) const
+        {
+            unsigned const shift = 3 * (max_level - 1 - level);
+            auto const it = std::partition_point(keys_.begin() + std::ptrdiff_t(begin),
+                keys_.begin() + std::ptrdiff_t(end),
+                [=](std::uint64_t key) { return ((key >> shift) & 7) <= octant; });
+            return std::size_t(it - keys_.begin());
+        }
+
+        static void child_lower(T const* lower, T size, unsigned octant, T* result)
+        {
+            T const half = size / 2;
+            result[0] = lower[0] + ((octant & 4) ? half : T(0));
+            result[1] = lower[1] + ((octant & 2) ? half : T(0));
+            result[2] = lower[2] + ((octant & 1) ? half : T(0));
+        }
+
+        node make_cell(std::size_t begin, std::size_t end, T const* lower, T size) const
+        {
+            node cell;
+            for (unsigned k = 0; k < 3; ++k) {
+                cell.cell_center[k] = lower[k] + size / 2;
+                cell.center[k] = T(0);
+            }
+            cell.half_size = size / 2;
+            cell.squared_size = size * size;
+            cell.strength = T(0);
+            cell.begin = begin;
+            cell.end = end;
+            cell.next = 0;
+            cell.leaf = false;
+            return cell;
+        }
+
+        // Computes the strength and the center of strength of a cell from the
+        // particles. Absolute strengths are used as weights so that the
+        // center is defined for cells with mixed signs.
+        void finish_cell(node& cell, std::size_t next) const
+        {
+            T weight = T(0);
+            T moment[3] = {};
+            for (std::size_t i = cell.begin; i < cell.end; ++i) {
+                T const q = strengths_[i].value();
+                T const w = q < T(0) ? -q : q;
+                cell.strength += q;
+                weight += w;
+                for (unsigned k = 0; k < 3; ++k) {
+                    moment[k] += w * positions_[i][k].value();
+                }
+            }
+            for (unsigned k = 0; k < 3; ++k) {
+                cell.center[k] = weight > T(0) ? moment[k] / weight : cell.cell_center[k];
+            }
+            cell.next = next;
+        }
+
+        // Appends the subtree of a cell to nodes in depth-first order. Indices
+        // stored in next are relative to the start of nodes.
+        void build_node(std::size_t begin,
+            std::size_t end,
+            unsigned level,
+            T const* lower,
+            T size,
+            std::vector<node>& nodes) const
+        {
+            std::size_t const index = nodes.size();
+            nodes.push_back(make_cell(begin, end, lower, size));
+
+            if (end - begin <= leaf_size_ || level == max_level) {
+                nodes[index].leaf = true;
+            } else {
+                std::size_t child_begin = begin;
+                for (unsigned octant = 0; octant < 8; ++octant) {
+                    std::size_t const child_end = octant_end(child_begin, end, level, octant);
+                    if (child_begin < child_end) {
+                        T child[3];
+                        child_lower(lower, size, octant, child);
+                        build_node(child_begin, child_end, level + 1, child, size / 2, nodes);
+                    }
+                    child_begin = child_end;
+                }
+            }
+            finish_cell(nodes[index], nodes.size());
+        }
+
+        bool inside(node const& cell, point_type const& target) const
+        {
+            for (unsigned k = 0; k < 3; ++k) {
+                T const delta = target[k].value() - cell.cell_center[k];
+                if (delta < -cell.half_size || delta > cell.half_size) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename Law, typename F, typename P>
+        static void accumulate(Law const& law,
+            displacement_type const& r,
+            strength_type source,
+            strength_type target,
+            F& force,
+            P* potential)
+        {
+            force += law.force(r, source, target);
+            add_potential(law, r, source, target, potential);
+        }
+
+        template<typename Law, typename P>
+        static void add_potential(Law const& law,
+            displacement_type const& r,
+            strength_type source,
+            strength_type target,
+            P* potential)
+        {
+            *potential += law.potential(r, source, target);
+        }
+
+        template<typename Law>
+        static void add_potential(Law const&,
+            displacement_type const&,
+            strength_type,
+            strength_type,
+            no_potential*)
+        {
+        }
+
+        template<typename P>
+        static void store(P* potentials, std::size_t index, P const& value)
+        {
+            potentials[index] = value;
+        }
+
+        static void store(no_potential*, std::size_t, no_potential const&)
+        {
+        }
+
+        template<typename Law, typename F, typename P>
+        void compute_impl(Law const& law, F* forces, P* potentials) const
+        {
+            T const theta2 = opening_angle_ * opening_angle_;
+
+            // Targets are processed in Morton order so that consecutive
+            // targets on a thread walk similar parts of the tree.
+            detail::parallel_for(size(), [&](std::size_t target) {
+                point_type const& position = positions_[target];
+                strength_type const strength = strengths_[target];
+                F force{};
+                P potential{};
+
+                std::size_t index = 0;
+                while (index < nodes_.size()) {
+                    node const& cell = nodes_[index];
+                    if (cell.leaf) {
+                        for (std::size_t i = cell.begin; i < cell.end; ++i) {
+                            if (i != target) {
+                                accumulate(law, position - positions_[i], strengths_[i],
+                                    strength, force, &potential);
+                            }
+                        }
+                        index = cell.next;
+                        continue;
+                    }
+
+                    displacement_type r;
+                    for (unsigned k = 0; k < 3; ++k) {
+                        r[k] = scalar<T, mech::length>{position[k].value() - cell.center[k]};
+                    }
+                    if (cell.squared_size < theta2 * squared_norm(r).value()
+                        && !inside(cell, position)) {
+                        accumulate(law, r, strength_type{cell.strength}, strength, force,
+                            &potential);
+                        index = cell.next;
+                    } else {
+                        index++;
+                    }
+                }
+
+                forces[order_[target]] = force;
+                store(potentials, order_[target], potential);
+            }, 64);
+        }
+    };
+} // namespace dim
+
+#endif // INCLUDED_DIM_BARNES_HUT_HPP
@@ -0,0 +1,359 @@
+/*
+ * dim - Batched bonded-interaction kernels over index tables.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_BONDED_HPP
+#define INCLUDED_DIM_BONDED_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Bonded potentials
+    //----------------------------------------------------------------
+
+    /*
+     * Harmonic bond U = k (r - r0)^2 / 2.
+     */
+    template<typename T>
+    struct harmonic_bond
+    {
+        static constexpr unsigned arity = 2;
+
+        scalar<T, quotient_dimension_t<mech::energy, power_dimension_t<mech::length, 2>>> stiffness;
+        scalar<T, mech::length> length;
+
+        scalar<T, mech::energy> operator()(
+            point<T, mech::length, 3> const* p, vector<T, mech::force, 3>* f) const
+        {
+            auto const r = p[1] - p[0];
+            auto const distance = norm(r);
+            auto const stretch = distance - length;
+            auto const force = stiffness * stretch * r / distance;
+            f[0] = force;
+            f[1] = -force;
+            return stiffness * stretch * stretch / T(2);
+        }
+    };
+
+    /*
+     * FENE bond U = -k R^2 log(1 - (r/R)^2) / 2. The bond must be shorter
+     * than the maximum length R.
+     */
+    template<typename T>
+    struct fene_bond
+    {
+        static constexpr unsigned arity = 2;
+
+        scalar<T, quotient_dimension_t<mech::energy, power_dimension_t<mech::length, 2>>> stiffness;
+        scalar<T, mech::length> max_length;
+
+        scalar<T, mech::energy> operator()(
+            point<T, mech::length, 3> const* p, vector<T, mech::force, 3>* f) const
+        {
+            auto const r = p[1] - p[0];
+            auto const max_length2 = max_length * max_length;
+            T const ratio = squared_norm(r) / max_length2;
+            auto const force = stiffness * r / (1 - ratio);
+            f[0] = force;
+            f[1] = -force;
+            return -stiffness * max_length2 * std::log(1 - ratio) / T(2);
+        }
+    };
+
+    /*
+     * Harmonic bond angle U = k (theta - theta0)^2 / 2, where theta is the
+     * angle p0-p1-p2 in radians.
+     */
+    template<typename T>
+    struct harmonic_angle
+    {
+        static constexpr unsigned arity = 3;
+
+        scalar<T, mech::energy> stiffness;
+        T angle;
+
+        scalar<T, mech::energy> operator()(
+            point<T, mech::length, 3> const* p, vector<T, mech::force, 3>* f) const
+        {
+            auto const a = p[0] - p[1];
+            auto const b = p[2] - p[1];
+            auto const n = cross(a, b);
+            auto const n_norm = norm(n);
+            T const theta = std::atan2(n_norm.value(), dot(a, b).value());
+            auto const torque = stiffness * (theta - angle);
+
+            // Gradients of theta with respect to a and b.
+            auto const grad_a = cross(a, n) / (squared_norm(a) * n_norm);
+            auto const grad_b = cross(n, b) / (squared_norm(b) * n_norm);
+            f[0] = -torque * grad_a;
+            f[2] = -torque * grad_b;
+            f[1] = -(f[0] + f[2]);
+            return torque * (theta - angle) / T(2);
+        }
+    };
+
+    /*
+     * Periodic dihedral U = k (1 + cos(n phi - delta)), where phi is the
+     * dihedral angle p0-p1-p2-p3 in radians (IUPAC convention).
+     */
+    template<typename T>
+    struct cosine_dihedral
+    {
+        static constexpr unsigned arity = 4;
+
+        scalar<T, mech::energy> stiffness;
+        int multiplicity;
+        T phase;
+
+        scalar<T, mech::energy> operator()(
+            point<T, mech::length, 3> const* p, vector<T, mech::force, 3>* f) const
+        {
+            auto const r_ij = p[0] - p[1];
+            auto const r_kj = p[2] - p[1];
+            auto const r_kl = p[2] - p[3];
+            auto const m = cross(r_ij, r_kj);
+            auto const n = cross(r_kj, r_kl);
+            auto const kj_norm2 = squared_norm(r_kj);
+            auto const kj_norm = sqrt(kj_norm2);
+
+            T const phi = std::atan2(
+                (dot(cross(m, n), r_kj) / kj_norm).value(), dot(m, n).value());
+            T const arg = T(multiplicity) * phi - phase;
+            auto const dudphi = -stiffness * T(multiplicity) * std::sin(arg);
+
+            auto const f_i = -dudphi * kj_norm / squared_norm(m) * m;
+            auto const f_l = dudphi * kj_norm / squared_norm(n) * n;
+            T const p_coef = dot(r_ij, r_kj) / kj_norm2;
+            T const q_coef = dot(r_kl, r_kj) / kj_norm2;
+            auto const s = p_coef * f_i - q_coef * f_l;
+
+            f[0] = f_i;
+            f[1] = s - f_i;
+            f[2] = -s - f_l;
+            f[3] = f_l;
+            return stiffness * (1 + std::cos(arg));
+        }
+    };
+
+    //----------------------------------------------------------------
+    // Engine
+    //----------------------------------------------------------------
+
+    /*
+     * Evaluates a bonded potential over a table of particle index tuples.
+     *
+     * Terms are greedily colored so that no two terms of the same color share
+     * a particle. Terms of one color are then evaluated concurrently and
+     * their forces scattered without atomics or private buffers. Positions
+     * are gathered into small contiguous blocks before evaluation.
+     */
+    template<typename T, typename Potential>
+    class bonded_engine
+    {
+      public:
+        static constexpr unsigned arity = Potential::arity;
+
+        using index_type = std::array<std::uint32_t, arity>;
+        using point_type = point<T, mech::length, 3>;
+        using force_type = vector<T, mech::force, 3>;
+        using energy_type = scalar<T, mech::energy>;
+
+        bonded_engine(std::vector<index_type> const& terms, Potential const& potential)
+            : potential_(potential)
+        {
+            assign_colors(terms);
+        }
+
+        std::size_t size() const
+        {
+            return terms_.size();
+        }
+
+        std::size_t color_count() const
+        {
+            return color_offsets_.size() - 1;
+        }
+
+        Potential const& potential() const
+        {
+            return potential_;
+        }
+
+        /*
+         * Adds the forces of all terms to forces and returns the total
+         * energy. The arrays must cover all particles referenced by terms.
+         */
+        energy_type compute(point_type const* positions, force_type* forces) const
+        {
+            T energy = T(0);
+
+            for (std::size_t color = 0; color + 1 < color_offsets_.size(); ++color) {
+                std::size_t const begin = color_offsets_[color];
+                std::size_t const count = color_offsets_[color + 1] - begin;
+                std::size_t const chunks = detail::chunk_count(count, 1024);
+                std::vector<T> energies(chunks, T(0));
+
+                detail::parallel_chunks(count, chunks,
+                    [&](std::size_t chunk, std::size_t chunk_begin, std::size_t chunk_end) {
+                        energies[chunk] =
+                            compute_range(positions, forces, begin + chunk_begin, begin + chunk_end);
+                    });
+
+                for (T const e : energies) {
+                    energy += e;
+                }
+            }
+            return energy_type{energy};
+        }
+
+        energy_type compute(std::vector<point_type> const& positions,
+            std::vector<force_type>& forces) const
+        {
+            return compute(positions.data(), forces.data());
+        }
+
+      private:
+        static constexpr std::size_t block_size = 32;
+
+        Potential potential_;
+        std::vector<index_type> terms_;
+        std::vector<std::size_t> color_offsets_;
+
+        T compute_range(point_type const* positions,
+            force_type* forces,
+            std::size_t begin,
+            std::size_t end) const
+        {
+            point_type gathered[block_size][arity];
+            force_type scattered[block_size][arity];
+            T energy = T(0);
+
+            for (std::size_t block = begin; block < end; block += block_size) {
+                std::size_t const size = (end - block < block_size) ? end - block : block_size;
+
+                for (std::size_t t = 0; t < size; ++t) {
+                    for (unsigned a = 0; a < arity; ++a) {
+                        gathered[t][a] = positions[terms_[block + t][a]];
+                    }
+                }
+                for (std::size_t t = 0; t < size; ++t) {
+                    energy += potential_(gathered[t], scattered[t]).value();
+                }
+                for (std::size_t t = 0; t < size; ++t) {
+                    for (unsigned a = 0; a < arity; ++a) {
+                        forces[terms_[block + t][a]] += scattered[t][a];
+                    }
+                }
+            }
+            return energy;
+        }
+
+        void assign_colors(std::vector<index_type> const& terms)
+        {
+            std::size_t particles = 0;
+            for (auto const& term : terms) {
+                for (auto const index : term) {
+                    particles = index + 1 > particles ? index + 1 : particles;
+                }
+            }
+
+            // Bit c of used[p * words + w / 64] tells whether color 64 w + c
+            // is already taken by a term involving particle p.
+            std::size_t words = 1;
+            std::vector<std::uint64_t> used(particles * words, 0);
+            std::vector<std::size_t> colors(terms.size());
+            std::size_t color_count = 0;
+
+            for (std::size_t t = 0; t < terms.size(); ++t) {
+                std::size_t color = 0;
+                for (;; ++color) {
+                    if (color == words * 64) {
+                        std::vector<std::uint64_t> wider(particles * words * 2, 0);
+                        for (std::size_t p = 0; p < particles; ++p) {
+                            for (std::size_t w = 0; w < words; ++w) {
+                                wider[p * words * 2 + w] = used[p * words + w];
+                            }
+                        }
+                        used.swap(wider);
+                        words *= 2;
+                    }
+                    std::uint64_t const bit = std::uint64_t(1) << (color % 64);
+                    bool taken = false;
+                    for (auto const index : terms[t]) {
+                        taken = taken || (used[index * words + color / 64] & bit);
+                    }
+                    if (!taken) {
+                        break;
+                    }
+                }
+                for (auto const index : terms[t]) {
+                    used[index * words + color / 64] |= std::uint64_t(1) << (color % 64);
+                }
+                colors[t] = color;
+                color_count = color + 1 > color_count ? color + 1 : color_count;
+            }
+
+            // Counting sort of terms by color.
+            color_offsets_.assign(color_count + 1, 0);
+            for (auto const color : colors) {
+                color_offsets_[color + 1]++;
+            }
+            for (std::size_t c = 0; c < color_count; ++c) {
+                color_offsets_[c + 1] += color_offsets_[c];
+            }
+            terms_.resize(terms.size());
+            std::vector<std::size_t> fill(color_offsets_.begin(), color_offsets_.end() - 1);
+            for (std::size_t t = 0; t < terms.size(); ++t) {
+                terms_[fill[colors[t]]++] = terms[t];
+            }
+        }
+    };
+
+    /*
+     * Creates a bonded_engine deducing the number type from the potential.
+     */
+    template<template<typename> class Potential, typename T>
+    bonded_engine<T, Potential<T>> make_bonded_engine(
+        std::vector<std::array<std::uint32_t, Potential<T>::arity>> const& terms,
+        Potential<T> const& potential)
+    {
+        return bonded_engine<T, Potential<T>>{terms, potential};
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_BONDED_HPP
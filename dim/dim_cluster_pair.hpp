@@ -0,0 +1,738 @@
+/*
+ * dim - Cluster-pair nonbonded kernels over SIMD-friendly particle tiles.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_CLUSTER_PAIR_HPP
+#define INCLUDED_DIM_CLUSTER_PAIR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_arena.hpp"
+#include "dim_parallel.hpp"
+#include "dim_timer.hpp"
+
+namespace dim
+{
+    /*
+     * Lennard-Jones potential U = 4 eps ((s/r)^12 - (s/r)^6) as a function
+     * of squared distance, evaluated together with the force factor
+     * -2 dU/d(r^2) like tabulated_function.
+     */
+    template<typename T>
+    struct lennard_jones
+    {
+        using argument_type = scalar<T, power_dimension_t<mech::length, 2>>;
+        using value_type = scalar<T, mech::energy>;
+        using force_factor_type = scalar<T, quotient_dimension_t<mech::energy, power_dimension_t<mech::length, 2>>>;
+
+        struct sample
+        {
+            value_type value;
+            force_factor_type force_factor;
+        };
+
+        value_type epsilon;
+        scalar<T, mech::length> sigma;
+
+        sample evaluate(argument_type r2) const
+        {
+            auto const inverse = T(1) / r2;
+            T const s2 = sigma * sigma * inverse;
+            T const s6 = s2 * s2 * s2;
+            return sample{4 * epsilon * (s6 * s6 - s6), 24 * epsilon * (2 * s6 * s6 - s6) * inverse};
+        }
+
+        value_type operator()(argument_type r2) const
+        {
+            return evaluate(r2).value;
+        }
+    };
+
+    /*
+     * Cluster-pair list for short-range interactions in an orthorhombic
+     * periodic box (Pall and Hess, Comput. Phys. Commun. 184, 2641 (2013)).
+     *
+     * Particles are sorted into columns of the xy plane and by z within a
+     * column, then cut into clusters of M particles stored as SoA tiles.
+     * The list holds pairs of clusters whose bounding boxes are closer than
+     * the list radius, each with a periodic shift and an M x M mask of the
+     * particle pairs that interact. Padding slots, excluded pairs and the
+     * lower triangle of a cluster paired with itself are masked out.
+     *
+     * The kernel computes all M x M distances of a cluster pair at once
+     * without branches, which keeps SIMD lanes full where per-particle
+     * neighbor lists cannot. M is 4 or 8.
+     */
+    template<typename T, unsigned M = 4>
+    class cluster_pair_list
+    {
+        static_assert(M == 4 || M == 8, "cluster size must be 4 or 8");
+
+      public:
+        using number_type = T;
+        using point_type = point<T, mech::length, 3>;
+        using box_type = vector<T, mech::length, 3>;
+        using length_type = scalar<T, mech::length>;
+        using energy_type = scalar<T, mech::energy>;
+        using force_type = vector<T, mech::force, 3>;
+        using mask_type = std::uint64_t;
+        using exclusion = std::pair<std::size_t, std::size_t>;
+
+        static constexpr unsigned cluster_size = M;
+        static constexpr std::size_t no_particle = std::size_t(-1);
+
+        /*
+         * Coordinates of the M particles of a cluster, one array per axis.
+         */
+        struct tile
+        {
+            alignas(M * sizeof(T)) T x[M];
+            alignas(M * sizeof(T)) T y[M];
+            alignas(M * sizeof(T)) T z[M];
+        };
+
+        using tile_buffer = std::vector<tile, aligned_allocator<tile, alignof(tile)>>;
+
+        /*
+         * Pair of clusters i <= j. The j cluster interacts through its image
+         * displaced by shift. A cluster pair is listed once for each image
+         * within range. Bit a * M + b of mask is set if particle a of
+         * cluster i interacts with particle b of cluster j.
+         */
+        struct cluster_pair
+        {
+            std::uint32_t i;
+            std::uint32_t j;
+            mask_type mask;
+            T shift[3];
+        };
+
+        /*
+         * Creates an empty list for a box. list_radius is the interaction
+         * cutoff plus a buffer covering the particle motion until the next
+         * build.
+         */
+        cluster_pair_list(box_type box, length_type list_radius)
+            : box_(box)
+            , list_radius_{list_radius.value()}
+        {
+            if (!(list_radius_ > T(0))) {
+                throw std::invalid_argument("list radius must be positive");
+            }
+            for (unsigned k = 0; k < 3; ++k) {
+                if (!(list_radius_ * 2 <= box[k].value())) {
+                    throw std::invalid_argument("list radius must not exceed half the box size");
+                }
+            }
+        }
+
+        box_type box() const
+        {
+            return box_;
+        }
+
+        length_type list_radius() const
+        {
+            return length_type{list_radius_};
+        }
+
+        std::size_t size() const
+        {
+            return particle_count_;
+        }
+
+        std::size_t cluster_count() const
+        {
+            return tiles_.size();
+        }
+
+        tile_buffer const& tiles() const
+        {
+            return tiles_;
+        }
+
+        std::vector<cluster_pair> const& pairs() const
+        {
+            return pairs_;
+        }
+
+        /*
+         * Returns the particle index stored in slot s of cluster c, or
+         * no_particle for a padding slot.
+         */
+        std::size_t particle(std::size_t c, unsigned s) const
+        {
+            return index_[c * M + s];
+        }
+
+        /*
+         * Returns the fraction of the M x M particle pairs of the listed
+         * cluster pairs that are not masked out.
+         */
+        T fill_ratio() const
+        {
+            std::size_t active = 0;
+            for (auto const& pair : pairs_) {
+                mask_type mask = pair.mask;
+                for (; mask != 0; mask &= mask - 1) {
+                    active++;
+                }
+            }
+            return pairs_.empty() ? T(0) : T(active) / T(pairs_.size() * M * M);
+        }
+
+        /*
+         * Sorts count particles into clusters and builds the cluster pair
+         * list. Excluded particle pairs never interact.
+         */
+        void build(point_type const* positions,
+            std::size_t count,
+            exclusion const* exclusions = nullptr,
+            std::size_t exclusion_count = 0)
+        {
+            DIM_TIMER_SCOPE("dim::cluster_pair_list::build", count, 0);
+            particle_count_ = count;
+            sort_particles(positions, count);
+            find_pairs();
+            apply_exclusions(exclusions, exclusion_count);
+        }
+
+        void build(std::vector<point_type> const& positions,
+            std::vector<exclusion> const& exclusions = std::vector<exclusion>{})
+        {
+            build(positions.data(), positions.size(), exclusions.data(), exclusions.size());
+        }
+
+        /*
+         * Refreshes the tile coordinates from moved particles without
+         * changing the clusters or the pairs. The list stays valid while no
+         * particle has moved more than half the buffer since the build.
+         * Positions must continue those given to build without being
+         * wrapped into the box again.
+         */
+        void update(point_type const* positions)
+        {
+            for (std::size_t c = 0; c < tiles_.size(); ++c) {
+                for (unsigned s = 0; s < M; ++s) {
+                    std::size_t const slot = c * M + s;
+                    std::size_t const i = index_[slot];
+                    if (i == no_particle) {
+                        continue;
+                    }
+                    tiles_[c].x[s] = positions[i][0].value() - image_[slot * 3 + 0];
+                    tiles_[c].y[s] = positions[i][1].value() - image_[slot * 3 + 1];
+                    tiles_[c].z[s] = positions[i][2].value() - image_[slot * 3 + 2];
+                }
+            }
+        }
+
+        void update(std::vector<point_type> const& positions)
+        {
+            update(positions.data());
+        }
+
+        /*
+         * Computes pair interactions within cutoff using multiple threads.
+         * P has evaluate(r^2) returning the energy as value and -2 dU/d(r^2)
+         * as force_factor, like lennard_jones and tabulated_function. Forces
+         * are added to forces in the original particle order. Returns the
+         * total energy. Throws std::invalid_argument if cutoff exceeds the
+         * list radius, since the list lacks the pairs beyond it.
+         */
+        template<typename P>
+        energy_type compute(P const& potential, length_type cutoff, force_type* forces) const
+        {
+            if (!(cutoff.value() <= list_radius_)) {
+                throw std::invalid_argument("cutoff must not exceed the list radius");
+            }
+            DIM_TIMER_SCOPE("dim::cluster_pair_list::compute", particle_count_, pairs_.size() * M * M);
+            std::size_t const chunks = detail::chunk_count(pairs_.size(), 512);
+            std::vector<std::vector<T>> buffers(chunks);
+            std::vector<T> energies(chunks, T(0));
+
+            detail::parallel_chunks(
+                pairs_.size(), chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    auto& buffer = buffers[chunk];
+                    buffer.assign(tiles_.size() * 3 * M, T(0));
+                    T energy = T(0);
+                    for (std::size_t p = begin; p < end; ++p) {
+                        energy += compute_pair(potential, cutoff.value(), pairs_[p], buffer.data());
+                    }
+                    energies[chunk] = energy;
+                });
+
+            T total = T(0);
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                total += energies[chunk];
+                T const* const buffer = buffers[chunk].data();
+                for (std::size_t c = 0; c < tiles_.size(); ++c) {
+                    for (unsigned s = 0; s < M; ++s) {
+                        std::size_t const i = index_[c * M + s];
+                        if (i == no_particle) {
+                            continue;
+                        }
+                        for (unsigned k = 0; k < 3; ++k) {
+                            forces[i][k] += scalar<T, mech::force>{buffer[(c * 3 + k) * M + s]};
+                        }
+                    }
+                }
+            }
+            return energy_type{total};
+        }
+
+        template<typename P>
+        energy_type compute(P const& potential, length_type cutoff, std::vector<force_type>& forces) const
+        {
+            return compute(potential, cutoff, forces.data());
+        }
+
+      private:
+        box_type box_;
+        T list_radius_;
+        std::size_t particle_count_ = 0;
+        tile_buffer tiles_;
+        std::vector<std::size_t> index_;
+        std::vector<T> image_;
+        std::vector<std::size_t> slot_of_;
+        std::vector<cluster_pair> pairs_;
+
+        void sort_particles(point_type const* positions, std::size_t count)
+        {
+            T side[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                side[k] = box_[k].value();
+            }
+
+            // Columns are about as wide as a cluster of the mean density is
+            // tall, so clusters come out roughly cubic.
+            T const volume = side[0] * side[1] * side[2];
+            T const edge = std::cbrt(T(M) * volume / T(count == 0 ? 1 : count));
+            std::size_t columns[2];
+            for (unsigned k = 0; k < 2; ++k) {
+                columns[k] = std::size_t(side[k] / edge);
+                columns[k] = columns[k] < 1 ? 1 : columns[k];
+            }
+
+            std::vector<T> wrapped(count * 3);
+            std::vector<std::size_t> column_of(count);
+            std::vector<std::size_t> column_start(columns[0] * columns[1] + 1, 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const x = positions[i][k].value();
+                    wrapped[i * 3 + k] = x - side[k] * std::floor(x / side[k]);
+                }
+                std::size_t column = 0;
+                for (unsigned k = 0; k < 2; ++k) {
+                    std::size_t c = std::size_t(wrapped[i * 3 + k] / side[k] * T(columns[k]));
+                    c = c < columns[k] ? c : columns[k] - 1;
+                    column = column * columns[k] + c;
+                }
+                column_of[i] = column;
+                column_start[column + 1]++;
+            }
+            for (std::size_t c = 0; c + 1 < column_start.size(); ++c) {
+                column_start[c + 1] += column_start[c];
+            }
+            std::vector<std::size_t> order(count);
+            std::vector<std::size_t> fill(column_start.begin(), column_start.end() - 1);
+            for (std::size_t i = 0; i < count; ++i) {
+                order[fill[column_of[i]]++] = i;
+            }
+
+            tiles_.clear();
+            index_.clear();
+            image_.clear();
+            slot_of_.assign(count, 0);
+            for (std::size_t c = 0; c + 1 < column_start.size(); ++c) {
+                auto const first = order.begin() + std::ptrdiff_t(column_start[c]);
+                auto const last = order.begin() + std::ptrdiff_t(column_start[c + 1]);
+                std::sort(first, last, [&](std::size_t a, std::size_t b) {
+                    return wrapped[a * 3 + 2] < wrapped[b * 3 + 2];
+                });
+
+                for (auto start = first; start < last; start += std::min<std::ptrdiff_t>(M, last - start)) {
+                    tile t;
+                    std::size_t const cluster = tiles_.size();
+                    std::ptrdiff_t const members = std::min<std::ptrdiff_t>(M, last - start);
+                    for (unsigned s = 0; s < M; ++s) {
+                        // Padding slots repeat the first particle so that the
+                        // bounding box stays tight. The masks ignore them.
+                        bool const valid = std::ptrdiff_t(s) < members;
+                        std::size_t const i = valid ? start[s] : start[0];
+                        t.x[s] = wrapped[i * 3 + 0];
+                        t.y[s] = wrapped[i * 3 + 1];
+                        t.z[s] = wrapped[i * 3 + 2];
+                        index_.push_back(valid ? i : no_particle);
+                        for (unsigned k = 0; k < 3; ++k) {
+                            image_.push_back(positions[i][k].value() - wrapped[i * 3 + k]);
+                        }
+                        if (valid) {
+                            slot_of_[i] = cluster * M + s;
+                        }
+                    }
+                    tiles_.push_back(t);
+                }
+            }
+        }
+
+        void find_pairs()
+        {
+            std::size_t const clusters = tiles_.size();
+            T side[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                side[k] = box_[k].value();
+            }
+
+            // Bounding boxes, centers and the largest extent along each axis.
+            std::vector<T> lower(clusters * 3);
+            std::vector<T> upper(clusters * 3);
+            std::vector<T> center(clusters * 3);
+            T max_extent[3] = {};
+            for (std::size_t c = 0; c < clusters; ++c) {
+                T const* const coords[3] = {tiles_[c].x, tiles_[c].y, tiles_[c].z};
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const lo = *std::min_element(coords[k], coords[k] + M);
+                    T const hi = *std::max_element(coords[k], coords[k] + M);
+                    lower[c * 3 + k] = lo;
+                    upper[c * 3 + k] = hi;
+                    center[c * 3 + k] = (lo + hi) / 2;
+                    max_extent[k] = std::max(max_extent[k], hi - lo);
+                }
+            }
+
+            // Centers of listed pairs are closer than reach along each axis.
+            T reach[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                reach[k] = list_radius_ + max_extent[k];
+            }
+
+            // Lists every periodic image of cluster j whose bounding box is
+            // within the list radius of cluster i. Coordinates are wrapped
+            // into the box, so the images differ by at most one box side.
+            // A cluster paired with its own image is listed for one of the
+            // two opposite shifts only.
+            pairs_.clear();
+            T const r2_max = list_radius_ * list_radius_;
+            auto const consider = [&](std::size_t a, std::size_t b) {
+                std::size_t const i = std::min(a, b);
+                std::size_t const j = std::max(a, b);
+                T shifts[3][3];
+                T gaps[3][3];
+                unsigned counts[3];
+                for (unsigned k = 0; k < 3; ++k) {
+                    counts[k] = 0;
+                    for (int image = -1; image <= 1; ++image) {
+                        T const shift = side[k] * T(image);
+                        T const below = lower[i * 3 + k] - (upper[j * 3 + k] + shift);
+                        T const above = (lower[j * 3 + k] + shift) - upper[i * 3 + k];
+                        T const gap = std::max(T(0), std::max(below, above));
+                        if (gap * gap < r2_max) {
+                            shifts[k][counts[k]] = shift;
+                            gaps[k][counts[k]] = gap * gap;
+                            counts[k]++;
+                        }
+                    }
+                }
+                for (unsigned x = 0; x < counts[0]; ++x) {
+                    for (unsigned y = 0; y < counts[1]; ++y) {
+                        for (unsigned z = 0; z < counts[2]; ++z) {
+                            if (gaps[0][x] + gaps[1][y] + gaps[2][z] >= r2_max) {
+                                continue;
+                            }
+                            cluster_pair pair;
+                            pair.i = std::uint32_t(i);
+                            pair.j = std::uint32_t(j);
+                            pair.shift[0] = shifts[0][x];
+                            pair.shift[1] = shifts[1][y];
+                            pair.shift[2] = shifts[2][z];
+                            bool const unshifted = is_zero(pair.shift);
+                            if (i == j && !unshifted && !is_positive(pair.shift)) {
+                                continue;
+                            }
+                            if (!within_range(i, j, pair.shift)) {
+                                continue;
+                            }
+                            pair.mask = initial_mask(i, j, unshifted);
+                            if (pair.mask != 0) {
+                                pairs_.push_back(pair);
+                            }
+                        }
+                    }
+                }
+            };
+
+            // Bin cluster centers into cells no smaller than the reach. Fall
+            // back to all pairs if the box is too small for a 3x3x3 stencil.
+            std::size_t cells[3];
+            bool use_cells = true;
+            for (unsigned k = 0; k < 3; ++k) {
+                cells[k] = std::size_t(side[k] / reach[k]);
+                use_cells = use_cells && cells[k] >= 3;
+            }
+
+            if (!use_cells) {
+                for (std::size_t i = 0; i < clusters; ++i) {
+                    for (std::size_t j = i; j < clusters; ++j) {
+                        consider(i, j);
+                    }
+                }
+            } else {
+                std::size_t const total = cells[0] * cells[1] * cells[2];
+                std::vector<std::size_t> cell_of(clusters);
+                std::vector<std::size_t> cell_start(total + 1, 0);
+                for (std::size_t c = 0; c < clusters; ++c) {
+                    std::size_t index = 0;
+                    for (unsigned k = 0; k < 3; ++k) {
+                        T const frac = center[c * 3 + k] / side[k];
+                        std::size_t cell = std::size_t(frac * T(cells[k]));
+                        cell = cell < cells[k] ? cell : cells[k] - 1;
+                        index = index * cells[k] + cell;
+                    }
+                    cell_of[c] = index;
+                    cell_start[index + 1]++;
+                }
+                for (std::size_t c = 0; c < total; ++c) {
+                    cell_start[c + 1] += cell_start[c];
+                }
+                std::vector<std::size_t> members(clusters);
+                std::vector<std::size_t> fill(cell_start.begin(), cell_start.end() - 1);
+                for (std::size_t c = 0; c < clusters; ++c) {
+                    members[fill[cell_of[c]]++] = c;
+                }
+
+                for (std::size_t i = 0; i < clusters; ++i) {
+                    std::size_t const c = cell_of[i];
+                    std::size_t const cz = c % cells[2];
+                    std::size_t const cy = c / cells[2] % cells[1];
+                    std::size_t const cx = c / cells[2] / cells[1];
+                    for (std::size_t dx = 0; dx < 3; ++dx) {
+                        std::size_t const nx = (cx + cells[0] + dx - 1) % cells[0];
+                        for (std::size_t dy = 0; dy < 3; ++dy) {
+                            std::size_t const ny = (cy + cells[1] + dy - 1) % cells[1];
+                            for (std::size_t dz = 0; dz < 3; ++dz) {
+                                std::size_t const nz = (cz + cells[2] + dz - 1) % cells[2];
+                                std::size_t const n = (nx * cells[1] + ny) * cells[2] + nz;
+                                for (std::size_t m = cell_start[n]; m < cell_start[n + 1]; ++m) {
+                                    if (members[m] >= i) {
+                                        consider(i, members[m]);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::sort(pairs_.begin(), pairs_.end(), [](cluster_pair const& a, cluster_pair const& b) {
+                return a.i != b.i ? a.i < b.i : a.j < b.j;
+            });
+        }
+
+        static bool is_zero(T const* shift)
+        {
+            return shift[0] == T(0) && shift[1] == T(0) && shift[2] == T(0);
+        }
+
+        // Whether the shift is lexicographically positive.
+        static bool is_positive(T const* shift)
+        {
+            for (unsigned k = 0; k < 3; ++k) {
+                if (shift[k] != T(0)) {
+                    return shift[k] > T(0);
+                }
+            }
+            return false;
+        }
+
+        // Whether any particle of cluster i is within the list radius of a
+        // particle of the shifted cluster j. Bounding boxes alone admit many
+        // pairs of clusters that have no particle pair in range.
+        bool within_range(std::size_t i, std::size_t j, T const* shift) const
+        {
+            tile const& ti = tiles_[i];
+            tile const& tj = tiles_[j];
+            T const r2_max = list_radius_ * list_radius_;
+            for (unsigned a = 0; a < M; ++a) {
+                for (unsigned b = 0; b < M; ++b) {
+                    T const dx = ti.x[a] - tj.x[b] - shift[0];
+                    T const dy = ti.y[a] - tj.y[b] - shift[1];
+                    T const dz = ti.z[a] - tj.z[b] - shift[2];
+                    if (dx * dx + dy * dy + dz * dz < r2_max) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        // Returns the mask of valid particle pairs. Within a cluster paired
+        // with itself without a shift only the upper triangle is set.
+        mask_type initial_mask(std::size_t i, std::size_t j, bool unshifted) const
+        {
+            mask_type mask = 0;
+            for (unsigned a = 0; a < M; ++a) {
+                for (unsigned b = 0; b < M; ++b) {
+                    bool const valid = index_[i * M + a] != no_particle && index_[j * M + b] != no_particle;
+                    if (valid && (i != j || !unshifted || b > a)) {
+                        mask |= mask_type(1) << (a * M + b);
+                    }
+                }
+            }
+            return mask;
+        }
+
+        void apply_exclusions(exclusion const* exclusions, std::size_t count)
+        {
+            for (std::size_t e = 0; e < count; ++e) {
+                std::size_t slot_a = slot_of_[exclusions[e].first];
+                std::size_t slot_b = slot_of_[exclusions[e].second];
+                if (slot_a > slot_b) {
+                    std::swap(slot_a, slot_b);
+                }
+                cluster_pair key;
+                key.i = std::uint32_t(slot_a / M);
+                key.j = std::uint32_t(slot_b / M);
+                auto const range = std::equal_range(pairs_.begin(), pairs_.end(), key,
+                    [](cluster_pair const& a, cluster_pair const& b) {
+                        return a.i != b.i ? a.i < b.i : a.j < b.j;
+                    });
+                for (auto pair = range.first; pair != range.second; ++pair) {
+                    pair->mask &= ~(mask_type(1) << (slot_a % M * M + slot_b % M));
+                    if (key.i == key.j) {
+                        pair->mask &= ~(mask_type(1) << (slot_b % M * M + slot_a % M));
+                    }
+                }
+            }
+        }
+
+        // Accumulates the interactions of a cluster pair into a force buffer
+        // laid out like the tiles and returns the energy.
+        template<typename P>
+        T compute_pair(P const& potential, T cutoff, cluster_pair const& pair, T* buffer) const
+        {
+            using argument_type = scalar<T, power_dimension_t<mech::length, 2>>;
+
+            tile const& ti = tiles_[pair.i];
+            tile const& tj = tiles_[pair.j];
+            T* const fi = buffer + std::size_t(pair.i) * 3 * M;
+            T* const fj = buffer + std::size_t(pair.j) * 3 * M;
+            T const rc2 = cutoff * cutoff;
+
+            alignas(M * sizeof(T)) T xj[M];
+            alignas(M * sizeof(T)) T yj[M];
+            alignas(M * sizeof(T)) T zj[M];
+            for (unsigned b = 0; b < M; ++b) {
+                xj[b] = tj.x[b] + pair.shift[0];
+                yj[b] = tj.y[b] + pair.shift[1];
+                zj[b] = tj.z[b] + pair.shift[2];
+            }
+
+            // The M x M lanes are laid out flat and processed in separate
+            // simple passes that compilers vectorize. Masked lanes are
+            // evaluated at the cutoff and weighted by zero instead of
+            // branching. Sums are kept per lane and reduced at the end, as
+            // compilers do not vectorize sequential floating-point sums.
+            constexpr unsigned lanes = M * M;
+            alignas(M * sizeof(T)) T dx[lanes];
+            alignas(M * sizeof(T)) T dy[lanes];
+            alignas(M * sizeof(T)) T dz[lanes];
+            alignas(M * sizeof(T)) T r2[lanes];
+            alignas(M * sizeof(T)) T weight[lanes];
+            for (unsigned a = 0; a < M; ++a) {
+                for (unsigned b = 0; b < M; ++b) {
+                    unsigned const l = a * M + b;
+                    dx[l] = ti.x[a] - xj[b];
+                    dy[l] = ti.y[a] - yj[b];
+                    dz[l] = ti.z[a] - zj[b];
+                }
+            }
+            for (unsigned l = 0; l < lanes; ++l) {
+                T const distance2 = dx[l] * dx[l] + dy[l] * dy[l] + dz[l] * dz[l];
+                bool const active = (pair.mask >> l & 1u) != 0 && distance2 < rc2;
+                weight[l] = active ? T(1) : T(0);
+                r2[l] = active ? distance2 : rc2;
+            }
+
+            alignas(M * sizeof(T)) T energies[lanes];
+            for (unsigned l = 0; l < lanes; ++l) {
+                auto const sample = potential.evaluate(argument_type{r2[l]});
+                T const factor = weight[l] * sample.force_factor.value();
+                energies[l] = weight[l] * sample.value.value();
+                dx[l] *= factor;
+                dy[l] *= factor;
+                dz[l] *= factor;
+            }
+
+            alignas(M * sizeof(T)) T column_energies[M] = {};
+            for (unsigned a = 0; a < M; ++a) {
+                for (unsigned b = 0; b < M; ++b) {
+                    unsigned const l = a * M + b;
+                    column_energies[b] += energies[l];
+                    fj[b] -= dx[l];
+                    fj[M + b] -= dy[l];
+                    fj[2 * M + b] -= dz[l];
+                }
+            }
+            for (unsigned a = 0; a < M; ++a) {
+                T fx = T(0);
+                T fy = T(0);
+                T fz = T(0);
+                for (unsigned b = 0; b < M; ++b) {
+                    fx += dx[a * M + b];
+                    fy += dy[a * M + b];
+                    fz += dz[a * M + b];
+                }
+                fi[a] += fx;
+                fi[M + a] += fy;
+                fi[2 * M + a] += fz;
+            }
+
+            T energy = T(0);
+            for (unsigned b = 0; b < M; ++b) {
+                energy += column_energies[b];
+            }
+            return energy;
+        }
+    };
+
+    template<typename T, unsigned M>
+    constexpr unsigned cluster_pair_list<T, M>::cluster_size;
+
+    template<typename T, unsigned M>
+    constexpr std::size_t cluster_pair_list<T, M>::no_particle;
+} // namespace dim
+
+#endif // INCLUDED_DIM_CLUSTER_PAIR_HPP
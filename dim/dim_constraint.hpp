@@ -0,0 +1,671 @@
+/*
+ * dim - SHAKE/RATTLE and LINCS solvers for bond length constraints.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_CONSTRAINT_HPP
+#define INCLUDED_DIM_CONSTRAINT_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    /*
+     * Keeps particles i and j at a fixed distance.
+     */
+    template<typename T>
+    struct distance_constraint
+    {
+        std::uint32_t i;
+        std::uint32_t j;
+        scalar<T, mech::length> length;
+    };
+
+    enum class constraint_method
+    {
+        // Iterative SHAKE for positions and RATTLE for velocities.
+        shake,
+
+        // LINCS: a truncated matrix expansion for the coupled constraints,
+        // with a fixed cost per step.
+        lincs,
+    };
+
+    template<typename T>
+    struct constraint_parameters
+    {
+        constraint_method method = constraint_method::shake;
+
+        // SHAKE/RATTLE: relative tolerance on bond lengths and on the bond
+        // components of relative velocities.
+        T tolerance = T(1e-10);
+
+        // SHAKE/RATTLE: iteration limit per cluster.
+        unsigned max_iterations = 500;
+
+        // LINCS: number of terms of the matrix expansion. Clusters with
+        // cycles (e.g. triangles) converge slowly and get twice as many.
+        unsigned lincs_order = 4;
+
+        // LINCS: corrections for the lengthening due to rotation.
+        unsigned lincs_iterations = 1;
+    };
+
+    /*
+     * Outcome of the last constraint update.
+     */
+    template<typename T>
+    struct constraint_statistics
+    {
+        // Largest number of sweeps any cluster needed (SHAKE/RATTLE), or the
+        // fixed number of matrix expansions done (LINCS).
+        std::size_t iterations = 0;
+
+        // Clusters that did not reach the tolerance within max_iterations.
+        std::size_t unconverged = 0;
+
+        // Largest remaining relative bond length error |r - d| / d after a
+        // position update, or largest |cos| of the angle between a bond and
+        // its relative velocity after a velocity update.
+        T max_deviation = 0;
+    };
+
+    /*
+     * Enforces distance constraints on positions and velocities.
+     *
+     * Constraints are grouped into clusters, the connected components of
+     * the graph of constrained particles. Clusters do not interact, so they
+     * are solved concurrently.
+     */
+    template<typename T>
+    class constraint_solver
+    {
+      public:
+        using point_type = point<T, mech::length, 3>;
+        using velocity_type = vector<T, mech::speed, 3>;
+        using mass_type = scalar<T, mech::mass>;
+        using time_type = scalar<T, mech::time>;
+        using constraint_type = distance_constraint<T>;
+        using statistics_type = constraint_statistics<T>;
+
+        /*
+         * Throws std::invalid_argument if a constraint joins a particle to
+         * itself, has a non-positive length or refers to a particle without
+         * a mass, or if a mass is not positive.
+         */
+        constraint_solver(std::vector<constraint_type> const& constraints,
+            std::vector<mass_type> const& masses,
+            constraint_parameters<T> const& params = constraint_parameters<T>{})
+            : params_(params)
+        {
+            inverse_masses_.reserve(masses.size());
+            for (mass_type const& mass : masses) {
+                if (!(mass.value() > 0)) {
+                    throw std::invalid_argument("masses must be positive");
+                }
+                inverse_masses_.push_back(T(1) / mass.value());
+            }
+            for (constraint_type const& c : constraints) {
+                if (c.i == c.j) {
+                    throw std::invalid_argument("constraint joins a particle to itself");
+                }
+                if (c.i >= masses.size() || c.j >= masses.size()) {
+                    throw std::invalid_argument("constraint refers to a particle without mass");
+                }
+                if (!(c.length.value() > 0)) {
+                    throw std::invalid_argument("constraint length must be positive");
+                }
+            }
+            if (params.method == constraint_method::shake && params.max_iterations == 0) {
+                throw std::invalid_argument("max_iterations must be positive");
+            }
+
+            build_clusters(constraints);
+            build_coupling();
+        }
+
+        std::size_t size() const
+        {
+            return constraints_.size();
+        }
+
+        std::size_t cluster_count() const
+        {
+            return cluster_offsets_.size() - 1;
+        }
+
+        constraint_parameters<T> const& parameters() const
+        {
+            return params_;
+        }
+
+        /*
+         * Statistics of the last apply() or apply_velocities().
+         */
+        statistics_type const& statistics() const
+        {
+            return statistics_;
+        }
+
+        /*
+         * Moves positions, updated from reference positions satisfying the
+         * constraints, back onto the constraints.
+         */
+        statistics_type apply(point_type const* reference, point_type* positions)
+        {
+            return apply(reference, positions, nullptr, time_type{});
+        }
+
+        /*
+         * Same as above, and adds the constraint displacements divided by
+         * dt to the velocities (the SHAKE half of RATTLE).
+         */
+        statistics_type apply(point_type const* reference,
+            point_type* positions,
+            velocity_type* velocities,
+            time_type dt)
+        {
+            return solve([&](std::size_t cluster, statistics_type& stats) {
+                if (params_.method == constraint_method::shake) {
+                    shake(cluster, reference, positions, velocities, dt, stats);
+                } else {
+                    lincs(cluster, reference, positions, velocities, dt, stats);
+                }
+            });
+        }
+
+        statistics_type apply(std::vector<point_type> const& reference, std::vector<point_type>& positions)
+        {
+            return apply(reference.data(), positions.data());
+        }
+
+        statistics_type apply(std::vector<point_type> const& reference,
+            std::vector<point_type>& positions,
+            std::vector<velocity_type>& velocities,
+            time_type dt)
+        {
+            return apply(reference.data(), positions.data(), velocities.data(), dt);
+        }
+
+        /*
+         * Removes the components of relative velocities along the
+         * constrained bonds at positions satisfying the constraints (the
+         * second half of RATTLE).
+         */
+        statistics_type apply_velocities(point_type const* positions, velocity_type* velocities)
+        {
+            return solve([&](std::size_t cluster, statistics_type& stats) {
+                if (params_.method == constraint_method::shake) {
+                    rattle(cluster, positions, velocities, stats);
+                } else {
+                    lincs_velocities(cluster, positions, velocities, stats);
+                }
+            });
+        }
+
+        statistics_type apply_velocities(
+            std::vector<point_type> const& positions, std::vector<velocity_type>& velocities)
+        {
+            return apply_velocities(positions.data(), velocities.data());
+        }
+
+      private:
+        using inverse_mass_type = scalar<T, power_dimension_t<mech::mass, -1>>;
+
+        struct coupling
+        {
+            std::size_t constraint;
+            T coefficient;
+        };
+
+        constraint_parameters<T> params_;
+        std::vector<T> inverse_masses_;
+        std::vector<constraint_type> constraints_;
+        std::vector<std::size_t> cluster_offsets_;
+        std::vector<bool> cyclic_;
+        statistics_type statistics_;
+
+        // LINCS data: 1 / sqrt(1/m_i + 1/m_j) per constraint and the
+        // constraints sharing a particle with each constraint.
+        std::vector<T> scale_;
+        std::vector<std::size_t> coupling_offsets_;
+        std::vector<coupling> couplings_;
+
+        // Runs solve_cluster(cluster, stats) on every cluster, in parallel
+        // chunks, and merges the statistics.
+        template<typename Solve>
+        statistics_type solve(Solve solve_cluster)
+        {
+            std::size_t const clusters = cluster_count();
+            // Work is sized by constraints but split by clusters.
+            std::size_t const work_chunks = detail::chunk_count(constraints_.size(), 1024);
+            std::size_t const chunks = work_chunks < clusters ? work_chunks : clusters;
+            std::vector<statistics_type> partial(chunks);
+
+            detail::parallel_chunks(clusters, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                for (std::size_t cluster = begin; cluster < end; ++cluster) {
+                    solve_cluster(cluster, partial[chunk]);
+                }
+            });
+
+            statistics_type total;
+            for (statistics_type const& stats : partial) {
+                total.iterations = stats.iterations > total.iterations ? stats.iterations : total.iterations;
+                total.unconverged += stats.unconverged;
+                total.max_deviation = stats.max_deviation > total.max_deviation ? stats.max_deviation : total.max_deviation;
+            }
+            statistics_ = total;
+            return total;
+        }
+
+        inverse_mass_type inverse_mass(std::uint32_t particle) const
+        {
+            return inverse_mass_type{inverse_masses_[particle]};
+        }
+
+        static void record(statistics_type& stats, std::size_t iterations, bool converged, T deviation)
+        {
+            stats.iterations = iterations > stats.iterations ? iterations : stats.iterations;
+            stats.unconverged += converged ? 0 : 1;
+            stats.max_deviation = deviation > stats.max_deviation ? deviation : stats.max_deviation;
+        }
+
+        T length_deviation(std::size_t cluster, point_type const* positions) const
+        {
+            T deviation = 0;
+            for (std::size_t c = cluster_offsets_[cluster]; c < cluster_offsets_[cluster + 1]; ++c) {
+                constraint_type const& con = constraints_[c];
+                T const error = std::fabs(distance(positions[con.i], positions[con.j]) / con.length - T(1));
+                deviation = error > deviation ? error : deviation;
+            }
+            return deviation;
+        }
+
+        //------------------------------------------------------------
+        // SHAKE and RATTLE
+        //------------------------------------------------------------
+
+        void shake(std::size_t cluster,
+            point_type const* reference,
+            point_type* positions,
+            velocity_type* velocities,
+            time_type dt,
+            statistics_type& stats) const
+        {
+            std::size_t const begin = cluster_offsets_[cluster];
+            std::size_t const end = cluster_offsets_[cluster + 1];
+            T const tolerance2 = 2 * params_.tolerance;
+
+            std::size_t iteration = 0;
+            bool converged = false;
+
+            while (!converged && iteration < params_.max_iterations) {
+                converged = true;
+                iteration++;
+
+                for (std::size_t c = begin; c < end; ++c) {
+                    constraint_type const& con = constraints_[c];
+                    auto const r = positions[con.i] - positions[con.j];
+                    auto const d2 = con.length * con.length;
+                    auto const error = d2 - squared_norm(r);
+
+                    if (std::fabs(error / d2) <= tolerance2) {
+                        continue;
+                    }
+                    converged = false;
+
+                    auto const r_ref = reference[con.i] - reference[con.j];
+                    auto const mi = inverse_mass(con.i);
+                    auto const mj = inverse_mass(con.j);
+                    auto const g = error / (T(2) * (mi + mj) * dot(r_ref, r));
+
+                    positions[con.i] += mi * g * r_ref;
+                    positions[con.j] -= mj * g * r_ref;
+                    if (velocities) {
+                        velocities[con.i] += mi * g * r_ref / dt;
+                        velocities[con.j] -= mj * g * r_ref / dt;
+                    }
+                }
+            }
+
+            record(stats, iteration, converged, length_deviation(cluster, positions));
+        }
+
+        void rattle(std::size_t cluster,
+            point_type const* positions,
+            velocity_type* velocities,
+            statistics_type& stats) const
+        {
+            std::size_t const begin = cluster_offsets_[cluster];
+            std::size_t const end = cluster_offsets_[cluster + 1];
+
+            std::size_t iteration = 0;
+            bool converged = false;
+            T deviation = 0;
+
+            while (!converged && iteration < params_.max_iterations) {
+                converged = true;
+                iteration++;
+                deviation = 0;
+
+                for (std::size_t c = begin; c < end; ++c) {
+                    constraint_type const& con = constraints_[c];
+                    auto const r = positions[con.i] - positions[con.j];
+                    auto const v = velocities[con.i] - velocities[con.j];
+                    auto const rv = dot(r, v);
+                    auto const scale = norm(r) * norm(v);
+
+                    T const cosine = scale.value() > 0 ? std::fabs(rv / scale) : T(0);
+                    deviation = cosine > deviation ? cosine : deviation;
+                    if (cosine <= params_.tolerance) {
+                        continue;
+                    }
+                    converged = false;
+
+                    auto const mi = inverse_mass(con.i);
+                    auto const mj = inverse_mass(con.j);
+                    auto const k = rv / ((mi + mj) * con.length * con.length);
+
+                    velocities[con.i] -= mi * k * r;
+                    velocities[con.j] += mj * k * r;
+                }
+            }
+
+            record(stats, iteration, converged, deviation);
+        }
+
+        //------------------------------------------------------------
+        // LINCS
+        //------------------------------------------------------------
+
+        // Solves (I - A) x = rhs by x = (I + A + A^2 + ...) rhs, where A is
+        // the coupling matrix for the bond directions in directions.
+        void expand(std::size_t begin,
+            std::size_t end,
+            std::vector<vector<T, mech::number, 3>> const& directions,
+            std::vector<T>& rhs,
+            std::vector<T>& solution,
+            std::vector<T>& next,
+            unsigned terms) const
+        {
+            for (std::size_t c = begin; c < end; ++c) {
+                solution[c - begin] = rhs[c - begin];
+            }
+            for (unsigned order = 0; order < terms; ++order) {
+                for (std::size_t c = begin; c < end; ++c) {
+                    T sum = 0;
+                    for (std::size_t n = coupling_offsets_[c]; n < coupling_offsets_[c + 1]; ++n) {
+                        coupling const& link = couplings_[n];
+                        T const cosine = dot(directions[c - begin], directions[link.constraint - begin]);
+                        sum += link.coefficient * cosine * rhs[link.constraint - begin];
+                    }
+                    next[c - begin] = sum;
+                }
+                for (std::size_t c = begin; c < end; ++c) {
+                    rhs[c - begin] = next[c - begin];
+                    solution[c - begin] += next[c - begin];
+                }
+            }
+        }
+
+        template<typename P>
+        void lincs_update(std::size_t begin,
+            std::size_t end,
+            std::vector<vector<T, mech::number, 3>> const& directions,
+            std::vector<T> const& solution,
+            P* values,
+            T factor = T(1)) const
+        {
+            for (std::size_t c = begin; c < end; ++c) {
+                constraint_type const& con = constraints_[c];
+                T const amount = factor * scale_[c] * solution[c - begin];
+                T const ai = amount * inverse_masses_[con.i];
+                T const aj = amount * inverse_masses_[con.j];
+                for (unsigned k = 0; k < 3; ++k) {
+                    values[con.i][k] -= typename P::scalar_type{ai * directions[c - begin][k].value()};
+                    values[con.j][k] += typename P::scalar_type{aj * directions[c - begin][k].value()};
+                }
+            }
+        }
+
+        // Applies a LINCS correction to the positions and, if velocities is
+        // not null, the same displacement divided by dt to the velocities.
+        void update_positions(std::size_t begin,
+            std::size_t end,
+            std::vector<vector<T, mech::number, 3>> const& directions,
+            std::vector<T> const& solution,
+            point_type* positions,
+            velocity_type* velocities,
+            time_type dt) const
+        {
+            lincs_update(begin, end, directions, solution, positions);
+            if (velocities) {
+                lincs_update(begin, end, directions, solution, velocities, T(1) / dt.value());
+            }
+        }
+
+        void lincs(std::size_t cluster,
+            point_type const* reference,
+            point_type* positions,
+            velocity_type* velocities,
+            time_type dt,
+            statistics_type& stats) const
+        {
+            std::size_t const begin = cluster_offsets_[cluster];
+            std::size_t const end = cluster_offsets_[cluster + 1];
+            std::size_t const size = end - begin;
+            unsigned const terms = cyclic_[cluster] ? 2 * params_.lincs_order : params_.lincs_order;
+
+            std::vector<vector<T, mech::number, 3>> directions(size);
+            std::vector<T> rhs(size);
+            std::vector<T> solution(size);
+            std::vector<T> next(size);
+
+            for (std::size_t c = begin; c < end; ++c) {
+                constraint_type const& con = constraints_[c];
+                auto const r = reference[con.i] - reference[con.j];
+                directions[c - begin] = r / norm(r);
+            }
+
+            for (std::size_t c = begin; c < end; ++c) {
+                constraint_type const& con = constraints_[c];
+                auto const r = positions[con.i] - positions[con.j];
+                rhs[c - begin] = scale_[c] * (dot(directions[c - begin], r) - con.length).value();
+            }
+            expand(begin, end, directions, rhs, solution, next, terms);
+            update_positions(begin, end, directions, solution, positions, velocities, dt);
+
+            // Correct for the rotation of the bonds: project the bond onto
+            // its old direction at the length that makes the rotated bond
+            // as long as required.
+            for (unsigned iteration = 0; iteration < params_.lincs_iterations; ++iteration) {
+                for (std::size_t c = begin; c < end; ++c) {
+                    constraint_type const& con = constraints_[c];
+                    auto const d2 = con.length * con.length;
+                    auto const p2 = T(2) * d2 - squared_norm(positions[con.i] - positions[con.j]);
+                    auto const p = p2.value() > 0 ? sqrt(p2) : scalar<T, mech::length>{};
+                    rhs[c - begin] = scale_[c] * (con.length - p).value();
+                }
+                expand(begin, end, directions, rhs, solution, next, terms);
+                update_positions(begin, end, directions, solution, positions, velocities, dt);
+            }
+
+            record(stats, terms * (params_.lincs_iterations + 1), true,
+                length_deviation(cluster, positions));
+        }
+
+        void lincs_velocities(std::size_t cluster,
+            point_type const* positions,
+            velocity_type* velocities,
+            statistics_type& stats) const
+        {
+            std::size_t const begin = cluster_offsets_[cluster];
+            std::size_t const end = cluster_offsets_[cluster + 1];
+            std::size_t const size = end - begin;
+            unsigned const terms = cyclic_[cluster] ? 2 * params_.lincs_order : params_.lincs_order;
+
+            std::vector<vector<T, mech::number, 3>> directions(size);
+            std::vector<T> rhs(size);
+            std::vector<T> solution(size);
+            std::vector<T> next(size);
+
+            for (std::size_t c = begin; c < end; ++c) {
+                constraint_type const& con = constraints_[c];
+                auto const r = positions[con.i] - positions[con.j];
+                directions[c - begin] = r / norm(r);
+                rhs[c - begin] = scale_[c] * dot(directions[c - begin], velocities[con.i] - velocities[con.j]).value();
+            }
+            expand(begin, end, directions, rhs, solution, next, terms);
+            lincs_update(begin, end, directions, solution, velocities);
+
+            T deviation = 0;
+            for (std::size_t c = begin; c < end; ++c) {
+                constraint_type const& con = constraints_[c];
+                auto const v = velocities[con.i] - velocities[con.j];
+                auto const speed = norm(v);
+                T const cosine = speed.value() > 0 ? std::fabs(dot(directions[c - begin], v) / speed) : T(0);
+                deviation = cosine > deviation ? cosine : deviation;
+            }
+            record(stats, terms, true, deviation);
+        }
+
+        //------------------------------------------------------------
+        // Setup
+        //------------------------------------------------------------
+
+        // Sorts the constraints by connected component of the particle
+        // graph, found by union-find. A component is cyclic if it has at
+        // least as many constraints as particles.
+        void build_clusters(std::vector<constraint_type> const& constraints)
+        {
+            std::vector<std::uint32_t> parent(inverse_masses_.size());
+            for (std::uint32_t p = 0; p < parent.size(); ++p) {
+                parent[p] = p;
+            }
+            auto const find = [&](std::uint32_t p) {
+                while (parent[p] != p) {
+                    parent[p] = parent[parent[p]];
+                    p = parent[p];
+                }
+                return p;
+            };
+            for (constraint_type const& c : constraints) {
+                std::uint32_t const a = find(c.i);
+                std::uint32_t const b = find(c.j);
+                if (a != b) {
+                    parent[a < b ? b : a] = a < b ? a : b;
+                }
+            }
+
+            // Number the clusters in order of first appearance, then
+            // counting-sort the constraints.
+            std::vector<std::size_t> label(parent.size(), std::size_t(-1));
+            std::vector<std::size_t> cluster_of(constraints.size());
+            std::size_t clusters = 0;
+            for (std::size_t c = 0; c < constraints.size(); ++c) {
+                std::uint32_t const root = find(constraints[c].i);
+                if (label[root] == std::size_t(-1)) {
+                    label[root] = clusters++;
+                }
+                cluster_of[c] = label[root];
+            }
+
+            std::vector<std::size_t> members(clusters, 0);
+            std::vector<bool> counted(parent.size(), false);
+            for (constraint_type const& c : constraints) {
+                for (std::uint32_t const p : {c.i, c.j}) {
+                    if (!counted[p]) {
+                        counted[p] = true;
+                        members[label[find(p)]]++;
+                    }
+                }
+            }
+
+            cluster_offsets_.assign(clusters + 1, 0);
+            for (std::size_t const cluster : cluster_of) {
+                cluster_offsets_[cluster + 1]++;
+            }
+            cyclic_.assign(clusters, false);
+            for (std::size_t k = 0; k < clusters; ++k) {
+                cyclic_[k] = cluster_offsets_[k + 1] >= members[k];
+                cluster_offsets_[k + 1] += cluster_offsets_[k];
+            }
+            constraints_.resize(constraints.size());
+            std::vector<std::size_t> fill(cluster_offsets_.begin(), cluster_offsets_.end() - 1);
+            for (std::size_t c = 0; c < constraints.size(); ++c) {
+                constraints_[fill[cluster_of[c]]++] = constraints[c];
+            }
+        }
+
+        // Precomputes the mass factors of the LINCS coupling matrix. For
+        // constraints c and c' sharing particle a, the element is
+        // -s * S_c S_c' / m_a times the cosine between the bonds, where s is
+        // +1 if a is the same end (i or j) of both constraints and -1
+        // otherwise.
+        void build_coupling()
+        {
+            scale_.resize(constraints_.size());
+            std::vector<std::vector<std::size_t>> touching(inverse_masses_.size());
+            for (std::size_t c = 0; c < constraints_.size(); ++c) {
+                constraint_type const& con = constraints_[c];
+                scale_[c] = T(1) / std::sqrt(inverse_masses_[con.i] + inverse_masses_[con.j]);
+                touching[con.i].push_back(c);
+                touching[con.j].push_back(c);
+            }
+
+            coupling_offsets_.assign(1, 0);
+            couplings_.clear();
+            for (std::size_t c = 0; c < constraints_.size(); ++c) {
+                constraint_type const& con = constraints_[c];
+                std::uint32_t const ends[2] = {con.i, con.j};
+                for (unsigned e = 0; e < 2; ++e) {
+                    std::uint32_t const shared = ends[e];
+                    for (std::size_t const other : touching[shared]) {
+                        if (other == c) {
+                            continue;
+                        }
+                        bool const same_end = (constraints_[other].i == shared) == (e == 0);
+                        T const sign = same_end ? T(1) : T(-1);
+                        couplings_.push_back(
+                            coupling{other, -sign * scale_[c] * scale_[other] * inverse_masses_[shared]});
+                    }
+                }
+                coupling_offsets_.push_back(couplings_.size());
+            }
+        }
+    };
+} // namespace dim
+
+#endif // INCLUDED_DIM_CONSTRAINT_HPP
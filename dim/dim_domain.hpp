@@ -0,0 +1,831 @@
+/*
+ * dim - Spatial domain decomposition with halo exchange over a pluggable transport.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_DOMAIN_HPP
+#define INCLUDED_DIM_DOMAIN_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dim.hpp"
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Transport
+    //----------------------------------------------------------------
+
+    /*
+     * Point-to-point message transport between the ranks of a domain
+     * decomposition. send() does not block and receive() blocks until a
+     * message with the given source and tag arrives. Messages with the same
+     * source, destination and tag are received in the order sent. A rank may
+     * send messages to itself.
+     *
+     * Derive from this class to plug in another backend such as MPI.
+     */
+    class transport
+    {
+      public:
+        using message = std::vector<unsigned char>;
+
+        // Tag reserved for the default all_gather implementation.
+        static constexpr int gather_tag = -1;
+
+        virtual ~transport() = default;
+
+        virtual int rank() const = 0;
+        virtual int size() const = 0;
+        virtual void send(int destination, int tag, message data) = 0;
+        virtual message receive(int source, int tag) = 0;
+
+        /*
+         * Collects a value from every rank. Returns the values indexed by
+         * rank. The default implementation exchanges point-to-point messages.
+         */
+        virtual std::vector<double> all_gather(double value)
+        {
+            message data(sizeof value);
+            std::memcpy(data.data(), &value, sizeof value);
+
+            for (int peer = 0; peer < size(); ++peer) {
+                if (peer != rank()) {
+                    send(peer, gather_tag, data);
+                }
+            }
+
+            std::vector<double> values(static_cast<std::size_t>(size()));
+            values[std::size_t(rank())] = value;
+
+            for (int peer = 0; peer < size(); ++peer) {
+                if (peer != rank()) {
+                    message const received = receive(peer, gather_tag);
+                    std::memcpy(&values[std::size_t(peer)], received.data(), sizeof value);
+                }
+            }
+            return values;
+        }
+    };
+
+    /*
+     * Mailboxes shared by the ranks of a shared_memory_transport. The ranks
+     * are threads of one process.
+     */
+    class shared_memory_hub
+    {
+      public:
+        explicit shared_memory_hub(int size)
+            : size_{size}
+        {
+            if (size <= 0) {
+                throw std::invalid_argument("number of ranks must be positive");
+            }
+            boxes_.reset(new mailbox[std::size_t(size)]);
+        }
+
+        shared_memory_hub(shared_memory_hub const&) = delete;
+        shared_memory_hub& operator=(shared_memory_hub const&) = delete;
+
+        int size() const
+        {
+            return size_;
+        }
+
+        /*
+         * Wakes up all blocked receivers and makes every subsequent receive
+         * on an empty queue throw std::runtime_error. Used to unwind the
+         * other ranks when one rank fails.
+         */
+        void abort()
+        {
+            aborted_ = true;
+            for (int rank = 0; rank < size_; ++rank) {
+                std::lock_guard<std::mutex> lock{boxes_[rank].mutex};
+                boxes_[rank].arrived.notify_all();
+            }
+        }
+
+      private:
+        friend class shared_memory_transport;
+
+        struct mailbox
+        {
+            std::mutex mutex;
+            std::condition_variable arrived;
+            std::map<std::pair<int, int>, std::deque<transport::message>> queues;
+        };
+
+        void post(int source, int destination, int tag, transport::message data)
+        {
+            mailbox& box = boxes_[destination];
+            {
+                std::lock_guard<std::mutex> lock{box.mutex};
+                box.queues[std::make_pair(source, tag)].push_back(std::move(data));
+            }
+            box.arrived.notify_all();
+        }
+
+        transport::message take(int source, int destination, int tag)
+        {
+            mailbox& box = boxes_[destination];
+            std::unique_lock<std::mutex> lock{box.mutex};
+            std::deque<transport::message>& queue = box.queues[std::make_pair(source, tag)];
+            box.arrived.wait(lock, [&] { return !queue.empty() || aborted_; });
+            if (queue.empty()) {
+                throw std::runtime_error("transport aborted");
+            }
+            transport::message data = std::move(queue.front());
+            queue.pop_front();
+            return data;
+        }
+
+        int size_;
+        std::unique_ptr<mailbox[]> boxes_;
+        std::atomic<bool> aborted_{false};
+    };
+
+    /*
+     * Transport between threads of one process. Each rank holds its own
+     * shared_memory_transport on a common shared_memory_hub.
+     */
+    class shared_memory_transport : public transport
+    {
+      public:
+        shared_memory_transport(shared_memory_hub& hub, int rank)
+            : hub_(hub)
+            , rank_{rank}
+        {
+            if (rank < 0 || rank >= hub.size()) {
+                throw std::invalid_argument("rank out of range");
+            }
+        }
+
+        int rank() const override
+        {
+            return rank_;
+        }
+
+        int size() const override
+        {
+            return hub_.size();
+        }
+
+        void send(int destination, int tag, message data) override
+        {
+            hub_.post(rank_, destination, tag, std::move(data));
+        }
+
+        message receive(int source, int tag) override
+        {
+            return hub_.take(source, rank_, tag);
+        }
+
+      private:
+        shared_memory_hub& hub_;
+        int rank_;
+    };
+
+    /*
+     * Runs fn(transport&) on size threads connected by a shared-memory
+     * transport and waits for all of them. If any rank throws, the others
+     * are unblocked and the first exception is rethrown.
+     */
+    template<typename Fn>
+    void run_shared_memory(int size, Fn fn)
+    {
+        shared_memory_hub hub{size};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto work = [&](int rank) {
+            try {
+                shared_memory_transport comm{hub, rank};
+                fn(static_cast<transport&>(comm));
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock{error_mutex};
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                hub.abort();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int rank = 1; rank < size; ++rank) {
+            workers.emplace_back(work, rank);
+        }
+        work(0);
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Domain decomposition
+    //----------------------------------------------------------------
+
+    namespace detail // for dim::domain_decomposition
+    {
+        // Tag bases of the exchanges. Each exchange uses six tags, one per
+        // axis and direction.
+        constexpr int halo_tag = 0;
+        constexpr int forward_tag = 8;
+        constexpr int reverse_tag = 16;
+        constexpr int migrate_tag = 24;
+
+        template<typename F, typename Access>
+        transport::message pack(std::vector<std::size_t> const& indices, Access at)
+        {
+            transport::message data(indices.size() * sizeof(F));
+            unsigned char* out = data.data();
+            for (std::size_t const index : indices) {
+                F const& value = at(index);
+                std::memcpy(out, &value, sizeof(F));
+                out += sizeof(F);
+            }
+            return data;
+        }
+
+        template<typename F>
+        std::size_t unpacked_count(transport::message const& data)
+        {
+            if (data.size() % sizeof(F) != 0) {
+                throw std::runtime_error("malformed halo message");
+            }
+            return data.size() / sizeof(F);
+        }
+    }
+
+    /*
+     * Parameters of a domain decomposition of an orthorhombic periodic box
+     * into grid[0] x grid[1] x grid[2] rectangular domains.
+     */
+    template<typename T>
+    struct decomposition_parameters
+    {
+        // Side lengths of the periodic box.
+        vector<T, mech::length, 3> box;
+
+        // Number of domains along each axis. The product must equal the
+        // number of ranks of the transport.
+        unsigned grid[3];
+
+        // Width of the ghost layer: the interaction cutoff plus any
+        // neighbor list buffer. Domains are kept at least this wide.
+        scalar<T, mech::length> halo_width;
+    };
+
+    /*
+     * One rank's share of a spatially decomposed particle system. Rank r
+     * owns the domain at grid coordinates (x, y, z) with r = (x * grid[1] +
+     * y) * grid[2] + z. Domain boundaries along each axis are shared by all
+     * domains of a slab, so the decomposition stays a rectilinear grid when
+     * it is load balanced.
+     *
+     * Particle is a trivially copyable record with a member position of type
+     * point<T, mech::length, 3>. Positions are kept wrapped into the box.
+     * Ghosts are copies of the particles of this and neighboring domains,
+     * including periodic images, lying within halo_width of the domain. They
+     * are found by exchanging layers with the two face neighbors along x,
+     * then y, then z, so edge and corner ghosts take two or three hops.
+     *
+     * All member functions that communicate are collective: every rank must
+     * call them in the same order.
+     */
+    template<typename T, typename Particle>
+    class domain_decomposition
+    {
+      public:
+        using particle_type = Particle;
+        using point_type = point<T, mech::length, 3>;
+        using time_type = scalar<double, mech::time>;
+
+        static_assert(std::is_trivially_copyable<Particle>::value,
+            "particles must be trivially copyable");
+        static_assert(std::is_same<decltype(std::declval<Particle&>().position), point_type>::value,
+            "particles must have a position member of type point<T, mech::length, 3>");
+
+        /*
+         * Creates evenly spaced domains. Throws std::invalid_argument if the
+         * grid does not match the number of ranks or a domain would be
+         * narrower than the halo width.
+         */
+        domain_decomposition(transport& comm, decomposition_parameters<T> const& params)
+            : comm_(comm)
+            , halo_{params.halo_width.value()}
+        {
+            if (!(halo_ > 0)) {
+                throw std::invalid_argument("halo width must be positive");
+            }
+
+            long domains = 1;
+            for (unsigned k = 0; k < 3; ++k) {
+                if (params.grid[k] == 0) {
+                    throw std::invalid_argument("grid must have at least one domain along each axis");
+                }
+                domains *= long(params.grid[k]);
+            }
+            if (domains != long(comm.size())) {
+                throw std::invalid_argument("grid does not match the number of ranks");
+            }
+
+            unsigned rest = unsigned(comm.rank());
+            for (unsigned k = 3; k-- > 0;) {
+                grid_[k] = params.grid[k];
+                coord_[k] = rest % grid_[k];
+                rest /= grid_[k];
+            }
+
+            for (unsigned k = 0; k < 3; ++k) {
+                box_[k] = params.box[k].value();
+                if (!(box_[k] / T(grid_[k]) >= halo_)) {
+                    throw std::invalid_argument("domains must not be narrower than the halo width");
+                }
+                cuts_[k].resize(grid_[k] + 1);
+                for (unsigned s = 0; s <= grid_[k]; ++s) {
+                    cuts_[k][s] = box_[k] * T(s) / T(grid_[k]);
+                }
+                cuts_[k][grid_[k]] = box_[k];
+            }
+        }
+
+        transport& comm() const
+        {
+            return comm_;
+        }
+
+        /*
+         * Lower and upper corners of this rank's domain.
+         */
+        point_type lower() const
+        {
+            return corner(0);
+        }
+
+        point_type upper() const
+        {
+            return corner(1);
+        }
+
+        /*
+         * Boundaries of the slabs along an axis: grid[axis] + 1 coordinates
+         * from zero to the box side.
+         */
+        std::vector<T> const& boundaries(unsigned axis) const
+        {
+            return cuts_[axis];
+        }
+
+        /*
+         * Particles owned by this rank. Positions may be modified between
+         * calls to migrate().
+         */
+        std::vector<Particle>& particles()
+        {
+            return owned_;
+        }
+
+        std::vector<Particle> const& particles() const
+        {
+            return owned_;
+        }
+
+        /*
+         * Ghost particles found by the last exchange_halo().
+         */
+        std::vector<Particle> const& ghosts() const
+        {
+            return ghosts_;
+        }
+
+        /*
+         * Keeps the particles of a global array lying in this rank's domain.
+         * Every rank is given the same array.
+         */
+        void distribute(std::vector<Particle> const& all)
+        {
+            owned_.clear();
+            ghosts_.clear();
+            for (Particle particle : all) {
+                bool mine = true;
+                for (unsigned k = 0; k < 3 && mine; ++k) {
+                    T const x = wrap(k, particle.position[k].value());
+                    particle.position[k] = scalar<T, mech::length>{x};
+                    mine = locate(k, x) == coord_[k];
+                }
+                if (mine) {
+                    owned_.push_back(particle);
+                }
+            }
+        }
+
+        /*
+         * Hands particles that left the domain over to their new owners and
+         * discards the ghosts. A particle may move into a neighboring domain
+         * (or across the periodic boundary) but no farther; otherwise
+         * std::runtime_error is thrown.
+         */
+        void migrate()
+        {
+            ghosts_.clear();
+
+            for (unsigned k = 0; k < 3; ++k) {
+                std::vector<Particle> staying;
+                std::vector<Particle> leaving[2];
+
+                for (Particle particle : owned_) {
+                    T const x = wrap(k, particle.position[k].value());
+                    particle.position[k] = scalar<T, mech::length>{x};
+
+                    unsigned const slab = locate(k, x);
+                    if (slab == coord_[k]) {
+                        staying.push_back(particle);
+                    } else if (slab == step(k, -1)) {
+                        leaving[0].push_back(particle);
+                    } else if (slab == step(k, +1)) {
+                        leaving[1].push_back(particle);
+                    } else {
+                        throw std::runtime_error("particle moved farther than a neighboring domain");
+                    }
+                }
+
+                for (int dir = 0; dir < 2; ++dir) {
+                    transport::message data(leaving[dir].size() * sizeof(Particle));
+                    if (!data.empty()) {
+                        std::memcpy(data.data(), leaving[dir].data(), data.size());
+                    }
+                    comm_.send(neighbor(k, dir), detail::migrate_tag + int(2 * k) + dir, std::move(data));
+                }
+                for (int dir = 0; dir < 2; ++dir) {
+                    transport::message const data =
+                        comm_.receive(neighbor(k, 1 - dir), detail::migrate_tag + int(2 * k) + dir);
+                    std::size_t const count = detail::unpacked_count<Particle>(data);
+                    std::size_t const offset = staying.size();
+                    staying.resize(offset + count);
+                    if (count > 0) {
+                        std::memcpy(&staying[offset], data.data(), data.size());
+                    }
+                }
+                owned_.swap(staying);
+            }
+        }
+
+        /*
+         * Rebuilds the ghosts from the current particle positions and
+         * records the exchange pattern reused by refresh_ghosts(),
+         * update_halo() and reduce_halo().
+         */
+        void exchange_halo()
+        {
+            ghosts_.clear();
+
+            for (unsigned k = 0; k < 3; ++k) {
+                std::size_t const candidates = owned_.size() + ghosts_.size();
+                T const low = cuts_[k][coord_[k]] + halo_;
+                T const high = cuts_[k][coord_[k] + 1] - halo_;
+
+                for (int dir = 0; dir < 2; ++dir) {
+                    layer& out = plan_[k][dir];
+                    out.indices.clear();
+                    out.shift = shift(k, dir);
+
+                    for (std::size_t i = 0; i < candidates; ++i) {
+                        T const x = entry(i).position[k].value();
+                        if (dir == 0 ? x < low : x >= high) {
+                            out.indices.push_back(i);
+                        }
+                    }
+
+                    transport::message data = detail::pack<Particle>(out.indices,
+                        [this](std::size_t i) -> Particle const& { return entry(i); });
+                    shift_positions(data, k, out.shift);
+                    comm_.send(neighbor(k, dir), detail::halo_tag + int(2 * k) + dir, std::move(data));
+                }
+
+                for (int dir = 0; dir < 2; ++dir) {
+                    transport::message const data =
+                        comm_.receive(neighbor(k, 1 - dir), detail::halo_tag + int(2 * k) + dir);
+                    std::size_t const count = detail::unpacked_count<Particle>(data);
+                    layer& in = plan_[k][dir];
+                    in.first = owned_.size() + ghosts_.size();
+                    in.count = count;
+                    ghosts_.resize(ghosts_.size() + count);
+                    if (count > 0) {
+                        std::memcpy(&ghosts_[in.first - owned_.size()], data.data(), data.size());
+                    }
+                }
+            }
+        }
+
+        /*
+         * Copies the owned particles again into the ghosts made by the last
+         * exchange_halo(), keeping the ghost set. Use this between
+         * neighbor list rebuilds after moving particles by less than the
+         * halo buffer.
+         */
+        void refresh_ghosts()
+        {
+            forward<Particle>(
+                [this](std::size_t i) -> Particle& { return entry(i); },
+                [this](transport::message& data, unsigned k, T shift) {
+                    shift_positions(data, k, shift);
+                });
+        }
+
+        /*
+         * Fills the ghost part of a per-particle array. values holds one
+         * entry per owned particle followed (after the call) by one entry
+         * per ghost in the order of ghosts(). F is a trivially copyable
+         * type such as a dimensioned scalar or vector.
+         */
+        template<typename F>
+        void update_halo(std::vector<F>& values)
+        {
+            static_assert(std::is_trivially_copyable<F>::value, "halo values must be trivially copyable");
+            check_size(values.size());
+            values.resize(owned_.size() + ghosts_.size());
+            forward<F>(
+                [&values](std::size_t i) -> F& { return values[i]; },
+                [](transport::message&, unsigned, T) {});
+        }
+
+        /*
+         * Adds the ghost entries of a per-particle array, laid out as in
+         * update_halo(), into the entries of the particles they were copied
+         * from. This is the reverse of update_halo() and collects forces
+         * computed on ghosts when each pair is evaluated on one rank only.
+         * The ghost entries are left unspecified.
+         */
+        template<typename F>
+        void reduce_halo(std::vector<F>& values)
+        {
+            static_assert(std::is_trivially_copyable<F>::value, "halo values must be trivially copyable");
+            if (values.size() != owned_.size() + ghosts_.size()) {
+                throw std::invalid_argument("array does not match the particles and ghosts");
+            }
+
+            for (unsigned k = 3; k-- > 0;) {
+                for (int dir = 0; dir < 2; ++dir) {
+                    layer const& in = plan_[k][dir];
+                    transport::message data(in.count * sizeof(F));
+                    if (in.count > 0) {
+                        std::memcpy(data.data(), &values[in.first], data.size());
+                    }
+                    comm_.send(neighbor(k, 1 - dir), detail::reverse_tag + int(2 * k) + dir, std::move(data));
+                }
+                for (int dir = 0; dir < 2; ++dir) {
+                    layer const& out = plan_[k][dir];
+                    transport::message const data =
+                        comm_.receive(neighbor(k, dir), detail::reverse_tag + int(2 * k) + dir);
+                    if (detail::unpacked_count<F>(data) != out.indices.size()) {
+                        throw std::runtime_error("halo exchange out of step");
+                    }
+                    unsigned char const* in = data.data();
+                    for (std::size_t const index : out.indices) {
+                        F contribution;
+                        std::memcpy(&contribution, in, sizeof(F));
+                        values[index] += contribution;
+                        in += sizeof(F);
+                    }
+                }
+            }
+        }
+
+        /*
+         * Moves the domain boundaries so that the time spent per slab is
+         * evened out, given the time this rank spent on its domain since the
+         * last call, and then migrates the particles. The cost is assumed
+         * to be spread uniformly within each slab, and each boundary goes
+         * halfway to its balanced position, so repeated calls converge
+         * without oscillating. A boundary moves by less than half the width
+         * of its adjacent slabs and never makes a slab narrower than the
+         * halo width.
+         */
+        void balance(time_type elapsed)
+        {
+            std::vector<double> const times = comm_.all_gather(elapsed.value());
+
+            for (unsigned k = 0; k < 3; ++k) {
+                unsigned const slabs = grid_[k];
+                if (slabs == 1) {
+                    continue;
+                }
+
+                std::vector<double> load(slabs, 0.0);
+                for (std::size_t rank = 0; rank < times.size(); ++rank) {
+                    load[slab_of(unsigned(rank), k)] += times[rank];
+                }
+                double total = 0;
+                for (double const l : load) {
+                    total += l;
+                }
+                if (!(total > 0)) {
+                    continue;
+                }
+
+                std::vector<T> const old = cuts_[k];
+                unsigned slab = 0;
+                double before = 0;
+
+                for (unsigned s = 1; s < slabs; ++s) {
+                    double const target = total * s / slabs;
+                    while (slab + 1 < slabs && before + load[slab] < target) {
+                        before += load[slab];
+                        slab++;
+                    }
+                    double const fraction = load[slab] > 0
+                        ? std::min(1.0, std::max(0.0, (target - before) / load[slab]))
+                        : 0.0;
+                    T const balanced = old[slab] + T(fraction) * (old[slab + 1] - old[slab]);
+
+                    T const room = std::max(T(0),
+                        (std::min(old[s] - old[s - 1], old[s + 1] - old[s]) - halo_) / 2);
+                    T const move = std::max(-room, std::min(room, (balanced - old[s]) / 2));
+                    cuts_[k][s] = old[s] + move;
+                }
+            }
+
+            migrate();
+        }
+
+      private:
+        struct layer
+        {
+            // Sent: indices into the owned particles followed by the ghosts.
+            std::vector<std::size_t> indices;
+            T shift = 0;
+
+            // Received: range of the ghosts in the same index space.
+            std::size_t first = 0;
+            std::size_t count = 0;
+        };
+
+        Particle& entry(std::size_t i)
+        {
+            return i < owned_.size() ? owned_[i] : ghosts_[i - owned_.size()];
+        }
+
+        point_type corner(unsigned side) const
+        {
+            point_type p;
+            for (unsigned k = 0; k < 3; ++k) {
+                p[k] = scalar<T, mech::length>{cuts_[k][coord_[k] + side]};
+            }
+            return p;
+        }
+
+        T wrap(unsigned k, T x) const
+        {
+            x -= box_[k] * std::floor(x / box_[k]);
+            return x < box_[k] ? x : T(0);
+        }
+
+        unsigned locate(unsigned k, T x) const
+        {
+            auto const upper = std::upper_bound(cuts_[k].begin() + 1, cuts_[k].end() - 1, x);
+            return unsigned(upper - cuts_[k].begin()) - 1;
+        }
+
+        unsigned step(unsigned k, int direction) const
+        {
+            return (coord_[k] + (direction < 0 ? grid_[k] - 1 : 1)) % grid_[k];
+        }
+
+        // Rank of the neighbor below (dir 0) or above (dir 1) along axis k.
+        int neighbor(unsigned k, int dir) const
+        {
+            unsigned coord[3] = {coord_[0], coord_[1], coord_[2]};
+            coord[k] = step(k, dir == 0 ? -1 : +1);
+            return int((coord[0] * grid_[1] + coord[1]) * grid_[2] + coord[2]);
+        }
+
+        unsigned slab_of(unsigned rank, unsigned k) const
+        {
+            unsigned const inner = k == 0 ? grid_[1] * grid_[2] : k == 1 ? grid_[2] : 1;
+            return rank / inner % grid_[k];
+        }
+
+        // Offset added to positions sent across the periodic boundary.
+        T shift(unsigned k, int dir) const
+        {
+            if (dir == 0) {
+                return coord_[k] == 0 ? box_[k] : T(0);
+            }
+            return coord_[k] == grid_[k] - 1 ? -box_[k] : T(0);
+        }
+
+        static void shift_positions(transport::message& data, unsigned k, T shift)
+        {
+            if (shift == T(0)) {
+                return;
+            }
+            for (std::size_t offset = 0; offset < data.size(); offset += sizeof(Particle)) {
+                Particle particle;
+                std::memcpy(&particle, &data[offset], sizeof(Particle));
+                particle.position[k] += scalar<T, mech::length>{shift};
+                std::memcpy(&data[offset], &particle, sizeof(Particle));
+            }
+        }
+
+        void check_size(std::size_t size) const
+        {
+            if (size < owned_.size()) {
+                throw std::invalid_argument("array is shorter than the owned particles");
+            }
+        }
+
+        // Sends the entries listed in the exchange plan and overwrites the
+        // ghost entries with the received copies.
+        template<typename F, typename Access, typename Adjust>
+        void forward(Access at, Adjust adjust)
+        {
+            for (unsigned k = 0; k < 3; ++k) {
+                for (int dir = 0; dir < 2; ++dir) {
+                    layer const& out = plan_[k][dir];
+                    transport::message data = detail::pack<F>(out.indices, at);
+                    adjust(data, k, out.shift);
+                    comm_.send(neighbor(k, dir), detail::forward_tag + int(2 * k) + dir, std::move(data));
+                }
+                for (int dir = 0; dir < 2; ++dir) {
+                    layer const& in = plan_[k][dir];
+                    transport::message const data =
+                        comm_.receive(neighbor(k, 1 - dir), detail::forward_tag + int(2 * k) + dir);
+                    if (detail::unpacked_count<F>(data) != in.count) {
+                        throw std::runtime_error("halo exchange out of step");
+                    }
+                    for (std::size_t i = 0; i < in.count; ++i) {
+                        std::memcpy(&at(in.first + i), &data[i * sizeof(F)], sizeof(F));
+                    }
+                }
+            }
+        }
+
+        transport& comm_;
+        T halo_;
+        T box_[3];
+        unsigned grid_[3];
+        unsigned coord_[3];
+        std::vector<T> cuts_[3];
+        std::vector<Particle> owned_;
+        std::vector<Particle> ghosts_;
+        layer plan_[3][2];
+    };
+
+    /*
+     * Creates the domain of the calling rank.
+     */
+    template<typename Particle, typename T>
+    domain_decomposition<T, Particle> make_domain_decomposition(
+        transport& comm, decomposition_parameters<T> const& params)
+    {
+        return domain_decomposition<T, Particle>(comm, params);
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_DOMAIN_HPP
@@ -0,0 +1,449 @@
+/*
+ * dim - Forward-mode automatic differentiation.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_DUAL_HPP
+#define INCLUDED_DIM_DUAL_HPP
+
+#include <cmath>
+#include <utility>
+
+#include "dim.hpp"
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Dual number
+    //----------------------------------------------------------------
+
+    /*
+     * Dual number carrying a value and its partial derivatives with respect
+     * to N independent variables (lanes). Usable as T in dim::scalar<T, D>,
+     * dim::vector<T, D, N> and dim::point<T, D, N>, so that evaluating an
+     * energy function once yields all N components of its gradient.
+     */
+    template<typename T, unsigned N = 1>
+    class dual
+    {
+      public:
+        using value_type = T;
+        static constexpr unsigned lanes = N;
+
+        dual() = default;
+
+        // Constant with zero derivatives.
+        dual(T value) // NOLINT
+            : value_{value}
+        {
+        }
+
+        // Independent variable whose derivative is one in the given lane.
+        static dual variable(T value, unsigned lane)
+        {
+            dual result{value};
+            result.derivatives_[lane] = 1;
+            return result;
+        }
+
+        T value() const
+        {
+            return value_;
+        }
+
+        T& derivative(unsigned lane)
+        {
+            return derivatives_[lane];
+        }
+
+        T derivative(unsigned lane) const
+        {
+            return derivatives_[lane];
+        }
+
+        explicit operator T() const
+        {
+            return value_;
+        }
+
+        dual& operator+=(dual const& rhs)
+        {
+            value_ += rhs.value_;
+            for (unsigned i = 0; i < N; ++i) {
+                derivatives_[i] += rhs.derivatives_[i];
+            }
+            return *this;
+        }
+
+        dual& operator-=(dual const& rhs)
+        {
+            value_ -= rhs.value_;
+            for (unsigned i = 0; i < N; ++i) {
+                derivatives_[i] -= rhs.derivatives_[i];
+            }
+            return *this;
+        }
+
+        dual& operator*=(dual const& rhs)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                derivatives_[i] = derivatives_[i] * rhs.value_ + value_ * rhs.derivatives_[i];
+            }
+            value_ *= rhs.value_;
+            return *this;
+        }
+
+        dual& operator/=(dual const& rhs)
+        {
+            T const inv = 1 / rhs.value_;
+            value_ *= inv;
+            for (unsigned i = 0; i < N; ++i) {
+                derivatives_[i] = (derivatives_[i] - value_ * rhs.derivatives_[i]) * inv;
+            }
+            return *this;
+        }
+
+        // Applies the chain rule for an elementary function whose value and
+        // derivative at value() are given.
+        dual chain(T value, T slope) const
+        {
+            dual result{value};
+            for (unsigned i = 0; i < N; ++i) {
+                result.derivatives_[i] = slope * derivatives_[i];
+            }
+            return result;
+        }
+
+      private:
+        T value_{};
+        T derivatives_[N]{};
+    };
+
+    template<typename T, unsigned N>
+    dual<T, N> operator+(dual<T, N> const& x)
+    {
+        return x;
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator-(dual<T, N> const& x)
+    {
+        return x.chain(-x.value(), -1);
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator+(dual<T, N> x, dual<T, N> const& y)
+    {
+        return x += y;
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator-(dual<T, N> x, dual<T, N> const& y)
+    {
+        return x -= y;
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator*(dual<T, N> x, dual<T, N> const& y)
+    {
+        return x *= y;
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator/(dual<T, N> x, dual<T, N> const& y)
+    {
+        return x /= y;
+    }
+
+    // Mixed operations with plain numbers. The number parameter is not
+    // deduced, so that literals of any arithmetic type are accepted.
+
+    template<typename T, unsigned N>
+    dual<T, N> operator+(dual<T, N> x, typename dual<T, N>::value_type y)
+    {
+        return x += dual<T, N>{y};
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator+(typename dual<T, N>::value_type x, dual<T, N> y)
+    {
+        return y += dual<T, N>{x};
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator-(dual<T, N> x, typename dual<T, N>::value_type y)
+    {
+        return x -= dual<T, N>{y};
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator-(typename dual<T, N>::value_type x, dual<T, N> const& y)
+    {
+        return dual<T, N>{x} -= y;
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator*(dual<T, N> const& x, typename dual<T, N>::value_type y)
+    {
+        return x.chain(x.value() * y, y);
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator*(typename dual<T, N>::value_type x, dual<T, N> const& y)
+    {
+        return y.chain(x * y.value(), x);
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator/(dual<T, N> const& x, typename dual<T, N>::value_type y)
+    {
+        return x.chain(x.value() / y, 1 / y);
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> operator/(typename dual<T, N>::value_type x, dual<T, N> const& y)
+    {
+        return dual<T, N>{x} /= y;
+    }
+
+    // Comparison looks only at values.
+
+    template<typename T, unsigned N>
+    bool operator==(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        return x.value() == y.value();
+    }
+
+    template<typename T, unsigned N>
+    bool operator!=(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        return x.value() != y.value();
+    }
+
+    template<typename T, unsigned N>
+    bool operator<(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        return x.value() < y.value();
+    }
+
+    template<typename T, unsigned N>
+    bool operator>(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        return x.value() > y.value();
+    }
+
+    template<typename T, unsigned N>
+    bool operator<=(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        return x.value() <= y.value();
+    }
+
+    template<typename T, unsigned N>
+    bool operator>=(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        return x.value() >= y.value();
+    }
+
+    // Math functions found by argument-dependent lookup from dim.hpp, so
+    // that dim::sqrt, dim::pow, dim::hypot and others propagate derivatives.
+
+    template<typename T, unsigned N>
+    dual<T, N> fabs(dual<T, N> const& x)
+    {
+        return x.chain(std::fabs(x.value()), x.value() < 0 ? T(-1) : T(1));
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> sqrt(dual<T, N> const& x)
+    {
+        T const root = std::sqrt(x.value());
+        return x.chain(root, 1 / (2 * root));
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> cbrt(dual<T, N> const& x)
+    {
+        T const root = std::cbrt(x.value());
+        return x.chain(root, 1 / (3 * root * root));
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> hypot(dual<T, N> const& x, dual<T, N> const& y)
+    {
+        T const norm = std::hypot(x.value(), y.value());
+        dual<T, N> result = x.chain(norm, x.value() / norm);
+        for (unsigned i = 0; i < N; ++i) {
+            result.derivative(i) += y.value() / norm * y.derivative(i);
+        }
+        return result;
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> pow(dual<T, N> const& x, int n)
+    {
+        if (n == 0) {
+            return dual<T, N>{1};
+        }
+        T const lower = std::pow(x.value(), n - 1);
+        return x.chain(lower * x.value(), T(n) * lower);
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> exp(dual<T, N> const& x)
+    {
+        T const e = std::exp(x.value());
+        return x.chain(e, e);
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> log(dual<T, N> const& x)
+    {
+        return x.chain(std::log(x.value()), 1 / x.value());
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> sin(dual<T, N> const& x)
+    {
+        return x.chain(std::sin(x.value()), std::cos(x.value()));
+    }
+
+    template<typename T, unsigned N>
+    dual<T, N> cos(dual<T, N> const& x)
+    {
+        return x.chain(std::cos(x.value()), -std::sin(x.value()));
+    }
+
+    //----------------------------------------------------------------
+    // Dimensioned derivatives
+    //----------------------------------------------------------------
+
+    /*
+     * Returns x as a single independent variable.
+     */
+    template<typename T, typename D>
+    scalar<dual<T, 1>, D> seed(scalar<T, D> const& x)
+    {
+        return scalar<dual<T, 1>, D>{dual<T, 1>::variable(x.value(), 0)};
+    }
+
+    /*
+     * Returns the coordinates of v as N independent variables, coordinate i
+     * in lane i.
+     */
+    template<typename T, typename D, unsigned N>
+    vector<dual<T, N>, D, N> seed(vector<T, D, N> const& v)
+    {
+        vector<dual<T, N>, D, N> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = scalar<dual<T, N>, D>{dual<T, N>::variable(v[i].value(), i)};
+        }
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N>
+    point<dual<T, N>, D, N> seed(point<T, D, N> const& p)
+    {
+        point<dual<T, N>, D, N> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = scalar<dual<T, N>, D>{dual<T, N>::variable(p[i].value(), i)};
+        }
+        return result;
+    }
+
+    /*
+     * Returns the value part of a dual scalar.
+     */
+    template<typename T, unsigned N, typename D>
+    scalar<T, D> primal(scalar<dual<T, N>, D> const& y)
+    {
+        return scalar<T, D>{y.value().value()};
+    }
+
+    /*
+     * Returns the derivative of y with respect to the variable of dimension
+     * DX seeded in the given lane. For example, the derivative of an energy
+     * with respect to a length is a force.
+     */
+    template<typename DX, typename T, unsigned N, typename DY>
+    scalar<T, quotient_dimension_t<DY, DX>> derivative(
+        scalar<dual<T, N>, DY> const& y, unsigned lane = 0)
+    {
+        return scalar<T, quotient_dimension_t<DY, DX>>{y.value().derivative(lane)};
+    }
+
+    /*
+     * Returns all N derivatives of y as a vector.
+     */
+    template<typename DX, typename T, unsigned N, typename DY>
+    vector<T, quotient_dimension_t<DY, DX>, N> gradient(scalar<dual<T, N>, DY> const& y)
+    {
+        vector<T, quotient_dimension_t<DY, DX>, N> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = derivative<DX>(y, i);
+        }
+        return result;
+    }
+
+    /*
+     * Value and gradient of a scalar function of a vector or point.
+     */
+    template<typename T, typename DY, typename DX, unsigned N>
+    struct differential
+    {
+        scalar<T, DY> value;
+        vector<T, quotient_dimension_t<DY, DX>, N> gradient;
+    };
+
+    namespace detail // for dim::differentiate
+    {
+        template<typename F, typename Arg>
+        using result_dimension_t =
+            typename decltype(std::declval<F&>()(std::declval<Arg const&>()))::dimension;
+    } // namespace detail
+
+    /*
+     * Evaluates f, a function of a vector returning a dual scalar, at x and
+     * returns the value and the gradient in one pass.
+     */
+    template<typename F, typename T, typename D, unsigned N>
+    differential<T, detail::result_dimension_t<F, vector<dual<T, N>, D, N>>, D, N> differentiate(
+        F f, vector<T, D, N> const& x)
+    {
+        auto const y = f(seed(x));
+        return {primal(y), gradient<D>(y)};
+    }
+
+    template<typename F, typename T, typename D, unsigned N>
+    differential<T, detail::result_dimension_t<F, point<dual<T, N>, D, N>>, D, N> differentiate(
+        F f, point<T, D, N> const& x)
+    {
+        auto const y = f(seed(x));
+        return {primal(y), gradient<D>(y)};
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_DUAL_HPP
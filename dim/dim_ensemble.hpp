@@ -0,0 +1,733 @@
+/*
+ * dim - Replica ensembles in a SIMD-interleaved layout.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_ENSEMBLE_HPP
+#define INCLUDED_DIM_ENSEMBLE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_arena.hpp"
+#include "dim_parallel.hpp"
+#include "dim_timer.hpp"
+
+namespace dim
+{
+    /*
+     * Number of replicas processed in lockstep by default. Eight doubles
+     * fill an AVX-512 register or two AVX2 registers.
+     */
+    constexpr unsigned default_ensemble_width = 8;
+
+    //----------------------------------------------------------------
+    // Interleaved quantities
+    //----------------------------------------------------------------
+
+    /*
+     * W values of a scalar quantity, one per replica ("lane"), stored
+     * contiguously and aligned so that lane-wise loops compile to packed
+     * SIMD instructions. W must be a power of two. The alignment reaches 64
+     * bytes, so containers of ensemble quantities need an allocator that
+     * honors it, such as dim::aligned_allocator, before C++17.
+     */
+    template<typename T, typename D, unsigned W = default_ensemble_width>
+    class ensemble_scalar
+    {
+        static_assert(W > 0 && (W & (W - 1)) == 0, "ensemble width must be a power of two");
+
+      public:
+        using number_type = T;
+        using dimension = D;
+        using scalar_type = scalar<T, D>;
+        static constexpr unsigned width = W;
+
+        ensemble_scalar() = default;
+
+        // Broadcasts value to all lanes.
+        explicit ensemble_scalar(scalar_type value)
+        {
+            for (unsigned l = 0; l < W; ++l) {
+                lanes_[l] = value.value();
+            }
+        }
+
+        scalar_type lane(unsigned l) const
+        {
+            return scalar_type{lanes_[l]};
+        }
+
+        void set_lane(unsigned l, scalar_type value)
+        {
+            lanes_[l] = value.value();
+        }
+
+        // Raw numbers of the W lanes.
+        T* data()
+        {
+            return lanes_;
+        }
+
+        T const* data() const
+        {
+            return lanes_;
+        }
+
+        ensemble_scalar& operator+=(ensemble_scalar const& rhs)
+        {
+            for (unsigned l = 0; l < W; ++l) {
+                lanes_[l] += rhs.lanes_[l];
+            }
+            return *this;
+        }
+
+        ensemble_scalar& operator-=(ensemble_scalar const& rhs)
+        {
+            for (unsigned l = 0; l < W; ++l) {
+                lanes_[l] -= rhs.lanes_[l];
+            }
+            return *this;
+        }
+
+      private:
+        alignas(W * sizeof(T) < 64 ? W * sizeof(T) : 64) T lanes_[W]{};
+    };
+
+    template<typename T, typename D, unsigned W>
+    constexpr unsigned ensemble_scalar<T, D, W>::width;
+
+    /*
+     * W vectors stored as N ensemble_scalars, i.e. one coordinate of all
+     * lanes after another. Containers need an over-aligning allocator like
+     * those of ensemble_scalar.
+     */
+    template<typename T, typename D, unsigned N, unsigned W = default_ensemble_width>
+    class ensemble_vector
+    {
+      public:
+        using number_type = T;
+        using scalar_type = ensemble_scalar<T, D, W>;
+        using value_type = vector<T, D, N>;
+        static constexpr unsigned dimension = N;
+        static constexpr unsigned width = W;
+
+        ensemble_vector() = default;
+
+        explicit ensemble_vector(value_type const& value)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i] = scalar_type{value[i]};
+            }
+        }
+
+        scalar_type& operator[](unsigned index)
+        {
+            return coords_[index];
+        }
+
+        scalar_type const& operator[](unsigned index) const
+        {
+            return coords_[index];
+        }
+
+        value_type lane(unsigned l) const
+        {
+            value_type value;
+            for (unsigned i = 0; i < N; ++i) {
+                value[i] = coords_[i].lane(l);
+            }
+            return value;
+        }
+
+        void set_lane(unsigned l, value_type const& value)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i].set_lane(l, value[i]);
+            }
+        }
+
+        ensemble_vector& operator+=(ensemble_vector const& rhs)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i] += rhs[i];
+            }
+            return *this;
+        }
+
+        ensemble_vector& operator-=(ensemble_vector const& rhs)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i] -= rhs[i];
+            }
+            return *this;
+        }
+
+      private:
+        scalar_type coords_[N];
+    };
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    constexpr unsigned ensemble_vector<T, D, N, W>::dimension;
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    constexpr unsigned ensemble_vector<T, D, N, W>::width;
+
+    /*
+     * W points stored like ensemble_vector, with the same allocator
+     * requirement.
+     */
+    template<typename T, typename D, unsigned N, unsigned W = default_ensemble_width>
+    class ensemble_point
+    {
+      public:
+        using number_type = T;
+        using scalar_type = ensemble_scalar<T, D, W>;
+        using vector_type = ensemble_vector<T, D, N, W>;
+        using value_type = point<T, D, N>;
+        static constexpr unsigned dimension = N;
+        static constexpr unsigned width = W;
+
+        ensemble_point() = default;
+
+        explicit ensemble_point(value_type const& value)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i] = scalar_type{value[i]};
+            }
+        }
+
+        scalar_type& operator[](unsigned index)
+        {
+            return coords_[index];
+        }
+
+        scalar_type const& operator[](unsigned index) const
+        {
+            return coords_[index];
+        }
+
+        value_type lane(unsigned l) const
+        {
+            value_type value;
+            for (unsigned i = 0; i < N; ++i) {
+                value[i] = coords_[i].lane(l);
+            }
+            return value;
+        }
+
+        void set_lane(unsigned l, value_type const& value)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i].set_lane(l, value[i]);
+            }
+        }
+
+        ensemble_point& operator+=(vector_type const& rhs)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i] += rhs[i];
+            }
+            return *this;
+        }
+
+        ensemble_point& operator-=(vector_type const& rhs)
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                coords_[i] -= rhs[i];
+            }
+            return *this;
+        }
+
+      private:
+        scalar_type coords_[N];
+    };
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    constexpr unsigned ensemble_point<T, D, N, W>::dimension;
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    constexpr unsigned ensemble_point<T, D, N, W>::width;
+
+    //----------------------------------------------------------------
+    // Lane-wise arithmetic
+    //----------------------------------------------------------------
+
+    template<typename T, typename D, unsigned W>
+    ensemble_scalar<T, D, W> operator+(ensemble_scalar<T, D, W> const& x, ensemble_scalar<T, D, W> const& y)
+    {
+        return ensemble_scalar<T, D, W>{x} += y;
+    }
+
+    template<typename T, typename D, unsigned W>
+    ensemble_scalar<T, D, W> operator-(ensemble_scalar<T, D, W> const& x, ensemble_scalar<T, D, W> const& y)
+    {
+        return ensemble_scalar<T, D, W>{x} -= y;
+    }
+
+    template<typename T, typename D, unsigned W>
+    ensemble_scalar<T, D, W> operator-(ensemble_scalar<T, D, W> const& x)
+    {
+        ensemble_scalar<T, D, W> result;
+        for (unsigned l = 0; l < W; ++l) {
+            result.data()[l] = -x.data()[l];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned W>
+    ensemble_scalar<T, product_dimension_t<D1, D2>, W> operator*(
+        ensemble_scalar<T, D1, W> const& x, ensemble_scalar<T, D2, W> const& y)
+    {
+        ensemble_scalar<T, product_dimension_t<D1, D2>, W> result;
+        for (unsigned l = 0; l < W; ++l) {
+            result.data()[l] = x.data()[l] * y.data()[l];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned W>
+    ensemble_scalar<T, quotient_dimension_t<D1, D2>, W> operator/(
+        ensemble_scalar<T, D1, W> const& x, ensemble_scalar<T, D2, W> const& y)
+    {
+        ensemble_scalar<T, quotient_dimension_t<D1, D2>, W> result;
+        for (unsigned l = 0; l < W; ++l) {
+            result.data()[l] = x.data()[l] / y.data()[l];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned W>
+    ensemble_scalar<T, product_dimension_t<D1, D2>, W> operator*(
+        scalar<T, D1> const& a, ensemble_scalar<T, D2, W> const& x)
+    {
+        ensemble_scalar<T, product_dimension_t<D1, D2>, W> result;
+        for (unsigned l = 0; l < W; ++l) {
+            result.data()[l] = a.value() * x.data()[l];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned W>
+    ensemble_scalar<T, product_dimension_t<D1, D2>, W> operator*(
+        ensemble_scalar<T, D1, W> const& x, scalar<T, D2> const& a)
+    {
+        return a * x;
+    }
+
+    template<typename T, typename D, unsigned W>
+    ensemble_scalar<T, root_dimension_t<D, 2>, W> sqrt(ensemble_scalar<T, D, W> const& x)
+    {
+        using std::sqrt;
+        ensemble_scalar<T, root_dimension_t<D, 2>, W> result;
+        for (unsigned l = 0; l < W; ++l) {
+            result.data()[l] = sqrt(x.data()[l]);
+        }
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_vector<T, D, N, W> operator+(ensemble_vector<T, D, N, W> const& v, ensemble_vector<T, D, N, W> const& w)
+    {
+        return ensemble_vector<T, D, N, W>{v} += w;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_vector<T, D, N, W> operator-(ensemble_vector<T, D, N, W> const& v, ensemble_vector<T, D, N, W> const& w)
+    {
+        return ensemble_vector<T, D, N, W>{v} -= w;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_vector<T, D, N, W> operator-(ensemble_vector<T, D, N, W> const& v)
+    {
+        ensemble_vector<T, D, N, W> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = -v[i];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned N, unsigned W>
+    ensemble_vector<T, product_dimension_t<D1, D2>, N, W> operator*(
+        ensemble_scalar<T, D1, W> const& a, ensemble_vector<T, D2, N, W> const& v)
+    {
+        ensemble_vector<T, product_dimension_t<D1, D2>, N, W> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = a * v[i];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned N, unsigned W>
+    ensemble_vector<T, product_dimension_t<D1, D2>, N, W> operator*(
+        ensemble_vector<T, D1, N, W> const& v, ensemble_scalar<T, D2, W> const& a)
+    {
+        return a * v;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned N, unsigned W>
+    ensemble_vector<T, product_dimension_t<D1, D2>, N, W> operator*(
+        scalar<T, D1> const& a, ensemble_vector<T, D2, N, W> const& v)
+    {
+        ensemble_vector<T, product_dimension_t<D1, D2>, N, W> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = a * v[i];
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned N, unsigned W>
+    ensemble_vector<T, product_dimension_t<D1, D2>, N, W> operator*(
+        ensemble_vector<T, D1, N, W> const& v, scalar<T, D2> const& a)
+    {
+        return a * v;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned N, unsigned W>
+    ensemble_vector<T, quotient_dimension_t<D1, D2>, N, W> operator/(
+        ensemble_vector<T, D1, N, W> const& v, ensemble_scalar<T, D2, W> const& a)
+    {
+        ensemble_vector<T, quotient_dimension_t<D1, D2>, N, W> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = v[i] / a;
+        }
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2, unsigned N, unsigned W>
+    ensemble_scalar<T, product_dimension_t<D1, D2>, W> dot(
+        ensemble_vector<T, D1, N, W> const& v, ensemble_vector<T, D2, N, W> const& w)
+    {
+        ensemble_scalar<T, product_dimension_t<D1, D2>, W> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result += v[i] * w[i];
+        }
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_scalar<T, power_dimension_t<D, 2>, W> squared_norm(ensemble_vector<T, D, N, W> const& v)
+    {
+        return dot(v, v);
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_scalar<T, D, W> norm(ensemble_vector<T, D, N, W> const& v)
+    {
+        return sqrt(squared_norm(v));
+    }
+
+    template<typename T, typename D1, typename D2, unsigned W>
+    ensemble_vector<T, product_dimension_t<D1, D2>, 3, W> cross(
+        ensemble_vector<T, D1, 3, W> const& v, ensemble_vector<T, D2, 3, W> const& w)
+    {
+        ensemble_vector<T, product_dimension_t<D1, D2>, 3, W> result;
+        result[0] = v[1] * w[2] - v[2] * w[1];
+        result[1] = v[2] * w[0] - v[0] * w[2];
+        result[2] = v[0] * w[1] - v[1] * w[0];
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_point<T, D, N, W> operator+(ensemble_point<T, D, N, W> const& p, ensemble_vector<T, D, N, W> const& v)
+    {
+        return ensemble_point<T, D, N, W>{p} += v;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_point<T, D, N, W> operator-(ensemble_point<T, D, N, W> const& p, ensemble_vector<T, D, N, W> const& v)
+    {
+        return ensemble_point<T, D, N, W>{p} -= v;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_vector<T, D, N, W> operator-(ensemble_point<T, D, N, W> const& p, ensemble_point<T, D, N, W> const& q)
+    {
+        ensemble_vector<T, D, N, W> result;
+        for (unsigned i = 0; i < N; ++i) {
+            result[i] = p[i] - q[i];
+        }
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_scalar<T, power_dimension_t<D, 2>, W> squared_distance(
+        ensemble_point<T, D, N, W> const& p, ensemble_point<T, D, N, W> const& q)
+    {
+        return squared_norm(p - q);
+    }
+
+    template<typename T, typename D, unsigned N, unsigned W>
+    ensemble_scalar<T, D, W> distance(ensemble_point<T, D, N, W> const& p, ensemble_point<T, D, N, W> const& q)
+    {
+        return norm(p - q);
+    }
+
+    //----------------------------------------------------------------
+    // Integration
+    //----------------------------------------------------------------
+
+    /*
+     * Advances count particles of W replicas by one velocity Verlet step
+     * of length dt. forces must hold the forces at the current positions
+     * on entry and hold the forces at the new positions on return.
+     * compute_forces(positions, forces, count) fills forces for all lanes.
+     */
+    template<typename T, unsigned W, typename Force>
+    void velocity_verlet(ensemble_point<T, mech::length, 3, W>* positions,
+        ensemble_vector<T, mech::speed, 3, W>* velocities,
+        ensemble_vector<T, mech::force, 3, W>* forces,
+        ensemble_scalar<T, mech::mass, W> const* masses,
+        std::size_t count,
+        scalar<T, mech::time> dt,
+        Force compute_forces)
+    {
+        DIM_TIMER_SCOPE("dim::velocity_verlet", count * W, 0);
+        scalar<T, mech::time> const half_dt = dt / T(2);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            velocities[i] += half_dt * (forces[i] / masses[i]);
+            positions[i] += dt * velocities[i];
+        }
+
+        compute_forces(static_cast<ensemble_point<T, mech::length, 3, W> const*>(positions), forces, count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            velocities[i] += half_dt * (forces[i] / masses[i]);
+        }
+    }
+
+    /*
+     * Storage for many replicas of a small system of particles. Replicas
+     * are grouped into batches of W, and each batch keeps its particles as
+     * ensemble_points whose lane l belongs to replica batch * W + l, so the
+     * same particle of W replicas is updated by one SIMD instruction.
+     * Unused lanes of the last batch mirror the last replica. Masses
+     * default to one.
+     */
+    template<typename T, unsigned W = default_ensemble_width>
+    class ensemble
+    {
+      public:
+        using point_type = point<T, mech::length, 3>;
+        using velocity_type = vector<T, mech::speed, 3>;
+        using force_type = vector<T, mech::force, 3>;
+        using mass_type = scalar<T, mech::mass>;
+        using time_type = scalar<T, mech::time>;
+
+        using batch_point = ensemble_point<T, mech::length, 3, W>;
+        using batch_velocity = ensemble_vector<T, mech::speed, 3, W>;
+        using batch_force = ensemble_vector<T, mech::force, 3, W>;
+        using batch_mass = ensemble_scalar<T, mech::mass, W>;
+
+        static constexpr unsigned width = W;
+
+        /*
+         * Creates replicas copies of a system of particles particles, all at
+         * the origin and at rest. Throws std::invalid_argument if replicas
+         * is zero.
+         */
+        ensemble(std::size_t replicas, std::size_t particles)
+            : replicas_{replicas}
+            , particles_{particles}
+            , batches_{(replicas + W - 1) / W}
+            , positions_(batches_ * particles)
+            , velocities_(batches_ * particles)
+            , forces_(batches_ * particles)
+            , masses_(batches_ * particles, batch_mass{mass_type{1}})
+        {
+            if (replicas == 0) {
+                throw std::invalid_argument("ensemble needs at least one replica");
+            }
+        }
+
+        std::size_t replicas() const
+        {
+            return replicas_;
+        }
+
+        std::size_t particles() const
+        {
+            return particles_;
+        }
+
+        std::size_t batches() const
+        {
+            return batches_;
+        }
+
+        point_type position(std::size_t replica, std::size_t particle) const
+        {
+            return positions_[index(replica, particle)].lane(lane(replica));
+        }
+
+        void set_position(std::size_t replica, std::size_t particle, point_type const& value)
+        {
+            positions_[index(replica, particle)].set_lane(lane(replica), value);
+            dirty_ = true;
+        }
+
+        velocity_type velocity(std::size_t replica, std::size_t particle) const
+        {
+            return velocities_[index(replica, particle)].lane(lane(replica));
+        }
+
+        void set_velocity(std::size_t replica, std::size_t particle, velocity_type const& value)
+        {
+            velocities_[index(replica, particle)].set_lane(lane(replica), value);
+            dirty_ = true;
+        }
+
+        mass_type mass(std::size_t replica, std::size_t particle) const
+        {
+            return masses_[index(replica, particle)].lane(lane(replica));
+        }
+
+        void set_mass(std::size_t replica, std::size_t particle, mass_type value)
+        {
+            masses_[index(replica, particle)].set_lane(lane(replica), value);
+            dirty_ = true;
+        }
+
+        /*
+         * Force on a particle as of the last step.
+         */
+        force_type force(std::size_t replica, std::size_t particle) const
+        {
+            return forces_[index(replica, particle)].lane(lane(replica));
+        }
+
+        // Particles of a batch.
+        batch_point* positions(std::size_t batch)
+        {
+            return &positions_[batch * particles_];
+        }
+
+        batch_point const* positions(std::size_t batch) const
+        {
+            return &positions_[batch * particles_];
+        }
+
+        batch_velocity* velocities(std::size_t batch)
+        {
+            return &velocities_[batch * particles_];
+        }
+
+        batch_velocity const* velocities(std::size_t batch) const
+        {
+            return &velocities_[batch * particles_];
+        }
+
+        batch_mass const* masses(std::size_t batch) const
+        {
+            return &masses_[batch * particles_];
+        }
+
+        /*
+         * Advances all replicas by steps velocity Verlet steps of length dt,
+         * running batches in parallel. compute_forces(batch, positions,
+         * forces, count) fills the forces on the count particles of a batch
+         * and is called concurrently for different batches.
+         */
+        template<typename Force>
+        void step(time_type dt, Force compute_forces, std::size_t steps = 1)
+        {
+            if (dirty_) {
+                mirror_padding();
+            }
+
+            // Work is sized by particles but split by batches.
+            std::size_t const work_chunks = detail::chunk_count(batches_ * particles_, 256);
+            std::size_t const chunks = work_chunks < batches_ ? work_chunks : batches_;
+            bool const refresh = dirty_;
+
+            detail::parallel_chunks(batches_, chunks, [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (std::size_t batch = begin; batch < end; ++batch) {
+                    auto batch_forces = [&](batch_point const* p, batch_force* f, std::size_t n) {
+                        compute_forces(batch, p, f, n);
+                    };
+                    if (refresh) {
+                        batch_forces(positions(batch), &forces_[batch * particles_], particles_);
+                    }
+                    for (std::size_t s = 0; s < steps; ++s) {
+                        velocity_verlet(positions(batch), velocities(batch), &forces_[batch * particles_],
+                            masses(batch), particles_, dt, batch_forces);
+                    }
+                }
+            });
+
+            dirty_ = false;
+        }
+
+      private:
+        template<typename U>
+        using batch_storage = std::vector<U, aligned_allocator<U, (alignof(U) < 64 ? 64 : alignof(U))>>;
+
+        std::size_t index(std::size_t replica, std::size_t particle) const
+        {
+            return replica / W * particles_ + particle;
+        }
+
+        static unsigned lane(std::size_t replica)
+        {
+            return unsigned(replica % W);
+        }
+
+        // Copies the last replica into the unused lanes so that they stay
+        // finite (e.g. no coincident particles in the force computation).
+        void mirror_padding()
+        {
+            unsigned const last = lane(replicas_ - 1);
+            std::size_t const base = (batches_ - 1) * particles_;
+            for (std::size_t i = base; i < base + particles_; ++i) {
+                for (unsigned l = last + 1; l < W; ++l) {
+                    positions_[i].set_lane(l, positions_[i].lane(last));
+                    velocities_[i].set_lane(l, velocities_[i].lane(last));
+                    masses_[i].set_lane(l, masses_[i].lane(last));
+                }
+            }
+        }
+
+        std::size_t replicas_;
+        std::size_t particles_;
+        std::size_t batches_;
+        batch_storage<batch_point> positions_;
+        batch_storage<batch_velocity> velocities_;
+        batch_storage<batch_force> forces_;
+        batch_storage<batch_mass> masses_;
+        bool dirty_ = true;
+    };
+
+    template<typename T, unsigned W>
+    constexpr unsigned ensemble<T, W>::width;
+} // namespace dim
+
+#endif // INCLUDED_DIM_ENSEMBLE_HPP
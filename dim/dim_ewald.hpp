@@ -0,0 +1,581 @@
+/*
+ * dim - Smooth particle-mesh Ewald summation for periodic charged systems.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_EWALD_HPP
+#define INCLUDED_DIM_EWALD_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_fft.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    /*
+     * Parameters of particle-mesh Ewald summation in an orthorhombic periodic
+     * box. mesh sizes must be powers of two not smaller than spline_order,
+     * spline_order must be at least 3, and cutoff must not exceed the half of
+     * the shortest box side.
+     */
+    template<typename T>
+    struct ewald_parameters
+    {
+        // Side lengths of the periodic box.
+        vector<T, mech::length, 3> box;
+
+        // Cutoff distance of the real-space sum.
+        scalar<T, mech::length> cutoff;
+
+        // Ewald splitting parameter (often called alpha or beta).
+        scalar<T, power_dimension_t<mech::length, -1>> splitting;
+
+        // Coulomb constant 1 / (4 pi epsilon).
+        scalar<T, quotient_dimension_t<product_dimension_t<mech::energy, mech::length>,
+                      power_dimension_t<elec::charge, 2>>>
+            coupling;
+
+        // Number of mesh points along each axis.
+        unsigned mesh[3];
+
+        // Order of the B-spline used for charge spreading.
+        unsigned spline_order;
+    };
+
+    namespace detail // for dim::particle_mesh_ewald
+    {
+        // Computes cardinal B-spline weights M_n(w + n - 1 - j) and their
+        // derivatives for j = 0, ..., n - 1, where 0 <= w < 1 is the
+        // fractional part of a scaled coordinate. (Essmann et al., J. Chem.
+        // Phys. 103, 8577 (1995).)
+        template<typename T>
+        void fill_bspline(T w, unsigned order, T* values, T* derivatives)
+        {
+            values[order - 1] = T(0);
+            values[1] = w;
+            values[0] = 1 - w;
+
+            auto const raise = [&](unsigned k) {
+                T const div = T(1) / T(k - 1);
+                values[k - 1] = div * w * values[k - 2];
+                for (unsigned j = 1; j + 1 < k; ++j) {
+                    values[k - j - 1] =
+                        div * ((w + T(j)) * values[k - j - 2] + (T(k - j) - w) * values[k - j - 1]);
+                }
+                values[0] = div * (1 - w) * values[0];
+            };
+
+            for (unsigned k = 3; k < order; ++k) {
+                raise(k);
+            }
+
+            derivatives[0] = -values[0];
+            for (unsigned j = 1; j < order; ++j) {
+                derivatives[j] = values[j - 1] - values[j];
+            }
+            raise(order);
+        }
+
+        // Computes the squared moduli |b(m)|^-1 of the Euler exponential
+        // spline factors for m = 0, ..., size - 1.
+        template<typename T>
+        std::vector<T> bspline_moduli(unsigned size, unsigned order)
+        {
+            std::vector<T> values(order);
+            std::vector<T> derivatives(order);
+            fill_bspline(T(0), order, values.data(), derivatives.data());
+
+            T const pi = T(3.14159265358979323846264338327950288L);
+            std::vector<T> moduli(size);
+            for (unsigned m = 0; m < size; ++m) {
+                T re = T(0);
+                T im = T(0);
+                for (unsigned k = 0; k + 1 < order; ++k) {
+                    T const arg = 2 * pi * T(m) * T(k) / T(size);
+                    re += values[order - 2 - k] * std::cos(arg);
+                    im += values[order - 2 - k] * std::sin(arg);
+                }
+                moduli[m] = re * re + im * im;
+            }
+
+            // Odd-order splines vanish at the Nyquist frequency. Interpolate
+            // to avoid dividing by zero.
+            for (unsigned m = 0; m < size; ++m) {
+                if (moduli[m] < T(1e-7)) {
+                    moduli[m] = (moduli[(m + size - 1) % size] + moduli[(m + 1) % size]) / 2;
+                }
+            }
+            return moduli;
+        }
+    } // namespace detail
+
+    /*
+     * Smooth particle-mesh Ewald (SPME) engine computing electrostatic
+     * energies and forces of point charges under periodic boundary
+     * conditions in O(N log N) time.
+     */
+    template<typename T>
+    class particle_mesh_ewald
+    {
+      public:
+        using number_type = T;
+        using point_type = point<T, mech::length, 3>;
+        using charge_type = scalar<T, elec::charge>;
+        using force_type = vector<T, mech::force, 3>;
+        using energy_type = scalar<T, mech::energy>;
+        using length_type = scalar<T, mech::length>;
+        using splitting_type = scalar<T, power_dimension_t<mech::length, -1>>;
+
+        /*
+         * Ewald energy decomposed into the real-space sum, the reciprocal
+         * sum, and the self and neutralizing-background correction.
+         */
+        struct energy_terms
+        {
+            energy_type real;
+            energy_type reciprocal;
+            energy_type self;
+
+            energy_type total() const
+            {
+                return real + reciprocal + self;
+            }
+        };
+
+        /*
+         * Creates an engine. Throws std::invalid_argument if the parameters
+         * are not valid.
+         */
+        explicit particle_mesh_ewald(ewald_parameters<T> const& params)
+            : params_(params)
+        {
+            if (params.spline_order < 3) {
+                throw std::invalid_argument("spline order must be at least 3");
+            }
+            for (unsigned k = 0; k < 3; ++k) {
+                if (!is_power_of_two(params.mesh[k]) || params.mesh[k] < params.spline_order) {
+                    throw std::invalid_argument(
+                        "mesh size must be a power of two not smaller than spline order");
+                }
+                if (params.cutoff.value() * 2 > params.box[k].value()) {
+                    throw std::invalid_argument("cutoff must not exceed half the box size");
+                }
+                moduli_[k] = detail::bspline_moduli<T>(params.mesh[k], params.spline_order);
+            }
+        }
+
+        ewald_parameters<T> const& parameters() const
+        {
+            return params_;
+        }
+
+        /*
+         * Returns the splitting parameter with which the real-space pair
+         * term erfc(splitting * r) falls to tolerance at the cutoff.
+         */
+        static splitting_type splitting_for(length_type cutoff, T tolerance)
+        {
+            T const rc = cutoff.value();
+            T high = T(1) / rc;
+            while (std::erfc(high * rc) > tolerance) {
+                high *= 2;
+            }
+            T low = T(0);
+            for (int iter = 0; iter < 60; ++iter) {
+                T const mid = (low + high) / 2;
+                (std::erfc(mid * rc) > tolerance ? low : high) = mid;
+            }
+            return splitting_type{high};
+        }
+
+        /*
+         * Computes the electrostatic energy of count charges and stores the
+         * force on each charge to forces.
+         */
+        energy_terms compute(point_type const* positions,
+            charge_type const* charges,
+            std::size_t count,
+            force_type* forces)
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                forces[i] = force_type{};
+            }
+            energy_terms energy;
+            energy.real = compute_real(positions, charges, count, forces);
+            energy.reciprocal = compute_reciprocal(positions, charges, count, forces);
+            energy.self = compute_self(charges, count);
+            return energy;
+        }
+
+        energy_terms compute(std::vector<point_type> const& positions,
+            std::vector<charge_type> const& charges,
+            std::vector<force_type>& forces)
+        {
+            forces.resize(positions.size());
+            return compute(positions.data(), charges.data(), positions.size(), forces.data());
+        }
+
+      private:
+        ewald_parameters<T> params_;
+        std::vector<T> moduli_[3];
+        std::vector<std::complex<T>> grid_;
+        std::vector<T> weights_;
+        std::vector<std::size_t> origins_;
+
+        static T pi()
+        {
+            return T(3.14159265358979323846264338327950288L);
+        }
+
+        T volume() const
+        {
+            return params_.box[0].value() * params_.box[1].value() * params_.box[2].value();
+        }
+
+        // Returns the periodic image of position inside [0, box).
+        void wrap(point_type const& position, T* result) const
+        {
+            for (unsigned k = 0; k < 3; ++k) {
+                T const side = params_.box[k].value();
+                T const x = position[k].value();
+                result[k] = x - side * std::floor(x / side);
+            }
+        }
+
+        //------------------------------------------------------------
+        // Real-space sum
+        //------------------------------------------------------------
+
+        // Accumulates the erfc-screened pair interaction of i with j. Returns
+        // the pair energy, or zero if j is outside the cutoff.
+        T real_pair(T const* xi, T const* xj, T qi, T qj, T* force) const
+        {
+            T const alpha = params_.splitting.value();
+            T const rc = params_.cutoff.value();
+
+            T delta[3];
+            T r2 = T(0);
+            for (unsigned k = 0; k < 3; ++k) {
+                T const side = params_.box[k].value();
+                delta[k] = xi[k] - xj[k];
+                delta[k] -= side * std::round(delta[k] / side);
+                r2 += delta[k] * delta[k];
+            }
+            if (r2 >= rc * rc || r2 == T(0)) {
+                return T(0);
+            }
+
+            T const r = std::sqrt(r2);
+            T const k = params_.coupling.value();
+            T const screened = std::erfc(alpha * r) / r;
+            T const gauss = 2 * alpha / std::sqrt(pi()) * std::exp(-alpha * alpha * r2);
+            T const magnitude = k * qi * qj * (screened + gauss) / r2;
+            for (unsigned a = 0; a < 3; ++a) {
+                force[a] += magnitude * delta[a];
+            }
+            return k * qi * qj * screened;
+        }
+
+        energy_type compute_real(point_type const* positions,
+            charge_type const* charges,
+            std::size_t count,
+            force_type* forces) const
+        {
+            std::vector<T> wrapped(count * 3);
+            for (std::size_t i = 0; i < count; ++i) {
+                wrap(positions[i], &wrapped[i * 3]);
+            }
+
+            // Bin charges into cells at least as large as the cutoff. Fall
+            // back to all pairs if the box is too small for a 3x3x3 stencil.
+            std::size_t cells[3];
+            bool use_cells = true;
+            for (unsigned k = 0; k < 3; ++k) {
+                cells[k] = std::size_t(params_.box[k].value() / params_.cutoff.value());
+                use_cells = use_cells && cells[k] >= 3;
+            }
+
+            std::vector<std::size_t> cell_start;
+            std::vector<std::size_t> cell_members;
+            std::vector<std::size_t> cell_of(count);
+            if (use_cells) {
+                std::size_t const total = cells[0] * cells[1] * cells[2];
+                cell_start.assign(total + 1, 0);
+                for (std::size_t i = 0; i < count; ++i) {
+                    std::size_t index = 0;
+                    for (unsigned k = 0; k < 3; ++k) {
+                        T const frac = wrapped[i * 3 + k] / params_.box[k].value();
+                        std::size_t c = std::size_t(frac * T(cells[k]));
+                        c = c < cells[k] ? c : cells[k] - 1;
+                        index = index * cells[k] + c;
+                    }
+                    cell_of[i] = index;
+                    cell_start[index + 1]++;
+                }
+                for (std::size_t c = 0; c < total; ++c) {
+                    cell_start[c + 1] += cell_start[c];
+                }
+                cell_members.resize(count);
+                std::vector<std::size_t> fill(cell_start.begin(), cell_start.end() - 1);
+                for (std::size_t i = 0; i < count; ++i) {
+                    cell_members[fill[cell_of[i]]++] = i;
+                }
+            }
+
+            std::size_t const chunks = detail::chunk_count(count, 256);
+            std::vector<T> energies(chunks, T(0));
+
+            // Each charge sums its own pairs so that threads never write to
+            // the same force. Pair energies are thus counted twice.
+            detail::parallel_chunks(
+                count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        T const* xi = &wrapped[i * 3];
+                        T const qi = charges[i].value();
+                        T force[3] = {};
+                        T energy = T(0);
+
+                        auto const visit = [&](std::size_t j) {
+                            if (j != i) {
+                                energy += real_pair(xi, &wrapped[j * 3], qi, charges[j].value(), force);
+                            }
+                        };
+
+                        if (use_cells) {
+                            std::size_t const c = cell_of[i];
+                            std::size_t const cz = c % cells[2];
+                            std::size_t const cy = c / cells[2] % cells[1];
+                            std::size_t const cx = c / cells[2] / cells[1];
+                            for (std::size_t dx = 0; dx < 3; ++dx) {
+                                std::size_t const nx = (cx + cells[0] + dx - 1) % cells[0];
+                                for (std::size_t dy = 0; dy < 3; ++dy) {
+                                    std::size_t const ny = (cy + cells[1] + dy - 1) % cells[1];
+                                    for (std::size_t dz = 0; dz < 3; ++dz) {
+                                        std::size_t const nz = (cz + cells[2] + dz - 1) % cells[2];
+                                        std::size_t const n = (nx * cells[1] + ny) * cells[2] + nz;
+                                        for (std::size_t m = cell_start[n]; m < cell_start[n + 1]; ++m) {
+                                            visit(cell_members[m]);
+                                        }
+                                    }
+                                }
+                            }
+                        } else {
+                            for (std::size_t j = 0; j < count; ++j) {
+                                visit(j);
+                            }
+                        }
+
+                        for (unsigned k = 0; k < 3; ++k) {
+                            forces[i][k] += scalar<T, mech::force>{force[k]};
+                        }
+                        energies[chunk] += energy;
+                    }
+                });
+
+            T total = T(0);
+            for (T const e : energies) {
+                total += e;
+            }
+            return energy_type{total / 2};
+        }
+
+        //------------------------------------------------------------
+        // Reciprocal-space sum
+        //------------------------------------------------------------
+
+        energy_type compute_reciprocal(point_type const* positions,
+            charge_type const* charges,
+            std::size_t count,
+            force_type* forces)
+        {
+            unsigned const order = params_.spline_order;
+            std::size_t const mx = params_.mesh[0];
+            std::size_t const my = params_.mesh[1];
+            std::size_t const mz = params_.mesh[2];
+            std::size_t const mesh_size = mx * my * mz;
+            std::size_t const mesh[3] = {mx, my, mz};
+
+            // Spline weights (values and derivatives) and the first mesh
+            // index touched by each charge.
+            weights_.resize(count * 6 * order);
+            origins_.resize(count * 3);
+            detail::parallel_for(count, [&](std::size_t i) {
+                T wrapped[3];
+                wrap(positions[i], wrapped);
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const u = wrapped[k] / params_.box[k].value() * T(mesh[k]);
+                    T const base = std::floor(u);
+                    T* const values = &weights_[(i * 6 + k * 2) * order];
+                    detail::fill_bspline(u - base, order, values, values + order);
+                    std::size_t const iu = std::size_t(base) % mesh[k];
+                    origins_[i * 3 + k] = (iu + mesh[k] - order + 1) % mesh[k];
+                }
+            });
+
+            // Spread charges to the mesh. Threads use private meshes that are
+            // summed afterwards.
+            std::size_t const chunks = detail::chunk_count(count, 4096);
+            std::vector<std::vector<T>> partials(chunks, std::vector<T>(mesh_size, T(0)));
+            detail::parallel_chunks(
+                count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    std::vector<T>& local = partials[chunk];
+                    for (std::size_t i = begin; i < end; ++i) {
+                        T const q = charges[i].value();
+                        T const* const wx = &weights_[(i * 6 + 0) * order];
+                        T const* const wy = &weights_[(i * 6 + 2) * order];
+                        T const* const wz = &weights_[(i * 6 + 4) * order];
+                        for (unsigned a = 0; a < order; ++a) {
+                            std::size_t const gx = (origins_[i * 3] + a) % mx;
+                            for (unsigned b = 0; b < order; ++b) {
+                                std::size_t const gy = (origins_[i * 3 + 1] + b) % my;
+                                T const qxy = q * wx[a] * wy[b];
+                                std::size_t const row = (gx * my + gy) * mz;
+                                for (unsigned c = 0; c < order; ++c) {
+                                    local[row + (origins_[i * 3 + 2] + c) % mz] += qxy * wz[c];
+                                }
+                            }
+                        }
+                    }
+                });
+
+            grid_.resize(mesh_size);
+            detail::parallel_for(mesh_size, [&](std::size_t g) {
+                T sum = T(0);
+                for (auto const& local : partials) {
+                    sum += local[g];
+                }
+                grid_[g] = std::complex<T>{sum, T(0)};
+            });
+
+            // Convolve with the influence function in Fourier space.
+            fft_3d(grid_.data(), mx, my, mz, -1);
+
+            T const alpha = params_.splitting.value();
+            T const prefactor = params_.coupling.value() / (pi() * volume());
+            std::size_t const planes = detail::chunk_count(mx, 1);
+            std::vector<T> energies(planes, T(0));
+            detail::parallel_chunks(
+                mx, planes, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    for (std::size_t ix = begin; ix < end; ++ix) {
+                        T const kx = wave_number(ix, 0);
+                        for (std::size_t iy = 0; iy < my; ++iy) {
+                            T const ky = wave_number(iy, 1);
+                            for (std::size_t iz = 0; iz < mz; ++iz) {
+                                std::size_t const g = (ix * my + iy) * mz + iz;
+                                if (g == 0) {
+                                    grid_[g] = T(0);
+                                    continue;
+                                }
+                                T const kz = wave_number(iz, 2);
+                                T const k2 = kx * kx + ky * ky + kz * kz;
+                                T const influence = prefactor
+                                    * std::exp(-pi() * pi() * k2 / (alpha * alpha)) / k2
+                                    / (moduli_[0][ix] * moduli_[1][iy] * moduli_[2][iz]);
+                                energies[chunk] += influence * std::norm(grid_[g]) / 2;
+                                grid_[g] *= influence;
+                            }
+                        }
+                    }
+                });
+
+            fft_3d(grid_.data(), mx, my, mz, +1);
+
+            // Interpolate forces as the gradient of the spline-weighted
+            // convolved potential.
+            detail::parallel_for(count, [&](std::size_t i) {
+                T const q = charges[i].value();
+                T const* const wx = &weights_[(i * 6 + 0) * order];
+                T const* const dx = &weights_[(i * 6 + 1) * order];
+                T const* const wy = &weights_[(i * 6 + 2) * order];
+                T const* const dy = &weights_[(i * 6 + 3) * order];
+                T const* const wz = &weights_[(i * 6 + 4) * order];
+                T const* const dz = &weights_[(i * 6 + 5) * order];
+
+                T grad[3] = {};
+                for (unsigned a = 0; a < order; ++a) {
+                    std::size_t const gx = (origins_[i * 3] + a) % mx;
+                    for (unsigned b = 0; b < order; ++b) {
+                        std::size_t const gy = (origins_[i * 3 + 1] + b) % my;
+                        std::size_t const row = (gx * my + gy) * mz;
+                        for (unsigned c = 0; c < order; ++c) {
+                            T const phi = grid_[row + (origins_[i * 3 + 2] + c) % mz].real();
+                            grad[0] += dx[a] * wy[b] * wz[c] * phi;
+                            grad[1] += wx[a] * dy[b] * wz[c] * phi;
+                            grad[2] += wx[a] * wy[b] * dz[c] * phi;
+                        }
+                    }
+                }
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const scale = T(mesh[k]) / params_.box[k].value();
+                    forces[i][k] -= scalar<T, mech::force>{q * grad[k] * scale};
+                }
+            });
+
+            T total = T(0);
+            for (T const e : energies) {
+                total += e;
+            }
+            return energy_type{total};
+        }
+
+        // Returns the wave number (reciprocal length) of mesh index along
+        // axis, folded into the symmetric range.
+        T wave_number(std::size_t index, unsigned axis) const
+        {
+            std::size_t const size = params_.mesh[axis];
+            T const m = index <= size / 2 ? T(index) : T(index) - T(size);
+            return m / params_.box[axis].value();
+        }
+
+        //------------------------------------------------------------
+        // Corrections
+        //------------------------------------------------------------
+
+        energy_type compute_self(charge_type const* charges, std::size_t count) const
+        {
+            T sum = T(0);
+            T sum2 = T(0);
+            for (std::size_t i = 0; i < count; ++i) {
+                sum += charges[i].value();
+                sum2 += charges[i].value() * charges[i].value();
+            }
+            T const alpha = params_.splitting.value();
+            T const k = params_.coupling.value();
+            T const self = -k * alpha / std::sqrt(pi()) * sum2;
+            T const background = -k * pi() * sum * sum / (2 * volume() * alpha * alpha);
+            return energy_type{self + background};
+        }
+    };
+} // namespace dim
+
+#endif // INCLUDED_DIM_EWALD_HPP
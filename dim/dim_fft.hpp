@@ -0,0 +1,147 @@
+/*
+ * dim - Self-contained fast Fourier transform used by the dim extensions.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_FFT_HPP
+#define INCLUDED_DIM_FFT_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    inline bool is_power_of_two(std::size_t n)
+    {
+        return n != 0 && (n & (n - 1)) == 0;
+    }
+
+    namespace detail // for dim::fft
+    {
+        // Returns exp(sign * 2 pi i k / n) for k = 0, ..., n/2 - 1.
+        template<typename T>
+        std::vector<std::complex<T>> fft_roots(std::size_t n, int sign)
+        {
+            T const pi = T(3.14159265358979323846264338327950288L);
+            std::vector<std::complex<T>> roots(n / 2);
+            for (std::size_t k = 0; k < n / 2; ++k) {
+                roots[k] = std::polar(T(1), T(sign) * 2 * pi * T(k) / T(n));
+            }
+            return roots;
+        }
+
+        template<typename T>
+        void fft(std::complex<T>* data, std::size_t n, std::complex<T> const* roots)
+        {
+            // Bit-reversal permutation.
+            for (std::size_t i = 1, j = 0; i < n; ++i) {
+                std::size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(data[i], data[j]);
+                }
+            }
+
+            for (std::size_t len = 2; len <= n; len <<= 1) {
+                std::size_t const half = len / 2;
+                std::size_t const step = n / len;
+                for (std::size_t start = 0; start < n; start += len) {
+                    for (std::size_t k = 0; k < half; ++k) {
+                        std::complex<T> const even = data[start + k];
+                        std::complex<T> const odd = data[start + k + half] * roots[k * step];
+                        data[start + k] = even + odd;
+                        data[start + k + half] = even - odd;
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+    /*
+     * Computes the unnormalized discrete Fourier transform
+     *
+     *   X[k] = sum_j x[j] exp(sign * 2 pi i j k / n)
+     *
+     * of n complex values in place. n must be a power of two.
+     */
+    template<typename T>
+    void fft(std::complex<T>* data, std::size_t n, int sign)
+    {
+        auto const roots = detail::fft_roots<T>(n, sign);
+        detail::fft(data, n, roots.data());
+    }
+
+    /*
+     * Computes the unnormalized three-dimensional discrete Fourier transform
+     * of a row-major nx-by-ny-by-nz grid in place. Each size must be a power
+     * of two. Lines along each axis are transformed in parallel.
+     */
+    template<typename T>
+    void fft_3d(std::complex<T>* data, std::size_t nx, std::size_t ny, std::size_t nz, int sign)
+    {
+        std::size_t const sizes[3] = {nx, ny, nz};
+        std::size_t const strides[3] = {ny * nz, nz, 1};
+
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            std::size_t const n = sizes[axis];
+            std::size_t const stride = strides[axis];
+            std::size_t const lines = nx * ny * nz / n;
+            auto const roots = detail::fft_roots<T>(n, sign);
+
+            detail::parallel_chunks(lines,
+                detail::chunk_count(lines, 16),
+                [&](std::size_t, std::size_t begin, std::size_t end) {
+                    std::vector<std::complex<T>> buffer(n);
+                    for (std::size_t line = begin; line < end; ++line) {
+                        // Decompose the line number into the offset of its
+                        // first element in the grid.
+                        std::size_t const inner = line % stride;
+                        std::size_t const outer = line / stride;
+                        std::complex<T>* const base = data + outer * stride * n + inner;
+
+                        for (std::size_t i = 0; i < n; ++i) {
+                            buffer[i] = base[i * stride];
+                        }
+                        detail::fft(buffer.data(), n, roots.data());
+                        for (std::size_t i = 0; i < n; ++i) {
+                            base[i * stride] = buffer[i];
+                        }
+                    }
+                });
+        }
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_FFT_HPP
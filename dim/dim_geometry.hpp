@@ -0,0 +1,407 @@
+/*
+ * dim - Bounding boxes and spatial statistics over arrays of dim::point.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_GEOMETRY_HPP
+#define INCLUDED_DIM_GEOMETRY_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Axis-aligned box
+    //----------------------------------------------------------------
+
+    /*
+     * Axis-aligned box spanned by two corner points.
+     */
+    template<typename T, typename D, unsigned N>
+    struct box
+    {
+        using point_type = point<T, D, N>;
+        using vector_type = vector<T, D, N>;
+
+        point_type lower;
+        point_type upper;
+
+        vector_type extent() const
+        {
+            return upper - lower;
+        }
+
+        point_type center() const
+        {
+            return lower + extent() / T(2);
+        }
+
+        bool contains(point_type const& p) const
+        {
+            for (unsigned i = 0; i < N; ++i) {
+                if (p[i] < lower[i] || p[i] > upper[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    template<typename T, typename D, unsigned N>
+    bool operator==(box<T, D, N> const& a, box<T, D, N> const& b)
+    {
+        return a.lower == b.lower && a.upper == b.upper;
+    }
+
+    template<typename T, typename D, unsigned N>
+    bool operator!=(box<T, D, N> const& a, box<T, D, N> const& b)
+    {
+        return !(a == b);
+    }
+
+    //----------------------------------------------------------------
+    // Single-pass reductions over point arrays
+    //----------------------------------------------------------------
+
+    // The reductions below throw std::invalid_argument for an empty point
+    // array, and for a mass array whose size differs from that of the points.
+
+    namespace detail // for spatial statistics
+    {
+        // Raw per-chunk moments of a point array. Coordinates are accumulated
+        // relative to a common origin to keep the second moment accurate for
+        // points far from the coordinate origin.
+        template<typename T, unsigned N>
+        struct point_moments
+        {
+            T lower[N];
+            T upper[N];
+            T sum[N];
+            T squared_sum;
+            T weight;
+        };
+
+        template<typename T, typename D, unsigned N, typename W>
+        point_moments<T, N> accumulate_moments(
+            point<T, D, N> const* points,
+            point<T, D, N> const& origin,
+            std::size_t begin,
+            std::size_t end,
+            W weight_of)
+        {
+            point_moments<T, N> moments;
+            for (unsigned k = 0; k < N; ++k) {
+                moments.lower[k] = points[begin][k].value();
+                moments.upper[k] = points[begin][k].value();
+                moments.sum[k] = T(0);
+            }
+            moments.squared_sum = T(0);
+            moments.weight = T(0);
+
+            // Plain loops over raw numbers so that compilers can unroll the
+            // coordinate loop and vectorize over points.
+            for (std::size_t i = begin; i < end; ++i) {
+                T const w = weight_of(i);
+                T squared = T(0);
+                for (unsigned k = 0; k < N; ++k) {
+                    T const x = points[i][k].value();
+                    T const dx = x - origin[k].value();
+                    moments.lower[k] = x < moments.lower[k] ? x : moments.lower[k];
+                    moments.upper[k] = x > moments.upper[k] ? x : moments.upper[k];
+                    moments.sum[k] += w * dx;
+                    squared += dx * dx;
+                }
+                moments.squared_sum += w * squared;
+                moments.weight += w;
+            }
+            return moments;
+        }
+
+        template<typename T, unsigned N>
+        void merge_moments(point_moments<T, N>& dest, point_moments<T, N> const& src)
+        {
+            for (unsigned k = 0; k < N; ++k) {
+                dest.lower[k] = src.lower[k] < dest.lower[k] ? src.lower[k] : dest.lower[k];
+                dest.upper[k] = src.upper[k] > dest.upper[k] ? src.upper[k] : dest.upper[k];
+                dest.sum[k] += src.sum[k];
+            }
+            dest.squared_sum += src.squared_sum;
+            dest.weight += src.weight;
+        }
+
+        inline void check_point_count(std::size_t count)
+        {
+            if (count == 0) {
+                throw std::invalid_argument("point array must not be empty");
+            }
+        }
+
+        inline void check_mass_count(std::size_t points, std::size_t masses)
+        {
+            if (masses != points) {
+                throw std::invalid_argument("mass count does not match point count");
+            }
+        }
+
+        // Computes moments of a non-empty point array using multiple threads.
+        template<typename T, typename D, unsigned N, typename W>
+        point_moments<T, N> compute_moments(
+            point<T, D, N> const* points, std::size_t count, W weight_of)
+        {
+            check_point_count(count);
+            point<T, D, N> const origin = points[0];
+            std::size_t const chunks = chunk_count(count);
+            std::vector<point_moments<T, N>> partials(chunks);
+
+            parallel_chunks(count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                partials[chunk] = accumulate_moments(points, origin, begin, end, weight_of);
+            });
+
+            for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+                merge_moments(partials[0], partials[chunk]);
+            }
+            return partials[0];
+        }
+
+        template<typename T>
+        struct unit_weight
+        {
+            T operator()(std::size_t) const
+            {
+                return T(1);
+            }
+        };
+
+        template<typename T, typename DM>
+        struct mass_weight
+        {
+            scalar<T, DM> const* masses;
+
+            T operator()(std::size_t i) const
+            {
+                return masses[i].value();
+            }
+        };
+
+        template<typename T, typename D, unsigned N>
+        box<T, D, N> moments_box(point_moments<T, N> const& moments)
+        {
+            box<T, D, N> result;
+            for (unsigned k = 0; k < N; ++k) {
+                result.lower[k] = scalar<T, D>{moments.lower[k]};
+                result.upper[k] = scalar<T, D>{moments.upper[k]};
+            }
+            return result;
+        }
+
+        template<typename T, typename D, unsigned N>
+        point<T, D, N> moments_mean(point_moments<T, N> const& moments, point<T, D, N> origin)
+        {
+            for (unsigned k = 0; k < N; ++k) {
+                origin[k] += scalar<T, D>{moments.sum[k] / moments.weight};
+            }
+            return origin;
+        }
+
+        template<typename T, typename D, unsigned N>
+        scalar<T, D> moments_gyration(point_moments<T, N> const& moments)
+        {
+            T mean_squared = T(0);
+            for (unsigned k = 0; k < N; ++k) {
+                T const mean = moments.sum[k] / moments.weight;
+                mean_squared += mean * mean;
+            }
+            T const variance = moments.squared_sum / moments.weight - mean_squared;
+            return sqrt(scalar<T, power_dimension_t<D, 2>>{variance > T(0) ? variance : T(0)});
+        }
+    } // namespace detail
+
+    /*
+     * Summary of the spatial distribution of a point array.
+     */
+    template<typename T, typename D, unsigned N>
+    struct point_statistics
+    {
+        box<T, D, N> bounds;
+        point<T, D, N> centroid;
+        scalar<T, D> radius_of_gyration;
+    };
+
+    /*
+     * Computes the bounding box, the centroid and the radius of gyration of
+     * a non-empty point array in a single pass over memory.
+     */
+    template<typename T, typename D, unsigned N>
+    point_statistics<T, D, N> compute_statistics(point<T, D, N> const* points, std::size_t count)
+    {
+        auto const moments = detail::compute_moments(points, count, detail::unit_weight<T>{});
+        point_statistics<T, D, N> result;
+        result.bounds = detail::moments_box<T, D>(moments);
+        result.centroid = detail::moments_mean(moments, points[0]);
+        result.radius_of_gyration = detail::moments_gyration<T, D>(moments);
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N>
+    point_statistics<T, D, N> compute_statistics(std::vector<point<T, D, N>> const& points)
+    {
+        return compute_statistics(points.data(), points.size());
+    }
+
+    /*
+     * Computes the smallest axis-aligned box containing all the points in a
+     * non-empty array.
+     */
+    template<typename T, typename D, unsigned N>
+    box<T, D, N> bounding_box(point<T, D, N> const* points, std::size_t count)
+    {
+        detail::check_point_count(count);
+        std::size_t const chunks = detail::chunk_count(count);
+        std::vector<box<T, D, N>> partials(chunks);
+
+        detail::parallel_chunks(
+            count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                T lower[N];
+                T upper[N];
+                for (unsigned k = 0; k < N; ++k) {
+                    lower[k] = upper[k] = points[begin][k].value();
+                }
+                for (std::size_t i = begin; i < end; ++i) {
+                    for (unsigned k = 0; k < N; ++k) {
+                        T const x = points[i][k].value();
+                        lower[k] = x < lower[k] ? x : lower[k];
+                        upper[k] = x > upper[k] ? x : upper[k];
+                    }
+                }
+                for (unsigned k = 0; k < N; ++k) {
+                    partials[chunk].lower[k] = scalar<T, D>{lower[k]};
+                    partials[chunk].upper[k] = scalar<T, D>{upper[k]};
+                }
+            });
+
+        box<T, D, N> result = partials[0];
+        for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+            for (unsigned k = 0; k < N; ++k) {
+                if (partials[chunk].lower[k] < result.lower[k]) {
+                    result.lower[k] = partials[chunk].lower[k];
+                }
+                if (partials[chunk].upper[k] > result.upper[k]) {
+                    result.upper[k] = partials[chunk].upper[k];
+                }
+            }
+        }
+        return result;
+    }
+
+    template<typename T, typename D, unsigned N>
+    box<T, D, N> bounding_box(std::vector<point<T, D, N>> const& points)
+    {
+        return bounding_box(points.data(), points.size());
+    }
+
+    /*
+     * Computes the arithmetic mean of the points in a non-empty array.
+     */
+    template<typename T, typename D, unsigned N>
+    point<T, D, N> centroid(point<T, D, N> const* points, std::size_t count)
+    {
+        auto const moments = detail::compute_moments(points, count, detail::unit_weight<T>{});
+        return detail::moments_mean(moments, points[0]);
+    }
+
+    template<typename T, typename D, unsigned N>
+    point<T, D, N> centroid(std::vector<point<T, D, N>> const& points)
+    {
+        return centroid(points.data(), points.size());
+    }
+
+    /*
+     * Computes the root-mean-square distance of the points in a non-empty
+     * array from their centroid.
+     */
+    template<typename T, typename D, unsigned N>
+    scalar<T, D> radius_of_gyration(point<T, D, N> const* points, std::size_t count)
+    {
+        auto const moments = detail::compute_moments(points, count, detail::unit_weight<T>{});
+        return detail::moments_gyration<T, D>(moments);
+    }
+
+    template<typename T, typename D, unsigned N>
+    scalar<T, D> radius_of_gyration(std::vector<point<T, D, N>> const& points)
+    {
+        return radius_of_gyration(points.data(), points.size());
+    }
+
+    /*
+     * Computes the mass-weighted radius of gyration of a non-empty point
+     * array. masses must point to count masses of any dimension.
+     */
+    template<typename T, typename D, unsigned N, typename DM>
+    scalar<T, D> radius_of_gyration(
+        point<T, D, N> const* points, scalar<T, DM> const* masses, std::size_t count)
+    {
+        auto const moments =
+            detail::compute_moments(points, count, detail::mass_weight<T, DM>{masses});
+        return detail::moments_gyration<T, D>(moments);
+    }
+
+    template<typename T, typename D, unsigned N, typename DM>
+    scalar<T, D> radius_of_gyration(
+        std::vector<point<T, D, N>> const& points, std::vector<scalar<T, DM>> const& masses)
+    {
+        detail::check_mass_count(points.size(), masses.size());
+        return radius_of_gyration(points.data(), masses.data(), points.size());
+    }
+
+    /*
+     * Computes the mass-weighted mean of the points in a non-empty array.
+     * masses must point to count masses of any dimension.
+     */
+    template<typename T, typename D, unsigned N, typename DM>
+    point<T, D, N> center_of_mass(
+        point<T, D, N> const* points, scalar<T, DM> const* masses, std::size_t count)
+    {
+        auto const moments =
+            detail::compute_moments(points, count, detail::mass_weight<T, DM>{masses});
+        return detail::moments_mean(moments, points[0]);
+    }
+
+    template<typename T, typename D, unsigned N, typename DM>
+    point<T, D, N> center_of_mass(
+        std::vector<point<T, D, N>> const& points, std::vector<scalar<T, DM>> const& masses)
+    {
+        detail::check_mass_count(points.size(), masses.size());
+        return center_of_mass(points.data(), masses.data(), points.size());
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_GEOMETRY_HPP
@@ -0,0 +1,403 @@
+/*
+ * dim - Implicit KD-tree for nearest-neighbor searches over dim::point.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_KDTREE_HPP
+#define INCLUDED_DIM_KDTREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+#include "dim_timer.hpp"
+
+namespace dim
+{
+    /*
+     * Static KD-tree over points. The tree has no explicit nodes: points are
+     * stored in tree order so that the median of every subrange [begin, end)
+     * is the node splitting that subrange, and only the split axis is kept
+     * for each node.
+     */
+    template<typename T, typename D, unsigned N>
+    class kdtree
+    {
+      public:
+        using number_type = T;
+        using scalar_type = scalar<T, D>;
+        using point_type = point<T, D, N>;
+        static constexpr unsigned dimension = N;
+
+        /*
+         * Search result: the index of a point in the array the tree was built
+         * from and its distance from the query point.
+         */
+        struct neighbor
+        {
+            std::size_t index;
+            scalar_type distance;
+        };
+
+        /*
+         * Reusable traversal state. Queries using the same workspace do not
+         * allocate memory once the workspace has grown to the needed size.
+         * A workspace must not be shared among threads.
+         */
+        class workspace
+        {
+            friend class kdtree;
+
+            struct frame
+            {
+                std::size_t begin;
+                std::size_t end;
+                T bound;
+            };
+
+            struct candidate
+            {
+                T squared_distance;
+                std::size_t node;
+
+                bool operator<(candidate const& other) const
+                {
+                    return squared_distance < other.squared_distance;
+                }
+            };
+
+            std::vector<frame> stack_;
+            std::vector<candidate> heap_;
+        };
+
+        kdtree() = default;
+
+        /*
+         * Builds a tree over count points. The points are copied.
+         */
+        kdtree(point_type const* points, std::size_t count)
+        {
+            build(points, count);
+        }
+
+        explicit kdtree(std::vector<point_type> const& points)
+        {
+            build(points.data(), points.size());
+        }
+
+        std::size_t size() const
+        {
+            return points_.size();
+        }
+
+        /*
+         * Finds the k nearest points to query, sorted in the ascending order
+         * of distance. Fewer than k points are returned if the tree has less
+         * than k points.
+         */
+        void knn(point_type const& query,
+            std::size_t k,
+            workspace& work,
+            std::vector<neighbor>& result) const
+        {
+            result.clear();
+            search_knn(query, k, work);
+            std::sort_heap(work.heap_.begin(), work.heap_.end());
+            for (auto const& cand : work.heap_) {
+                result.push_back(make_neighbor(cand));
+            }
+        }
+
+        std::vector<neighbor> knn(point_type const& query, std::size_t k) const
+        {
+            workspace work;
+            std::vector<neighbor> result;
+            knn(query, k, work, result);
+            return result;
+        }
+
+        /*
+         * Finds k nearest points for each of count query points using
+         * multiple threads. Results are stored in results[i * k + j] for the
+         * j-th nearest point to queries[i]. k must not exceed size().
+         */
+        void knn(point_type const* queries,
+            std::size_t count,
+            std::size_t k,
+            neighbor* results) const
+        {
+            detail::parallel_chunks(count,
+                detail::chunk_count(count, 256),
+                [&](std::size_t, std::size_t begin, std::size_t end) {
+                    workspace work;
+                    for (std::size_t i = begin; i < end; ++i) {
+                        search_knn(queries[i], k, work);
+                        std::sort_heap(work.heap_.begin(), work.heap_.end());
+                        for (std::size_t j = 0; j < work.heap_.size(); ++j) {
+                            results[i * k + j] = make_neighbor(work.heap_[j]);
+                        }
+                    }
+                });
+        }
+
+        /*
+         * Finds all points within radius from query (inclusive). The results
+         * are not sorted.
+         */
+        void radius_query(point_type const& query,
+            scalar_type radius,
+            workspace& work,
+            std::vector<neighbor>& result) const
+        {
+            result.clear();
+            for_each_within(query, radius, work, [&](std::size_t node, T squared_distance) {
+                result.push_back(neighbor{indices_[node], scalar_type{std::sqrt(squared_distance)}});
+            });
+        }
+
+        std::vector<neighbor> radius_query(point_type const& query, scalar_type radius) const
+        {
+            workspace work;
+            std::vector<neighbor> result;
+            radius_query(query, radius, work, result);
+            return result;
+        }
+
+        /*
+         * Runs radius queries for count query points using multiple threads.
+         * callback(i, neighbors, n) is called for each query point queries[i]
+         * with the n neighbors found. The callback may be called concurrently
+         * from different threads, and the neighbors array is valid only
+         * during the call.
+         */
+        template<typename Callback>
+        void radius_query(point_type const* queries,
+            std::size_t count,
+            scalar_type radius,
+            Callback callback) const
+        {
+            detail::parallel_chunks(count,
+                detail::chunk_count(count, 256),
+                [&](std::size_t, std::size_t begin, std::size_t end) {
+                    workspace work;
+                    std::vector<neighbor> found;
+                    for (std::size_t i = begin; i < end; ++i) {
+                        radius_query(queries[i], radius, work, found);
+                        callback(i, static_cast<neighbor const*>(found.data()), found.size());
+                    }
+                });
+        }
+
+      private:
+        // Subtrees smaller than this are built on the calling thread.
+        static constexpr std::size_t parallel_build_threshold = 32768;
+
+        std::vector<point_type> points_;
+        std::vector<std::size_t> indices_;
+        std::vector<unsigned> axes_;
+
+        void build(point_type const* points, std::size_t count)
+        {
+            DIM_TIMER_SCOPE("dim::kdtree::build", count, 0);
+            indices_.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                indices_[i] = i;
+            }
+            axes_.assign(count, 0);
+
+            unsigned spawn_depth = 0;
+            for (unsigned threads = std::thread::hardware_concurrency(); threads > 1;
+                 threads /= 2) {
+                spawn_depth++;
+            }
+            build_range(points, 0, count, spawn_depth);
+
+            points_.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                points_[i] = points[indices_[i]];
+            }
+        }
+
+        void build_range(point_type const* points,
+            std::size_t begin,
+            std::size_t end,
+            unsigned spawn_depth)
+        {
+            if (end - begin <= 1) {
+                return;
+            }
+
+            // Split along the axis of the largest spread.
+            T lower[N];
+            T upper[N];
+            for (unsigned k = 0; k < N; ++k) {
+                lower[k] = upper[k] = points[indices_[begin]][k].value();
+            }
+            for (std::size_t i = begin; i < end; ++i) {
+                for (unsigned k = 0; k < N; ++k) {
+                    T const x = points[indices_[i]][k].value();
+                    lower[k] = x < lower[k] ? x : lower[k];
+                    upper[k] = x > upper[k] ? x : upper[k];
+                }
+            }
+            unsigned axis = 0;
+            for (unsigned k = 1; k < N; ++k) {
+                if (upper[k] - lower[k] > upper[axis] - lower[axis]) {
+                    axis = k;
+                }
+            }
+
+            std::size_t const mid = begin + (end - begin) / 2;
+            std::nth_element(indices_.begin() + std::ptrdiff_t(begin),
+                indices_.begin() + std::ptrdiff_t(mid),
+                indices_.begin() + std::ptrdiff_t(end),
+                [&](std::size_t i, std::size_t j) { return points[i][axis] < points[j][axis]; });
+            axes_[mid] = axis;
+
+            if (spawn_depth > 0 && end - begin > parallel_build_threshold) {
+                std::thread left([=] { build_range(points, begin, mid, spawn_depth - 1); });
+                build_range(points, mid + 1, end, spawn_depth - 1);
+                left.join();
+            } else {
+                build_range(points, begin, mid, 0);
+                build_range(points, mid + 1, end, 0);
+            }
+        }
+
+        neighbor make_neighbor(typename workspace::candidate const& cand) const
+        {
+            return neighbor{indices_[cand.node], scalar_type{std::sqrt(cand.squared_distance)}};
+        }
+
+        T squared_distance_to(point_type const& query, std::size_t node) const
+        {
+            T sum = T(0);
+            for (unsigned k = 0; k < N; ++k) {
+                T const delta = query[k].value() - points_[node][k].value();
+                sum += delta * delta;
+            }
+            return sum;
+        }
+
+        // Leaves the k nearest candidates in work.heap_ as a max-heap.
+        void search_knn(point_type const& query, std::size_t k, workspace& work) const
+        {
+            auto& heap = work.heap_;
+            auto& stack = work.stack_;
+            heap.clear();
+            stack.clear();
+            if (k == 0 || points_.empty()) {
+                return;
+            }
+
+            stack.push_back({0, points_.size(), T(0)});
+            while (!stack.empty()) {
+                auto const frame = stack.back();
+                stack.pop_back();
+                if (heap.size() == k && frame.bound >= heap.front().squared_distance) {
+                    continue;
+                }
+
+                std::size_t const mid = frame.begin + (frame.end - frame.begin) / 2;
+                T const dist2 = squared_distance_to(query, mid);
+                if (heap.size() < k) {
+                    heap.push_back({dist2, mid});
+                    std::push_heap(heap.begin(), heap.end());
+                } else if (dist2 < heap.front().squared_distance) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = {dist2, mid};
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                push_children(query, frame, mid, stack);
+            }
+        }
+
+        template<typename F>
+        void for_each_within(
+            point_type const& query, scalar_type radius, workspace& work, F fn) const
+        {
+            auto& stack = work.stack_;
+            stack.clear();
+            if (points_.empty()) {
+                return;
+            }
+
+            T const radius2 = radius.value() * radius.value();
+            stack.push_back({0, points_.size(), T(0)});
+            while (!stack.empty()) {
+                auto const frame = stack.back();
+                stack.pop_back();
+                if (frame.bound > radius2) {
+                    continue;
+                }
+
+                std::size_t const mid = frame.begin + (frame.end - frame.begin) / 2;
+                T const dist2 = squared_distance_to(query, mid);
+                if (dist2 <= radius2) {
+                    fn(mid, dist2);
+                }
+                push_children(query, frame, mid, stack);
+            }
+        }
+
+        // Pushes the far child and then the near child so that the near one
+        // is visited first. The far child is bounded by the distance to the
+        // splitting plane.
+        void push_children(point_type const& query,
+            typename workspace::frame const& frame,
+            std::size_t mid,
+            std::vector<typename workspace::frame>& stack) const
+        {
+            unsigned const axis = axes_[mid];
+            T const delta = query[axis].value() - points_[mid][axis].value();
+            T const plane2 = delta * delta > frame.bound ? delta * delta : frame.bound;
+
+            typename workspace::frame const left = {frame.begin, mid, frame.bound};
+            typename workspace::frame const right = {mid + 1, frame.end, frame.bound};
+            if (delta < T(0)) {
+                if (right.begin < right.end) {
+                    stack.push_back({right.begin, right.end, plane2});
+                }
+                if (left.begin < left.end) {
+                    stack.push_back(left);
+                }
+            } else {
+                if (left.begin < left.end) {
+                    stack.push_back({left.begin, left.end, plane2});
+                }
+                if (right.begin < right.end) {
+                    stack.push_back(right);
+                }
+            }
+        }
+    };
+} // namespace dim
+
+#endif // INCLUDED_DIM_KDTREE_HPP
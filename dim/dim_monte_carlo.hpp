@@ -0,0 +1,616 @@
+/*
+ * dim - Metropolis Monte Carlo with incremental energy evaluation.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_MONTE_CARLO_HPP
+#define INCLUDED_DIM_MONTE_CARLO_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+#include "dim_timer.hpp"
+
+namespace dim
+{
+    /*
+     * Parameters of a Metropolis Monte Carlo simulation in an orthorhombic
+     * periodic box. cutoff must be positive and must not exceed the half of
+     * the shortest box side.
+     */
+    template<typename T>
+    struct monte_carlo_parameters
+    {
+        // Side lengths of the periodic box.
+        vector<T, mech::length, 3> box;
+
+        // Distance beyond which the pair potential is zero.
+        scalar<T, mech::length> cutoff;
+
+        // Maximum displacement along each axis in a trial move.
+        scalar<T, mech::length> max_step;
+
+        // Thermal energy k_B T of the sampled Boltzmann distribution.
+        scalar<T, mech::energy> thermal_energy;
+    };
+
+    /*
+     * Counts of trial moves and the total energy change of accepted moves.
+     */
+    template<typename T>
+    struct move_statistics
+    {
+        std::size_t attempted = 0;
+        std::size_t accepted = 0;
+        scalar<T, mech::energy> energy_change;
+
+        T acceptance_ratio() const
+        {
+            return attempted == 0 ? T(0) : T(accepted) / T(attempted);
+        }
+
+        move_statistics& operator+=(move_statistics const& other)
+        {
+            attempted += other.attempted;
+            accepted += other.accepted;
+            energy_change += other.energy_change;
+            return *this;
+        }
+    };
+
+    namespace detail // for dim::monte_carlo
+    {
+        // SplitMix64 generator (Steele, Lea and Flood, OOPSLA 2014). It is
+        // cheap to seed, so every cell of a checkerboard sweep gets its own
+        // stream.
+        class splitmix64
+        {
+          public:
+            using result_type = std::uint64_t;
+
+            explicit splitmix64(std::uint64_t seed)
+                : state_{seed}
+            {
+            }
+
+            static constexpr result_type min()
+            {
+                return 0;
+            }
+
+            static constexpr result_type max()
+            {
+                return ~result_type(0);
+            }
+
+            result_type operator()()
+            {
+                std::uint64_t z = (state_ += 0x9E3779B97F4A7C15u);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+                return z ^ (z >> 31);
+            }
+
+          private:
+            std::uint64_t state_;
+        };
+
+        // Returns a uniform random number in [0, 1).
+        template<typename T, typename URBG>
+        T uniform_unit(URBG& rng)
+        {
+            T const u = std::generate_canonical<T, std::numeric_limits<T>::digits>(rng);
+            return u < T(1) ? u : T(0);
+        }
+
+        // Returns a uniform random index in [0, count).
+        template<typename URBG>
+        std::size_t uniform_index(URBG& rng, std::size_t count)
+        {
+            std::size_t const index = std::size_t(uniform_unit<double>(rng) * double(count));
+            return index < count ? index : count - 1;
+        }
+
+        // Writes the distinct cells adjacent to (and including) cell c along
+        // an axis of size cells, and returns how many there are.
+        inline unsigned adjacent_cells(std::size_t c, std::size_t cells, std::size_t* result)
+        {
+            if (cells < 3) {
+                result[0] = c;
+                result[1] = cells - 1 - c;
+                return unsigned(cells);
+            }
+            result[0] = (c + cells - 1) % cells;
+            result[1] = c;
+            result[2] = (c + 1) % cells;
+            return 3;
+        }
+    } // namespace detail
+
+    /*
+     * Metropolis Monte Carlo engine for particles interacting by a pair
+     * potential with a finite cutoff in a periodic box.
+     *
+     * Particles are binned into a cell list, so the energy change of a trial
+     * move is computed from the neighbors of the moved particle alone in O(1)
+     * time instead of recomputing the total energy. The engine keeps the
+     * running total energy up to date with the accepted changes.
+     *
+     * P is a callable taking a squared distance, scalar<T, length^2>, and
+     * returning the pair energy. It is only called for squared distances
+     * below the squared cutoff. tabulated_function is such a callable.
+     */
+    template<typename T, typename P>
+    class monte_carlo
+    {
+      public:
+        using number_type = T;
+        using potential_type = P;
+        using point_type = point<T, mech::length, 3>;
+        using length_type = scalar<T, mech::length>;
+        using squared_length_type = scalar<T, power_dimension_t<mech::length, 2>>;
+        using energy_type = scalar<T, mech::energy>;
+        using statistics_type = move_statistics<T>;
+
+        /*
+         * Creates an engine for count particles. Positions are wrapped into
+         * the box. Throws std::invalid_argument if the parameters are not
+         * valid.
+         */
+        monte_carlo(monte_carlo_parameters<T> const& params,
+            P potential,
+            point_type const* positions,
+            std::size_t count)
+            : params_(params)
+            , potential_(potential)
+            , positions_(positions, positions + count)
+        {
+            T const rc = params.cutoff.value();
+            if (!(rc > T(0))) {
+                throw std::invalid_argument("cutoff must be positive");
+            }
+            for (unsigned k = 0; k < 3; ++k) {
+                T const side = params.box[k].value();
+                if (!(rc * 2 <= side)) {
+                    throw std::invalid_argument("cutoff must not exceed half the box size");
+                }
+
+                // Cells are at least as large as the cutoff. Their number is
+                // kept even so that cells can be colored as a checkerboard.
+                std::size_t n = std::size_t(side / rc);
+                n = n > 2 && n % 2 == 1 ? n - 1 : n;
+                cells_[k] = n;
+                cell_width_[k] = side / T(n);
+                shift_[k] = T(0);
+            }
+            for (auto& position : positions_) {
+                position = wrap(position);
+            }
+            rebuild_cells();
+            energy_ = total_energy().value();
+        }
+
+        monte_carlo(monte_carlo_parameters<T> const& params,
+            P potential,
+            std::vector<point_type> const& positions)
+            : monte_carlo(params, potential, positions.data(), positions.size())
+        {
+        }
+
+        monte_carlo_parameters<T> const& parameters() const
+        {
+            return params_;
+        }
+
+        P const& potential() const
+        {
+            return potential_;
+        }
+
+        std::size_t size() const
+        {
+            return positions_.size();
+        }
+
+        /*
+         * Returns the current positions, wrapped into [0, box).
+         */
+        std::vector<point_type> const& positions() const
+        {
+            return positions_;
+        }
+
+        /*
+         * Changes the maximum displacement of trial moves, e.g. to tune the
+         * acceptance ratio during equilibration.
+         */
+        void set_max_step(length_type max_step)
+        {
+            params_.max_step = max_step;
+        }
+
+        /*
+         * Returns the total energy kept up to date by accepted moves.
+         */
+        energy_type energy() const
+        {
+            return energy_type{energy_};
+        }
+
+        /*
+         * Computes the total energy from scratch. Comparing it with energy()
+         * measures the accumulated rounding drift.
+         */
+        energy_type total_energy() const
+        {
+            std::size_t const count = positions_.size();
+            std::size_t const chunks = detail::chunk_count(count, 1024);
+            std::vector<T> energies(chunks, T(0));
+            detail::parallel_chunks(
+                count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    T energy = T(0);
+                    for (std::size_t i = begin; i < end; ++i) {
+                        energy += local_energy(positions_[i], i);
+                    }
+                    energies[chunk] = energy;
+                });
+
+            // Each pair is counted from both sides.
+            T total = T(0);
+            for (T const e : energies) {
+                total += e;
+            }
+            return energy_type{total / 2};
+        }
+
+        /*
+         * Returns the interaction energy of particle i with all the others.
+         */
+        energy_type particle_energy(std::size_t i) const
+        {
+            return energy_type{local_energy(positions_[i], i)};
+        }
+
+        /*
+         * Returns the change of the total energy if particle i were moved to
+         * trial. The configuration is not changed.
+         */
+        energy_type delta_energy(std::size_t i, point_type const& trial) const
+        {
+            return energy_type{local_energy(wrap(trial), i) - local_energy(positions_[i], i)};
+        }
+
+        /*
+         * Computes the energy changes of count independent trial moves of
+         * particles indices[m] to trials[m], each against the current
+         * configuration, using multiple threads.
+         */
+        void delta_energy(std::size_t const* indices,
+            point_type const* trials,
+            std::size_t count,
+            energy_type* deltas) const
+        {
+            detail::parallel_for(
+                count, [&](std::size_t m) { deltas[m] = delta_energy(indices[m], trials[m]); }, 256);
+        }
+
+        /*
+         * Moves particle i to position and updates the cell list and the
+         * running energy. Returns the energy change.
+         */
+        energy_type move(std::size_t i, point_type const& position)
+        {
+            point_type const wrapped = wrap(position);
+            T const delta = local_energy(wrapped, i) - local_energy(positions_[i], i);
+            place(i, wrapped);
+            energy_ += delta;
+            return energy_type{delta};
+        }
+
+        /*
+         * Performs a batch of moves trial moves of randomly chosen particles
+         * with the Metropolis criterion.
+         */
+        template<typename URBG>
+        statistics_type sweep(URBG& rng, std::size_t moves)
+        {
+            statistics_type stats;
+            if (positions_.empty()) {
+                return stats;
+            }
+
+            T change = T(0);
+            for (std::size_t m = 0; m < moves; ++m) {
+                std::size_t const i = detail::uniform_index(rng, positions_.size());
+                point_type const trial = wrap(displace(positions_[i], rng));
+                T const delta = local_energy(trial, i) - local_energy(positions_[i], i);
+
+                stats.attempted++;
+                if (accept(delta, rng)) {
+                    place(i, trial);
+                    change += delta;
+                    stats.accepted++;
+                }
+            }
+            energy_ += change;
+            stats.energy_change = energy_type{change};
+            return stats;
+        }
+
+        /*
+         * Performs as many trial moves as there are particles.
+         */
+        template<typename URBG>
+        statistics_type sweep(URBG& rng)
+        {
+            return sweep(rng, positions_.size());
+        }
+
+        /*
+         * Performs on average one trial move per particle using multiple
+         * threads. Cells are colored as a 2x2x2 checkerboard and the cells
+         * of one color are updated concurrently: a particle only moves within
+         * its own cell, so no two concurrent moves share a neighbor. The cell
+         * grid is shifted by a random offset before each sweep so that
+         * particles can still cross cell boundaries over many sweeps.
+         *
+         * All random numbers are derived from rng, so the result does not
+         * depend on the number of threads.
+         */
+        template<typename URBG>
+        statistics_type checkerboard_sweep(URBG& rng)
+        {
+            for (unsigned k = 0; k < 3; ++k) {
+                shift_[k] = detail::uniform_unit<T>(rng) * cell_width_[k];
+            }
+            rebuild_cells();
+
+            unsigned colors[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+            for (unsigned c = 7; c > 0; --c) {
+                std::swap(colors[c], colors[detail::uniform_index(rng, c + 1)]);
+            }
+
+            statistics_type total;
+            std::vector<std::size_t> active;
+            std::vector<std::uint64_t> seeds;
+            for (unsigned const color : colors) {
+                active.clear();
+                for (std::size_t x = color >> 2 & 1; x < cells_[0]; x += 2) {
+                    for (std::size_t y = color >> 1 & 1; y < cells_[1]; y += 2) {
+                        for (std::size_t z = color & 1; z < cells_[2]; z += 2) {
+                            active.push_back((x * cells_[1] + y) * cells_[2] + z);
+                        }
+                    }
+                }
+                seeds.resize(active.size());
+                for (auto& seed : seeds) {
+                    seed = rng();
+                }
+
+                std::size_t const chunks = detail::chunk_count(active.size(), 16);
+                std::vector<statistics_type> partials(chunks);
+                detail::parallel_chunks(
+                    active.size(), chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                        for (std::size_t a = begin; a < end; ++a) {
+                            partials[chunk] += sweep_cell(active[a], seeds[a]);
+                        }
+                    });
+                for (auto const& partial : partials) {
+                    energy_ += partial.energy_change.value();
+                    total += partial;
+                }
+            }
+            return total;
+        }
+
+      private:
+        monte_carlo_parameters<T> params_;
+        P potential_;
+        std::vector<point_type> positions_;
+        std::size_t cells_[3];
+        T cell_width_[3];
+        T shift_[3];
+        std::vector<std::size_t> cell_of_;
+        std::vector<std::size_t> slot_of_;
+        std::vector<std::vector<std::size_t>> members_;
+        T energy_ = T(0);
+
+        point_type wrap(point_type const& position) const
+        {
+            point_type result;
+            for (unsigned k = 0; k < 3; ++k) {
+                T const side = params_.box[k].value();
+                T const x = position[k].value();
+                T wrapped = x - side * std::floor(x / side);
+                wrapped = wrapped < side ? wrapped : T(0);
+                result[k] = length_type{wrapped};
+            }
+            return result;
+        }
+
+        std::size_t cell_coordinate(point_type const& position, unsigned k) const
+        {
+            T const s = std::floor((position[k].value() - shift_[k]) / cell_width_[k]);
+            std::ptrdiff_t c = std::ptrdiff_t(s) % std::ptrdiff_t(cells_[k]);
+            c = c < 0 ? c + std::ptrdiff_t(cells_[k]) : c;
+            return std::size_t(c);
+        }
+
+        std::size_t cell_index(point_type const& position) const
+        {
+            return (cell_coordinate(position, 0) * cells_[1] + cell_coordinate(position, 1))
+                * cells_[2]
+                + cell_coordinate(position, 2);
+        }
+
+        void rebuild_cells()
+        {
+            DIM_TIMER_SCOPE("dim::monte_carlo::rebuild_cells", positions_.size(), 0);
+            members_.assign(cells_[0] * cells_[1] * cells_[2], std::vector<std::size_t>{});
+            cell_of_.resize(positions_.size());
+            slot_of_.resize(positions_.size());
+            for (std::size_t i = 0; i < positions_.size(); ++i) {
+                std::size_t const c = cell_index(positions_[i]);
+                cell_of_[i] = c;
+                slot_of_[i] = members_[c].size();
+                members_[c].push_back(i);
+            }
+        }
+
+        // Moves particle i to a wrapped position and updates the cell list.
+        void place(std::size_t i, point_type const& position)
+        {
+            positions_[i] = position;
+
+            std::size_t const c = cell_index(position);
+            std::size_t const old = cell_of_[i];
+            if (c == old) {
+                return;
+            }
+            auto& from = members_[old];
+            std::size_t const moved = from.back();
+            from[slot_of_[i]] = moved;
+            slot_of_[moved] = slot_of_[i];
+            from.pop_back();
+
+            cell_of_[i] = c;
+            slot_of_[i] = members_[c].size();
+            members_[c].push_back(i);
+        }
+
+        // Returns the interaction energy of a particle at position with all
+        // particles except self.
+        T local_energy(point_type const& position, std::size_t self) const
+        {
+            T const rc2 = params_.cutoff.value() * params_.cutoff.value();
+            T const side[3] = {
+                params_.box[0].value(), params_.box[1].value(), params_.box[2].value()};
+            T const x[3] = {position[0].value(), position[1].value(), position[2].value()};
+
+            std::size_t adjacent[3][3];
+            unsigned counts[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                counts[k] = detail::adjacent_cells(cell_coordinate(position, k), cells_[k], adjacent[k]);
+            }
+
+            T energy = T(0);
+            for (unsigned a = 0; a < counts[0]; ++a) {
+                for (unsigned b = 0; b < counts[1]; ++b) {
+                    for (unsigned c = 0; c < counts[2]; ++c) {
+                        std::size_t const cell =
+                            (adjacent[0][a] * cells_[1] + adjacent[1][b]) * cells_[2] + adjacent[2][c];
+                        for (std::size_t const j : members_[cell]) {
+                            if (j == self) {
+                                continue;
+                            }
+                            T r2 = T(0);
+                            for (unsigned k = 0; k < 3; ++k) {
+                                T delta = x[k] - positions_[j][k].value();
+                                delta -= side[k] * std::round(delta / side[k]);
+                                r2 += delta * delta;
+                            }
+                            if (r2 < rc2) {
+                                energy += energy_type{potential_(squared_length_type{r2})}.value();
+                            }
+                        }
+                    }
+                }
+            }
+            return energy;
+        }
+
+        template<typename URBG>
+        point_type displace(point_type const& position, URBG& rng) const
+        {
+            T const step = params_.max_step.value();
+            point_type result = position;
+            for (unsigned k = 0; k < 3; ++k) {
+                result[k] += length_type{(2 * detail::uniform_unit<T>(rng) - 1) * step};
+            }
+            return result;
+        }
+
+        template<typename URBG>
+        bool accept(T delta, URBG& rng) const
+        {
+            if (delta <= T(0)) {
+                return true;
+            }
+            return detail::uniform_unit<T>(rng) < std::exp(-delta / params_.thermal_energy.value());
+        }
+
+        // Performs trial moves of the particles in a cell, as many as the
+        // cell has, rejecting moves that leave the cell. Only the positions
+        // of the particles in the cell are written.
+        statistics_type sweep_cell(std::size_t cell, std::uint64_t seed)
+        {
+            statistics_type stats;
+            auto const& members = members_[cell];
+            detail::splitmix64 rng{seed};
+
+            T change = T(0);
+            for (std::size_t m = 0; m < members.size(); ++m) {
+                std::size_t const i = members[detail::uniform_index(rng, members.size())];
+                point_type const trial = wrap(displace(positions_[i], rng));
+
+                stats.attempted++;
+                if (cell_index(trial) != cell) {
+                    continue;
+                }
+                T const delta = local_energy(trial, i) - local_energy(positions_[i], i);
+                if (accept(delta, rng)) {
+                    positions_[i] = trial;
+                    change += delta;
+                    stats.accepted++;
+                }
+            }
+            stats.energy_change = energy_type{change};
+            return stats;
+        }
+    };
+
+    /*
+     * Creates a Monte Carlo engine deducing the potential type.
+     */
+    template<typename T, typename P>
+    monte_carlo<T, P> make_monte_carlo(monte_carlo_parameters<T> const& params,
+        P potential,
+        std::vector<point<T, mech::length, 3>> const& positions)
+    {
+        return monte_carlo<T, P>(params, potential, positions);
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_MONTE_CARLO_HPP
@@ -0,0 +1,411 @@
+/*
+ * dim - Operation-counting number type for profiling dim computations.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_OPCOUNT_HPP
+#define INCLUDED_DIM_OPCOUNT_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace dim
+{
+    /*
+     * Numbers of arithmetic operations and math function calls.
+     */
+    struct op_counts
+    {
+        std::uint64_t add = 0;
+        std::uint64_t sub = 0;
+        std::uint64_t mul = 0;
+        std::uint64_t div = 0;
+        std::uint64_t sqrt = 0;
+        std::uint64_t cbrt = 0;
+        std::uint64_t hypot = 0;
+        std::uint64_t pow = 0;
+        std::uint64_t abs = 0;
+        std::uint64_t compare = 0;
+
+        std::uint64_t total() const
+        {
+            return add + sub + mul + div + sqrt + cbrt + hypot + pow + abs + compare;
+        }
+
+        op_counts& operator+=(op_counts const& other)
+        {
+            add += other.add;
+            sub += other.sub;
+            mul += other.mul;
+            div += other.div;
+            sqrt += other.sqrt;
+            cbrt += other.cbrt;
+            hypot += other.hypot;
+            pow += other.pow;
+            abs += other.abs;
+            compare += other.compare;
+            return *this;
+        }
+
+        op_counts& operator-=(op_counts const& other)
+        {
+            add -= other.add;
+            sub -= other.sub;
+            mul -= other.mul;
+            div -= other.div;
+            sqrt -= other.sqrt;
+            cbrt -= other.cbrt;
+            hypot -= other.hypot;
+            pow -= other.pow;
+            abs -= other.abs;
+            compare -= other.compare;
+            return *this;
+        }
+    };
+
+    inline op_counts operator-(op_counts x, op_counts const& y)
+    {
+        return x -= y;
+    }
+
+    inline bool operator==(op_counts const& x, op_counts const& y)
+    {
+        return x.add == y.add && x.sub == y.sub && x.mul == y.mul && x.div == y.div
+            && x.sqrt == y.sqrt && x.cbrt == y.cbrt && x.hypot == y.hypot && x.pow == y.pow
+            && x.abs == y.abs && x.compare == y.compare;
+    }
+
+    inline bool operator!=(op_counts const& x, op_counts const& y)
+    {
+        return !(x == y);
+    }
+
+    /*
+     * Returns the operation counts of the calling thread.
+     */
+    inline op_counts& thread_op_counts()
+    {
+        static thread_local op_counts counts;
+        return counts;
+    }
+
+    //----------------------------------------------------------------
+    // Counting number type
+    //----------------------------------------------------------------
+
+    /*
+     * Number type that counts every arithmetic operation and math function
+     * applied to it. Usable as T in dim::scalar<T, D> and dim::vector<T, D,
+     * N>, so existing code can be profiled by changing the number type.
+     */
+    template<typename T>
+    class counted
+    {
+      public:
+        using value_type = T;
+
+        counted() = default;
+
+        counted(T value) // NOLINT
+            : value_{value}
+        {
+        }
+
+        T value() const
+        {
+            return value_;
+        }
+
+        explicit operator T() const
+        {
+            return value_;
+        }
+
+        counted& operator+=(counted rhs)
+        {
+            thread_op_counts().add++;
+            value_ += rhs.value_;
+            return *this;
+        }
+
+        counted& operator-=(counted rhs)
+        {
+            thread_op_counts().sub++;
+            value_ -= rhs.value_;
+            return *this;
+        }
+
+        counted& operator*=(counted rhs)
+        {
+            thread_op_counts().mul++;
+            value_ *= rhs.value_;
+            return *this;
+        }
+
+        counted& operator/=(counted rhs)
+        {
+            thread_op_counts().div++;
+            value_ /= rhs.value_;
+            return *this;
+        }
+
+      private:
+        T value_{};
+    };
+
+    template<typename T>
+    counted<T> operator+(counted<T> x)
+    {
+        return x;
+    }
+
+    template<typename T>
+    counted<T> operator-(counted<T> x)
+    {
+        return counted<T>{-x.value()};
+    }
+
+    template<typename T>
+    counted<T> operator+(counted<T> x, counted<T> y)
+    {
+        return x += y;
+    }
+
+    template<typename T>
+    counted<T> operator-(counted<T> x, counted<T> y)
+    {
+        return x -= y;
+    }
+
+    template<typename T>
+    counted<T> operator*(counted<T> x, counted<T> y)
+    {
+        return x *= y;
+    }
+
+    template<typename T>
+    counted<T> operator/(counted<T> x, counted<T> y)
+    {
+        return x /= y;
+    }
+
+    template<typename T>
+    bool operator==(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().compare++;
+        return x.value() == y.value();
+    }
+
+    template<typename T>
+    bool operator!=(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().compare++;
+        return x.value() != y.value();
+    }
+
+    template<typename T>
+    bool operator<(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().compare++;
+        return x.value() < y.value();
+    }
+
+    template<typename T>
+    bool operator>(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().compare++;
+        return x.value() > y.value();
+    }
+
+    template<typename T>
+    bool operator<=(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().compare++;
+        return x.value() <= y.value();
+    }
+
+    template<typename T>
+    bool operator>=(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().compare++;
+        return x.value() >= y.value();
+    }
+
+    // Math functions found by argument-dependent lookup from dim.hpp.
+
+    template<typename T>
+    counted<T> fabs(counted<T> x)
+    {
+        thread_op_counts().abs++;
+        return counted<T>{std::fabs(x.value())};
+    }
+
+    template<typename T>
+    counted<T> sqrt(counted<T> x)
+    {
+        thread_op_counts().sqrt++;
+        return counted<T>{std::sqrt(x.value())};
+    }
+
+    template<typename T>
+    counted<T> cbrt(counted<T> x)
+    {
+        thread_op_counts().cbrt++;
+        return counted<T>{std::cbrt(x.value())};
+    }
+
+    template<typename T>
+    counted<T> hypot(counted<T> x, counted<T> y)
+    {
+        thread_op_counts().hypot++;
+        return counted<T>{std::hypot(x.value(), y.value())};
+    }
+
+    template<typename T>
+    counted<T> pow(counted<T> x, int n)
+    {
+        thread_op_counts().pow++;
+        return counted<T>{std::pow(x.value(), n)};
+    }
+
+    //----------------------------------------------------------------
+    // Named scopes
+    //----------------------------------------------------------------
+
+    namespace detail // for dim::op_scope
+    {
+        struct op_registry
+        {
+            std::mutex mutex;
+            std::map<std::string, op_counts> scopes;
+        };
+
+        inline op_registry& global_op_registry()
+        {
+            static op_registry registry;
+            return registry;
+        }
+    } // namespace detail
+
+    /*
+     * Adds the operations counted on the calling thread during its lifetime
+     * to the named entry of the global registry. Nested scopes count
+     * inclusively.
+     */
+    class op_scope
+    {
+      public:
+        explicit op_scope(std::string name)
+            : name_(std::move(name)), start_(thread_op_counts())
+        {
+        }
+
+        op_scope(op_scope const&) = delete;
+        op_scope& operator=(op_scope const&) = delete;
+
+        ~op_scope()
+        {
+            op_counts const delta = thread_op_counts() - start_;
+            auto& registry = detail::global_op_registry();
+            std::lock_guard<std::mutex> lock{registry.mutex};
+            registry.scopes[name_] += delta;
+        }
+
+      private:
+        std::string name_;
+        op_counts start_;
+    };
+
+    /*
+     * Returns the counts accumulated for a named scope.
+     */
+    inline op_counts scope_op_counts(std::string const& name)
+    {
+        auto& registry = detail::global_op_registry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        auto const it = registry.scopes.find(name);
+        return it == registry.scopes.end() ? op_counts{} : it->second;
+    }
+
+    /*
+     * Clears all the scope counters.
+     */
+    inline void reset_op_counts()
+    {
+        auto& registry = detail::global_op_registry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        registry.scopes.clear();
+    }
+
+    /*
+     * Writes the scope counters as CSV with a header line.
+     */
+    inline void dump_op_counts(std::ostream& os)
+    {
+        auto& registry = detail::global_op_registry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        os << "scope,add,sub,mul,div,sqrt,cbrt,hypot,pow,abs,compare,total\n";
+        for (auto const& entry : registry.scopes) {
+            op_counts const& c = entry.second;
+            os << entry.first << ',' << c.add << ',' << c.sub << ',' << c.mul << ',' << c.div
+               << ',' << c.sqrt << ',' << c.cbrt << ',' << c.hypot << ',' << c.pow << ','
+               << c.abs << ',' << c.compare << ',' << c.total() << '\n';
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Compile-time switch
+    //----------------------------------------------------------------
+
+    /*
+     * instrumented<T> is counted<T> if DIM_COUNT_OPERATIONS is defined and T
+     * otherwise. DIM_OP_SCOPE(name) opens an op_scope for the rest of the
+     * enclosing block only if DIM_COUNT_OPERATIONS is defined. With the
+     * switch off, code written in terms of these compiles to exactly the
+     * uninstrumented code.
+     */
+#if defined(DIM_COUNT_OPERATIONS)
+    template<typename T>
+    using instrumented = counted<T>;
+
+#define DIM_OP_SCOPE_CAT2(a, b) a##b
+#define DIM_OP_SCOPE_CAT(a, b) DIM_OP_SCOPE_CAT2(a, b)
+#define DIM_OP_SCOPE(name) ::dim::op_scope DIM_OP_SCOPE_CAT(dim_op_scope_, __LINE__){name}
+#else
+    template<typename T>
+    using instrumented = T;
+
+#define DIM_OP_SCOPE(name) static_cast<void>(0)
+#endif
+} // namespace dim
+
+#endif // INCLUDED_DIM_OPCOUNT_HPP
@@ -0,0 +1,453 @@
+/*
+ * dim - Padded, over-aligned storage of three-dimensional vectors.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_PADDED_HPP
+#define INCLUDED_DIM_PADDED_HPP
+
+#if defined(__AVX2__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+#include "dim.hpp"
+
+namespace dim
+{
+    /*
+     * Storage layout tag of vector<T, D, 3, padded>. The three coordinates
+     * are followed by a pad lane and the vector is aligned to its size of
+     * 4 * sizeof(T), so that each element of an array is one aligned 256-bit
+     * (double) or 128-bit (float) load and never straddles a cache line.
+     */
+    struct padded
+    {
+    };
+
+    namespace detail // for dim::padded
+    {
+        /*
+         * Lane-wise kernels on the four numbers of a padded vector. a, b and
+         * out point to 4 * sizeof(T)-aligned storage. The generic versions
+         * are plain loops; double with AVX2 and float with SSE use one
+         * register per vector. Reductions and comparisons read only the
+         * first three lanes, and cross leaves the pad lane zero.
+         */
+        template<typename T>
+        struct padded_kernels
+        {
+            static void add(T const* a, T const* b, T* out)
+            {
+                for (unsigned i = 0; i < 4; ++i) {
+                    out[i] = a[i] + b[i];
+                }
+            }
+
+            static void subtract(T const* a, T const* b, T* out)
+            {
+                for (unsigned i = 0; i < 4; ++i) {
+                    out[i] = a[i] - b[i];
+                }
+            }
+
+            static void scale(T const* a, T factor, T* out)
+            {
+                for (unsigned i = 0; i < 4; ++i) {
+                    out[i] = a[i] * factor;
+                }
+            }
+
+            static void divide(T const* a, T divisor, T* out)
+            {
+                for (unsigned i = 0; i < 4; ++i) {
+                    out[i] = a[i] / divisor;
+                }
+            }
+
+            static bool equal(T const* a, T const* b)
+            {
+                return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+            }
+
+            static T dot(T const* a, T const* b)
+            {
+                return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+            }
+
+            static void cross(T const* a, T const* b, T* out)
+            {
+                T const x = a[1] * b[2] - a[2] * b[1];
+                T const y = a[2] * b[0] - a[0] * b[2];
+                T const z = a[0] * b[1] - a[1] * b[0];
+                out[0] = x;
+                out[1] = y;
+                out[2] = z;
+                out[3] = 0;
+            }
+        };
+
+#if defined(__AVX2__)
+        template<>
+        struct padded_kernels<double>
+        {
+            static void add(double const* a, double const* b, double* out)
+            {
+                _mm256_store_pd(out, _mm256_add_pd(_mm256_load_pd(a), _mm256_load_pd(b)));
+            }
+
+            static void subtract(double const* a, double const* b, double* out)
+            {
+                _mm256_store_pd(out, _mm256_sub_pd(_mm256_load_pd(a), _mm256_load_pd(b)));
+            }
+
+            static void scale(double const* a, double factor, double* out)
+            {
+                _mm256_store_pd(out, _mm256_mul_pd(_mm256_load_pd(a), _mm256_set1_pd(factor)));
+            }
+
+            static void divide(double const* a, double divisor, double* out)
+            {
+                _mm256_store_pd(out, _mm256_div_pd(_mm256_load_pd(a), _mm256_set1_pd(divisor)));
+            }
+
+            static bool equal(double const* a, double const* b)
+            {
+                __m256d const same = _mm256_cmp_pd(_mm256_load_pd(a), _mm256_load_pd(b), _CMP_EQ_OQ);
+                return (_mm256_movemask_pd(same) & 7) == 7;
+            }
+
+            // Sums (x + y) + z in the order of the packed dot product.
+            static double dot(double const* a, double const* b)
+            {
+                __m256d const product = _mm256_mul_pd(_mm256_load_pd(a), _mm256_load_pd(b));
+                __m128d const xy = _mm256_castpd256_pd128(product);
+                __m128d const zw = _mm256_extractf128_pd(product, 1);
+                return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), zw));
+            }
+
+            // cross(a, b) = (a * b.yzx - a.yzx * b).yzx
+            static void cross(double const* a, double const* b, double* out)
+            {
+                __m256d const va = _mm256_load_pd(a);
+                __m256d const vb = _mm256_load_pd(b);
+                __m256d const a_yzx = _mm256_permute4x64_pd(va, _MM_SHUFFLE(3, 0, 2, 1));
+                __m256d const b_yzx = _mm256_permute4x64_pd(vb, _MM_SHUFFLE(3, 0, 2, 1));
+                __m256d const zxy = _mm256_sub_pd(_mm256_mul_pd(va, b_yzx), _mm256_mul_pd(a_yzx, vb));
+                __m256d const xyz = _mm256_permute4x64_pd(zxy, _MM_SHUFFLE(3, 0, 2, 1));
+                _mm256_store_pd(out, _mm256_blend_pd(xyz, _mm256_setzero_pd(), 8));
+            }
+        };
+#endif
+
+#if defined(__SSE__)
+        template<>
+        struct padded_kernels<float>
+        {
+            static void add(float const* a, float const* b, float* out)
+            {
+                _mm_store_ps(out, _mm_add_ps(_mm_load_ps(a), _mm_load_ps(b)));
+            }
+
+            static void subtract(float const* a, float const* b, float* out)
+            {
+                _mm_store_ps(out, _mm_sub_ps(_mm_load_ps(a), _mm_load_ps(b)));
+            }
+
+            static void scale(float const* a, float factor, float* out)
+            {
+                _mm_store_ps(out, _mm_mul_ps(_mm_load_ps(a), _mm_set1_ps(factor)));
+            }
+
+            static void divide(float const* a, float divisor, float* out)
+            {
+                _mm_store_ps(out, _mm_div_ps(_mm_load_ps(a), _mm_set1_ps(divisor)));
+            }
+
+            static bool equal(float const* a, float const* b)
+            {
+                return (_mm_movemask_ps(_mm_cmpeq_ps(_mm_load_ps(a), _mm_load_ps(b))) & 7) == 7;
+            }
+
+            static float dot(float const* a, float const* b)
+            {
+                __m128 const product = _mm_mul_ps(_mm_load_ps(a), _mm_load_ps(b));
+                __m128 const xy = _mm_add_ss(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(1, 1, 1, 1)));
+                return _mm_cvtss_f32(_mm_add_ss(xy, _mm_movehl_ps(product, product)));
+            }
+
+            static void cross(float const* a, float const* b, float* out)
+            {
+                __m128 const va = _mm_load_ps(a);
+                __m128 const vb = _mm_load_ps(b);
+                __m128 const a_yzx = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 0, 2, 1));
+                __m128 const b_yzx = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 0, 2, 1));
+                __m128 const zxy = _mm_sub_ps(_mm_mul_ps(va, b_yzx), _mm_mul_ps(a_yzx, vb));
+                __m128 const xyz = _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(3, 0, 2, 1));
+                // Clear the pad lane.
+                __m128 const mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+                _mm_store_ps(out, _mm_and_ps(xyz, mask));
+            }
+        };
+#endif
+    } // namespace detail
+
+    /*
+     * Three-dimensional vector stored as four lanes aligned to 4 * sizeof(T)
+     * bytes. The pad lane is zero after construction and is ignored by ==,
+     * dot, norm and cross. It converts implicitly from and to the packed
+     * vector<T, D, 3>. Containers of padded vectors need an allocator that
+     * honors the alignment, such as dim::aligned_allocator, before C++17.
+     */
+    template<typename T, typename D>
+    class vector<T, D, 3, padded>
+    {
+        using kernels = detail::padded_kernels<T>;
+
+      public:
+        using number_type = T;
+        using scalar_type = scalar<T, D>;
+        using packed_type = vector<T, D, 3>;
+        static constexpr unsigned dimension = 3;
+
+        vector() = default;
+
+        vector(scalar_type x, scalar_type y, scalar_type z) // NOLINT
+            : coords_{x, y, z, scalar_type{}}
+        {
+        }
+
+        explicit vector(T x, T y, T z)
+            : coords_{scalar_type{x}, scalar_type{y}, scalar_type{z}, scalar_type{}}
+        {
+        }
+
+        vector(packed_type const& v) // NOLINT
+            : coords_{v[0], v[1], v[2], scalar_type{}}
+        {
+        }
+
+        operator packed_type() const // NOLINT
+        {
+            return packed_type{coords_[0], coords_[1], coords_[2]};
+        }
+
+        scalar_type& operator[](unsigned index)
+        {
+            return coords_[index];
+        }
+
+        scalar_type const& operator[](unsigned index) const
+        {
+            return coords_[index];
+        }
+
+        // Contiguous, aligned storage of the three coordinates followed by
+        // the pad lane.
+        scalar_type* data()
+        {
+            return coords_;
+        }
+
+        scalar_type const* data() const
+        {
+            return coords_;
+        }
+
+        // The four lanes as numbers, for the SIMD kernels.
+        number_type* lanes()
+        {
+            return reinterpret_cast<number_type*>(coords_);
+        }
+
+        number_type const* lanes() const
+        {
+            return reinterpret_cast<number_type const*>(coords_);
+        }
+
+        vector& operator+=(vector const& rhs)
+        {
+            kernels::add(lanes(), rhs.lanes(), lanes());
+            return *this;
+        }
+
+        vector& operator-=(vector const& rhs)
+        {
+            kernels::subtract(lanes(), rhs.lanes(), lanes());
+            return *this;
+        }
+
+        vector& operator*=(number_type scale)
+        {
+            kernels::scale(lanes(), scale, lanes());
+            return *this;
+        }
+
+        vector& operator/=(number_type scale)
+        {
+            kernels::divide(lanes(), scale, lanes());
+            return *this;
+        }
+
+      private:
+        alignas(4 * sizeof(T)) scalar_type coords_[4]{};
+    };
+
+    template<typename T, typename D>
+    constexpr unsigned vector<T, D, 3, padded>::dimension;
+
+    // Shorthand for the padded three-dimensional vector.
+    template<typename T, typename D>
+    using padded_vector = vector<T, D, 3, padded>;
+
+    template<typename T, typename D>
+    bool operator==(padded_vector<T, D> const& v, padded_vector<T, D> const& w)
+    {
+        return detail::padded_kernels<T>::equal(v.lanes(), w.lanes());
+    }
+
+    template<typename T, typename D>
+    bool operator!=(padded_vector<T, D> const& v, padded_vector<T, D> const& w)
+    {
+        return !(v == w);
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator+(padded_vector<T, D> const& v)
+    {
+        return v;
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator-(padded_vector<T, D> const& v)
+    {
+        padded_vector<T, D> result;
+        detail::padded_kernels<T>::scale(v.lanes(), T(-1), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator+(padded_vector<T, D> const& v, padded_vector<T, D> const& w)
+    {
+        padded_vector<T, D> result;
+        detail::padded_kernels<T>::add(v.lanes(), w.lanes(), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator-(padded_vector<T, D> const& v, padded_vector<T, D> const& w)
+    {
+        padded_vector<T, D> result;
+        detail::padded_kernels<T>::subtract(v.lanes(), w.lanes(), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator*(padded_vector<T, D> const& v, typename padded_vector<T, D>::number_type a)
+    {
+        padded_vector<T, D> result;
+        detail::padded_kernels<T>::scale(v.lanes(), a, result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator*(typename padded_vector<T, D>::number_type a, padded_vector<T, D> const& v)
+    {
+        return v * a;
+    }
+
+    template<typename T, typename D>
+    padded_vector<T, D> operator/(padded_vector<T, D> const& v, typename padded_vector<T, D>::number_type a)
+    {
+        padded_vector<T, D> result;
+        detail::padded_kernels<T>::divide(v.lanes(), a, result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2>
+    padded_vector<T, product_dimension_t<D1, D2>> operator*(padded_vector<T, D1> const& v, scalar<T, D2> const& a)
+    {
+        padded_vector<T, product_dimension_t<D1, D2>> result;
+        detail::padded_kernels<T>::scale(v.lanes(), a.value(), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2>
+    padded_vector<T, product_dimension_t<D1, D2>> operator*(scalar<T, D1> const& a, padded_vector<T, D2> const& v)
+    {
+        padded_vector<T, product_dimension_t<D1, D2>> result;
+        detail::padded_kernels<T>::scale(v.lanes(), a.value(), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2>
+    padded_vector<T, quotient_dimension_t<D1, D2>> operator/(padded_vector<T, D1> const& v, scalar<T, D2> const& a)
+    {
+        padded_vector<T, quotient_dimension_t<D1, D2>> result;
+        detail::padded_kernels<T>::divide(v.lanes(), a.value(), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D1, typename D2>
+    scalar<T, product_dimension_t<D1, D2>> dot(padded_vector<T, D1> const& v, padded_vector<T, D2> const& w)
+    {
+        return scalar<T, product_dimension_t<D1, D2>>{detail::padded_kernels<T>::dot(v.lanes(), w.lanes())};
+    }
+
+    template<typename T, typename D>
+    scalar<T, power_dimension_t<D, 2>> squared_norm(padded_vector<T, D> const& v)
+    {
+        return dot(v, v);
+    }
+
+    template<typename T, typename D>
+    scalar<T, D> norm(padded_vector<T, D> const& v)
+    {
+        return sqrt(squared_norm(v));
+    }
+
+    template<typename T, typename D1, typename D2>
+    padded_vector<T, product_dimension_t<D1, D2>> cross(padded_vector<T, D1> const& v, padded_vector<T, D2> const& w)
+    {
+        padded_vector<T, product_dimension_t<D1, D2>> result;
+        detail::padded_kernels<T>::cross(v.lanes(), w.lanes(), result.lanes());
+        return result;
+    }
+
+    template<typename T, typename D>
+    point<T, D, 3> operator+(point<T, D, 3> const& p, padded_vector<T, D> const& v)
+    {
+        return point<T, D, 3>{p} += vector<T, D, 3>(v);
+    }
+
+    template<typename T, typename D>
+    point<T, D, 3> operator-(point<T, D, 3> const& p, padded_vector<T, D> const& v)
+    {
+        return point<T, D, 3>{p} -= vector<T, D, 3>(v);
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_PADDED_HPP
@@ -0,0 +1,114 @@
+/*
+ * dim - Minimal thread-parallel loop helpers used by the dim extensions.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_PARALLEL_HPP
+#define INCLUDED_DIM_PARALLEL_HPP
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace dim
+{
+    namespace detail // for parallel loops
+    {
+        // Minimum number of items a worker thread is given. Spawning threads
+        // for smaller chunks costs more than it saves.
+        constexpr std::size_t default_grain_size = 8192;
+
+        // Returns the number of chunks a range of count items should be split
+        // into. The result is at least one and at most the hardware
+        // concurrency.
+        inline std::size_t chunk_count(std::size_t count, std::size_t grain = default_grain_size)
+        {
+            std::size_t const max_workers = std::thread::hardware_concurrency();
+            std::size_t const needed = (count + grain - 1) / (grain == 0 ? 1 : grain);
+            if (needed <= 1 || max_workers <= 1) {
+                return 1;
+            }
+            return needed < max_workers ? needed : max_workers;
+        }
+
+        // Calls fn(chunk, begin, end) for each of the chunks disjoint ranges
+        // covering [0, count). Chunks other than the first run on their own
+        // threads. An exception thrown by any chunk is rethrown after all the
+        // chunks finish.
+        template<typename F>
+        void parallel_chunks(std::size_t count, std::size_t chunks, F fn)
+        {
+            if (chunks <= 1) {
+                fn(std::size_t(0), std::size_t(0), count);
+                return;
+            }
+
+            std::vector<std::exception_ptr> errors(chunks);
+            std::vector<std::thread> workers;
+            workers.reserve(chunks - 1);
+
+            auto const run = [&](std::size_t chunk) {
+                std::size_t const begin = count * chunk / chunks;
+                std::size_t const end = count * (chunk + 1) / chunks;
+                try {
+                    fn(chunk, begin, end);
+                } catch (...) {
+                    errors[chunk] = std::current_exception();
+                }
+            };
+
+            for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+                workers.emplace_back(run, chunk);
+            }
+            run(0);
+
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            for (auto const& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        // Calls fn(index) for each index in [0, count) using multiple threads.
+        template<typename F>
+        void parallel_for(std::size_t count, F fn, std::size_t grain = default_grain_size)
+        {
+            parallel_chunks(
+                count, chunk_count(count, grain), [&](std::size_t, std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        fn(i);
+                    }
+                });
+        }
+    } // namespace detail
+} // namespace dim
+
+#endif // INCLUDED_DIM_PARALLEL_HPP
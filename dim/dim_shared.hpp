@@ -0,0 +1,524 @@
+/*
+ * dim - Cross-process shared-memory arrays of dimensioned quantities.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_SHARED_HPP
+#define INCLUDED_DIM_SHARED_HPP
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dim.hpp"
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Type description
+    //----------------------------------------------------------------
+
+    namespace detail // for dim::shared_array_writer and dim::shared_array_reader
+    {
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+            "shared arrays need lock-free 64-bit atomics");
+
+        // Kinds of quantity recorded in the header.
+        enum : std::uint32_t
+        {
+            shared_scalar = 1,
+            shared_vector = 2,
+            shared_point = 3,
+        };
+
+        // Kinds of number recorded in the header.
+        enum : std::uint32_t
+        {
+            shared_signed = 1,
+            shared_unsigned = 2,
+            shared_floating = 3,
+        };
+
+        // Exponents of a dimension. Only mechanical dimensions can be stored
+        // in shared arrays.
+        template<typename D>
+        struct shared_exponents;
+
+        template<int L, int M, int T, int Q>
+        struct shared_exponents<mechanical_dimension<L, M, T, Q>>
+        {
+            static constexpr std::int32_t values[4] = {L, M, T, Q};
+        };
+
+        template<int L, int M, int T, int Q>
+        constexpr std::int32_t shared_exponents<mechanical_dimension<L, M, T, Q>>::values[4];
+
+        template<typename T>
+        constexpr std::uint32_t shared_number_kind()
+        {
+            return std::is_floating_point<T>::value ? shared_floating
+                : std::is_signed<T>::value ? shared_signed : shared_unsigned;
+        }
+
+        template<typename Q>
+        struct shared_element;
+
+        template<typename T, typename D>
+        struct shared_element<scalar<T, D>>
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr std::uint32_t kind = shared_scalar;
+            static constexpr std::uint32_t components = 1;
+        };
+
+        template<typename T, typename D, unsigned N>
+        struct shared_element<vector<T, D, N>>
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr std::uint32_t kind = shared_vector;
+            static constexpr std::uint32_t components = N;
+        };
+
+        template<typename T, typename D, unsigned N>
+        struct shared_element<point<T, D, N>>
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr std::uint32_t kind = shared_point;
+            static constexpr std::uint32_t components = N;
+        };
+
+        constexpr char shared_magic[8] = {'d', 'i', 'm', 's', 'h', 'm', '0', '1'};
+
+        /*
+         * Header at the start of a shared array. The data follow at
+         * data_offset. sequence is the seqlock counter: it is odd while a
+         * frame is being written and advances by two per published frame.
+         */
+        struct shared_header
+        {
+            char magic[8];
+            std::uint32_t kind;
+            std::uint32_t number_kind;
+            std::uint32_t number_size;
+            std::uint32_t components;
+            std::int32_t exponents[4];
+            std::uint64_t capacity;
+            std::atomic<std::uint32_t> ready;
+            std::atomic<std::uint64_t> sequence;
+            std::atomic<std::uint64_t> count;
+            std::atomic<std::uint64_t> frame;
+        };
+
+        constexpr std::size_t shared_data_offset = 128;
+
+        static_assert(sizeof(shared_header) <= shared_data_offset,
+            "shared array header overlaps the data");
+
+        template<typename Q>
+        void describe(shared_header& header, std::size_t capacity)
+        {
+            using element = shared_element<Q>;
+            using number_type = typename element::number_type;
+
+            std::memcpy(header.magic, shared_magic, sizeof header.magic);
+            header.kind = element::kind;
+            header.number_kind = shared_number_kind<number_type>();
+            header.number_size = sizeof(number_type);
+            header.components = element::components;
+            for (unsigned i = 0; i < 4; ++i) {
+                header.exponents[i] = shared_exponents<typename element::dimension>::values[i];
+            }
+            header.capacity = capacity;
+        }
+
+        template<typename Q>
+        bool describes(shared_header const& header)
+        {
+            shared_header expected;
+            describe<Q>(expected, std::size_t(header.capacity));
+            return std::memcmp(header.magic, expected.magic, sizeof header.magic) == 0
+                && header.kind == expected.kind
+                && header.number_kind == expected.number_kind
+                && header.number_size == expected.number_size
+                && header.components == expected.components
+                && std::memcmp(header.exponents, expected.exponents, sizeof header.exponents) == 0;
+        }
+
+        template<typename Q>
+        void check_shared_element()
+        {
+            using element = shared_element<Q>;
+            static_assert(std::is_trivially_copyable<Q>::value,
+                "shared array elements must be trivially copyable");
+            static_assert(sizeof(Q) == element::components * sizeof(typename element::number_type),
+                "shared array elements must be packed numbers");
+            static_assert(alignof(Q) <= shared_data_offset,
+                "shared array elements are over-aligned");
+        }
+
+        inline std::size_t shared_bytes(std::size_t capacity, std::size_t element_size)
+        {
+            if (capacity > (SIZE_MAX - shared_data_offset) / element_size) {
+                throw std::invalid_argument("shared array capacity too large");
+            }
+            return shared_data_offset + capacity * element_size;
+        }
+
+        inline void* map_shared(int fd, std::size_t bytes, int protection, std::string const& name)
+        {
+            void* const data = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                int const error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "cannot map " + name);
+            }
+            ::close(fd);
+            return data;
+        }
+    } // namespace detail
+
+    //----------------------------------------------------------------
+    // Writer
+    //----------------------------------------------------------------
+
+    /*
+     * Producer side of a POSIX shared-memory array of quantities Q (a
+     * scalar, vector or point of a mechanical dimension). The header records
+     * the number type, the number of components and the dimension exponents
+     * so that readers in other processes can check what they attach to.
+     *
+     * Frames are published under a seqlock: readers never block the writer
+     * and detect frames overwritten while they were reading. There must be
+     * a single writer per array.
+     */
+    template<typename Q>
+    class shared_array_writer
+    {
+      public:
+        /*
+         * Creates the shared memory object name (which should start with a
+         * slash) holding up to capacity elements. Throws std::system_error
+         * if the object already exists or cannot be created.
+         */
+        shared_array_writer(std::string const& name, std::size_t capacity)
+            : name_{name}
+            , bytes_{detail::shared_bytes(capacity, sizeof(Q))}
+        {
+            detail::check_shared_element<Q>();
+
+            int const fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "cannot create " + name);
+            }
+            if (::ftruncate(fd, off_t(bytes_)) != 0) {
+                int const error = errno;
+                ::close(fd);
+                ::shm_unlink(name.c_str());
+                throw std::system_error(error, std::generic_category(), "cannot resize " + name);
+            }
+            try {
+                data_ = detail::map_shared(fd, bytes_, PROT_READ | PROT_WRITE, name);
+            } catch (...) {
+                ::shm_unlink(name.c_str());
+                throw;
+            }
+
+            // The object is zero-filled, so the atomics start out as zero.
+            detail::shared_header& head = header();
+            detail::describe<Q>(head, capacity);
+            head.ready.store(1, std::memory_order_release);
+        }
+
+        shared_array_writer(shared_array_writer const&) = delete;
+        shared_array_writer& operator=(shared_array_writer const&) = delete;
+
+        /*
+         * Unmaps the array and removes its name. Readers that already
+         * attached keep their mapping.
+         */
+        ~shared_array_writer()
+        {
+            ::munmap(data_, bytes_);
+            ::shm_unlink(name_.c_str());
+        }
+
+        std::string const& name() const
+        {
+            return name_;
+        }
+
+        std::size_t capacity() const
+        {
+            return std::size_t(header().capacity);
+        }
+
+        /*
+         * Number of frames published so far.
+         */
+        std::uint64_t frames() const
+        {
+            return header().frame.load(std::memory_order_relaxed);
+        }
+
+        /*
+         * Publishes a frame of count elements written in place by
+         * fill(Q* data). Throws std::invalid_argument if count exceeds the
+         * capacity.
+         */
+        template<typename Fill>
+        void update(std::size_t count, Fill fill)
+        {
+            if (count > capacity()) {
+                throw std::invalid_argument("frame exceeds the shared array capacity");
+            }
+            detail::shared_header& head = header();
+            std::uint64_t const sequence = head.sequence.load(std::memory_order_relaxed);
+
+            head.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            fill(elements());
+            head.count.store(count, std::memory_order_relaxed);
+            head.frame.store(head.frame.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            head.sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        /*
+         * Publishes a copy of count elements.
+         */
+        void publish(Q const* values, std::size_t count)
+        {
+            update(count, [&](Q* data) {
+                if (count > 0) {
+                    std::memcpy(static_cast<void*>(data), values, count * sizeof(Q));
+                }
+            });
+        }
+
+        void publish(std::vector<Q> const& values)
+        {
+            publish(values.data(), values.size());
+        }
+
+      private:
+        detail::shared_header& header() const
+        {
+            return *static_cast<detail::shared_header*>(data_);
+        }
+
+        Q* elements() const
+        {
+            return reinterpret_cast<Q*>(static_cast<unsigned char*>(data_) + detail::shared_data_offset);
+        }
+
+        std::string name_;
+        std::size_t bytes_;
+        void* data_ = nullptr;
+    };
+
+    //----------------------------------------------------------------
+    // Reader
+    //----------------------------------------------------------------
+
+    /*
+     * Consistent view of a published frame, valid as long as the reader is
+     * alive. The data may be overwritten at any time; results computed from
+     * them count only if shared_array_reader::validate() returns true
+     * afterwards.
+     */
+    template<typename Q>
+    struct shared_frame
+    {
+        Q const* data = nullptr;
+        std::size_t count = 0;
+        std::uint64_t frame = 0;
+        std::uint64_t sequence = 0;
+    };
+
+    /*
+     * Consumer side of a shared array, mapped read-only. Views point
+     * directly into the shared memory, so reading a frame copies nothing.
+     */
+    template<typename Q>
+    class shared_array_reader
+    {
+      public:
+        /*
+         * Attaches to the shared memory object name. Throws
+         * std::system_error if it cannot be opened and std::runtime_error if
+         * it is not a shared array of Q.
+         */
+        explicit shared_array_reader(std::string const& name)
+        {
+            detail::check_shared_element<Q>();
+
+            int const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "cannot open " + name);
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                int const error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "cannot stat " + name);
+            }
+            bytes_ = std::size_t(info.st_size);
+            if (bytes_ < detail::shared_data_offset) {
+                ::close(fd);
+                throw std::runtime_error(name + " is not a shared array");
+            }
+            data_ = detail::map_shared(fd, bytes_, PROT_READ, name);
+
+            detail::shared_header const& head = header();
+            if (head.ready.load(std::memory_order_acquire) != 1 || !detail::describes<Q>(head)
+                || detail::shared_bytes(std::size_t(head.capacity), sizeof(Q)) > bytes_) {
+                ::munmap(data_, bytes_);
+                throw std::runtime_error(name + " does not hold an array of the requested quantity");
+            }
+        }
+
+        shared_array_reader(shared_array_reader const&) = delete;
+        shared_array_reader& operator=(shared_array_reader const&) = delete;
+
+        ~shared_array_reader()
+        {
+            ::munmap(data_, bytes_);
+        }
+
+        std::size_t capacity() const
+        {
+            return std::size_t(header().capacity);
+        }
+
+        /*
+         * Number of frames published so far.
+         */
+        std::uint64_t frames() const
+        {
+            return header().frame.load(std::memory_order_acquire);
+        }
+
+        /*
+         * Returns a view of the latest frame, or false if a frame is being
+         * written right now or none has been published.
+         */
+        bool try_view(shared_frame<Q>& view) const
+        {
+            detail::shared_header const& head = header();
+            std::uint64_t const sequence = head.sequence.load(std::memory_order_acquire);
+            if (sequence % 2 != 0 || sequence == 0) {
+                return false;
+            }
+            view.data = elements();
+            view.count = std::size_t(head.count.load(std::memory_order_relaxed));
+            view.frame = head.frame.load(std::memory_order_relaxed);
+            view.sequence = sequence;
+            return validate(view);
+        }
+
+        /*
+         * Returns true if the frame of a view has not been overwritten since
+         * the view was taken, i.e. everything read through it so far is
+         * consistent.
+         */
+        bool validate(shared_frame<Q> const& view) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return header().sequence.load(std::memory_order_relaxed) == view.sequence;
+        }
+
+        /*
+         * Copies the latest frame into values, retrying while the writer is
+         * busy. Returns false without waiting if no frame has been
+         * published.
+         */
+        bool read(std::vector<Q>& values, std::uint64_t* frame = nullptr) const
+        {
+            shared_frame<Q> view;
+            for (;;) {
+                if (!try_view(view)) {
+                    if (frames() == 0) {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+                values.resize(view.count);
+                if (view.count > 0) {
+                    std::memcpy(static_cast<void*>(values.data()), view.data, view.count * sizeof(Q));
+                }
+                if (validate(view)) {
+                    break;
+                }
+            }
+            if (frame) {
+                *frame = view.frame;
+            }
+            return true;
+        }
+
+      private:
+        detail::shared_header const& header() const
+        {
+            return *static_cast<detail::shared_header const*>(data_);
+        }
+
+        Q const* elements() const
+        {
+            return reinterpret_cast<Q const*>(
+                static_cast<unsigned char const*>(data_) + detail::shared_data_offset);
+        }
+
+        std::size_t bytes_ = 0;
+        void* data_ = nullptr;
+    };
+} // namespace dim
+
+#endif
+
+#endif // INCLUDED_DIM_SHARED_HPP
@@ -0,0 +1,530 @@
+/*
+ * dim - Open-addressing spatial hash of points keyed by quantized coordinates.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_SPATIAL_HASH_HPP
+#define INCLUDED_DIM_SPATIAL_HASH_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "dim.hpp"
+
+namespace dim
+{
+    namespace detail // for dim::spatial_hash
+    {
+        // Mixes the bits of a 64-bit integer (the splitmix64 finalizer).
+        inline std::uint64_t mix_bits(std::uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111eb;
+            x ^= x >> 31;
+            return x;
+        }
+    } // namespace detail
+
+    /*
+     * Sparse grid of cubic cells holding point ids, for unbounded or mostly
+     * empty domains. Only occupied cells are stored, in an open-addressing
+     * table with linear probing keyed by the integer cell coordinates
+     * floor(x / cell_size). The ids of a cell are kept contiguously in a
+     * shared pool, so scanning a cell reads one block of memory.
+     *
+     * Points are inserted, moved and removed one at a time by id. Ids index
+     * an internal array, so they should be small integers such as particle
+     * indices.
+     */
+    template<typename T, typename D, unsigned N>
+    class spatial_hash
+    {
+      public:
+        using number_type = T;
+        using scalar_type = scalar<T, D>;
+        using point_type = point<T, D, N>;
+        using key_type = std::array<std::int64_t, N>;
+        static constexpr unsigned dimension = N;
+
+        /*
+         * Creates an empty hash. Throws std::invalid_argument if cell_size
+         * is not positive.
+         */
+        explicit spatial_hash(scalar_type cell_size)
+            : cell_size_{cell_size.value()}
+            , table_(16)
+        {
+            if (!(cell_size_ > 0)) {
+                throw std::invalid_argument("cell size must be positive");
+            }
+        }
+
+        scalar_type cell_size() const
+        {
+            return scalar_type{cell_size_};
+        }
+
+        // Number of points.
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        // Number of occupied cells.
+        std::size_t cell_count() const
+        {
+            return cells_;
+        }
+
+        key_type cell_of(point_type const& p) const
+        {
+            key_type key;
+            for (unsigned k = 0; k < N; ++k) {
+                key[k] = std::int64_t(std::floor(p[k].value() / cell_size_));
+            }
+            return key;
+        }
+
+        bool contains(std::size_t id) const
+        {
+            return id < members_.size() && members_[id].present;
+        }
+
+        point_type const& position(std::size_t id) const
+        {
+            return members_[id].position;
+        }
+
+        /*
+         * Adds point id at p. Throws std::invalid_argument if id is already
+         * present.
+         */
+        void insert(std::size_t id, point_type const& p)
+        {
+            if (contains(id)) {
+                throw std::invalid_argument("id is already in the spatial hash");
+            }
+            if (id >= members_.size()) {
+                members_.resize(id + 1);
+            }
+            members_[id].position = p;
+            members_[id].present = true;
+            add(id, cell_of(p));
+            size_++;
+        }
+
+        /*
+         * Removes point id. Throws std::invalid_argument if id is absent.
+         */
+        void remove(std::size_t id)
+        {
+            if (!contains(id)) {
+                throw std::invalid_argument("id is not in the spatial hash");
+            }
+            drop(id, cell_of(members_[id].position));
+            members_[id].present = false;
+            size_--;
+        }
+
+        /*
+         * Moves point id to p. The cell lists are touched only if the point
+         * leaves its cell.
+         */
+        void move(std::size_t id, point_type const& p)
+        {
+            if (!contains(id)) {
+                throw std::invalid_argument("id is not in the spatial hash");
+            }
+            key_type const from = cell_of(members_[id].position);
+            key_type const to = cell_of(p);
+            members_[id].position = p;
+            if (from != to) {
+                drop(id, from);
+                add(id, to);
+            }
+        }
+
+        void clear()
+        {
+            table_.assign(16, cell{});
+            pool_.clear();
+            members_.clear();
+            size_ = 0;
+            cells_ = 0;
+            garbage_ = 0;
+        }
+
+        /*
+         * Calls fn(id) for each point in a cell.
+         */
+        template<typename Fn>
+        void for_each_in_cell(key_type const& key, Fn fn) const
+        {
+            std::size_t const slot = find(key);
+            if (slot == npos) {
+                return;
+            }
+            cell const& c = table_[slot];
+            for (std::uint32_t n = 0; n < c.size; ++n) {
+                fn(pool_[c.begin + n]);
+            }
+        }
+
+        /*
+         * Calls fn(id) for each point in the 3^N cells around the cell of
+         * query. These include all points within cell_size of query.
+         */
+        template<typename Fn>
+        void for_each_near(point_type const& query, Fn fn) const
+        {
+            for_each_cell_around(cell_of(query), 1, [&](cell const& c) {
+                for (std::uint32_t n = 0; n < c.size; ++n) {
+                    fn(pool_[c.begin + n]);
+                }
+            });
+        }
+
+        /*
+         * Calls fn(id) for each point within radius from query (inclusive).
+         */
+        template<typename Fn>
+        void radius_query(point_type const& query, scalar_type radius, Fn fn) const
+        {
+            T const r2 = radius.value() * radius.value();
+            auto const reach = std::int64_t(std::ceil(radius.value() / cell_size_));
+
+            for_each_cell_around(cell_of(query), reach, [&](cell const& c) {
+                for (std::uint32_t n = 0; n < c.size; ++n) {
+                    std::size_t const id = pool_[c.begin + n];
+                    if (squared_distance(members_[id].position, query).value() <= r2) {
+                        fn(id);
+                    }
+                }
+            });
+        }
+
+        std::vector<std::size_t> radius_query(point_type const& query, scalar_type radius) const
+        {
+            std::vector<std::size_t> result;
+            radius_query(query, radius, [&](std::size_t id) { result.push_back(id); });
+            return result;
+        }
+
+        /*
+         * Calls fn(i, j) once for each pair of points within radius of each
+         * other (inclusive). radius must not exceed the cell size; otherwise
+         * std::invalid_argument is thrown.
+         */
+        template<typename Fn>
+        void for_each_pair(scalar_type radius, Fn fn) const
+        {
+            if (radius.value() > cell_size_) {
+                throw std::invalid_argument("pair radius exceeds the cell size");
+            }
+            T const r2 = radius.value() * radius.value();
+
+            for (cell const& home : table_) {
+                if (home.size == 0) {
+                    continue;
+                }
+                std::size_t const* const ids = &pool_[home.begin];
+
+                for (std::uint32_t a = 0; a < home.size; ++a) {
+                    for (std::uint32_t b = a + 1; b < home.size; ++b) {
+                        if (squared_distance(members_[ids[a]].position, members_[ids[b]].position).value() <= r2) {
+                            fn(ids[a], ids[b]);
+                        }
+                    }
+                }
+
+                // Forward half of the neighbor cells: offsets whose first
+                // nonzero component is positive.
+                key_type offset;
+                offset.fill(-1);
+                for (;;) {
+                    unsigned k = 0;
+                    while (k < N && offset[k] == 1) {
+                        offset[k] = -1;
+                        k++;
+                    }
+                    if (k == N) {
+                        break;
+                    }
+                    offset[k]++;
+
+                    if (!is_forward(offset)) {
+                        continue;
+                    }
+                    key_type key = home.key;
+                    for (unsigned i = 0; i < N; ++i) {
+                        key[i] += offset[i];
+                    }
+                    std::size_t const slot = find(key);
+                    if (slot == npos) {
+                        continue;
+                    }
+                    cell const& other = table_[slot];
+                    for (std::uint32_t a = 0; a < home.size; ++a) {
+                        point_type const& p = members_[ids[a]].position;
+                        for (std::uint32_t b = 0; b < other.size; ++b) {
+                            std::size_t const j = pool_[other.begin + b];
+                            if (squared_distance(p, members_[j].position).value() <= r2) {
+                                fn(ids[a], j);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /*
+         * Rewrites the id pool without the blocks abandoned by growing
+         * cells. This also happens automatically when more than half of the
+         * pool is unused.
+         */
+        void compact()
+        {
+            std::vector<std::size_t> pool;
+            pool.reserve(size_ + size_ / 2);
+            for (cell& c : table_) {
+                if (c.size == 0) {
+                    continue;
+                }
+                std::uint32_t const begin = std::uint32_t(pool.size());
+                pool.insert(pool.end(), pool_.begin() + c.begin, pool_.begin() + c.begin + c.size);
+                pool.resize(pool.size() + (c.capacity - c.size));
+                c.begin = begin;
+            }
+            pool_.swap(pool);
+            garbage_ = 0;
+        }
+
+      private:
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        struct cell
+        {
+            key_type key;
+            std::uint32_t begin = 0;
+            std::uint32_t size = 0;
+            std::uint32_t capacity = 0;
+        };
+
+        struct member
+        {
+            point_type position;
+            std::uint32_t offset = 0;
+            bool present = false;
+        };
+
+        T cell_size_;
+        std::vector<cell> table_;
+        std::vector<std::size_t> pool_;
+        std::vector<member> members_;
+        std::size_t size_ = 0;
+        std::size_t cells_ = 0;
+        std::size_t garbage_ = 0;
+
+        static bool is_forward(key_type const& offset)
+        {
+            for (unsigned k = 0; k < N; ++k) {
+                if (offset[k] != 0) {
+                    return offset[k] > 0;
+                }
+            }
+            return false;
+        }
+
+        std::size_t home_slot(key_type const& key) const
+        {
+            std::uint64_t h = 0;
+            for (unsigned k = 0; k < N; ++k) {
+                h = detail::mix_bits(h ^ std::uint64_t(key[k]));
+            }
+            return std::size_t(h) & (table_.size() - 1);
+        }
+
+        std::size_t find(key_type const& key) const
+        {
+            std::size_t const mask = table_.size() - 1;
+            for (std::size_t slot = home_slot(key);; slot = (slot + 1) & mask) {
+                cell const& c = table_[slot];
+                if (c.size == 0) {
+                    return npos;
+                }
+                if (c.key == key) {
+                    return slot;
+                }
+            }
+        }
+
+        // Calls visit(cell) for each occupied cell within reach cells of
+        // center along every axis.
+        template<typename Visit>
+        void for_each_cell_around(key_type const& center, std::int64_t reach, Visit visit) const
+        {
+            key_type offset;
+            offset.fill(-reach);
+            for (;;) {
+                key_type key = center;
+                for (unsigned k = 0; k < N; ++k) {
+                    key[k] += offset[k];
+                }
+                std::size_t const slot = find(key);
+                if (slot != npos) {
+                    visit(table_[slot]);
+                }
+
+                unsigned k = 0;
+                while (k < N && offset[k] == reach) {
+                    offset[k] = -reach;
+                    k++;
+                }
+                if (k == N) {
+                    break;
+                }
+                offset[k]++;
+            }
+        }
+
+        void add(std::size_t id, key_type const& key)
+        {
+            if (2 * (cells_ + 1) > table_.size()) {
+                rehash(table_.size() * 2);
+            }
+
+            std::size_t const mask = table_.size() - 1;
+            std::size_t slot = home_slot(key);
+            while (table_[slot].size != 0 && table_[slot].key != key) {
+                slot = (slot + 1) & mask;
+            }
+
+            cell& c = table_[slot];
+            if (c.size == 0) {
+                c.key = key;
+                c.capacity = 0;
+                cells_++;
+            }
+            if (c.size == c.capacity) {
+                grow(c);
+            }
+            pool_[c.begin + c.size] = id;
+            members_[id].offset = c.size;
+            c.size++;
+        }
+
+        void drop(std::size_t id, key_type const& key)
+        {
+            std::size_t slot = find(key);
+            cell& c = table_[slot];
+
+            std::uint32_t const offset = members_[id].offset;
+            std::size_t const last = pool_[c.begin + c.size - 1];
+            pool_[c.begin + offset] = last;
+            members_[last].offset = offset;
+            c.size--;
+
+            if (c.size > 0) {
+                return;
+            }
+
+            // Empty cells are deleted by shifting later entries of the probe
+            // sequence back, so no tombstones accumulate.
+            garbage_ += c.capacity;
+            c.capacity = 0;
+            cells_--;
+            std::size_t const mask = table_.size() - 1;
+            for (std::size_t next = (slot + 1) & mask; table_[next].size != 0; next = (next + 1) & mask) {
+                std::size_t const home = home_slot(table_[next].key);
+                bool const movable = slot <= next ? (home <= slot || home > next) : (home <= slot && home > next);
+                if (movable) {
+                    table_[slot] = table_[next];
+                    table_[next] = cell{};
+                    slot = next;
+                }
+            }
+            maybe_compact();
+        }
+
+        // Moves a full cell to a block of twice the size at the end of the
+        // pool.
+        void grow(cell& c)
+        {
+            std::uint32_t const capacity = c.capacity == 0 ? 4 : 2 * c.capacity;
+            std::size_t const begin = pool_.size();
+            if (begin + capacity > std::size_t(UINT32_MAX)) {
+                throw std::length_error("spatial hash pool is full");
+            }
+            pool_.resize(begin + capacity);
+            for (std::uint32_t n = 0; n < c.size; ++n) {
+                pool_[begin + n] = pool_[c.begin + n];
+            }
+            garbage_ += c.capacity;
+            c.begin = std::uint32_t(begin);
+            c.capacity = capacity;
+            maybe_compact();
+        }
+
+        void maybe_compact()
+        {
+            if (garbage_ > 1024 && 2 * garbage_ > pool_.size()) {
+                compact();
+            }
+        }
+
+        void rehash(std::size_t slots)
+        {
+            std::vector<cell> old(slots);
+            old.swap(table_);
+            std::size_t const mask = table_.size() - 1;
+            for (cell const& c : old) {
+                if (c.size == 0) {
+                    continue;
+                }
+                std::size_t slot = home_slot(c.key);
+                while (table_[slot].size != 0) {
+                    slot = (slot + 1) & mask;
+                }
+                table_[slot] = c;
+            }
+        }
+    };
+
+    template<typename T, typename D, unsigned N>
+    constexpr unsigned spatial_hash<T, D, N>::dimension;
+
+    template<typename T, typename D, unsigned N>
+    constexpr std::size_t spatial_hash<T, D, N>::npos;
+} // namespace dim
+
+#endif // INCLUDED_DIM_SPATIAL_HASH_HPP
@@ -0,0 +1,719 @@
+/*
+ * dim - Single-pass, mergeable statistics of dimensioned time series.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_STATISTICS_HPP
+#define INCLUDED_DIM_STATISTICS_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_fft.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    namespace detail // for statistics accumulators
+    {
+        /*
+         * Component access and result types of the observables accepted by
+         * the accumulators: scalars and vectors. Products of observables are
+         * dot products, so the variance and correlation of a quantity of
+         * dimension D have dimension D^2.
+         */
+        template<typename Q>
+        struct observable_traits;
+
+        template<typename T, typename D>
+        struct observable_traits<scalar<T, D>>
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr unsigned components = 1;
+
+            template<typename D2>
+            using same_shape = scalar<T, D2>;
+
+            static T get(scalar<T, D> const& value, unsigned)
+            {
+                return value.value();
+            }
+
+            template<typename D2>
+            static scalar<T, D2> make(T const* values)
+            {
+                return scalar<T, D2>(values[0]);
+            }
+        };
+
+        template<typename T, typename D, unsigned N>
+        struct observable_traits<vector<T, D, N>>
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr unsigned components = N;
+
+            template<typename D2>
+            using same_shape = vector<T, D2, N>;
+
+            static T get(vector<T, D, N> const& value, unsigned k)
+            {
+                return value[k].value();
+            }
+
+            template<typename D2>
+            static vector<T, D2, N> make(T const* values)
+            {
+                vector<T, D2, N> result;
+                for (unsigned k = 0; k < N; ++k) {
+                    result[k] = scalar<T, D2>(values[k]);
+                }
+                return result;
+            }
+        };
+    } // namespace detail
+
+    //------------------------------------------------------------------------
+    // Welford mean and variance
+    //------------------------------------------------------------------------
+
+    template<typename Q>
+    class block_average;
+
+    /*
+     * Running mean and variance of a scalar or vector observable by Welford's
+     * algorithm. Vectors are treated component-wise. Accumulators of disjoint
+     * parts of a series can be merged exactly (Chan et al.), so parts may be
+     * accumulated in parallel.
+     */
+    template<typename Q>
+    class running_statistics
+    {
+        using traits = detail::observable_traits<Q>;
+        static constexpr unsigned components = traits::components;
+
+      public:
+        using number_type = typename traits::number_type;
+        using dimension = typename traits::dimension;
+        using value_type = Q;
+        using variance_type = typename traits::template same_shape<power_dimension_t<dimension, 2>>;
+        using total_variance_type = scalar<number_type, power_dimension_t<dimension, 2>>;
+
+        running_statistics()
+        {
+            for (unsigned k = 0; k < components; ++k) {
+                mean_[k] = 0;
+                m2_[k] = 0;
+            }
+        }
+
+        void add(Q const& value)
+        {
+            number_type values[components];
+            for (unsigned k = 0; k < components; ++k) {
+                values[k] = traits::get(value, k);
+            }
+            add(values);
+        }
+
+        // Combines the samples of other into this accumulator.
+        void merge(running_statistics const& other)
+        {
+            if (other.count_ == 0) {
+                return;
+            }
+            if (count_ == 0) {
+                *this = other;
+                return;
+            }
+            number_type const n_a = number_type(count_);
+            number_type const n_b = number_type(other.count_);
+            number_type const n = n_a + n_b;
+            for (unsigned k = 0; k < components; ++k) {
+                number_type const delta = other.mean_[k] - mean_[k];
+                mean_[k] += delta * (n_b / n);
+                m2_[k] += other.m2_[k] + delta * delta * (n_a * n_b / n);
+            }
+            count_ += other.count_;
+        }
+
+        std::size_t count() const
+        {
+            return count_;
+        }
+
+        Q mean() const
+        {
+            return traits::template make<dimension>(mean_);
+        }
+
+        // Population variance: the mean squared deviation from the mean.
+        variance_type variance() const
+        {
+            return scaled_m2(count_);
+        }
+
+        // Unbiased sample variance. Requires at least two samples.
+        variance_type sample_variance() const
+        {
+            return scaled_m2(count_ - 1);
+        }
+
+        // Square root of the sample variance.
+        Q standard_deviation() const
+        {
+            number_type values[components];
+            for (unsigned k = 0; k < components; ++k) {
+                values[k] = std::sqrt(m2_[k] / number_type(count_ - 1));
+            }
+            return traits::template make<dimension>(values);
+        }
+
+        // Sum of the component variances: the population mean squared
+        // distance from the mean.
+        total_variance_type total_variance() const
+        {
+            number_type sum = 0;
+            for (unsigned k = 0; k < components; ++k) {
+                sum += m2_[k];
+            }
+            return total_variance_type{sum / number_type(count_)};
+        }
+
+      private:
+        template<typename>
+        friend class block_average;
+
+        void add(number_type const* values)
+        {
+            ++count_;
+            number_type const n = number_type(count_);
+            for (unsigned k = 0; k < components; ++k) {
+                number_type const delta = values[k] - mean_[k];
+                mean_[k] += delta / n;
+                m2_[k] += delta * (values[k] - mean_[k]);
+            }
+        }
+
+        variance_type scaled_m2(std::size_t divisor) const
+        {
+            number_type values[components];
+            for (unsigned k = 0; k < components; ++k) {
+                values[k] = m2_[k] / number_type(divisor);
+            }
+            return traits::template make<power_dimension_t<dimension, 2>>(values);
+        }
+
+        std::size_t count_ = 0;
+        number_type mean_[components];
+        number_type m2_[components];
+    };
+
+    template<typename Q>
+    constexpr unsigned running_statistics<Q>::components;
+
+    /*
+     * Accumulates the statistics of count values using multiple threads, one
+     * running_statistics per chunk merged at the end.
+     */
+    template<typename Q>
+    running_statistics<Q> accumulate_statistics(Q const* values, std::size_t count)
+    {
+        std::size_t const chunks = detail::chunk_count(count);
+        std::vector<running_statistics<Q>> partial(chunks);
+        detail::parallel_chunks(count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                partial[chunk].add(values[i]);
+            }
+        });
+        for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+            partial[0].merge(partial[chunk]);
+        }
+        return partial[0];
+    }
+
+    template<typename Q>
+    running_statistics<Q> accumulate_statistics(std::vector<Q> const& values)
+    {
+        return accumulate_statistics(values.data(), values.size());
+    }
+
+    //------------------------------------------------------------------------
+    // Block averaging
+    //------------------------------------------------------------------------
+
+    /*
+     * Error of the mean of a correlated series by blocking (Flyvbjerg and
+     * Petersen, J. Chem. Phys. 91, 461 (1989)). Level k holds the statistics
+     * of the means of consecutive blocks of 2^k samples, built online by
+     * averaging pairs, so memory grows only with log2 of the sample count.
+     * The standard error estimated at level k grows with k until the blocks
+     * are longer than the correlation time and then plateaus.
+     */
+    template<typename Q>
+    class block_average
+    {
+        using traits = detail::observable_traits<Q>;
+        static constexpr unsigned components = traits::components;
+
+      public:
+        using number_type = typename traits::number_type;
+        using dimension = typename traits::dimension;
+        using statistics_type = running_statistics<Q>;
+
+        void add(Q const& value)
+        {
+            number_type values[components];
+            for (unsigned k = 0; k < components; ++k) {
+                values[k] = traits::get(value, k);
+            }
+            push(0, values);
+        }
+
+        /*
+         * Combines the blocks of other, a series that follows this one, into
+         * this accumulator. Level statistics are merged level by level, and
+         * the incomplete blocks at the end of other become those of this
+         * accumulator. The result is exact if count() is a multiple of
+         * 2^other.levels(), e.g. when this part is long and aligned and other
+         * is the short remainder. Otherwise the blocks of other stay aligned
+         * to its own start and the incomplete blocks of this one are dropped
+         * at the junction, so every block is still the mean of consecutive
+         * samples but each level may have one block fewer than a single
+         * accumulator would.
+         */
+        void merge(block_average const& other)
+        {
+            std::size_t const other_levels = other.levels_.size();
+            bool const aligned = other_levels < std::size_t(std::numeric_limits<std::size_t>::digits)
+                ? count() % (std::size_t(1) << other_levels) == 0
+                : count() == 0;
+
+            if (levels_.size() < other_levels) {
+                levels_.resize(other_levels);
+            }
+            for (std::size_t level = 0; level < levels_.size(); ++level) {
+                level_state& ours = levels_[level];
+                if (level < other_levels) {
+                    level_state const& theirs = other.levels_[level];
+                    ours.statistics.merge(theirs.statistics);
+                    ours.has_pending = theirs.has_pending;
+                    for (unsigned k = 0; k < components; ++k) {
+                        ours.pending[k] = theirs.pending[k];
+                    }
+                } else if (!aligned) {
+                    ours.has_pending = false;
+                }
+            }
+        }
+
+        std::size_t count() const
+        {
+            return levels_.empty() ? 0 : levels_[0].statistics.count();
+        }
+
+        Q mean() const
+        {
+            return levels_.empty() ? Q{} : levels_[0].statistics.mean();
+        }
+
+        // Number of blocking levels. Level k has count() / 2^k blocks unless
+        // unaligned parts were merged.
+        std::size_t levels() const
+        {
+            return levels_.size();
+        }
+
+        // Statistics of the block means at the given level.
+        statistics_type const& level(std::size_t level) const
+        {
+            return levels_.at(level).statistics;
+        }
+
+        // Standard error of the mean estimated from the blocks at the given
+        // level. The level needs at least two blocks.
+        Q level_error(std::size_t level) const
+        {
+            statistics_type const& stats = levels_.at(level).statistics;
+            number_type const blocks = number_type(stats.count());
+            number_type values[components];
+            for (unsigned k = 0; k < components; ++k) {
+                values[k] = std::sqrt(stats.m2_[k] / (blocks * (blocks - 1)));
+            }
+            return traits::template make<dimension>(values);
+        }
+
+        /*
+         * Conservative estimate of the standard error of the mean: the
+         * largest level error, per component, over the levels that have at
+         * least min_blocks blocks. Levels with fewer blocks fluctuate too
+         * much to be trusted.
+         */
+        Q standard_error(std::size_t min_blocks = 16) const
+        {
+            number_type values[components] = {};
+            for (std::size_t level = 0; level < levels_.size(); ++level) {
+                if (levels_[level].statistics.count() < min_blocks || levels_[level].statistics.count() < 2) {
+                    break;
+                }
+                Q const error = level_error(level);
+                for (unsigned k = 0; k < components; ++k) {
+                    number_type const value = traits::get(error, k);
+                    values[k] = value > values[k] ? value : values[k];
+                }
+            }
+            return traits::template make<dimension>(values);
+        }
+
+      private:
+        struct level_state
+        {
+            statistics_type statistics;
+            number_type pending[components] = {};
+            bool has_pending = false;
+        };
+
+        // Adds a block mean at the given level and carries completed pairs
+        // up to the next levels.
+        void push(std::size_t level, number_type const* values)
+        {
+            number_type block[components];
+            for (unsigned k = 0; k < components; ++k) {
+                block[k] = values[k];
+            }
+            for (;; ++level) {
+                if (level == levels_.size()) {
+                    levels_.emplace_back();
+                }
+                level_state& state = levels_[level];
+                state.statistics.add(block);
+                if (!state.has_pending) {
+                    state.has_pending = true;
+                    for (unsigned k = 0; k < components; ++k) {
+                        state.pending[k] = block[k];
+                    }
+                    return;
+                }
+                state.has_pending = false;
+                for (unsigned k = 0; k < components; ++k) {
+                    block[k] = (state.pending[k] + block[k]) / 2;
+                }
+            }
+        }
+
+        std::vector<level_state> levels_;
+    };
+
+    template<typename Q>
+    constexpr unsigned block_average<Q>::components;
+
+    //------------------------------------------------------------------------
+    // Autocorrelation
+    //------------------------------------------------------------------------
+
+    /*
+     * Online time correlation <x(t) . x(t + lag)> by the multiple-tau method
+     * (Ramirez et al., J. Chem. Phys. 133, 154103 (2010)). Level 0 keeps the
+     * last points samples and correlates lags 0 to points - 1 exactly. Each
+     * higher level receives averages of averaging consecutive values of the
+     * level below and covers lags averaging times longer, so levels levels
+     * reach lags up to about points * averaging^(levels - 1) with memory
+     * proportional to levels * points.
+     */
+    template<typename Q>
+    class multiple_tau_correlator
+    {
+        using traits = detail::observable_traits<Q>;
+        static constexpr unsigned components = traits::components;
+
+      public:
+        using number_type = typename traits::number_type;
+        using dimension = typename traits::dimension;
+        using correlation_type = scalar<number_type, power_dimension_t<dimension, 2>>;
+
+        // Throws std::invalid_argument unless levels >= 1, averaging >= 2
+        // and points is a positive multiple of averaging.
+        explicit multiple_tau_correlator(std::size_t levels = 16, std::size_t points = 16, std::size_t averaging = 2)
+            : levels_{levels}
+            , points_{points}
+            , averaging_{averaging}
+            , samples_(levels * points * components, 0)
+            , head_(levels, 0)
+            , filled_(levels, 0)
+            , sums_(levels * points, 0)
+            , counts_(levels * points, 0)
+            , accumulators_(levels * components, 0)
+            , accumulated_(levels, 0)
+        {
+            if (levels < 1 || averaging < 2 || points < averaging || points % averaging != 0) {
+                throw std::invalid_argument("invalid multiple-tau parameters");
+            }
+        }
+
+        void add(Q const& value)
+        {
+            number_type values[components];
+            for (unsigned k = 0; k < components; ++k) {
+                values[k] = traits::get(value, k);
+            }
+            statistics_.add(value);
+            push(0, values);
+        }
+
+        /*
+         * Adds the correlation sums of other, which must have the same
+         * parameters, to this correlator. Meant for independent series such
+         * as replicas accumulated in parallel; the history of this correlator
+         * is kept.
+         */
+        void merge(multiple_tau_correlator const& other)
+        {
+            if (other.levels_ != levels_ || other.points_ != points_ || other.averaging_ != averaging_) {
+                throw std::invalid_argument("multiple-tau parameters do not match");
+            }
+            for (std::size_t i = 0; i < sums_.size(); ++i) {
+                sums_[i] += other.sums_[i];
+                counts_[i] += other.counts_[i];
+            }
+            statistics_.merge(other.statistics_);
+        }
+
+        std::size_t count() const
+        {
+            return statistics_.count();
+        }
+
+        Q mean() const
+        {
+            return statistics_.mean();
+        }
+
+        // Lags, in samples, that have been correlated so far, ascending.
+        std::vector<std::size_t> lags() const
+        {
+            std::vector<std::size_t> result;
+            std::size_t scale = 1;
+            for (std::size_t level = 0; level < levels_; ++level, scale *= averaging_) {
+                for (std::size_t j = first_point(level); j < points_; ++j) {
+                    if (counts_[level * points_ + j] != 0) {
+                        result.push_back(j * scale);
+                    }
+                }
+            }
+            return result;
+        }
+
+        // Mean of x(t) . x(t + lag) for each of lags().
+        std::vector<correlation_type> correlation() const
+        {
+            std::vector<correlation_type> result;
+            for (std::size_t level = 0; level < levels_; ++level) {
+                for (std::size_t j = first_point(level); j < points_; ++j) {
+                    std::size_t const index = level * points_ + j;
+                    if (counts_[index] != 0) {
+                        result.push_back(correlation_type{sums_[index] / number_type(counts_[index])});
+                    }
+                }
+            }
+            return result;
+        }
+
+        // Correlation of the fluctuations around the overall mean for each of
+        // lags().
+        std::vector<correlation_type> covariance() const
+        {
+            std::vector<correlation_type> result = correlation();
+            number_type square = 0;
+            Q const average = statistics_.mean();
+            for (unsigned k = 0; k < components; ++k) {
+                square += traits::get(average, k) * traits::get(average, k);
+            }
+            for (auto& value : result) {
+                value -= correlation_type{square};
+            }
+            return result;
+        }
+
+      private:
+        // Lags below points / averaging at a level repeat those of the level
+        // below, so only level 0 correlates them.
+        std::size_t first_point(std::size_t level) const
+        {
+            return level == 0 ? 0 : points_ / averaging_;
+        }
+
+        void push(std::size_t level, number_type const* values)
+        {
+            std::size_t& head = head_[level];
+            head = (head + points_ - 1) % points_;
+            number_type* const newest = &samples_[(level * points_ + head) * components];
+            for (unsigned k = 0; k < components; ++k) {
+                newest[k] = values[k];
+            }
+            if (filled_[level] < points_) {
+                ++filled_[level];
+            }
+
+            for (std::size_t j = first_point(level); j < filled_[level]; ++j) {
+                number_type const* const older = &samples_[(level * points_ + (head + j) % points_) * components];
+                number_type product = 0;
+                for (unsigned k = 0; k < components; ++k) {
+                    product += newest[k] * older[k];
+                }
+                sums_[level * points_ + j] += product;
+                ++counts_[level * points_ + j];
+            }
+
+            number_type* const accumulator = &accumulators_[level * components];
+            for (unsigned k = 0; k < components; ++k) {
+                accumulator[k] += values[k];
+            }
+            if (++accumulated_[level] == averaging_) {
+                number_type average[components];
+                for (unsigned k = 0; k < components; ++k) {
+                    average[k] = accumulator[k] / number_type(averaging_);
+                    accumulator[k] = 0;
+                }
+                accumulated_[level] = 0;
+                if (level + 1 < levels_) {
+                    push(level + 1, average);
+                }
+            }
+        }
+
+        std::size_t levels_;
+        std::size_t points_;
+        std::size_t averaging_;
+        std::vector<number_type> samples_;
+        std::vector<std::size_t> head_;
+        std::vector<std::size_t> filled_;
+        std::vector<number_type> sums_;
+        std::vector<std::size_t> counts_;
+        std::vector<number_type> accumulators_;
+        std::vector<std::size_t> accumulated_;
+        running_statistics<Q> statistics_;
+    };
+
+    template<typename Q>
+    constexpr unsigned multiple_tau_correlator<Q>::components;
+
+    namespace detail // for dim::autocorrelation
+    {
+        template<typename Q>
+        std::vector<scalar<typename observable_traits<Q>::number_type,
+            power_dimension_t<typename observable_traits<Q>::dimension, 2>>>
+        correlate_fft(Q const* values, std::size_t count, std::size_t max_lag, bool subtract_mean)
+        {
+            using traits = observable_traits<Q>;
+            using T = typename traits::number_type;
+            using correlation_type = scalar<T, power_dimension_t<typename traits::dimension, 2>>;
+
+            std::size_t const lags = count < max_lag + 1 ? count : max_lag + 1;
+            std::vector<T> sums(lags, 0);
+            if (lags == 0) {
+                return std::vector<correlation_type>();
+            }
+
+            // Zero padding to at least 2 * count avoids circular wrap-around.
+            std::size_t n = 1;
+            while (n < 2 * count) {
+                n *= 2;
+            }
+            auto const forward = fft_roots<T>(n, -1);
+            auto const inverse = fft_roots<T>(n, 1);
+            std::vector<std::complex<T>> buffer(n);
+
+            for (unsigned k = 0; k < traits::components; ++k) {
+                T mean = 0;
+                if (subtract_mean) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        mean += traits::get(values[i], k);
+                    }
+                    mean /= T(count);
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    buffer[i] = i < count ? traits::get(values[i], k) - mean : T(0);
+                }
+                fft(buffer.data(), n, forward.data());
+                for (auto& x : buffer) {
+                    x = std::norm(x);
+                }
+                fft(buffer.data(), n, inverse.data());
+                for (std::size_t lag = 0; lag < lags; ++lag) {
+                    sums[lag] += buffer[lag].real();
+                }
+            }
+
+            std::vector<correlation_type> result(lags);
+            for (std::size_t lag = 0; lag < lags; ++lag) {
+                result[lag] = correlation_type{sums[lag] / (T(n) * T(count - lag))};
+            }
+            return result;
+        }
+    } // namespace detail
+
+    /*
+     * Returns the mean of x(t) . x(t + lag) over the stored series for lags
+     * 0 to max_lag (at most count - 1), computed with FFTs in O(n log n).
+     */
+    template<typename Q>
+    std::vector<typename multiple_tau_correlator<Q>::correlation_type> autocorrelation(
+        Q const* values, std::size_t count, std::size_t max_lag)
+    {
+        return detail::correlate_fft(values, count, max_lag, false);
+    }
+
+    template<typename Q>
+    std::vector<typename multiple_tau_correlator<Q>::correlation_type> autocorrelation(
+        std::vector<Q> const& values, std::size_t max_lag)
+    {
+        return autocorrelation(values.data(), values.size(), max_lag);
+    }
+
+    // Like autocorrelation, but of the fluctuations around the series mean.
+    template<typename Q>
+    std::vector<typename multiple_tau_correlator<Q>::correlation_type> autocovariance(
+        Q const* values, std::size_t count, std::size_t max_lag)
+    {
+        return detail::correlate_fft(values, count, max_lag, true);
+    }
+
+    template<typename Q>
+    std::vector<typename multiple_tau_correlator<Q>::correlation_type> autocovariance(
+        std::vector<Q> const& values, std::size_t max_lag)
+    {
+        return autocovariance(values.data(), values.size(), max_lag);
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_STATISTICS_HPP
@@ -0,0 +1,711 @@
+/*
+ * dim - Streaming radial distribution function and structure factor analysis.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_STRUCTURE_HPP
+#define INCLUDED_DIM_STRUCTURE_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+
+namespace dim
+{
+    //----------------------------------------------------------------
+    // Frames and frame sources
+    //----------------------------------------------------------------
+
+    /*
+     * Non-owning view of a trajectory frame: count positions in an
+     * orthorhombic periodic box.
+     */
+    template<typename T>
+    struct frame_view
+    {
+        point<T, mech::length, 3> const* positions;
+        std::size_t count;
+        vector<T, mech::length, 3> box;
+    };
+
+    /*
+     * Frame source handing out views into a contiguous array of frames of
+     * the same particle count, such as a memory-mapped trajectory. No
+     * coordinates are copied.
+     *
+     * A frame source has a member function bool next(frame_view<T>&) that
+     * returns false after the last frame.
+     */
+    template<typename T>
+    class buffer_frame_source
+    {
+      public:
+        using point_type = point<T, mech::length, 3>;
+        using box_type = vector<T, mech::length, 3>;
+
+        static_assert(std::is_standard_layout<point_type>::value
+                && sizeof(point_type) == 3 * sizeof(T),
+            "points must be stored as three packed coordinates");
+
+        buffer_frame_source(
+            point_type const* data, std::size_t frame_count, std::size_t particle_count, box_type box)
+            : data_{data}
+            , frames_{frame_count}
+            , particles_{particle_count}
+            , box_(box)
+        {
+        }
+
+        /*
+         * Interprets bytes of raw memory holding packed xyz coordinates as
+         * frames of particle_count points. Trailing bytes not filling a
+         * whole frame are ignored. Throws std::invalid_argument if data is
+         * not aligned for T.
+         */
+        buffer_frame_source(
+            void const* data, std::size_t bytes, std::size_t particle_count, box_type box)
+            : data_{static_cast<point_type const*>(data)}
+            , frames_{particle_count == 0 ? 0 : bytes / (particle_count * sizeof(point_type))}
+            , particles_{particle_count}
+            , box_(box)
+        {
+            if (reinterpret_cast<std::uintptr_t>(data) % alignof(point_type) != 0) {
+                throw std::invalid_argument("frame data is not aligned");
+            }
+        }
+
+        std::size_t frame_count() const
+        {
+            return frames_;
+        }
+
+        /*
+         * Rewinds to the first frame.
+         */
+        void reset()
+        {
+            next_ = 0;
+        }
+
+        bool next(frame_view<T>& frame)
+        {
+            if (next_ >= frames_) {
+                return false;
+            }
+            frame.positions = data_ + next_ * particles_;
+            frame.count = particles_;
+            frame.box = box_;
+            next_++;
+            return true;
+        }
+
+      private:
+        point_type const* data_;
+        std::size_t frames_;
+        std::size_t particles_;
+        box_type box_;
+        std::size_t next_ = 0;
+    };
+
+#if defined(__unix__) || defined(__APPLE__)
+    /*
+     * Read-only memory mapping of a whole file. Throws std::system_error if
+     * the file cannot be opened or mapped.
+     */
+    class mapped_file
+    {
+      public:
+        explicit mapped_file(std::string const& path)
+        {
+            int const fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                int const error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "cannot stat " + path);
+            }
+            size_ = std::size_t(info.st_size);
+            if (size_ > 0) {
+                void* const data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+                if (data == MAP_FAILED) {
+                    int const error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), "cannot map " + path);
+                }
+                data_ = data;
+            }
+            ::close(fd);
+        }
+
+        mapped_file(mapped_file const&) = delete;
+        mapped_file& operator=(mapped_file const&) = delete;
+
+        ~mapped_file()
+        {
+            if (data_) {
+                ::munmap(data_, size_);
+            }
+        }
+
+        void const* data() const
+        {
+            return data_;
+        }
+
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+      private:
+        void* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+#endif
+
+    //----------------------------------------------------------------
+    // Radial distribution function
+    //----------------------------------------------------------------
+
+    namespace detail // for dim::radial_distribution
+    {
+        // Forward half of the 26 neighbor cell offsets. Visiting these and
+        // the cell itself enumerates every pair of adjacent cells once.
+        constexpr int half_stencil[13][3] = {{0, 0, 1}, {0, 1, -1}, {0, 1, 0}, {0, 1, 1},
+            {1, -1, -1}, {1, -1, 0}, {1, -1, 1}, {1, 0, -1}, {1, 0, 0}, {1, 0, 1}, {1, 1, -1},
+            {1, 1, 0}, {1, 1, 1}};
+    } // namespace detail
+
+    /*
+     * Accumulates the radial distribution function g(r) over frames. Pairs
+     * are found through a cell list and binned into per-thread histograms,
+     * so a frame costs O(N) instead of O(N^2) for a fixed density.
+     */
+    template<typename T>
+    class radial_distribution
+    {
+      public:
+        using number_type = T;
+        using length_type = scalar<T, mech::length>;
+
+        /*
+         * Creates an empty accumulator for distances in [0, max_distance)
+         * split into bins bins. Throws std::invalid_argument if there are no
+         * bins or max_distance is not positive.
+         */
+        radial_distribution(length_type max_distance, std::size_t bins)
+            : max_distance_{max_distance.value()}
+            , counts_(bins, 0)
+        {
+            if (bins == 0 || !(max_distance_ > T(0))) {
+                throw std::invalid_argument("invalid histogram range");
+            }
+        }
+
+        std::size_t bins() const
+        {
+            return counts_.size();
+        }
+
+        length_type bin_width() const
+        {
+            return length_type{max_distance_ / T(counts_.size())};
+        }
+
+        length_type bin_center(std::size_t bin) const
+        {
+            return bin_width() * (T(bin) + T(0.5));
+        }
+
+        std::size_t frames() const
+        {
+            return frames_;
+        }
+
+        /*
+         * Returns the accumulated numbers of unordered pairs in the bins.
+         */
+        std::vector<std::uint64_t> const& counts() const
+        {
+            return counts_;
+        }
+
+        /*
+         * Returns g(r) in each bin: the pair counts divided by those of an
+         * ideal gas of the same density averaged over the frames.
+         */
+        std::vector<T> values() const
+        {
+            T const pi = T(3.14159265358979323846264338327950288L);
+            T const width = max_distance_ / T(counts_.size());
+            std::vector<T> result(counts_.size(), T(0));
+            if (pair_density_ == T(0)) {
+                return result;
+            }
+            for (std::size_t b = 0; b < counts_.size(); ++b) {
+                T const inner = width * T(b);
+                T const outer = width * T(b + 1);
+                T const shell = 4 * pi / 3 * (outer * outer * outer - inner * inner * inner);
+                result[b] = T(counts_[b]) / (pair_density_ * shell);
+            }
+            return result;
+        }
+
+        void reset()
+        {
+            counts_.assign(counts_.size(), 0);
+            pair_density_ = T(0);
+            frames_ = 0;
+        }
+
+        /*
+         * Adds the pairs of a frame. Throws std::invalid_argument if the
+         * maximum distance exceeds the half of the shortest box side.
+         */
+        void accumulate(frame_view<T> const& frame)
+        {
+            T side[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                side[k] = frame.box[k].value();
+                if (!(max_distance_ * 2 <= side[k])) {
+                    throw std::invalid_argument("maximum distance must not exceed half the box size");
+                }
+            }
+
+            std::size_t const count = frame.count;
+            T const volume = side[0] * side[1] * side[2];
+            pair_density_ += T(count) * T(count == 0 ? 0 : count - 1) / (2 * volume);
+            frames_++;
+
+            std::size_t cells[3];
+            bool use_cells = true;
+            for (unsigned k = 0; k < 3; ++k) {
+                cells[k] = std::size_t(side[k] / max_distance_);
+                use_cells = use_cells && cells[k] >= 3;
+            }
+            if (!use_cells) {
+                cells[0] = cells[1] = cells[2] = 1;
+            }
+            sort_into_cells(frame, side, cells);
+
+            std::size_t const total = cells[0] * cells[1] * cells[2];
+            std::size_t const chunks = detail::chunk_count(use_cells ? total : count, use_cells ? 64 : 512);
+            std::vector<std::vector<std::uint64_t>> histograms(
+                chunks, std::vector<std::uint64_t>(counts_.size(), 0));
+
+            if (use_cells) {
+                detail::parallel_chunks(
+                    total, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                        for (std::size_t c = begin; c < end; ++c) {
+                            count_cell_pairs(c, cells, side, histograms[chunk].data());
+                        }
+                    });
+            } else {
+                detail::parallel_chunks(
+                    count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                        for (std::size_t i = begin; i < end; ++i) {
+                            count_pairs(i, i + 1, count, side, histograms[chunk].data());
+                        }
+                    });
+            }
+
+            for (auto const& histogram : histograms) {
+                for (std::size_t b = 0; b < counts_.size(); ++b) {
+                    counts_[b] += histogram[b];
+                }
+            }
+        }
+
+        /*
+         * Adds all the frames of a source. Returns the number of frames.
+         */
+        template<typename Source>
+        std::size_t accumulate_all(Source& source)
+        {
+            std::size_t count = 0;
+            frame_view<T> frame;
+            while (source.next(frame)) {
+                accumulate(frame);
+                count++;
+            }
+            return count;
+        }
+
+      private:
+        T max_distance_;
+        std::vector<std::uint64_t> counts_;
+        T pair_density_ = T(0);
+        std::size_t frames_ = 0;
+
+        // Frame coordinates wrapped into the box and sorted by cell.
+        std::vector<T> sorted_;
+        std::vector<std::size_t> cell_start_;
+
+        void sort_into_cells(frame_view<T> const& frame, T const* side, std::size_t const* cells)
+        {
+            std::size_t const count = frame.count;
+            std::size_t const total = cells[0] * cells[1] * cells[2];
+            std::vector<std::size_t> cell_of(count);
+            cell_start_.assign(total + 1, 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t index = 0;
+                for (unsigned k = 0; k < 3; ++k) {
+                    T const x = frame.positions[i][k].value();
+                    T const frac = x / side[k] - std::floor(x / side[k]);
+                    std::size_t c = std::size_t(frac * T(cells[k]));
+                    c = c < cells[k] ? c : cells[k] - 1;
+                    index = index * cells[k] + c;
+                }
+                cell_of[i] = index;
+                cell_start_[index + 1]++;
+            }
+            for (std::size_t c = 0; c < total; ++c) {
+                cell_start_[c + 1] += cell_start_[c];
+            }
+
+            sorted_.resize(count * 3);
+            std::vector<std::size_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+            for (std::size_t i = 0; i < count; ++i) {
+                T* const dest = &sorted_[fill[cell_of[i]]++ * 3];
+                for (unsigned k = 0; k < 3; ++k) {
+                    dest[k] = frame.positions[i][k].value();
+                }
+            }
+        }
+
+        // Bins the pairs of sorted particle i with sorted particles in
+        // [begin, end).
+        void count_pairs(
+            std::size_t i, std::size_t begin, std::size_t end, T const* side, std::uint64_t* histogram) const
+        {
+            T const r2_max = max_distance_ * max_distance_;
+            T const scale = T(counts_.size()) / max_distance_;
+            std::size_t const last = counts_.size() - 1;
+            T const* const xi = &sorted_[i * 3];
+
+            for (std::size_t j = begin; j < end; ++j) {
+                T const* const xj = &sorted_[j * 3];
+                T r2 = T(0);
+                for (unsigned k = 0; k < 3; ++k) {
+                    T delta = xi[k] - xj[k];
+                    delta -= side[k] * std::round(delta / side[k]);
+                    r2 += delta * delta;
+                }
+                if (r2 < r2_max) {
+                    std::size_t const bin = std::size_t(std::sqrt(r2) * scale);
+                    histogram[bin < last ? bin : last]++;
+                }
+            }
+        }
+
+        void count_cell_pairs(
+            std::size_t c, std::size_t const* cells, T const* side, std::uint64_t* histogram) const
+        {
+            std::size_t const cz = c % cells[2];
+            std::size_t const cy = c / cells[2] % cells[1];
+            std::size_t const cx = c / cells[2] / cells[1];
+            std::size_t const begin = cell_start_[c];
+            std::size_t const end = cell_start_[c + 1];
+
+            for (std::size_t i = begin; i < end; ++i) {
+                count_pairs(i, i + 1, end, side, histogram);
+            }
+            for (auto const& offset : detail::half_stencil) {
+                std::size_t const nx = (cx + cells[0] + std::size_t(offset[0] + 1) - 1) % cells[0];
+                std::size_t const ny = (cy + cells[1] + std::size_t(offset[1] + 1) - 1) % cells[1];
+                std::size_t const nz = (cz + cells[2] + std::size_t(offset[2] + 1) - 1) % cells[2];
+                std::size_t const n = (nx * cells[1] + ny) * cells[2] + nz;
+                for (std::size_t i = begin; i < end; ++i) {
+                    count_pairs(i, cell_start_[n], cell_start_[n + 1], side, histogram);
+                }
+            }
+        }
+    };
+
+    //----------------------------------------------------------------
+    // Static structure factor
+    //----------------------------------------------------------------
+
+    /*
+     * Accumulates the static structure factor S(k) = |sum_j exp(i k.r_j)|^2 / N
+     * over frames, averaged over the wave vectors of the periodic box within
+     * spherical shells of |k| in [0, max_wavenumber).
+     *
+     * The phase factors exp(i k.r) are built by recurrence from per-axis
+     * tables, so a frame costs O(N K) multiplications for K wave vectors
+     * and no trigonometric calls beyond 3 N.
+     */
+    template<typename T>
+    class structure_factor
+    {
+      public:
+        using number_type = T;
+        using wavenumber_type = scalar<T, power_dimension_t<mech::length, -1>>;
+
+        /*
+         * Creates an empty accumulator. Throws std::invalid_argument if there
+         * are no bins or max_wavenumber is not positive.
+         */
+        structure_factor(wavenumber_type max_wavenumber, std::size_t bins)
+            : max_wavenumber_{max_wavenumber.value()}
+            , sums_(bins, T(0))
+            , samples_(bins, 0)
+        {
+            if (bins == 0 || !(max_wavenumber_ > T(0))) {
+                throw std::invalid_argument("invalid histogram range");
+            }
+        }
+
+        std::size_t bins() const
+        {
+            return sums_.size();
+        }
+
+        wavenumber_type bin_width() const
+        {
+            return wavenumber_type{max_wavenumber_ / T(sums_.size())};
+        }
+
+        wavenumber_type bin_center(std::size_t bin) const
+        {
+            return bin_width() * (T(bin) + T(0.5));
+        }
+
+        std::size_t frames() const
+        {
+            return frames_;
+        }
+
+        /*
+         * Returns the number of wave vectors sampled in each bin over all
+         * frames. Bins narrower than the reciprocal lattice spacing may have
+         * none.
+         */
+        std::vector<std::uint64_t> const& samples() const
+        {
+            return samples_;
+        }
+
+        /*
+         * Returns the mean S(k) in each bin, or zero for bins without
+         * samples.
+         */
+        std::vector<T> values() const
+        {
+            std::vector<T> result(sums_.size(), T(0));
+            for (std::size_t b = 0; b < sums_.size(); ++b) {
+                if (samples_[b] != 0) {
+                    result[b] = sums_[b] / T(samples_[b]);
+                }
+            }
+            return result;
+        }
+
+        void reset()
+        {
+            sums_.assign(sums_.size(), T(0));
+            samples_.assign(samples_.size(), 0);
+            frames_ = 0;
+        }
+
+        /*
+         * Adds the wave vectors of a frame.
+         */
+        void accumulate(frame_view<T> const& frame)
+        {
+            T const pi = T(3.14159265358979323846264338327950288L);
+            std::size_t const count = frame.count;
+            frames_++;
+            if (count == 0) {
+                return;
+            }
+
+            // Phase tables exp(i 2 pi m x / L) for m = 0, ..., modes[k] laid
+            // out as [m * count + particle].
+            std::size_t modes[3];
+            T unit[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                T const side = frame.box[k].value();
+                unit[k] = 2 * pi / side;
+                modes[k] = std::size_t(max_wavenumber_ / unit[k]);
+                auto& table = phases_[k];
+                table.resize((modes[k] + 1) * count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    T const angle = unit[k] * frame.positions[i][k].value();
+                    T const c = std::cos(angle);
+                    T const s = std::sin(angle);
+                    table[i] = std::complex<T>{1, 0};
+                    for (std::size_t m = 1; m <= modes[k]; ++m) {
+                        std::complex<T> const prev = table[(m - 1) * count + i];
+                        table[m * count + i] = std::complex<T>{
+                            prev.real() * c - prev.imag() * s, prev.real() * s + prev.imag() * c};
+                    }
+                }
+            }
+
+            // Wave vectors in the half space, as S(k) = S(-k).
+            struct wave
+            {
+                std::ptrdiff_t n[3];
+                std::size_t bin;
+            };
+            std::vector<wave> waves;
+            T const scale = T(sums_.size()) / max_wavenumber_;
+            std::ptrdiff_t const mx = std::ptrdiff_t(modes[0]);
+            std::ptrdiff_t const my = std::ptrdiff_t(modes[1]);
+            std::ptrdiff_t const mz = std::ptrdiff_t(modes[2]);
+            for (std::ptrdiff_t x = 0; x <= mx; ++x) {
+                for (std::ptrdiff_t y = (x == 0 ? 0 : -my); y <= my; ++y) {
+                    for (std::ptrdiff_t z = (x == 0 && y == 0 ? 1 : -mz); z <= mz; ++z) {
+                        T const kx = unit[0] * T(x);
+                        T const ky = unit[1] * T(y);
+                        T const kz = unit[2] * T(z);
+                        T const k = std::sqrt(kx * kx + ky * ky + kz * kz);
+                        if (k < max_wavenumber_) {
+                            std::size_t const bin = std::size_t(k * scale);
+                            waves.push_back(wave{{x, y, z}, bin < sums_.size() ? bin : sums_.size() - 1});
+                        }
+                    }
+                }
+            }
+
+            std::size_t const chunks = detail::chunk_count(waves.size() * count, 1 << 16);
+            std::vector<std::vector<T>> partials(chunks, std::vector<T>(sums_.size(), T(0)));
+            detail::parallel_chunks(
+                waves.size(), chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    for (std::size_t w = begin; w < end; ++w) {
+                        partials[chunk][waves[w].bin] += intensity(waves[w].n, count);
+                    }
+                });
+
+            for (auto const& partial : partials) {
+                for (std::size_t b = 0; b < sums_.size(); ++b) {
+                    sums_[b] += partial[b];
+                }
+            }
+            for (auto const& w : waves) {
+                samples_[w.bin]++;
+            }
+        }
+
+        /*
+         * Adds all the frames of a source. Returns the number of frames.
+         */
+        template<typename Source>
+        std::size_t accumulate_all(Source& source)
+        {
+            std::size_t count = 0;
+            frame_view<T> frame;
+            while (source.next(frame)) {
+                accumulate(frame);
+                count++;
+            }
+            return count;
+        }
+
+      private:
+        T max_wavenumber_;
+        std::vector<T> sums_;
+        std::vector<std::uint64_t> samples_;
+        std::size_t frames_ = 0;
+        std::vector<std::complex<T>> phases_[3];
+
+        // Returns |sum_j exp(i k.r_j)|^2 / N for k = 2 pi (n / L). Complex
+        // products are spelled out to avoid the library's NaN handling.
+        T intensity(std::ptrdiff_t const* n, std::size_t count) const
+        {
+            std::complex<T> const* tables[3];
+            T signs[3];
+            for (unsigned k = 0; k < 3; ++k) {
+                std::size_t const m = std::size_t(n[k] < 0 ? -n[k] : n[k]);
+                tables[k] = &phases_[k][m * count];
+                signs[k] = n[k] < 0 ? T(-1) : T(1);
+            }
+
+            T re = T(0);
+            T im = T(0);
+            for (std::size_t i = 0; i < count; ++i) {
+                T const ar = tables[0][i].real();
+                T const ai = signs[0] * tables[0][i].imag();
+                T const br = tables[1][i].real();
+                T const bi = signs[1] * tables[1][i].imag();
+                T const cr = tables[2][i].real();
+                T const ci = signs[2] * tables[2][i].imag();
+                T const abr = ar * br - ai * bi;
+                T const abi = ar * bi + ai * br;
+                re += abr * cr - abi * ci;
+                im += abr * ci + abi * cr;
+            }
+            return (re * re + im * im) / T(count);
+        }
+    };
+
+    //----------------------------------------------------------------
+    // Streaming
+    //----------------------------------------------------------------
+
+    /*
+     * Reads every frame of source once and passes it to each of the
+     * analyzers, which are objects with accumulate(frame_view<T> const&).
+     * Returns the number of frames.
+     */
+    template<typename T, typename Source, typename... Analyzers>
+    std::size_t analyze(Source& source, Analyzers&... analyzers)
+    {
+        std::size_t count = 0;
+        frame_view<T> frame;
+        while (source.next(frame)) {
+            int const expand[] = {0, (analyzers.accumulate(frame), 0)...};
+            (void) expand;
+            count++;
+        }
+        return count;
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_STRUCTURE_HPP
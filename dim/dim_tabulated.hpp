@@ -0,0 +1,343 @@
+/*
+ * dim - Tabulated functions of squared distance with cubic-spline interpolation.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_TABULATED_HPP
+#define INCLUDED_DIM_TABULATED_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "dim.hpp"
+#include "dim_arena.hpp"
+
+namespace dim
+{
+    namespace detail // for dim::tabulated_function
+    {
+        // Cubic polynomial c0 + c1 t + c2 t^2 + c3 t^3 on a unit interval.
+        // A segment of doubles fills exactly one 256-bit lane.
+        template<typename T>
+        struct alignas(4 * sizeof(T)) spline_segment
+        {
+            T coeffs[4];
+        };
+
+        // Contiguous array of spline segments aligned to a cache line.
+        template<typename T>
+        using segment_buffer =
+            std::vector<spline_segment<T>, aligned_allocator<spline_segment<T>, 64>>;
+
+        // Evaluates a uniform spline and the derivative with respect to the
+        // (unscaled) argument at x, given in units of intervals from the
+        // lower end. x is clamped to the table range.
+        template<typename T>
+        void evaluate_spline(
+            spline_segment<T> const* segments, std::size_t size, T x, T& value, T& slope)
+        {
+            x = x < T(0) ? T(0) : (x > T(size) ? T(size) : x);
+            std::size_t index = std::size_t(x);
+            index = index < size ? index : size - 1;
+            T const t = x - T(index);
+            T const* c = segments[index].coeffs;
+            value = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+            slope = c[1] + t * (2 * c[2] + t * 3 * c[3]);
+        }
+
+        // Batch evaluation. The loop has no branches so that compilers may
+        // vectorize it with gather instructions.
+        template<typename T>
+        void evaluate_spline_batch(spline_segment<T> const* segments,
+            std::size_t size,
+            T const* xs,
+            std::size_t count,
+            T* values,
+            T* slopes)
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                evaluate_spline(segments, size, xs[i], values[i], slopes[i]);
+            }
+        }
+
+#if defined(__AVX2__)
+        inline void evaluate_spline_batch(spline_segment<double> const* segments,
+            std::size_t size,
+            double const* xs,
+            std::size_t count,
+            double* values,
+            double* slopes)
+        {
+            double const* const base = segments[0].coeffs;
+            __m256d const zero = _mm256_setzero_pd();
+            __m256d const upper = _mm256_set1_pd(double(size));
+            __m256d const last = _mm256_set1_pd(double(size - 1));
+            __m256d const two = _mm256_set1_pd(2);
+            __m256d const three = _mm256_set1_pd(3);
+            __m256d const all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d x = _mm256_loadu_pd(xs + i);
+                x = _mm256_min_pd(_mm256_max_pd(x, zero), upper);
+                __m256d const index = _mm256_min_pd(_mm256_floor_pd(x), last);
+                __m256d const t = _mm256_sub_pd(x, index);
+
+                // Each segment has four coefficients.
+                __m128i const offset = _mm_slli_epi32(_mm256_cvttpd_epi32(index), 2);
+                __m256d const c0 = _mm256_mask_i32gather_pd(zero, base, offset, all, 8);
+                __m256d const c1 = _mm256_mask_i32gather_pd(zero, base + 1, offset, all, 8);
+                __m256d const c2 = _mm256_mask_i32gather_pd(zero, base + 2, offset, all, 8);
+                __m256d const c3 = _mm256_mask_i32gather_pd(zero, base + 3, offset, all, 8);
+
+                __m256d value = _mm256_add_pd(c2, _mm256_mul_pd(t, c3));
+                value = _mm256_add_pd(c1, _mm256_mul_pd(t, value));
+                value = _mm256_add_pd(c0, _mm256_mul_pd(t, value));
+
+                __m256d slope = _mm256_mul_pd(_mm256_mul_pd(t, three), c3);
+                slope = _mm256_add_pd(_mm256_mul_pd(two, c2), slope);
+                slope = _mm256_add_pd(c1, _mm256_mul_pd(t, slope));
+
+                _mm256_storeu_pd(values + i, value);
+                _mm256_storeu_pd(slopes + i, slope);
+            }
+            for (; i < count; ++i) {
+                evaluate_spline(segments, size, xs[i], values[i], slopes[i]);
+            }
+        }
+#endif
+    } // namespace detail
+
+    /*
+     * Function of squared distance tabulated on a uniform grid and
+     * interpolated with a clamped cubic spline. Working with squared
+     * distance avoids square roots in pair loops.
+     *
+     * DY is the dimension of the function value (energy by default) and DX
+     * is the dimension of distance. The argument is clamped to the table
+     * range.
+     */
+    template<typename T, typename DY = mech::energy, typename DX = mech::length>
+    class tabulated_function
+    {
+      public:
+        using number_type = T;
+        using argument_type = scalar<T, power_dimension_t<DX, 2>>;
+        using value_type = scalar<T, DY>;
+        using force_type = scalar<T, quotient_dimension_t<DY, DX>>;
+        using force_factor_type = scalar<T, quotient_dimension_t<DY, power_dimension_t<DX, 2>>>;
+
+        /*
+         * Function value and force factor -2 dU/d(r^2) at a point. The force
+         * vector on the first particle of a pair is the force factor times
+         * the displacement vector from the second particle.
+         */
+        struct sample
+        {
+            value_type value;
+            force_factor_type force_factor;
+        };
+
+        // An empty table. It evaluates to zero with zero force.
+        tabulated_function() = default;
+
+        /*
+         * Samples fn at intervals + 1 points evenly spaced in [lower, upper].
+         * fn takes argument_type and returns value_type.
+         */
+        template<typename F>
+        tabulated_function(F fn, argument_type lower, argument_type upper, std::size_t intervals)
+            : lower_{lower.value()}
+            , scale_{T(intervals) / (upper.value() - lower.value())}
+        {
+            build(fn, lower.value(), upper.value(), intervals);
+        }
+
+        argument_type lower() const
+        {
+            return argument_type{lower_};
+        }
+
+        argument_type upper() const
+        {
+            return argument_type{lower_ + T(segments_.size()) / scale_};
+        }
+
+        std::size_t size() const
+        {
+            return segments_.size();
+        }
+
+        /*
+         * Returns the maximum absolute interpolation error against fn,
+         * measured at the quarter points of each interval at construction.
+         */
+        value_type max_error() const
+        {
+            return value_type{max_error_};
+        }
+
+        value_type operator()(argument_type x) const
+        {
+            return evaluate(x).value;
+        }
+
+        sample evaluate(argument_type x) const
+        {
+            if (segments_.empty()) {
+                return sample{};
+            }
+            T value;
+            T slope;
+            detail::evaluate_spline(segments_.data(), segments_.size(),
+                (x.value() - lower_) * scale_, value, slope);
+            return sample{value_type{value}, force_factor_type{-2 * slope * scale_}};
+        }
+
+        /*
+         * Returns the magnitude -dU/dr of the force. This takes a square
+         * root; prefer the force factor in pair loops.
+         */
+        force_type force_magnitude(argument_type x) const
+        {
+            return evaluate(x).force_factor * sqrt(x);
+        }
+
+        /*
+         * Evaluates the function and the force factor at count arguments.
+         * Uses AVX2 gathers for double when available.
+         */
+        void evaluate(argument_type const* xs,
+            std::size_t count,
+            value_type* values,
+            force_factor_type* force_factors) const
+        {
+            if (segments_.empty()) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    values[i] = value_type{};
+                    force_factors[i] = force_factor_type{};
+                }
+                return;
+            }
+
+            constexpr std::size_t block = 64;
+            T args[block];
+            T raw_values[block];
+            T raw_slopes[block];
+
+            for (std::size_t start = 0; start < count; start += block) {
+                std::size_t const size = count - start < block ? count - start : block;
+                for (std::size_t i = 0; i < size; ++i) {
+                    args[i] = (xs[start + i].value() - lower_) * scale_;
+                }
+                detail::evaluate_spline_batch(
+                    segments_.data(), segments_.size(), args, size, raw_values, raw_slopes);
+                for (std::size_t i = 0; i < size; ++i) {
+                    values[start + i] = value_type{raw_values[i]};
+                    force_factors[start + i] = force_factor_type{-2 * raw_slopes[i] * scale_};
+                }
+            }
+        }
+
+      private:
+        T lower_ = T(0);
+        T scale_ = T(1);
+        T max_error_ = T(0);
+        detail::segment_buffer<T> segments_;
+
+        template<typename F>
+        void build(F& fn, T lower, T upper, std::size_t intervals)
+        {
+            T const h = (upper - lower) / T(intervals);
+            auto const f = [&](T x) { return value_type{fn(argument_type{x})}.value(); };
+
+            std::vector<T> y(intervals + 1);
+            for (std::size_t i = 0; i <= intervals; ++i) {
+                y[i] = f(lower + h * T(i));
+            }
+
+            // End slopes by third-order one-sided differences on a finer
+            // grid, so that the function is never evaluated outside the
+            // range. These are exact for cubic polynomials.
+            T const delta = h / 16;
+            T const slope_lower = (-11 * y[0] + 18 * f(lower + delta) - 9 * f(lower + 2 * delta)
+                                      + 2 * f(lower + 3 * delta))
+                / (6 * delta);
+            T const slope_upper = (11 * y[intervals] - 18 * f(upper - delta)
+                                      + 9 * f(upper - 2 * delta) - 2 * f(upper - 3 * delta))
+                / (6 * delta);
+
+            // Solve the tridiagonal system of the clamped spline for second
+            // derivatives m by the Thomas algorithm.
+            std::size_t const n = intervals + 1;
+            std::vector<T> diag(n, T(4));
+            std::vector<T> rhs(n);
+            diag[0] = diag[n - 1] = T(2);
+            rhs[0] = 6 / h * ((y[1] - y[0]) / h - slope_lower);
+            rhs[n - 1] = 6 / h * (slope_upper - (y[n - 1] - y[n - 2]) / h);
+            for (std::size_t i = 1; i + 1 < n; ++i) {
+                rhs[i] = 6 * (y[i + 1] - 2 * y[i] + y[i - 1]) / (h * h);
+            }
+            for (std::size_t i = 1; i < n; ++i) {
+                T const w = T(1) / diag[i - 1];
+                diag[i] -= w;
+                rhs[i] -= w * rhs[i - 1];
+            }
+            std::vector<T> m(n);
+            m[n - 1] = rhs[n - 1] / diag[n - 1];
+            for (std::size_t i = n - 1; i-- > 0;) {
+                m[i] = (rhs[i] - m[i + 1]) / diag[i];
+            }
+
+            segments_.resize(intervals);
+            auto* const segments = segments_.data();
+            for (std::size_t i = 0; i < intervals; ++i) {
+                T* const c = segments[i].coeffs;
+                c[0] = y[i];
+                c[1] = y[i + 1] - y[i] - h * h * (2 * m[i] + m[i + 1]) / 6;
+                c[2] = h * h * m[i] / 2;
+                c[3] = h * h * (m[i + 1] - m[i]) / 6;
+            }
+
+            max_error_ = T(0);
+            for (std::size_t i = 0; i < intervals; ++i) {
+                for (unsigned q = 1; q < 4; ++q) {
+                    T const x = lower + h * (T(i) + T(q) / 4);
+                    T const error = std::fabs(evaluate(argument_type{x}).value.value() - f(x));
+                    max_error_ = error > max_error_ ? error : max_error_;
+                }
+            }
+        }
+    };
+} // namespace dim
+
+#endif // INCLUDED_DIM_TABULATED_HPP
@@ -0,0 +1,1618 @@
+/*
+ * dim - Fast CSV and XYZ text formatting and parsing of dimensioned arrays.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_TEXT_HPP
+#define INCLUDED_DIM_TEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dim.hpp"
+#include "dim_parallel.hpp"
+#include "dim_timer.hpp"
+
+namespace dim
+{
+    //------------------------------------------------------------------------
+    // Shortest round-trip number formatting
+    //------------------------------------------------------------------------
+
+    namespace detail // for dim::format_number
+    {
+        struct uint128
+        {
+            std::uint64_t low;
+            std::uint64_t high;
+        };
+
+        // Returns the 128-bit product a * b.
+        inline uint128 multiply_128(std::uint64_t a, std::uint64_t b)
+        {
+#if defined(__SIZEOF_INT128__)
+            __extension__ typedef unsigned __int128 wide;
+            wide const product = wide(a) * b;
+            return uint128{std::uint64_t(product), std::uint64_t(product >> 64)};
+#else
+            std::uint64_t const a_low = a & 0xFFFFFFFFu;
+            std::uint64_t const a_high = a >> 32;
+            std::uint64_t const b_low = b & 0xFFFFFFFFu;
+            std::uint64_t const b_high = b >> 32;
+            std::uint64_t const low_low = a_low * b_low;
+            std::uint64_t const low_high = a_low * b_high;
+            std::uint64_t const high_low = a_high * b_low;
+            std::uint64_t const high_high = a_high * b_high;
+            std::uint64_t const middle = (low_low >> 32) + (low_high & 0xFFFFFFFFu) + (high_low & 0xFFFFFFFFu);
+            return uint128{(middle << 32) | (low_low & 0xFFFFFFFFu),
+                high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32)};
+#endif
+        }
+
+        // Little-endian 32-bit words of a nonnegative integer, used only to
+        // compute the tables below exactly.
+        using big_number = std::vector<std::uint32_t>;
+
+        inline int big_bit_length(big_number const& number)
+        {
+            std::size_t word = number.size();
+            while (word > 0 && number[word - 1] == 0) {
+                --word;
+            }
+            if (word == 0) {
+                return 0;
+            }
+            int bits = int(word - 1) * 32;
+            for (std::uint32_t top = number[word - 1]; top != 0; top >>= 1) {
+                ++bits;
+            }
+            return bits;
+        }
+
+        inline bool big_test_bit(big_number const& number, int bit)
+        {
+            std::size_t const word = std::size_t(bit) / 32;
+            return word < number.size() && (number[word] >> (bit % 32) & 1) != 0;
+        }
+
+        inline void set_bit(uint128& number, int bit)
+        {
+            if (bit < 64) {
+                number.low |= std::uint64_t(1) << bit;
+            } else if (bit < 128) {
+                number.high |= std::uint64_t(1) << (bit - 64);
+            }
+        }
+
+        inline void big_multiply(big_number& number, std::uint32_t factor)
+        {
+            std::uint64_t carry = 0;
+            for (auto& word : number) {
+                std::uint64_t const product = std::uint64_t(word) * factor + carry;
+                word = std::uint32_t(product);
+                carry = product >> 32;
+            }
+            if (carry != 0) {
+                number.push_back(std::uint32_t(carry));
+            }
+        }
+
+        inline void big_shift_left(big_number& number)
+        {
+            std::uint32_t carry = 0;
+            for (auto& word : number) {
+                std::uint32_t const next = word >> 31;
+                word = (word << 1) | carry;
+                carry = next;
+            }
+        }
+
+        // Compares numbers with possibly different word counts.
+        inline bool big_less(big_number const& lhs, big_number const& rhs)
+        {
+            std::size_t const words = lhs.size() > rhs.size() ? lhs.size() : rhs.size();
+            for (std::size_t i = words; i-- > 0;) {
+                std::uint32_t const a = i < lhs.size() ? lhs[i] : 0;
+                std::uint32_t const b = i < rhs.size() ? rhs[i] : 0;
+                if (a != b) {
+                    return a < b;
+                }
+            }
+            return false;
+        }
+
+        // lhs -= rhs, where lhs >= rhs and lhs has at least as many words.
+        inline void big_subtract(big_number& lhs, big_number const& rhs)
+        {
+            std::uint64_t borrow = 0;
+            for (std::size_t i = 0; i < lhs.size(); ++i) {
+                std::uint64_t const b = (i < rhs.size() ? rhs[i] : 0) + borrow;
+                borrow = lhs[i] < b ? 1 : 0;
+                lhs[i] = std::uint32_t(lhs[i] - b);
+            }
+        }
+
+        // Returns the low 128 bits of number shifted right by shift bits (left
+        // if shift is negative).
+        inline uint128 big_extract(big_number const& number, int shift)
+        {
+            uint128 result = {0, 0};
+            for (int bit = 0; bit < 128; ++bit) {
+                int const source = bit + shift;
+                if (source >= 0 && big_test_bit(number, source)) {
+                    set_bit(result, bit);
+                }
+            }
+            return result;
+        }
+
+        // Returns floor(2^(bits(divisor) - 1 + top) / divisor), which must be
+        // less than 2^128, by binary long division.
+        inline uint128 big_reciprocal(big_number const& divisor, int top)
+        {
+            // The quotient bits above top are zero, so start from the
+            // remainder 2^(bits - 1).
+            int const bits = big_bit_length(divisor);
+            big_number remainder(divisor.size() + 1, 0);
+            remainder[std::size_t(bits - 1) / 32] = std::uint32_t(1) << ((bits - 1) % 32);
+            uint128 quotient = {0, 0};
+            for (int bit = top; bit >= 0; --bit) {
+                if (bit != top) {
+                    big_shift_left(remainder);
+                }
+                if (!big_less(remainder, divisor)) {
+                    big_subtract(remainder, divisor);
+                    set_bit(quotient, bit);
+                }
+            }
+            return quotient;
+        }
+
+        // Number of significant bits of the 128-bit entries of pow5_tables.
+        constexpr int pow5_table_bits = 125;
+
+        /*
+         * Tables of the Ryu algorithm (Ulf Adams, PLDI 2018). powers[i] holds
+         * the leading 125 bits of 5^i and inverses[i] holds
+         * floor(2^(bits(5^i) - 1 + 125) / 5^i) + 1. The entries are computed
+         * exactly on first use rather than pasted as 10 kB of literals.
+         */
+        struct pow5_tables
+        {
+            static constexpr int power_count = 326;
+            static constexpr int inverse_count = 342;
+
+            uint128 powers[power_count];
+            uint128 inverses[inverse_count];
+
+            pow5_tables()
+            {
+                big_number power(1, 1);
+                for (int i = 0; i < inverse_count; ++i) {
+                    if (i < power_count) {
+                        powers[i] = big_extract(power, big_bit_length(power) - pow5_table_bits);
+                    }
+                    inverses[i] = big_reciprocal(power, pow5_table_bits);
+                    if (++inverses[i].low == 0) {
+                        ++inverses[i].high;
+                    }
+                    big_multiply(power, 5);
+                }
+            }
+        };
+
+        inline pow5_tables const& get_pow5_tables()
+        {
+            static pow5_tables const tables;
+            return tables;
+        }
+
+        // ceil(log2(5^e)) for e > 0, and 1 for e = 0.
+        inline int pow5_bits(int e)
+        {
+            return int((std::uint32_t(e) * 1217359u) >> 19) + 1;
+        }
+
+        // floor(log10(2^e)) and floor(log10(5^e)) for e >= 0.
+        inline int log10_pow2(int e)
+        {
+            return int((std::uint32_t(e) * 78913u) >> 18);
+        }
+
+        inline int log10_pow5(int e)
+        {
+            return int((std::uint32_t(e) * 732923u) >> 20);
+        }
+
+        inline bool multiple_of_pow5(std::uint64_t value, int p)
+        {
+            int count = 0;
+            while (value % 5 == 0) {
+                value /= 5;
+                ++count;
+            }
+            return count >= p;
+        }
+
+        inline bool multiple_of_pow2(std::uint64_t value, int p)
+        {
+            return (value & ((std::uint64_t(1) << p) - 1)) == 0;
+        }
+
+        // Returns floor(m * factor / 2^shift) for 64 <= shift < 128.
+        inline std::uint64_t multiply_shift(std::uint64_t m, uint128 const& factor, int shift)
+        {
+            uint128 const low = multiply_128(m, factor.low);
+            uint128 const high = multiply_128(m, factor.high);
+            std::uint64_t const sum_low = high.low + low.high;
+            std::uint64_t const sum_high = high.high + (sum_low < high.low ? 1 : 0);
+            int const distance = shift - 64;
+            if (distance == 0) {
+                return sum_low;
+            }
+            return (sum_high << (64 - distance)) | (sum_low >> distance);
+        }
+
+        // Decimal value digits * 10^exponent.
+        struct decimal_number
+        {
+            std::uint64_t digits;
+            int exponent;
+        };
+
+        /*
+         * Returns the shortest decimal that rounds to the binary floating-point
+         * number with the given raw fields under round-to-nearest-even, picking
+         * the one closest to the exact value when several are equally short.
+         * This is Ryu's d2d generalized over the field widths, so that float
+         * uses it too. The number must be finite and nonzero.
+         */
+        inline decimal_number shortest_decimal(
+            std::uint64_t mantissa_field, int exponent_field, int mantissa_bits, int bias)
+        {
+            pow5_tables const& tables = get_pow5_tables();
+
+            // Work with 4 * m2 * 2^e2 so that the halfway bounds are integers.
+            int e2;
+            std::uint64_t m2;
+            if (exponent_field == 0) {
+                e2 = 1 - bias - mantissa_bits - 2;
+                m2 = mantissa_field;
+            } else {
+                e2 = exponent_field - bias - mantissa_bits - 2;
+                m2 = (std::uint64_t(1) << mantissa_bits) | mantissa_field;
+            }
+            bool const accept_bounds = (m2 & 1) == 0;
+            std::uint64_t const mv = 4 * m2;
+            std::uint64_t const mm_shift = (mantissa_field != 0 || exponent_field <= 1) ? 1 : 0;
+
+            // Scale the interval [mm, mp] around mv to decimal.
+            std::uint64_t vr, vp, vm;
+            int e10;
+            bool vm_trailing_zeros = false;
+            bool vr_trailing_zeros = false;
+            if (e2 >= 0) {
+                int const q = log10_pow2(e2) - (e2 > 3 ? 1 : 0);
+                e10 = q;
+                int const k = pow5_table_bits + pow5_bits(q) - 1;
+                int const shift = -e2 + q + k;
+                vr = multiply_shift(mv, tables.inverses[q], shift);
+                vp = multiply_shift(mv + 2, tables.inverses[q], shift);
+                vm = multiply_shift(mv - 1 - mm_shift, tables.inverses[q], shift);
+                if (q <= 21) {
+                    // At most one of mv, mp and mm is a multiple of 5.
+                    if (mv % 5 == 0) {
+                        vr_trailing_zeros = multiple_of_pow5(mv, q);
+                    } else if (accept_bounds) {
+                        vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+                    } else {
+                        vp -= multiple_of_pow5(mv + 2, q) ? 1 : 0;
+                    }
+                }
+            } else {
+                int const q = log10_pow5(-e2) - (-e2 > 1 ? 1 : 0);
+                e10 = q + e2;
+                int const i = -e2 - q;
+                int const k = pow5_bits(i) - pow5_table_bits;
+                int const shift = q - k;
+                vr = multiply_shift(mv, tables.powers[i], shift);
+                vp = multiply_shift(mv + 2, tables.powers[i], shift);
+                vm = multiply_shift(mv - 1 - mm_shift, tables.powers[i], shift);
+                if (q <= 1) {
+                    // mv = 4 * m2 has at least two trailing zero bits.
+                    vr_trailing_zeros = true;
+                    if (accept_bounds) {
+                        vm_trailing_zeros = mm_shift == 1;
+                    } else {
+                        --vp;
+                    }
+                } else if (q < 63) {
+                    vr_trailing_zeros = multiple_of_pow2(mv, q);
+                }
+            }
+
+            // Drop digits while the interval still contains a shorter decimal.
+            int removed = 0;
+            std::uint64_t output;
+            if (vm_trailing_zeros || vr_trailing_zeros) {
+                unsigned last_removed = 0;
+                while (vp / 10 > vm / 10) {
+                    vm_trailing_zeros &= vm % 10 == 0;
+                    vr_trailing_zeros &= last_removed == 0;
+                    last_removed = unsigned(vr % 10);
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    ++removed;
+                }
+                if (vm_trailing_zeros) {
+                    while (vm % 10 == 0) {
+                        vr_trailing_zeros &= last_removed == 0;
+                        last_removed = unsigned(vr % 10);
+                        vr /= 10;
+                        vp /= 10;
+                        vm /= 10;
+                        ++removed;
+                    }
+                }
+                if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+                    // The exact value is halfway; round to even.
+                    last_removed = 4;
+                }
+                bool const outside = vr == vm && (!accept_bounds || !vm_trailing_zeros);
+                output = vr + ((outside || last_removed >= 5) ? 1 : 0);
+            } else {
+                bool round_up = false;
+                if (vp / 100 > vm / 100) {
+                    round_up = vr % 100 >= 50;
+                    vr /= 100;
+                    vp /= 100;
+                    vm /= 100;
+                    removed += 2;
+                }
+                while (vp / 10 > vm / 10) {
+                    round_up = vr % 10 >= 5;
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    ++removed;
+                }
+                output = vr + ((vr == vm || round_up) ? 1 : 0);
+            }
+            return decimal_number{output, e10 + removed};
+        }
+
+        inline char* write_exponent(char* out, int exponent)
+        {
+            *out++ = 'e';
+            *out++ = exponent < 0 ? '-' : '+';
+            unsigned magnitude = unsigned(exponent < 0 ? -exponent : exponent);
+            if (magnitude >= 100) {
+                *out++ = char('0' + magnitude / 100);
+                magnitude %= 100;
+            }
+            *out++ = char('0' + magnitude / 10);
+            *out++ = char('0' + magnitude % 10);
+            return out;
+        }
+
+        // Fixed notation is used only when it is not longer than scientific
+        // notation of at most 17 significant digits, "d.dddddddddddddddde-308",
+        // so fixed numbers have at most 23 characters and digits. The
+        // explicit bounds below let the compiler see that the output fits
+        // max_number_length.
+        constexpr int max_fixed_digits = 23;
+
+        /*
+         * Writes the decimal digits of the integer significand * 2^shift,
+         * least significant first, and returns the number of digits. shift
+         * must be less than 64 and the integer must have at most
+         * max_fixed_digits digits.
+         */
+        inline int integer_digits(char* digits, std::uint64_t significand, int shift)
+        {
+            // 32-bit limbs of the 128-bit value, least significant first.
+            std::uint64_t const low = significand << shift;
+            std::uint64_t const high = shift == 0 ? 0 : significand >> (64 - shift);
+            std::uint32_t limbs[4] = {
+                std::uint32_t(low), std::uint32_t(low >> 32), std::uint32_t(high), std::uint32_t(high >> 32)};
+
+            int length = 0;
+            while ((limbs[0] | limbs[1] | limbs[2] | limbs[3]) != 0 && length < max_fixed_digits) {
+                std::uint64_t remainder = 0;
+                for (int i = 4; i-- > 0;) {
+                    std::uint64_t const current = remainder << 32 | limbs[i];
+                    limbs[i] = std::uint32_t(current / 10);
+                    remainder = current % 10;
+                }
+                digits[length++] = char('0' + remainder);
+            }
+            return length;
+        }
+
+        /*
+         * Writes digits * 10^exponent in fixed or scientific notation,
+         * whichever is shorter (fixed on ties), as std::to_chars does. The
+         * value must equal significand * 2^shift. Integers wider than the
+         * shortest digits are written in fixed notation with all their exact
+         * digits instead of padding zeros, e.g. 3256937983961036488704 rather
+         * than 3256937983961036500000.
+         */
+        inline char* write_decimal(char* out, bool negative, decimal_number number, std::uint64_t significand, int shift)
+        {
+            char digits[max_fixed_digits];
+            int length = 0;
+            for (std::uint64_t rest = number.digits; rest != 0 && length < max_fixed_digits; rest /= 10) {
+                digits[length++] = char('0' + rest % 10);
+            }
+            // The digits are reversed: digits[length - 1] leads.
+            int point = length + number.exponent;
+            int const exponent = point - 1;
+            int const exponent_abs = exponent < 0 ? -exponent : exponent;
+            int const scientific_length = length + (length > 1 ? 1 : 0) + 2 + (exponent_abs >= 100 ? 3 : 2);
+            int const fixed_length = point <= 0 ? 2 - point + length : point >= length ? point : length + 1;
+
+            if (fixed_length <= scientific_length && point > length && shift > 0) {
+                length = integer_digits(digits, significand, shift);
+                point = length;
+            }
+
+            if (negative) {
+                *out++ = '-';
+            }
+            if (fixed_length <= scientific_length && fixed_length <= max_fixed_digits) {
+                if (point <= 0) {
+                    *out++ = '0';
+                    *out++ = '.';
+                    for (int i = point; i < 0; ++i) {
+                        *out++ = '0';
+                    }
+                    for (int i = length; i-- > 0;) {
+                        *out++ = digits[i];
+                    }
+                } else {
+                    for (int i = 0; i < length || i < point; ++i) {
+                        if (i == point) {
+                            *out++ = '.';
+                        }
+                        *out++ = i < length ? digits[length - 1 - i] : '0';
+                    }
+                }
+                return out;
+            }
+
+            *out++ = digits[length - 1];
+            if (length > 1) {
+                *out++ = '.';
+                for (int i = length - 1; i-- > 0;) {
+                    *out++ = digits[i];
+                }
+            }
+            return write_exponent(out, exponent);
+        }
+
+        inline char* write_special(char* out, bool negative, bool zero, bool nan)
+        {
+            char const* text = nan ? "nan" : zero ? "0" : "inf";
+            if (negative && !nan) {
+                *out++ = '-';
+            }
+            while (*text != '\0') {
+                *out++ = *text++;
+            }
+            return out;
+        }
+    } // namespace detail
+
+    // Buffer size sufficient for any number written by format_number.
+    constexpr std::size_t max_number_length = 32;
+
+    /*
+     * Writes the shortest decimal representation of value that parses back to
+     * exactly the same value, and returns the end of the written characters.
+     * out must have room for max_number_length characters. The output uses
+     * fixed or scientific notation (like 0.001, 12.5 or 1.5e+20) whichever is
+     * shorter, and inf, -inf or nan for the special values. Apart from the
+     * sign of nan, the output matches std::to_chars without a format, which
+     * writes large integers in fixed notation with their exact digits. No
+     * terminating null character is written.
+     */
+    inline char* format_number(char* out, double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        bool const negative = (bits >> 63) != 0;
+        int const exponent = int((bits >> 52) & 0x7FF);
+        std::uint64_t const mantissa = bits & ((std::uint64_t(1) << 52) - 1);
+        if (exponent == 0x7FF || (exponent == 0 && mantissa == 0)) {
+            return detail::write_special(out, negative, exponent == 0, mantissa != 0);
+        }
+        return detail::write_decimal(out,
+            negative,
+            detail::shortest_decimal(mantissa, exponent, 52, 1023),
+            mantissa | std::uint64_t(1) << 52,
+            exponent - 1075);
+    }
+
+    inline char* format_number(char* out, float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        bool const negative = (bits >> 31) != 0;
+        int const exponent = int((bits >> 23) & 0xFF);
+        std::uint32_t const mantissa = bits & ((std::uint32_t(1) << 23) - 1);
+        if (exponent == 0xFF || (exponent == 0 && mantissa == 0)) {
+            return detail::write_special(out, negative, exponent == 0, mantissa != 0);
+        }
+        return detail::write_decimal(out,
+            negative,
+            detail::shortest_decimal(mantissa, exponent, 23, 127),
+            mantissa | std::uint32_t(1) << 23,
+            exponent - 150);
+    }
+
+    // Returns the shortest round-trip representation of value as a string.
+    template<typename T>
+    std::string to_text(T value)
+    {
+        char buffer[max_number_length];
+        return std::string(buffer, format_number(buffer, value));
+    }
+
+    //------------------------------------------------------------------------
+    // Number parsing
+    //------------------------------------------------------------------------
+
+    namespace detail // for dim::parse_number
+    {
+        template<typename T>
+        struct exact_parse;
+
+        // Decimals d * 10^e with d and 10^|e| exactly representable convert
+        // with a single rounding (Clinger's fast path).
+        template<>
+        struct exact_parse<double>
+        {
+            static constexpr std::uint64_t max_digits = std::uint64_t(1) << 53;
+            static constexpr int max_power = 22;
+
+            static double power(int e)
+            {
+                static double const powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+                return powers[e];
+            }
+
+            static double convert(char const* text, char** end)
+            {
+                return std::strtod(text, end);
+            }
+        };
+
+        template<>
+        struct exact_parse<float>
+        {
+            static constexpr std::uint64_t max_digits = std::uint64_t(1) << 24;
+            static constexpr int max_power = 10;
+
+            static float power(int e)
+            {
+                static float const powers[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+                return powers[e];
+            }
+
+            static float convert(char const* text, char** end)
+            {
+                return std::strtof(text, end);
+            }
+        };
+
+        /*
+         * Leading 128 bits of 10^e, rounded down, for e in [min_exponent,
+         * max_exponent]. Used by parse_decimal.
+         */
+        struct pow10_table
+        {
+            static constexpr int min_exponent = -348;
+            static constexpr int max_exponent = 347;
+
+            uint128 powers[max_exponent - min_exponent + 1];
+
+            pow10_table()
+            {
+                big_number power(1, 1);
+                for (int e = 0; e <= -min_exponent; ++e) {
+                    if (e <= max_exponent) {
+                        powers[e - min_exponent] = big_extract(power, big_bit_length(power) - 128);
+                    }
+                    if (e > 0) {
+                        powers[-e - min_exponent] = big_reciprocal(power, 128);
+                    }
+                    big_multiply(power, 10);
+                }
+            }
+        };
+
+        inline pow10_table const& get_pow10_table()
+        {
+            static pow10_table const table;
+            return table;
+        }
+
+        inline int leading_zeros(std::uint64_t value)
+        {
+            int count = 0;
+            for (std::uint64_t bit = std::uint64_t(1) << 63; (value & bit) == 0; bit >>= 1) {
+                ++count;
+            }
+            return count;
+        }
+
+        /*
+         * Converts digits * 10^exponent (digits nonzero) to the nearest double
+         * by the Eisel-Lemire algorithm (Lemire, Software: Practice and
+         * Experience 51(8), 2021). Returns false in the rare cases it cannot
+         * decide, and for subnormal or overflowing results.
+         */
+        inline bool parse_decimal(std::uint64_t digits, int exponent, bool negative, double& value)
+        {
+            if (exponent < pow10_table::min_exponent || exponent > pow10_table::max_exponent) {
+                return false;
+            }
+            uint128 const& power = get_pow10_table().powers[exponent - pow10_table::min_exponent];
+
+            int const zeros = leading_zeros(digits);
+            std::uint64_t const mantissa = digits << zeros;
+            // floor(log2(10^exponent)), rounding toward minus infinity.
+            int const scaled = 217706 * exponent;
+            int const log2_power = scaled >= 0 ? scaled / 65536 : -((-scaled + 65535) / 65536);
+            std::uint64_t result_exponent = std::uint64_t(std::int64_t(log2_power) + 64 + 1023 - zeros);
+
+            uint128 product = multiply_128(mantissa, power.high);
+            if ((product.high & 0x1FF) == 0x1FF && product.low + mantissa < mantissa) {
+                // The truncated power may matter; widen to 192 bits.
+                uint128 const low = multiply_128(mantissa, power.low);
+                std::uint64_t const merged_low = product.low + low.high;
+                std::uint64_t const merged_high = product.high + (merged_low < product.low ? 1 : 0);
+                if ((merged_high & 0x1FF) == 0x1FF && merged_low + 1 == 0 && low.low + mantissa < mantissa) {
+                    return false;
+                }
+                product.high = merged_high;
+                product.low = merged_low;
+            }
+
+            std::uint64_t const top = product.high >> 63;
+            std::uint64_t result = product.high >> (top + 9);
+            result_exponent -= 1 ^ top;
+
+            // Exactly halfway between two doubles: defer to the slow path.
+            if (product.low == 0 && (product.high & 0x1FF) == 0 && (result & 3) == 1) {
+                return false;
+            }
+
+            result += result & 1;
+            result >>= 1;
+            if ((result >> 53) != 0) {
+                result >>= 1;
+                ++result_exponent;
+            }
+            if (result_exponent - 1 >= 0x7FF - 1) {
+                return false;
+            }
+
+            std::uint64_t const bits = (negative ? std::uint64_t(1) << 63 : 0) | result_exponent << 52
+                | (result & ((std::uint64_t(1) << 52) - 1));
+            std::memcpy(&value, &bits, sizeof value);
+            return true;
+        }
+
+        // Eisel-Lemire for float is not implemented; strtof handles the rest.
+        inline bool parse_decimal(std::uint64_t, int, bool, float&)
+        {
+            return false;
+        }
+
+        inline bool is_digit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        inline bool is_blank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        inline char const* skip_blanks(char const* first, char const* last)
+        {
+            while (first != last && is_blank(*first)) {
+                ++first;
+            }
+            return first;
+        }
+
+        // Falls back to the C library for the inputs the fast path rejects:
+        // long mantissas, large exponents, inf and nan.
+        template<typename T>
+        char const* parse_number_slow(char const* first, char const* last, T& value)
+        {
+            char const* token_end = first;
+            while (token_end != last && (is_digit(*token_end) || *token_end == '+' || *token_end == '-'
+                                            || *token_end == '.' || (*token_end >= 'a' && *token_end <= 'z')
+                                            || (*token_end >= 'A' && *token_end <= 'Z'))) {
+                ++token_end;
+            }
+            // The C functions need a terminated string. Decimals are short,
+            // so copy to the stack unless the token is unusually long.
+            std::size_t const length = std::size_t(token_end - first);
+            char buffer[64];
+            std::string heap;
+            char* token = buffer;
+            if (length >= sizeof buffer) {
+                heap.assign(first, token_end);
+                token = &heap[0];
+            } else {
+                std::memcpy(buffer, first, length);
+                buffer[length] = '\0';
+            }
+            char* end;
+            T const result = exact_parse<T>::convert(token, &end);
+            if (end == token) {
+                return first;
+            }
+            value = result;
+            return first + (end - token);
+        }
+    } // namespace detail
+
+    /*
+     * Parses a decimal number at the start of [first, last), stores it to value
+     * and returns the end of the parsed characters. Returns first and leaves
+     * value untouched if no number starts there. Numbers of up to 19
+     * significant digits are converted inline (doubles by the Eisel-Lemire
+     * algorithm, floats only up to 7 digits with moderate exponents); the
+     * rest go through std::strtod or std::strtof and thus expect the C locale.
+     */
+    template<typename T>
+    char const* parse_number(char const* first, char const* last, T& value)
+    {
+        using exact = detail::exact_parse<T>;
+
+        char const* p = first;
+        bool negative = false;
+        if (p != last && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            ++p;
+        }
+
+        std::uint64_t digits = 0;
+        int significant = 0;
+        int exponent = 0;
+        bool any_digit = false;
+        bool truncated = false;
+
+        auto const take_digit = [&](unsigned digit, bool fraction) {
+            any_digit = true;
+            if (digits == 0 && digit == 0) {
+                exponent -= fraction ? 1 : 0;
+            } else if (significant < 19) {
+                digits = digits * 10 + digit;
+                ++significant;
+                exponent -= fraction ? 1 : 0;
+            } else {
+                exponent += fraction ? 0 : 1;
+                truncated |= digit != 0;
+            }
+        };
+
+        for (; p != last && detail::is_digit(*p); ++p) {
+            take_digit(unsigned(*p - '0'), false);
+        }
+        if (p != last && *p == '.') {
+            for (++p; p != last && detail::is_digit(*p); ++p) {
+                take_digit(unsigned(*p - '0'), true);
+            }
+        }
+        if (!any_digit) {
+            return detail::parse_number_slow(first, last, value);
+        }
+
+        if (p != last && (*p == 'e' || *p == 'E')) {
+            char const* q = p + 1;
+            bool exponent_negative = false;
+            if (q != last && (*q == '-' || *q == '+')) {
+                exponent_negative = *q == '-';
+                ++q;
+            }
+            if (q != last && detail::is_digit(*q)) {
+                int explicit_exponent = 0;
+                for (; q != last && detail::is_digit(*q); ++q) {
+                    if (explicit_exponent < 100000) {
+                        explicit_exponent = explicit_exponent * 10 + (*q - '0');
+                    }
+                }
+                exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+                p = q;
+            }
+        }
+
+        if (digits == 0) {
+            value = negative ? -T(0) : T(0);
+            return p;
+        }
+        if (truncated) {
+            return detail::parse_number_slow(first, last, value);
+        }
+        if (digits > exact::max_digits || exponent > exact::max_power || exponent < -exact::max_power) {
+            return detail::parse_decimal(digits, exponent, negative, value) ? p
+                                                                            : detail::parse_number_slow(first, last, value);
+        }
+        T const magnitude = exponent >= 0 ? T(digits) * exact::power(exponent) : T(digits) / exact::power(-exponent);
+        value = negative ? -magnitude : magnitude;
+        return p;
+    }
+
+    //------------------------------------------------------------------------
+    // Dimension annotation
+    //------------------------------------------------------------------------
+
+    namespace detail // for dim::dimension_string
+    {
+        template<typename D>
+        struct text_exponents;
+
+        template<int L, int M, int T, int Q>
+        struct text_exponents<mechanical_dimension<L, M, T, Q>>
+        {
+            static std::string format()
+            {
+                char const symbols[4] = {'L', 'M', 'T', 'Q'};
+                int const exponents[4] = {L, M, T, Q};
+                std::string text;
+                for (unsigned i = 0; i < 4; ++i) {
+                    if (exponents[i] == 0) {
+                        continue;
+                    }
+                    if (!text.empty()) {
+                        text += ' ';
+                    }
+                    text += symbols[i];
+                    if (exponents[i] != 1) {
+                        text += '^';
+                        text += std::to_string(exponents[i]);
+                    }
+                }
+                return text.empty() ? "1" : text;
+            }
+        };
+    } // namespace detail
+
+    /*
+     * Returns the dimension D in terms of the base dimensions, like "L M T^-2"
+     * for force, or "1" for dimensionless quantities. Used as the unit
+     * annotation of CSV columns.
+     */
+    template<typename D>
+    std::string dimension_string()
+    {
+        return detail::text_exponents<D>::format();
+    }
+
+    //------------------------------------------------------------------------
+    // Block-buffered output
+    //------------------------------------------------------------------------
+
+    namespace detail // for CSV and XYZ writers
+    {
+        template<typename Q>
+        struct text_element;
+
+        template<typename T, typename D>
+        struct text_element<scalar<T, D>>
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr unsigned components = 1;
+
+            static T get(scalar<T, D> const& value, unsigned)
+            {
+                return value.value();
+            }
+
+            static void set(scalar<T, D>& value, unsigned, T number)
+            {
+                value = scalar<T, D>(number);
+            }
+        };
+
+        template<typename Q, typename T, typename D, unsigned N>
+        struct text_coords
+        {
+            using number_type = T;
+            using dimension = D;
+            static constexpr unsigned components = N;
+
+            static T get(Q const& value, unsigned k)
+            {
+                return value[k].value();
+            }
+
+            static void set(Q& value, unsigned k, T number)
+            {
+                value[k] = scalar<T, D>(number);
+            }
+        };
+
+        template<typename T, typename D, unsigned N>
+        struct text_element<vector<T, D, N>> : text_coords<vector<T, D, N>, T, D, N>
+        {
+        };
+
+        template<typename T, typename D, unsigned N>
+        struct text_element<point<T, D, N>> : text_coords<point<T, D, N>, T, D, N>
+        {
+        };
+
+        // Column name of component k: name, name_x to name_z, or name_0 etc.
+        template<typename Q>
+        std::string component_name(std::string const& name, unsigned k)
+        {
+            unsigned const components = text_element<Q>::components;
+            if (components == 1) {
+                return name;
+            }
+            if (components <= 3) {
+                return name + '_' + char('x' + k);
+            }
+            return name + '_' + std::to_string(k);
+        }
+
+        // Growable character buffer written through raw pointers.
+        struct text_block
+        {
+            std::vector<char> chars;
+            std::size_t size = 0;
+
+            // Returns a pointer to at least n writable characters at the end.
+            char* reserve(std::size_t n)
+            {
+                if (size + n > chars.size()) {
+                    chars.resize(size + n > 2 * chars.size() ? size + n : 2 * chars.size());
+                }
+                return chars.data() + size;
+            }
+
+            void commit(char* end)
+            {
+                size = std::size_t(end - chars.data());
+            }
+
+            void append(std::string const& text)
+            {
+                char* out = reserve(text.size());
+                std::memcpy(out, text.data(), text.size());
+                commit(out + text.size());
+            }
+        };
+
+        // Rows formatted per worker between writes to the stream.
+        constexpr std::size_t text_block_rows = 65536;
+        constexpr std::size_t text_grain_rows = 4096;
+
+        /*
+         * Formats rows [0, count) with format_row(block, row) in parallel
+         * chunks and writes the chunks to os in order, one large write per
+         * chunk.
+         */
+        template<typename F>
+        void write_rows(std::ostream& os, std::size_t count, F format_row)
+        {
+            std::size_t const workers = chunk_count(count, text_grain_rows);
+            std::vector<text_block> blocks(workers);
+
+            for (std::size_t start = 0; start < count; start += workers * text_block_rows) {
+                std::size_t const rows
+                    = count - start < workers * text_block_rows ? count - start : workers * text_block_rows;
+                std::size_t const chunks = chunk_count(rows, text_grain_rows);
+                parallel_chunks(rows, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                    text_block& block = blocks[chunk];
+                    block.size = 0;
+                    for (std::size_t row = begin; row < end; ++row) {
+                        format_row(block, start + row);
+                    }
+                });
+                for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                    os.write(blocks[chunk].chars.data(), std::streamsize(blocks[chunk].size));
+                }
+            }
+        }
+    } // namespace detail
+
+    //------------------------------------------------------------------------
+    // CSV
+    //------------------------------------------------------------------------
+
+    struct csv_options
+    {
+        // Field separator.
+        char delimiter = ',';
+
+        // Whether the first line names the columns.
+        bool header = true;
+
+        // Whether header names carry the dimension, like "velocity_x [L T^-1]".
+        bool units = false;
+    };
+
+    /*
+     * Named array of scalars, vectors or points to write as CSV columns.
+     * Vectors and points expand to one column per component.
+     */
+    template<typename Q>
+    struct csv_column
+    {
+        std::string name;
+        Q const* values;
+    };
+
+    template<typename Q>
+    csv_column<Q> make_csv_column(std::string name, Q const* values)
+    {
+        return csv_column<Q>{std::move(name), values};
+    }
+
+    template<typename Q>
+    csv_column<Q> make_csv_column(std::string name, std::vector<Q> const& values)
+    {
+        return csv_column<Q>{std::move(name), values.data()};
+    }
+
+    namespace detail // for dim::write_csv
+    {
+        inline void append_csv_header(std::string&, csv_options const&)
+        {
+        }
+
+        template<typename Q, typename... Rest>
+        void append_csv_header(
+            std::string& line, csv_options const& options, csv_column<Q> const& column, csv_column<Rest> const&... rest)
+        {
+            for (unsigned k = 0; k < text_element<Q>::components; ++k) {
+                line += component_name<Q>(column.name, k);
+                if (options.units) {
+                    line += " [" + dimension_string<typename text_element<Q>::dimension>() + "]";
+                }
+                line += options.delimiter;
+            }
+            append_csv_header(line, options, rest...);
+        }
+
+        inline char* format_csv_fields(char* out, std::size_t, char)
+        {
+            return out;
+        }
+
+        template<typename Q, typename... Rest>
+        char* format_csv_fields(
+            char* out, std::size_t row, char delimiter, csv_column<Q> const& column, csv_column<Rest> const&... rest)
+        {
+            using element = text_element<Q>;
+            for (unsigned k = 0; k < element::components; ++k) {
+                out = format_number(out, element::get(column.values[row], k));
+                *out++ = delimiter;
+            }
+            return format_csv_fields(out, row, delimiter, rest...);
+        }
+
+        inline std::size_t csv_components()
+        {
+            return 0;
+        }
+
+        template<typename Q, typename... Rest>
+        std::size_t csv_components(csv_column<Q> const&, csv_column<Rest> const&... rest)
+        {
+            return text_element<Q>::components + csv_components(rest...);
+        }
+    } // namespace detail
+
+    /*
+     * Writes rows [0, rows) of the columns as CSV. Numbers are formatted with
+     * format_number in parallel and written to os in large blocks.
+     */
+    template<typename... Q>
+    void write_csv(std::ostream& os, std::size_t rows, csv_options const& options, csv_column<Q> const&... columns)
+    {
+        DIM_TIMER_SCOPE("dim::write_csv", rows, 0);
+        std::size_t const fields = detail::csv_components(columns...);
+        if (fields == 0) {
+            throw std::invalid_argument("no csv columns");
+        }
+
+        if (options.header) {
+            std::string line;
+            detail::append_csv_header(line, options, columns...);
+            line.back() = '\n';
+            os.write(line.data(), std::streamsize(line.size()));
+        }
+
+        detail::write_rows(os, rows, [&](detail::text_block& block, std::size_t row) {
+            char* const begin = block.reserve(fields * (max_number_length + 1));
+            char* const end = detail::format_csv_fields(begin, row, options.delimiter, columns...);
+            end[-1] = '\n';
+            block.commit(end);
+        });
+    }
+
+    template<typename... Q>
+    void write_csv(std::ostream& os, std::size_t rows, csv_column<Q> const&... columns)
+    {
+        write_csv(os, rows, csv_options{}, columns...);
+    }
+
+    /*
+     * Numbers parsed from CSV text, stored row-major.
+     */
+    template<typename T>
+    struct csv_table
+    {
+        // Column names as written, including any unit annotation. Empty if
+        // the text had no header.
+        std::vector<std::string> header;
+        std::size_t rows = 0;
+        std::size_t columns = 0;
+        std::vector<T> values;
+
+        T operator()(std::size_t row, std::size_t column) const
+        {
+            return values[row * columns + column];
+        }
+    };
+
+    namespace detail // for dim::parse_csv and dim::parse_xyz
+    {
+        // Bytes of text a parser worker is given at least.
+        constexpr std::size_t text_grain_bytes = 65536;
+
+        // First parse error in a chunk, by line within the chunk.
+        struct text_error
+        {
+            std::size_t line;
+            std::string message;
+        };
+
+        inline char const* line_end(char const* first, char const* last)
+        {
+            void const* newline = std::memchr(first, '\n', std::size_t(last - first));
+            return newline ? static_cast<char const*>(newline) : last;
+        }
+
+        inline bool is_blank_line(char const* first, char const* last)
+        {
+            return skip_blanks(first, last) == last;
+        }
+
+        inline std::string trim(char const* first, char const* last)
+        {
+            first = skip_blanks(first, last);
+            while (last != first && is_blank(last[-1])) {
+                --last;
+            }
+            return std::string(first, last);
+        }
+
+        /*
+         * Splits [first, last) into about chunks pieces that end right after
+         * a newline. Returns the chunks + 1 boundaries.
+         */
+        inline std::vector<char const*> split_lines(char const* first, char const* last, std::size_t chunks)
+        {
+            std::vector<char const*> bounds(1, first);
+            std::size_t const size = std::size_t(last - first);
+            for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+                char const* cut = first + size * chunk / chunks;
+                if (cut < bounds.back()) {
+                    cut = bounds.back();
+                }
+                cut = line_end(cut, last);
+                bounds.push_back(cut == last ? last : cut + 1);
+            }
+            bounds.push_back(last);
+            return bounds;
+        }
+
+        // Parses the delimited numbers of one line. Returns an empty string
+        // on success and the reason on failure.
+        template<typename T>
+        std::string parse_csv_line(
+            char const* first, char const* last, char delimiter, std::size_t columns, std::vector<T>& values)
+        {
+            for (std::size_t column = 0; column < columns; ++column) {
+                first = skip_blanks(first, last);
+                T value;
+                char const* const end = parse_number(first, last, value);
+                if (end == first) {
+                    return "expected a number in column " + std::to_string(column + 1);
+                }
+                values.push_back(value);
+                first = skip_blanks(end, last);
+                if (column + 1 < columns) {
+                    if (first == last || *first != delimiter) {
+                        return "expected " + std::to_string(columns) + " columns";
+                    }
+                    ++first;
+                }
+            }
+            if (first != last) {
+                return "unexpected text after column " + std::to_string(columns);
+            }
+            return std::string();
+        }
+    } // namespace detail
+
+    /*
+     * Parses CSV text of numbers. The text is split at line boundaries into
+     * chunks that are parsed in parallel. Blank lines are skipped and every
+     * other line must have as many fields as the header, or as the first line
+     * if options.header is false. Throws std::runtime_error naming the line
+     * of the first malformed row.
+     */
+    template<typename T>
+    csv_table<T> parse_csv(char const* data, std::size_t size, csv_options const& options = csv_options{})
+    {
+        DIM_TIMER_SCOPE("dim::parse_csv", 0, 0);
+        char const* first = data;
+        char const* const last = data + size;
+        std::size_t header_lines = 0;
+        csv_table<T> table;
+
+        // Determine the columns from the header or the first row.
+        while (first != last) {
+            char const* const end = detail::line_end(first, last);
+            if (!detail::is_blank_line(first, end)) {
+                for (char const* field = first;;) {
+                    char const* const field_end
+                        = static_cast<char const*>(std::memchr(field, options.delimiter, std::size_t(end - field)));
+                    if (options.header) {
+                        table.header.push_back(detail::trim(field, field_end ? field_end : end));
+                    }
+                    ++table.columns;
+                    if (!field_end) {
+                        break;
+                    }
+                    field = field_end + 1;
+                }
+                if (options.header) {
+                    first = end == last ? last : end + 1;
+                    ++header_lines;
+                }
+                break;
+            }
+            first = end == last ? last : end + 1;
+            ++header_lines;
+        }
+        if (table.columns == 0) {
+            return table;
+        }
+
+        std::size_t const chunks = detail::chunk_count(std::size_t(last - first), detail::text_grain_bytes);
+        std::vector<char const*> const bounds = detail::split_lines(first, last, chunks);
+        std::vector<std::vector<T>> values(chunks);
+        std::vector<std::size_t> lines(chunks, 0);
+        std::vector<detail::text_error> errors(chunks);
+
+        detail::parallel_chunks(chunks, chunks, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t chunk = begin; chunk < end; ++chunk) {
+                for (char const* line = bounds[chunk]; line != bounds[chunk + 1]; ++lines[chunk]) {
+                    char const* const line_last = detail::line_end(line, bounds[chunk + 1]);
+                    if (!detail::is_blank_line(line, line_last)) {
+                        std::string message = detail::parse_csv_line(
+                            line, line_last, options.delimiter, table.columns, values[chunk]);
+                        if (!message.empty()) {
+                            errors[chunk].line = lines[chunk];
+                            errors[chunk].message = std::move(message);
+                            return;
+                        }
+                    }
+                    line = line_last == bounds[chunk + 1] ? line_last : line_last + 1;
+                }
+            }
+        });
+
+        std::size_t line_offset = header_lines;
+        std::size_t total = 0;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            if (!errors[chunk].message.empty()) {
+                throw std::runtime_error("csv line " + std::to_string(line_offset + errors[chunk].line + 1) + ": "
+                    + errors[chunk].message);
+            }
+            line_offset += lines[chunk];
+            total += values[chunk].size();
+        }
+
+        table.values.reserve(total);
+        for (auto const& chunk_values : values) {
+            table.values.insert(table.values.end(), chunk_values.begin(), chunk_values.end());
+        }
+        table.rows = total / table.columns;
+        return table;
+    }
+
+    template<typename T>
+    csv_table<T> parse_csv(std::string const& text, csv_options const& options = csv_options{})
+    {
+        return parse_csv<T>(text.data(), text.size(), options);
+    }
+
+    /*
+     * Returns the quantities stored in the columns starting at first_column,
+     * one column per component.
+     */
+    template<typename Q, typename T>
+    std::vector<Q> extract_csv(csv_table<T> const& table, std::size_t first_column)
+    {
+        using element = detail::text_element<Q>;
+        using number_type = typename element::number_type;
+
+        if (first_column + element::components > table.columns) {
+            throw std::invalid_argument("csv column out of range");
+        }
+        std::vector<Q> result(table.rows);
+        for (std::size_t row = 0; row < table.rows; ++row) {
+            for (unsigned k = 0; k < element::components; ++k) {
+                element::set(result[row], k, static_cast<number_type>(table(row, first_column + k)));
+            }
+        }
+        return result;
+    }
+
+    /*
+     * Returns the quantities stored in the columns named like write_csv names
+     * them. A unit annotation in the header must match the dimension of Q.
+     * Throws std::invalid_argument if a column is missing, misplaced or has a
+     * different dimension.
+     */
+    template<typename Q, typename T>
+    std::vector<Q> extract_csv(csv_table<T> const& table, std::string const& name)
+    {
+        using element = detail::text_element<Q>;
+
+        std::string const unit = "[" + dimension_string<typename element::dimension>() + "]";
+        std::size_t first_column = table.header.size();
+        for (unsigned k = 0; k < element::components; ++k) {
+            std::string const expected = detail::component_name<Q>(name, k);
+            std::size_t column = 0;
+            std::string annotation;
+            for (; column < table.header.size(); ++column) {
+                std::string const& title = table.header[column];
+                if (title.compare(0, expected.size(), expected) != 0) {
+                    continue;
+                }
+                annotation = detail::trim(title.data() + expected.size(), title.data() + title.size());
+                if (annotation.empty() || annotation[0] == '[') {
+                    break;
+                }
+            }
+            if (column == table.header.size()) {
+                throw std::invalid_argument("no csv column " + expected);
+            }
+            if (k == 0) {
+                first_column = column;
+            } else if (column != first_column + k) {
+                throw std::invalid_argument("csv column " + expected + " is not next to " + name);
+            }
+            if (!annotation.empty() && annotation != unit) {
+                throw std::invalid_argument("csv column " + expected + " has dimension " + annotation + ", not " + unit);
+            }
+        }
+        return extract_csv<Q>(table, first_column);
+    }
+
+    //------------------------------------------------------------------------
+    // XYZ
+    //------------------------------------------------------------------------
+
+    /*
+     * One frame of an XYZ file: an atom count line, a comment line and one
+     * "symbol x y z" line per atom.
+     */
+    template<typename T>
+    struct xyz_frame
+    {
+        std::string comment;
+
+        // Atom symbols. Empty or a single symbol when writing means that all
+        // atoms are written as "X" or as that symbol, respectively.
+        std::vector<std::string> symbols;
+
+        std::vector<point<T, mech::length, 3>> positions;
+    };
+
+    /*
+     * Writes an XYZ frame of count positions. symbols must be empty, hold one
+     * symbol for all atoms, or one symbol per atom. Throws
+     * std::invalid_argument for other symbol counts or a multi-line comment.
+     */
+    template<typename T>
+    void write_xyz(std::ostream& os,
+        point<T, mech::length, 3> const* positions,
+        std::size_t count,
+        std::string const& comment = std::string(),
+        std::vector<std::string> const& symbols = std::vector<std::string>())
+    {
+        DIM_TIMER_SCOPE("dim::write_xyz", count, 0);
+        if (symbols.size() > 1 && symbols.size() != count) {
+            throw std::invalid_argument("xyz symbol count does not match atom count");
+        }
+        if (comment.find('\n') != std::string::npos) {
+            throw std::invalid_argument("xyz comment must be a single line");
+        }
+
+        std::string const head = std::to_string(count) + '\n' + comment + '\n';
+        os.write(head.data(), std::streamsize(head.size()));
+
+        std::string const default_symbol = symbols.empty() ? "X" : symbols[0];
+        detail::write_rows(os, count, [&](detail::text_block& block, std::size_t atom) {
+            std::string const& symbol = symbols.size() > 1 ? symbols[atom] : default_symbol;
+            char* out = block.reserve(symbol.size() + 3 * (max_number_length + 1));
+            std::memcpy(out, symbol.data(), symbol.size());
+            out += symbol.size();
+            for (unsigned k = 0; k < 3; ++k) {
+                *out++ = ' ';
+                out = format_number(out, positions[atom][k].value());
+            }
+            *out++ = '\n';
+            block.commit(out);
+        });
+    }
+
+    template<typename T>
+    void write_xyz(std::ostream& os, xyz_frame<T> const& frame)
+    {
+        write_xyz(os, frame.positions.data(), frame.positions.size(), frame.comment, frame.symbols);
+    }
+
+    /*
+     * Parses one XYZ frame at the start of [data, data + size) into frame and
+     * returns the number of bytes consumed, so that consecutive frames of a
+     * trajectory can be read in a loop. Returns 0 if the text holds only blank
+     * lines. Atom lines are parsed in parallel; columns after z are ignored.
+     * Throws std::runtime_error naming the line of malformed input.
+     */
+    template<typename T>
+    std::size_t parse_xyz(char const* data, std::size_t size, xyz_frame<T>& frame)
+    {
+        DIM_TIMER_SCOPE("dim::parse_xyz", 0, 0);
+        char const* first = data;
+        char const* const last = data + size;
+        std::size_t line_number = 1;
+
+        auto const next_line = [&](char const* end) {
+            ++line_number;
+            return end == last ? last : end + 1;
+        };
+        auto const fail = [&](std::size_t line, std::string const& message) {
+            throw std::runtime_error("xyz line " + std::to_string(line) + ": " + message);
+        };
+
+        char const* count_end = detail::line_end(first, last);
+        while (detail::is_blank_line(first, count_end)) {
+            if (count_end == last) {
+                return 0;
+            }
+            first = next_line(count_end);
+            count_end = detail::line_end(first, last);
+        }
+
+        char const* p = detail::skip_blanks(first, count_end);
+        std::size_t count = 0;
+        if (p == count_end || !detail::is_digit(*p)) {
+            fail(line_number, "expected an atom count");
+        }
+        for (; p != count_end && detail::is_digit(*p); ++p) {
+            count = count * 10 + std::size_t(*p - '0');
+        }
+        if (detail::skip_blanks(p, count_end) != count_end) {
+            fail(line_number, "expected an atom count");
+        }
+        if (count_end == last) {
+            fail(line_number, "missing comment line");
+        }
+        first = next_line(count_end);
+
+        char const* const comment_end = detail::line_end(first, last);
+        frame.comment.assign(first, comment_end != first && comment_end[-1] == '\r' ? comment_end - 1 : comment_end);
+        std::size_t const first_atom_line = line_number + 1;
+        first = comment_end == last ? last : comment_end + 1;
+
+        std::vector<char const*> lines;
+        lines.reserve(count + 1);
+        for (std::size_t atom = 0; atom < count; ++atom) {
+            if (first == last) {
+                fail(first_atom_line + atom, "expected " + std::to_string(count) + " atoms");
+            }
+            lines.push_back(first);
+            char const* const end = detail::line_end(first, last);
+            first = end == last ? last : end + 1;
+        }
+        lines.push_back(first);
+
+        frame.symbols.resize(count);
+        frame.positions.resize(count);
+        std::size_t const chunks = detail::chunk_count(count, detail::text_grain_rows);
+        std::vector<detail::text_error> errors(chunks);
+
+        detail::parallel_chunks(count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            for (std::size_t atom = begin; atom < end; ++atom) {
+                char const* const line_last = detail::line_end(lines[atom], lines[atom + 1]);
+                char const* q = detail::skip_blanks(lines[atom], line_last);
+                char const* symbol_end = q;
+                while (symbol_end != line_last && !detail::is_blank(*symbol_end)) {
+                    ++symbol_end;
+                }
+                if (symbol_end == q) {
+                    errors[chunk] = detail::text_error{atom, "expected an atom symbol"};
+                    return;
+                }
+                frame.symbols[atom].assign(q, symbol_end);
+                q = symbol_end;
+                for (unsigned k = 0; k < 3; ++k) {
+                    q = detail::skip_blanks(q, line_last);
+                    T value;
+                    char const* const number_end = parse_number(q, line_last, value);
+                    if (number_end == q || (number_end != line_last && !detail::is_blank(*number_end))) {
+                        errors[chunk] = detail::text_error{atom, "expected three coordinates"};
+                        return;
+                    }
+                    frame.positions[atom][k] = scalar<T, mech::length>(value);
+                    q = number_end;
+                }
+            }
+        });
+
+        for (auto const& error : errors) {
+            if (!error.message.empty()) {
+                fail(first_atom_line + error.line, error.message);
+            }
+        }
+        return std::size_t(first - data);
+    }
+
+    template<typename T>
+    std::size_t parse_xyz(std::string const& text, xyz_frame<T>& frame)
+    {
+        return parse_xyz(text.data(), text.size(), frame);
+    }
+} // namespace dim
+
+#endif // INCLUDED_DIM_TEXT_HPP
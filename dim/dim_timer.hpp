@@ -0,0 +1,406 @@
+/*
+ * dim - Scoped hot-path timers with throughput reporting.
+ *
+ * Copyright snsinfu 2017, 2018.
+ * Distributed under the Boost Software License, Version 1.0.
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef INCLUDED_DIM_TIMER_HPP
+#define INCLUDED_DIM_TIMER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(DIM_TIMER_RDTSC) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define DIM_TIMER_USE_RDTSC
+#endif
+
+#include "dim.hpp"
+
+namespace dim
+{
+    namespace detail // for dim::scoped_timer
+    {
+        // Maximum number of distinct kernels. Kernels registered beyond
+        // this are not timed.
+        constexpr std::size_t max_timer_kernels = 128;
+
+        inline std::uint64_t timer_ticks()
+        {
+#if defined(DIM_TIMER_USE_RDTSC)
+            return __rdtsc();
+#else
+            return std::uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        // Returns the length of a tick in seconds. The TSC is calibrated
+        // against steady_clock on the first call.
+        inline double seconds_per_tick()
+        {
+#if defined(DIM_TIMER_USE_RDTSC)
+            static double const period = [] {
+                auto const start = std::chrono::steady_clock::now();
+                std::uint64_t const start_ticks = timer_ticks();
+                auto now = start;
+                while (now - start < std::chrono::milliseconds(20)) {
+                    now = std::chrono::steady_clock::now();
+                }
+                std::uint64_t const ticks = timer_ticks() - start_ticks;
+                return std::chrono::duration<double>(now - start).count() / double(ticks);
+            }();
+            return period;
+#else
+            return double(std::chrono::steady_clock::period::num)
+                / double(std::chrono::steady_clock::period::den);
+#endif
+        }
+
+        // Counters of one kernel on one thread. Only the owning thread writes
+        // to them, so relaxed loads and stores suffice and no lock or
+        // read-modify-write is needed on the hot path.
+        struct timer_slot
+        {
+            std::atomic<std::uint64_t> ticks{0};
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> particles{0};
+            std::atomic<std::uint64_t> pairs{0};
+        };
+
+        inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t delta)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        struct timer_totals
+        {
+            std::uint64_t ticks = 0;
+            std::uint64_t calls = 0;
+            std::uint64_t particles = 0;
+            std::uint64_t pairs = 0;
+        };
+
+        struct timer_table;
+
+        struct timer_registry
+        {
+            std::mutex mutex;
+            std::vector<std::string> names;
+            std::vector<timer_table*> tables;
+            timer_totals retired[max_timer_kernels];
+            std::string dump_path;
+
+            ~timer_registry();
+        };
+
+        inline timer_registry& global_timer_registry()
+        {
+            static timer_registry registry;
+            return registry;
+        }
+
+        // Per-thread counters. Registered on the first probe of a thread, and
+        // folded into the retired totals when the thread exits.
+        struct timer_table
+        {
+            timer_slot slots[max_timer_kernels];
+
+            timer_table()
+            {
+                auto& registry = global_timer_registry();
+                std::lock_guard<std::mutex> lock{registry.mutex};
+                registry.tables.push_back(this);
+            }
+
+            ~timer_table()
+            {
+                auto& registry = global_timer_registry();
+                std::lock_guard<std::mutex> lock{registry.mutex};
+                for (std::size_t i = 0; i < max_timer_kernels; ++i) {
+                    registry.retired[i].ticks += slots[i].ticks.load(std::memory_order_relaxed);
+                    registry.retired[i].calls += slots[i].calls.load(std::memory_order_relaxed);
+                    registry.retired[i].particles += slots[i].particles.load(std::memory_order_relaxed);
+                    registry.retired[i].pairs += slots[i].pairs.load(std::memory_order_relaxed);
+                }
+                for (auto& table : registry.tables) {
+                    if (table == this) {
+                        table = registry.tables.back();
+                        registry.tables.pop_back();
+                        break;
+                    }
+                }
+            }
+        };
+
+        inline timer_table& thread_timer_table()
+        {
+            static thread_local timer_table table;
+            return table;
+        }
+    } // namespace detail
+
+    /*
+     * Named kernel to be timed. Usually defined as a function-local static
+     * object by the DIM_TIMER_SCOPE macro.
+     */
+    class timer_kernel
+    {
+      public:
+        explicit timer_kernel(std::string const& name)
+        {
+            auto& registry = detail::global_timer_registry();
+            std::lock_guard<std::mutex> lock{registry.mutex};
+            for (std::size_t i = 0; i < registry.names.size(); ++i) {
+                if (registry.names[i] == name) {
+                    id_ = i;
+                    return;
+                }
+            }
+            id_ = registry.names.size();
+            registry.names.push_back(name);
+        }
+
+        std::size_t id() const
+        {
+            return id_;
+        }
+
+      private:
+        std::size_t id_;
+    };
+
+    /*
+     * Probe timing its own lifetime and attributing the time and the
+     * processed particle and pair counts to a kernel.
+     */
+    class scoped_timer
+    {
+      public:
+        explicit scoped_timer(
+            timer_kernel const& kernel, std::uint64_t particles = 0, std::uint64_t pairs = 0)
+            : id_{kernel.id()}, particles_{particles}, pairs_{pairs}, start_{detail::timer_ticks()}
+        {
+        }
+
+        scoped_timer(scoped_timer const&) = delete;
+        scoped_timer& operator=(scoped_timer const&) = delete;
+
+        ~scoped_timer()
+        {
+            std::uint64_t const end = detail::timer_ticks();
+            if (id_ >= detail::max_timer_kernels) {
+                return;
+            }
+            detail::timer_slot& slot = detail::thread_timer_table().slots[id_];
+            detail::bump(slot.ticks, end - start_);
+            detail::bump(slot.calls, 1);
+            detail::bump(slot.particles, particles_);
+            detail::bump(slot.pairs, pairs_);
+        }
+
+        // Counts may be added during the scope when they are not known in
+        // advance, e.g. the number of pairs within the cutoff.
+        void add_particles(std::uint64_t count)
+        {
+            particles_ += count;
+        }
+
+        void add_pairs(std::uint64_t count)
+        {
+            pairs_ += count;
+        }
+
+      private:
+        std::size_t id_;
+        std::uint64_t particles_;
+        std::uint64_t pairs_;
+        std::uint64_t start_;
+    };
+
+    /*
+     * Aggregated statistics of a kernel over all threads. Throughputs are
+     * counts per unit time.
+     */
+    struct timer_report
+    {
+        using time_type = scalar<double, mech::time>;
+        using rate_type = scalar<double, power_dimension_t<mech::time, -1>>;
+
+        std::string name;
+        std::uint64_t calls;
+        std::uint64_t particles;
+        std::uint64_t pairs;
+        time_type total_time;
+        rate_type particle_rate;
+        rate_type pair_rate;
+    };
+
+    namespace detail // for dim::collect_timers
+    {
+        // Caller must hold the registry mutex.
+        inline std::vector<timer_report> collect_timers(timer_registry const& registry)
+        {
+            double const period = seconds_per_tick();
+
+            std::vector<timer_report> reports;
+            for (std::size_t id = 0; id < registry.names.size() && id < max_timer_kernels; ++id) {
+                timer_totals totals = registry.retired[id];
+                for (auto const* table : registry.tables) {
+                    auto const& slot = table->slots[id];
+                    totals.ticks += slot.ticks.load(std::memory_order_relaxed);
+                    totals.calls += slot.calls.load(std::memory_order_relaxed);
+                    totals.particles += slot.particles.load(std::memory_order_relaxed);
+                    totals.pairs += slot.pairs.load(std::memory_order_relaxed);
+                }
+
+                double const seconds = double(totals.ticks) * period;
+                timer_report report;
+                report.name = registry.names[id];
+                report.calls = totals.calls;
+                report.particles = totals.particles;
+                report.pairs = totals.pairs;
+                report.total_time = timer_report::time_type{seconds};
+                report.particle_rate =
+                    timer_report::rate_type{seconds > 0 ? double(totals.particles) / seconds : 0};
+                report.pair_rate =
+                    timer_report::rate_type{seconds > 0 ? double(totals.pairs) / seconds : 0};
+                reports.push_back(report);
+            }
+            return reports;
+        }
+
+        inline void write_timers_csv(std::ostream& os, std::vector<timer_report> const& reports)
+        {
+            os << "kernel,calls,seconds,particles,pairs,particles_per_second,pairs_per_second\n";
+            for (auto const& r : reports) {
+                os << r.name << ',' << r.calls << ',' << r.total_time.value() << ','
+                   << r.particles << ',' << r.pairs << ',' << r.particle_rate.value() << ','
+                   << r.pair_rate.value() << '\n';
+            }
+        }
+
+        inline void write_timers_json(std::ostream& os, std::vector<timer_report> const& reports)
+        {
+            os << "[";
+            for (std::size_t i = 0; i < reports.size(); ++i) {
+                auto const& r = reports[i];
+                os << (i == 0 ? "\n" : ",\n") << "  {\"kernel\": \"";
+                for (char const ch : r.name) {
+                    if (ch == '"' || ch == '\\') {
+                        os << '\\';
+                    }
+                    os << ch;
+                }
+                os << "\", \"calls\": " << r.calls << ", \"seconds\": " << r.total_time.value()
+                   << ", \"particles\": " << r.particles << ", \"pairs\": " << r.pairs
+                   << ", \"particles_per_second\": " << r.particle_rate.value()
+                   << ", \"pairs_per_second\": " << r.pair_rate.value() << "}";
+            }
+            os << "\n]\n";
+        }
+
+        inline timer_registry::~timer_registry()
+        {
+            if (dump_path.empty()) {
+                return;
+            }
+            std::string const json = ".json";
+            bool const is_json = dump_path.size() >= json.size()
+                && dump_path.compare(dump_path.size() - json.size(), json.size(), json) == 0;
+
+            std::ofstream file{dump_path};
+            if (is_json) {
+                write_timers_json(file, collect_timers(*this));
+            } else {
+                write_timers_csv(file, collect_timers(*this));
+            }
+        }
+    } // namespace detail
+
+    /*
+     * Collects the statistics of all kernels. Times are in seconds.
+     */
+    inline std::vector<timer_report> collect_timers()
+    {
+        auto& registry = detail::global_timer_registry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        return detail::collect_timers(registry);
+    }
+
+    /*
+     * Writes kernel statistics as CSV with a header line.
+     */
+    inline void dump_timers_csv(std::ostream& os)
+    {
+        detail::write_timers_csv(os, collect_timers());
+    }
+
+    /*
+     * Writes kernel statistics as a JSON array of objects.
+     */
+    inline void dump_timers_json(std::ostream& os)
+    {
+        detail::write_timers_json(os, collect_timers());
+    }
+
+    /*
+     * Requests the statistics to be written to path at program exit. The
+     * format is JSON if path ends with ".json" and CSV otherwise.
+     */
+    inline void dump_timers_at_exit(std::string const& path)
+    {
+        auto& registry = detail::global_timer_registry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        registry.dump_path = path;
+    }
+} // namespace dim
+
+/*
+ * DIM_TIMER_SCOPE(name, particles, pairs) times the rest of the enclosing
+ * block as kernel name. It expands to nothing unless DIM_ENABLE_TIMERS is
+ * defined.
+ */
+#if defined(DIM_ENABLE_TIMERS)
+#define DIM_TIMER_CAT2(a, b) a##b
+#define DIM_TIMER_CAT(a, b) DIM_TIMER_CAT2(a, b)
+#define DIM_TIMER_SCOPE(name, particles, pairs)                                               \
+    static ::dim::timer_kernel const DIM_TIMER_CAT(dim_timer_kernel_, __LINE__){name};        \
+    ::dim::scoped_timer DIM_TIMER_CAT(dim_timer_, __LINE__)                                   \
+    {                                                                                         \
+        DIM_TIMER_CAT(dim_timer_kernel_, __LINE__), (particles), (pairs)                      \
+    }
+#else
+#define DIM_TIMER_SCOPE(name, particles, pairs) static_cast<void>(0)
+#endif
+
+#endif // INCLUDED_DIM_TIMER_HPP
@@ -0,0 +1,26 @@
+#ifndef INCLUDED_DIM_TESTS_RANDOM_POINTS_HPP
+#define INCLUDED_DIM_TESTS_RANDOM_POINTS_HPP
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <dim.hpp>
+
+namespace dim_test
+{
+    // Returns count points uniformly distributed in the cube [0, box)^3.
+    inline std::vector<dim::point<double, dim::mech::length, 3>> random_points(
+        std::size_t count, double box, unsigned seed)
+    {
+        std::mt19937 engine(seed);
+        std::uniform_real_distribution<double> coord(0, box);
+        std::vector<dim::point<double, dim::mech::length, 3>> points(count);
+        for (auto& p : points) {
+            p = dim::point<double, dim::mech::length, 3>{coord(engine), coord(engine), coord(engine)};
+        }
+        return points;
+    }
+} // namespace dim_test
+
+#endif // INCLUDED_DIM_TESTS_RANDOM_POINTS_HPP
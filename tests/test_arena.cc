@@ -0,0 +1,100 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_arena.hpp>
+#include <doctest.h>
+
+namespace
+{
+    bool is_aligned(void const* ptr, std::size_t alignment)
+    {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+}
+
+TEST_CASE("aligned_allocator: aligns container storage")
+{
+    using displace_t = dim::vector<double, dim::mech::length, 3>;
+    using allocator_t = dim::aligned_allocator<displace_t, 64>;
+
+    std::vector<displace_t, allocator_t> displacements(100);
+    CHECK(is_aligned(displacements.data(), 64));
+    CHECK(displacements[99] == displace_t{0, 0, 0});
+
+    displacements.resize(1000, displace_t{1, 2, 3});
+    CHECK(is_aligned(displacements.data(), 64));
+    CHECK(displacements[999] == displace_t{1, 2, 3});
+}
+
+TEST_CASE("arena: allocates aligned memory")
+{
+    dim::arena arena{1024};
+    void* const a = arena.allocate(3, 1);
+    void* const b = arena.allocate(8, 32);
+    CHECK(a != b);
+    CHECK(is_aligned(b, 32));
+    CHECK(arena.bytes_in_use() >= 11);
+    CHECK(arena.stats().allocation_count == 2);
+}
+
+TEST_CASE("arena: reuses memory after reset")
+{
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+
+    dim::arena arena{4096};
+    velocity_t* const first = arena.allocate_array<velocity_t>(10);
+    CHECK(first[9] == velocity_t{0, 0, 0});
+    first[0] = velocity_t{1, 2, 3};
+
+    arena.reset();
+    CHECK(arena.bytes_in_use() == 0);
+    velocity_t* const second = arena.allocate_array<velocity_t>(10);
+    CHECK(second == first);
+    CHECK(second[0] == velocity_t{0, 0, 0});
+}
+
+TEST_CASE("arena: grows and merges blocks on reset")
+{
+    dim::arena arena{256};
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(200);
+    }
+    auto const grown = arena.stats();
+    CHECK(grown.block_count > 1);
+    CHECK(grown.capacity >= 2000);
+    CHECK(grown.peak_bytes >= 2000);
+
+    arena.reset();
+    auto const merged = arena.stats();
+    CHECK(merged.block_count == 1);
+    CHECK(merged.capacity == grown.capacity);
+    CHECK(merged.peak_bytes == grown.peak_bytes);
+    CHECK(merged.bytes_in_use == 0);
+    CHECK(merged.reset_count == 1);
+
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(200);
+    }
+    CHECK(arena.stats().block_count == 1);
+}
+
+TEST_CASE("arena_allocator: backs standard containers")
+{
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using allocator_t = dim::arena_allocator<force_t>;
+
+    dim::arena arena;
+    {
+        std::vector<force_t, allocator_t> forces(allocator_t{arena});
+        for (int i = 0; i < 100; ++i) {
+            forces.push_back(force_t{double(i), 0, 0});
+        }
+        CHECK(forces[42] == force_t{42, 0, 0});
+        CHECK(arena.bytes_in_use() >= 100 * sizeof(force_t));
+    }
+    CHECK(allocator_t{arena} == dim::arena_allocator<int>{arena});
+    arena.reset();
+    CHECK(arena.bytes_in_use() == 0);
+}
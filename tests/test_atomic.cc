@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_atomic.hpp>
+#include <doctest.h>
+
+TEST_CASE("atomic_scalar: keeps the dimension type")
+{
+    using atomic_t = dim::atomic_scalar<double, dim::mech::energy>;
+    CHECK((std::is_same<atomic_t::value_type, dim::scalar<double, dim::mech::energy>>::value));
+    CHECK((std::is_same<decltype(std::declval<atomic_t&>().load()), atomic_t::value_type>::value));
+}
+
+TEST_CASE("atomic_scalar: provides load, store and arithmetic")
+{
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+
+    dim::atomic_scalar<double, dim::mech::energy> x{energy_t{1}};
+    CHECK(x.load() == energy_t{1});
+
+    x.store(energy_t{2});
+    CHECK(x.fetch_add(energy_t{3}) == energy_t{2});
+    CHECK(x.fetch_sub(energy_t{1}) == energy_t{5});
+    CHECK((x += energy_t{6}) == energy_t{10});
+    CHECK((x -= energy_t{4}) == energy_t{6});
+    CHECK(x.load() == energy_t{6});
+}
+
+TEST_CASE("atomic_scalar: accumulates fixed-point numbers natively")
+{
+    using fixed_t = dim::scalar<std::int64_t, dim::mech::force>;
+
+    dim::atomic_scalar<std::int64_t, dim::mech::force> x;
+    CHECK(x.is_lock_free());
+    x += fixed_t{40};
+    x -= fixed_t{2};
+    CHECK(x.load() == fixed_t{38});
+}
+
+TEST_CASE("atomic_scalar: accumulates concurrent additions")
+{
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+
+    dim::atomic_scalar<double, dim::mech::energy> sum;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                sum += energy_t{0.5};
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(sum.load() == energy_t{20000});
+}
+
+TEST_CASE("atomic_vector: accumulates vectors coordinate-wise")
+{
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+
+    dim::atomic_vector<double, dim::mech::force, 3> f{force_t{1, 2, 3}};
+    CHECK(f.load() == force_t{1, 2, 3});
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                f += force_t{1, -1, 0.25};
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(f.load() == force_t{4001, -3998, 1003});
+
+    f -= force_t{1, 2, 3};
+    CHECK(f.load() == force_t{4000, -4000, 1000});
+    CHECK(f[0].load() == dim::scalar<double, dim::mech::force>{4000});
+}
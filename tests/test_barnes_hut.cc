@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_barnes_hut.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using mass_t = dim::scalar<double, dim::mech::mass>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using law_t = dim::inverse_square_law<double, dim::mech::mass>;
+
+    void make_system(std::size_t count, std::vector<point_t>& points, std::vector<mass_t>& masses)
+    {
+        std::mt19937 random;
+        std::uniform_real_distribution<double> coord{-1, 1};
+        std::uniform_real_distribution<double> mass{0.5, 1.5};
+        for (std::size_t i = 0; i < count; ++i) {
+            points.push_back(point_t{coord(random), coord(random), coord(random)});
+            masses.push_back(mass_t{mass(random)});
+        }
+    }
+
+    void direct_sum(law_t const& law,
+        std::vector<point_t> const& points,
+        std::vector<mass_t> const& masses,
+        std::vector<force_t>& forces,
+        std::vector<energy_t>& potentials)
+    {
+        forces.assign(points.size(), force_t{});
+        potentials.assign(points.size(), energy_t{});
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            for (std::size_t j = 0; j < points.size(); ++j) {
+                if (i != j) {
+                    forces[i] += law.force(points[i] - points[j], masses[j], masses[i]);
+                    potentials[i] += law.potential(points[i] - points[j], masses[j], masses[i]);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("inverse_square_law: computes dimensioned force and potential")
+{
+    using displace_t = dim::vector<double, dim::mech::length, 3>;
+
+    law_t const gravity{law_t::coupling_type{-1}};
+    displace_t const r{0, 0, 2};
+    CHECK(gravity.force(r, mass_t{2}, mass_t{3}) == force_t{0, 0, -1.5});
+    CHECK(gravity.potential(r, mass_t{2}, mass_t{3}) == energy_t{-3});
+}
+
+TEST_CASE("barnes_hut: matches direct summation with zero opening angle")
+{
+    std::vector<point_t> points;
+    std::vector<mass_t> masses;
+    make_system(500, points, masses);
+
+    law_t const gravity{law_t::coupling_type{-1}};
+    std::vector<force_t> expected_forces;
+    std::vector<energy_t> expected_potentials;
+    direct_sum(gravity, points, masses, expected_forces, expected_potentials);
+
+    dim::barnes_hut<double, dim::mech::mass> tree{0.0, 4};
+    tree.build(points, masses);
+    CHECK(tree.size() == points.size());
+    CHECK(tree.node_count() > 1);
+
+    std::vector<force_t> forces;
+    std::vector<energy_t> potentials;
+    tree.compute(gravity, forces, potentials);
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        CHECK(dim::norm(forces[i] - expected_forces[i]) / dim::norm(expected_forces[i]) < 1e-12);
+        CHECK(dim::abs(potentials[i] - expected_potentials[i]) / dim::abs(expected_potentials[i])
+            < 1e-12);
+    }
+}
+
+TEST_CASE("barnes_hut: approximates direct summation")
+{
+    std::vector<point_t> points;
+    std::vector<mass_t> masses;
+    make_system(1000, points, masses);
+
+    law_t const gravity{law_t::coupling_type{-1}};
+    std::vector<force_t> expected_forces;
+    std::vector<energy_t> expected_potentials;
+    direct_sum(gravity, points, masses, expected_forces, expected_potentials);
+
+    dim::barnes_hut<double, dim::mech::mass> tree{0.5};
+    tree.build(points, masses);
+
+    std::vector<force_t> forces(points.size());
+    tree.compute(gravity, forces.data());
+
+    double sum_error = 0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        sum_error += dim::norm(forces[i] - expected_forces[i]) / dim::norm(expected_forces[i]);
+    }
+    CHECK(sum_error / double(points.size()) < 1e-2);
+}
+
+TEST_CASE("barnes_hut: accepts user-defined force laws")
+{
+    using displace_t = dim::vector<double, dim::mech::length, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    // Screened interaction between unit-less charges.
+    struct yukawa_law
+    {
+        dim::scalar<double, dim::mech::energy> strength;
+        length_t screening;
+
+        force_t force(displace_t const& r, double qs, double qt) const
+        {
+            auto const d = dim::norm(r);
+            auto const decay = std::exp(-d / screening);
+            return strength * length_t{1} * qs * qt * decay * (1 + d / screening) * r
+                / dim::pow<3>(d);
+        }
+
+        energy_t potential(displace_t const& r, double qs, double qt) const
+        {
+            auto const d = dim::norm(r);
+            return strength * (length_t{1} / d) * qs * qt * std::exp(-d / screening);
+        }
+    };
+
+    using charge_t = dim::scalar<double, dim::mech::number>;
+    std::vector<point_t> const points = {point_t{0, 0, 0}, point_t{0, 0, 1}};
+    std::vector<charge_t> const charges = {charge_t{1}, charge_t{-1}};
+
+    dim::barnes_hut<double, dim::mech::number> tree;
+    tree.build(points, charges);
+
+    yukawa_law const law{energy_t{1}, length_t{1}};
+    std::vector<force_t> forces;
+    std::vector<energy_t> potentials;
+    tree.compute(law, forces, potentials);
+
+    CHECK(forces[0] == -forces[1]);
+    CHECK(forces[0][2].value() > 0);
+    CHECK(potentials[0] == energy_t{-std::exp(-1.0)});
+}
@@ -0,0 +1,119 @@
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_bonded.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using bond_stiffness_t = decltype(dim::harmonic_bond<double>::stiffness);
+
+    // Checks forces computed by a potential against the numerical gradient
+    // of its energy.
+    template<typename Potential>
+    void check_gradient(Potential const& potential, std::vector<point_t> points)
+    {
+        std::vector<force_t> forces(points.size());
+        potential(points.data(), forces.data());
+
+        std::vector<force_t> dummy(points.size());
+        double const h = 1e-6;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            for (unsigned k = 0; k < 3; ++k) {
+                auto moved = points;
+                moved[i][k] += length_t{h};
+                double const forward = potential(moved.data(), dummy.data()).value();
+                moved[i][k] -= length_t{2 * h};
+                double const backward = potential(moved.data(), dummy.data()).value();
+                CHECK(std::fabs(forces[i][k].value() + (forward - backward) / (2 * h)) < 1e-6);
+            }
+        }
+    }
+}
+
+TEST_CASE("harmonic_bond: computes energy and forces")
+{
+    dim::harmonic_bond<double> const bond{bond_stiffness_t{2}, length_t{1}};
+    std::vector<point_t> const points = {point_t{0, 0, 0}, point_t{0, 3, 0}};
+    force_t forces[2];
+    CHECK(bond(points.data(), forces) == energy_t{4});
+    CHECK(forces[0] == force_t{0, 4, 0});
+    CHECK(forces[1] == force_t{0, -4, 0});
+    check_gradient(bond, {point_t{0.1, 0.2, 0.3}, point_t{1.2, 0.7, -0.4}});
+}
+
+TEST_CASE("fene_bond: computes energy and forces")
+{
+    dim::fene_bond<double> const bond{bond_stiffness_t{3}, length_t{2}};
+    std::vector<point_t> const points = {point_t{0, 0, 0}, point_t{1, 1, 1}};
+    force_t forces[2];
+    CHECK(std::fabs(bond(points.data(), forces).value() + 6 * std::log(0.25)) < 1e-12);
+    check_gradient(bond, {point_t{0.1, 0.2, 0.3}, point_t{1.2, 0.7, -0.4}});
+}
+
+TEST_CASE("harmonic_angle: computes energy and forces")
+{
+    double const pi = std::acos(-1.0);
+    dim::harmonic_angle<double> const angle{energy_t{2}, pi / 2};
+    std::vector<point_t> const points = {point_t{1, 0, 0}, point_t{0, 0, 0}, point_t{-1, 0, 0}};
+    force_t forces[3];
+    CHECK(std::fabs(angle(points.data(), forces).value() - pi * pi / 4) < 1e-12);
+    check_gradient(angle, {point_t{1, 0.2, 0}, point_t{0, 0, 0.1}, point_t{0.3, 1, 0.2}});
+}
+
+TEST_CASE("cosine_dihedral: computes energy and forces")
+{
+    dim::cosine_dihedral<double> const dihedral{energy_t{1.5}, 3, 0.4};
+    std::vector<point_t> const trans = {
+        point_t{1, 1, 0}, point_t{0, 0, 0}, point_t{0, 0, 1}, point_t{-1, -1, 1}};
+    force_t forces[4];
+    double const pi = std::acos(-1.0);
+    CHECK(std::fabs(dihedral(trans.data(), forces).value() - 1.5 * (1 + std::cos(3 * pi - 0.4)))
+        < 1e-12);
+    check_gradient(dihedral,
+        {point_t{1, 0.2, 0}, point_t{0, 0, 0.1}, point_t{0.3, 0.1, 1.2}, point_t{0.5, 1, 1.4}});
+}
+
+TEST_CASE("bonded_engine: colors terms and sums all of them")
+{
+    std::vector<point_t> positions;
+    for (int i = 0; i < 200; ++i) {
+        positions.push_back(point_t{0.9 * i, std::sin(i), std::cos(0.5 * i)});
+    }
+
+    std::vector<std::array<std::uint32_t, 3>> angles;
+    for (std::uint32_t i = 0; i + 2 < 200; ++i) {
+        angles.push_back({{i, i + 1, i + 2}});
+    }
+    dim::harmonic_angle<double> const potential{energy_t{1}, 2.0};
+    auto const engine = dim::make_bonded_engine(angles, potential);
+    CHECK(engine.size() == angles.size());
+    CHECK(engine.color_count() == 3);
+
+    std::vector<force_t> forces(positions.size());
+    energy_t const energy = engine.compute(positions, forces);
+
+    std::vector<force_t> expected_forces(positions.size());
+    double expected_energy = 0;
+    for (auto const& term : angles) {
+        point_t const points[] = {positions[term[0]], positions[term[1]], positions[term[2]]};
+        force_t term_forces[3];
+        expected_energy += potential(points, term_forces).value();
+        for (unsigned a = 0; a < 3; ++a) {
+            expected_forces[term[a]] += term_forces[a];
+        }
+    }
+
+    CHECK(std::fabs(energy.value() - expected_energy) < 1e-9);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        CHECK(dim::norm(forces[i] - expected_forces[i]).value() < 1e-12);
+    }
+}
@@ -0,0 +1,202 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_cluster_pair.hpp>
+#include <doctest.h>
+
+#include "random_points.hpp"
+
+namespace
+{
+    using dim_test::random_points;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using box_t = dim::vector<double, dim::mech::length, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using area_t = dim::scalar<double, dim::power_dimension_t<dim::mech::length, 2>>;
+    using factor_t = dim::scalar<double,
+        dim::quotient_dimension_t<dim::mech::energy, dim::power_dimension_t<dim::mech::length, 2>>>;
+
+    // Soft repulsion (1 - r^2)^2 within the unit distance.
+    struct soft_sphere
+    {
+        struct sample
+        {
+            energy_t value;
+            factor_t force_factor;
+        };
+
+        sample evaluate(area_t r2) const
+        {
+            double const s = 1 - r2.value();
+            return sample{energy_t{s * s}, factor_t{4 * s}};
+        }
+    };
+
+    bool is_excluded(std::vector<std::pair<std::size_t, std::size_t>> const& exclusions,
+        std::size_t i,
+        std::size_t j)
+    {
+        for (auto const& e : exclusions) {
+            if ((e.first == i && e.second == j) || (e.first == j && e.second == i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Energy and forces by all pairs with the minimum image convention.
+    double brute_force(std::vector<point_t> const& points,
+        double box,
+        double cutoff,
+        std::vector<std::pair<std::size_t, std::size_t>> const& exclusions,
+        std::vector<force_t>& forces)
+    {
+        soft_sphere const potential;
+        double energy = 0;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            for (std::size_t j = i + 1; j < points.size(); ++j) {
+                double d[3];
+                double r2 = 0;
+                for (unsigned k = 0; k < 3; ++k) {
+                    d[k] = points[i][k].value() - points[j][k].value();
+                    d[k] -= box * std::round(d[k] / box);
+                    r2 += d[k] * d[k];
+                }
+                if (r2 >= cutoff * cutoff || is_excluded(exclusions, i, j)) {
+                    continue;
+                }
+                auto const sample = potential.evaluate(area_t{r2});
+                energy += sample.value.value();
+                for (unsigned k = 0; k < 3; ++k) {
+                    double const f = sample.force_factor.value() * d[k];
+                    forces[i][k] += dim::scalar<double, dim::mech::force>{f};
+                    forces[j][k] -= dim::scalar<double, dim::mech::force>{f};
+                }
+            }
+        }
+        return energy;
+    }
+
+    template<unsigned M>
+    void check_against_brute_force(double box, std::size_t count, unsigned seed)
+    {
+        auto points = random_points(count, box, seed);
+        points[0] = point_t{0.01, box - 0.01, 0.5};
+        std::vector<std::pair<std::size_t, std::size_t>> exclusions;
+        for (std::size_t i = 0; i + 1 < count; i += 7) {
+            exclusions.emplace_back(i, i + 1);
+        }
+
+        dim::cluster_pair_list<double, M> list{box_t{box, box, box}, length_t{1.2}};
+        list.build(points, exclusions);
+        REQUIRE(list.pairs().size() > 0);
+        CHECK(list.size() == count);
+        CHECK(list.cluster_count() >= (count + M - 1) / M);
+        CHECK(list.fill_ratio() > 0);
+        CHECK(list.fill_ratio() <= 1);
+
+        std::vector<force_t> expected(count);
+        std::vector<force_t> actual(count);
+        double const energy = brute_force(points, box, 1, exclusions, expected);
+        CHECK(list.compute(soft_sphere{}, length_t{1}, actual).value() == doctest::Approx(energy).epsilon(1e-10));
+        for (std::size_t i = 0; i < count; ++i) {
+            for (unsigned k = 0; k < 3; ++k) {
+                CHECK(actual[i][k].value() == doctest::Approx(expected[i][k].value()).epsilon(1e-9));
+            }
+        }
+
+        // Moves within the half of the buffer only need a coordinate update,
+        // even if particles leave the box.
+        std::mt19937 engine(seed + 1);
+        std::uniform_real_distribution<double> step(-0.05, 0.05);
+        for (auto& p : points) {
+            p += dim::vector<double, dim::mech::length, 3>{step(engine), step(engine), step(engine)};
+        }
+        points[0] = point_t{-0.03, box + 0.02, 0.5};
+        list.update(points);
+        std::vector<force_t> moved_expected(count);
+        std::vector<force_t> moved_actual(count);
+        double const moved_energy = brute_force(points, box, 1, exclusions, moved_expected);
+        CHECK(list.compute(soft_sphere{}, length_t{1}, moved_actual).value()
+            == doctest::Approx(moved_energy).epsilon(1e-10));
+        for (std::size_t i = 0; i < count; ++i) {
+            for (unsigned k = 0; k < 3; ++k) {
+                CHECK(moved_actual[i][k].value() == doctest::Approx(moved_expected[i][k].value()).epsilon(1e-9));
+            }
+        }
+    }
+}
+
+TEST_CASE("lennard_jones: vanishes at sigma and has zero force at the minimum")
+{
+    dim::lennard_jones<double> lj{energy_t{2}, length_t{1.5}};
+    CHECK(lj(area_t{1.5 * 1.5}).value() == doctest::Approx(0).epsilon(1e-12));
+
+    double const rmin = std::pow(2.0, 1.0 / 6) * 1.5;
+    auto const sample = lj.evaluate(area_t{rmin * rmin});
+    CHECK(sample.value.value() == doctest::Approx(-2));
+    CHECK(sample.force_factor.value() == doctest::Approx(0).epsilon(1e-12));
+}
+
+TEST_CASE("cluster_pair_list: rejects invalid parameters")
+{
+    using list_t = dim::cluster_pair_list<double, 4>;
+    CHECK_THROWS_AS(list_t(box_t{4, 4, 4}, length_t{0}), std::invalid_argument);
+    CHECK_THROWS_AS(list_t(box_t{4, 4, 2}, length_t{1.5}), std::invalid_argument);
+
+    list_t list{box_t{4, 4, 4}, length_t{1.2}};
+    list.build(std::vector<point_t>{point_t{1, 1, 1}, point_t{2, 1, 1}});
+    std::vector<force_t> forces(2);
+    CHECK(list.compute(soft_sphere{}, length_t{1.2}, forces).value() == doctest::Approx(0));
+    CHECK_THROWS_AS(list.compute(soft_sphere{}, length_t{1.3}, forces), std::invalid_argument);
+}
+
+TEST_CASE("cluster_pair_list: stores every particle once in spatial tiles")
+{
+    auto const points = random_points(1001, 10, 2);
+    dim::cluster_pair_list<double, 8> list{box_t{10, 10, 10}, length_t{1.2}};
+    list.build(points);
+
+    std::vector<int> seen(points.size(), 0);
+    std::size_t padding = 0;
+    for (std::size_t c = 0; c < list.cluster_count(); ++c) {
+        for (unsigned s = 0; s < 8; ++s) {
+            std::size_t const i = list.particle(c, s);
+            if (i == list.no_particle) {
+                padding++;
+                continue;
+            }
+            seen[i]++;
+            CHECK(list.tiles()[c].x[s] == points[i][0].value());
+            CHECK(list.tiles()[c].z[s] == points[i][2].value());
+        }
+    }
+    CHECK(padding == list.cluster_count() * 8 - points.size());
+    for (int const n : seen) {
+        CHECK(n == 1);
+    }
+    for (auto const& pair : list.pairs()) {
+        CHECK(pair.i <= pair.j);
+    }
+}
+
+TEST_CASE("cluster_pair_list: 4x4 kernel matches the all-pairs loop")
+{
+    // Sparse clusters span the box and interact with their own images.
+    check_against_brute_force<4>(2.5, 30, 7);
+    check_against_brute_force<4>(6, 800, 3);
+    check_against_brute_force<4>(12, 4000, 4);
+}
+
+TEST_CASE("cluster_pair_list: 8x8 kernel matches the all-pairs loop")
+{
+    check_against_brute_force<8>(6, 800, 5);
+    check_against_brute_force<8>(12, 4000, 6);
+}
@@ -0,0 +1,276 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_constraint.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using mass_t = dim::scalar<double, dim::mech::mass>;
+    using time_t_ = dim::scalar<double, dim::mech::time>;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+    using constraint_t = dim::distance_constraint<double>;
+    using solver_t = dim::constraint_solver<double>;
+
+    // Triangular molecules (three coupled constraints) followed by zig-zag
+    // four-particle chains, laid out on a coarse grid. LINCS converges
+    // slowly on nearly collinear chains, so the chains are bent.
+    struct molecules
+    {
+        std::vector<constraint_t> constraints;
+        std::vector<mass_t> masses;
+        std::vector<point_t> positions;
+    };
+
+    molecules make_molecules(std::size_t triangles, std::size_t chains)
+    {
+        molecules system;
+        std::mt19937 engine{3};
+        std::uniform_real_distribution<double> angle(0, 6.283185307179586);
+        std::uniform_real_distribution<double> mass(1, 16);
+
+        auto const add = [&](point_t const& p) {
+            system.positions.push_back(p);
+            system.masses.push_back(mass_t{mass(engine)});
+            return std::uint32_t(system.positions.size() - 1);
+        };
+        auto const bond = [&](std::uint32_t i, std::uint32_t j) {
+            length_t const length = distance(system.positions[i], system.positions[j]);
+            system.constraints.push_back(constraint_t{i, j, length});
+        };
+
+        for (std::size_t m = 0; m < triangles + chains; ++m) {
+            double const x = double(m % 16) * 4;
+            double const y = double(m / 16) * 4;
+            double const a = angle(engine);
+            if (m < triangles) {
+                std::uint32_t const o = add(point_t{x, y, 0.0});
+                std::uint32_t const h1 = add(point_t{x + std::cos(a), y + std::sin(a), 0.0});
+                std::uint32_t const h2 = add(point_t{x + std::cos(a + 1.8), y + std::sin(a + 1.8), 0.2});
+                bond(o, h1);
+                bond(o, h2);
+                bond(h1, h2);
+            } else {
+                std::uint32_t prev = add(point_t{x, y, 0.0});
+                for (int k = 1; k < 4; ++k) {
+                    std::uint32_t const next =
+                        add(point_t{x + 1.0 * k, y + 0.8 * (k % 2), 0.2 * std::sin(a * k)});
+                    bond(prev, next);
+                    prev = next;
+                }
+            }
+        }
+        return system;
+    }
+
+    std::vector<velocity_t> random_velocities(std::size_t count, unsigned seed)
+    {
+        std::mt19937 engine{seed};
+        std::normal_distribution<double> normal(0, 1);
+        std::vector<velocity_t> velocities;
+        for (std::size_t i = 0; i < count; ++i) {
+            velocities.push_back(velocity_t{normal(engine), normal(engine), normal(engine)});
+        }
+        return velocities;
+    }
+
+    double max_length_error(molecules const& system, std::vector<point_t> const& positions)
+    {
+        double error = 0;
+        for (constraint_t const& c : system.constraints) {
+            double const e = std::fabs(distance(positions[c.i], positions[c.j]) / c.length - 1);
+            error = e > error ? e : error;
+        }
+        return error;
+    }
+
+    double max_bond_velocity(molecules const& system,
+        std::vector<point_t> const& positions,
+        std::vector<velocity_t> const& velocities)
+    {
+        double result = 0;
+        for (constraint_t const& c : system.constraints) {
+            auto const r = positions[c.i] - positions[c.j];
+            double const v = std::fabs(dot(r / norm(r), velocities[c.i] - velocities[c.j]).value());
+            result = v > result ? v : result;
+        }
+        return result;
+    }
+
+    dim::constraint_parameters<double> lincs_parameters()
+    {
+        dim::constraint_parameters<double> params;
+        params.method = dim::constraint_method::lincs;
+        params.lincs_order = 8;
+        params.lincs_iterations = 2;
+        return params;
+    }
+}
+
+TEST_CASE("constraint_solver - rejects invalid constraints")
+{
+    std::vector<mass_t> const masses(3, mass_t{1});
+
+    CHECK_THROWS_AS(solver_t({constraint_t{0, 0, length_t{1}}}, masses), std::invalid_argument);
+    CHECK_THROWS_AS(solver_t({constraint_t{0, 3, length_t{1}}}, masses), std::invalid_argument);
+    CHECK_THROWS_AS(solver_t({constraint_t{0, 1, length_t{0}}}, masses), std::invalid_argument);
+    CHECK_THROWS_AS(solver_t({constraint_t{0, 1, length_t{1}}}, {mass_t{1}, mass_t{0}}), std::invalid_argument);
+}
+
+TEST_CASE("constraint_solver - groups coupled constraints into clusters")
+{
+    molecules const system = make_molecules(5, 7);
+    solver_t const solver(system.constraints, system.masses);
+    CHECK(solver.size() == 5 * 3 + 7 * 3);
+    CHECK(solver.cluster_count() == 12);
+
+    solver_t const single({constraint_t{0, 1, length_t{1}}, constraint_t{2, 1, length_t{1}}},
+        std::vector<mass_t>(4, mass_t{1}));
+    CHECK(single.cluster_count() == 1);
+}
+
+TEST_CASE("constraint_solver - SHAKE restores bond lengths and corrects velocities")
+{
+    molecules const system = make_molecules(200, 200);
+    solver_t solver(system.constraints, system.masses);
+    time_t_ const dt{0.01};
+
+    std::vector<velocity_t> velocities = random_velocities(system.positions.size(), 4);
+    std::vector<point_t> positions = system.positions;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        positions[i] += dt * velocities[i];
+    }
+    std::vector<point_t> const unconstrained = positions;
+    std::vector<velocity_t> const initial_velocities = velocities;
+    CHECK(max_length_error(system, positions) > 1e-4);
+
+    auto const stats = solver.apply(system.positions, positions, velocities, dt);
+    CHECK(stats.unconverged == 0);
+    CHECK(stats.iterations > 1);
+    CHECK(stats.max_deviation < 1e-9);
+    CHECK(max_length_error(system, positions) < 1e-9);
+    CHECK(solver.statistics().iterations == stats.iterations);
+
+    // Velocities absorb exactly the constraint displacements, and the
+    // constraint forces do not move the center of mass of a molecule.
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        auto const expected = initial_velocities[i] + (positions[i] - unconstrained[i]) / dt;
+        for (unsigned k = 0; k < 3; ++k) {
+            CHECK(velocities[i][k].value() == doctest::Approx(expected[k].value()));
+        }
+    }
+    for (std::size_t m = 0; m < 3; ++m) {
+        double moment[3] = {};
+        for (std::size_t i = 3 * m; i < 3 * m + 3; ++i) {
+            auto const shift = positions[i] - unconstrained[i];
+            for (unsigned k = 0; k < 3; ++k) {
+                moment[k] += system.masses[i].value() * shift[k].value();
+            }
+        }
+        for (double const component : moment) {
+            CHECK(component == doctest::Approx(0).epsilon(1e-9));
+        }
+    }
+}
+
+TEST_CASE("constraint_solver - RATTLE removes relative velocities along bonds")
+{
+    molecules const system = make_molecules(100, 100);
+    solver_t solver(system.constraints, system.masses);
+
+    std::vector<velocity_t> velocities = random_velocities(system.positions.size(), 5);
+    CHECK(max_bond_velocity(system, system.positions, velocities) > 0.1);
+
+    auto const stats = solver.apply_velocities(system.positions, velocities);
+    CHECK(stats.unconverged == 0);
+    CHECK(stats.max_deviation <= 1e-10);
+    CHECK(max_bond_velocity(system, system.positions, velocities) < 1e-8);
+}
+
+TEST_CASE("constraint_solver - LINCS approaches SHAKE with a fixed amount of work")
+{
+    molecules const system = make_molecules(150, 150);
+    time_t_ const dt{0.005};
+    std::vector<velocity_t> const velocities = random_velocities(system.positions.size(), 6);
+
+    std::vector<point_t> moved = system.positions;
+    for (std::size_t i = 0; i < moved.size(); ++i) {
+        moved[i] += dt * velocities[i];
+    }
+
+    solver_t shake(system.constraints, system.masses);
+    solver_t lincs(system.constraints, system.masses, lincs_parameters());
+
+    std::vector<point_t> by_shake = moved;
+    std::vector<point_t> by_lincs = moved;
+    std::vector<velocity_t> lincs_velocities = velocities;
+    shake.apply(system.positions, by_shake);
+    auto const stats = lincs.apply(system.positions, by_lincs, lincs_velocities, dt);
+
+    CHECK(stats.iterations == 2 * 8 * 3);
+    CHECK(stats.unconverged == 0);
+    CHECK(stats.max_deviation < 1e-5);
+    CHECK(max_length_error(system, by_lincs) == doctest::Approx(stats.max_deviation));
+
+    double max_difference = 0;
+    for (std::size_t i = 0; i < moved.size(); ++i) {
+        double const d = distance(by_shake[i], by_lincs[i]).value();
+        max_difference = d > max_difference ? d : max_difference;
+        auto const expected = velocities[i] + (by_lincs[i] - moved[i]) / dt;
+        CHECK(lincs_velocities[i][0].value() == doctest::Approx(expected[0].value()));
+    }
+    CHECK(max_difference < 1e-4);
+
+    std::vector<velocity_t> projected = velocities;
+    auto const velocity_stats = lincs.apply_velocities(system.positions, projected);
+    CHECK(velocity_stats.max_deviation < 1e-2);
+    CHECK(max_bond_velocity(system, system.positions, projected)
+        < 1e-2 * max_bond_velocity(system, system.positions, velocities));
+}
+
+TEST_CASE("constraint_solver - velocity Verlet with RATTLE keeps a rotor rigid")
+{
+    // A free triangle spinning about its center: the constrained dynamics
+    // must keep the bond lengths and the kinetic energy.
+    molecules const system = make_molecules(1, 0);
+    solver_t solver(system.constraints, system.masses);
+    time_t_ const dt{0.002};
+
+    std::vector<point_t> positions = system.positions;
+    std::vector<velocity_t> velocities(3);
+    for (std::size_t i = 0; i < 3; ++i) {
+        auto const r = positions[i] - positions[0];
+        velocities[i] = velocity_t{-r[1].value(), r[0].value(), 0.0} * 2.0;
+    }
+    solver.apply_velocities(positions, velocities);
+
+    auto const kinetic = [&] {
+        double energy = 0;
+        for (std::size_t i = 0; i < 3; ++i) {
+            energy += system.masses[i].value() * squared_norm(velocities[i]).value() / 2;
+        }
+        return energy;
+    };
+    double const initial = kinetic();
+    REQUIRE(initial > 0);
+
+    for (int step = 0; step < 2000; ++step) {
+        std::vector<point_t> const reference = positions;
+        for (std::size_t i = 0; i < 3; ++i) {
+            positions[i] += dt * velocities[i];
+        }
+        auto const stats = solver.apply(reference, positions, velocities, dt);
+        REQUIRE(stats.unconverged == 0);
+        solver.apply_velocities(positions, velocities);
+    }
+
+    CHECK(max_length_error(system, positions) < 1e-9);
+    CHECK(kinetic() == doctest::Approx(initial).epsilon(1e-3));
+}
@@ -14,3 +14,31 @@ TEST_CASE("predefined dimensions")
     CHECK((std::is_same<dim::mech::force, dim::mechanical_dimension<1, 1, -2>>::value));
     CHECK((std::is_same<dim::mech::energy, dim::mechanical_dimension<2, 1, -2>>::value));
 }
+
+TEST_CASE("charge exponent defaults to zero")
+{
+    CHECK((std::is_same<dim::mechanical_dimension<1, 2, 3>,
+        dim::mechanical_dimension<1, 2, 3, 0>>::value));
+}
+
+TEST_CASE("predefined electric dimensions")
+{
+    CHECK((std::is_same<dim::elec::charge, dim::mechanical_dimension<0, 0, 0, 1>>::value));
+    CHECK((std::is_same<dim::elec::current, dim::mechanical_dimension<0, 0, -1, 1>>::value));
+    CHECK((std::is_same<dim::elec::electric_potential,
+        dim::mechanical_dimension<2, 1, -2, -1>>::value));
+    CHECK((std::is_same<dim::elec::electric_field,
+        dim::mechanical_dimension<1, 1, -2, -1>>::value));
+    CHECK((std::is_same<dim::elec::permittivity,
+        dim::mechanical_dimension<-3, -1, 2, 2>>::value));
+}
+
+TEST_CASE("charge combines with mechanical dimensions")
+{
+    using charge_t = dim::scalar<double, dim::elec::charge>;
+    using field_t = dim::vector<double, dim::elec::electric_field, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+
+    force_t const force = charge_t{2} * field_t{1, 2, 3};
+    CHECK(force == force_t{2, 4, 6});
+}
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_domain.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using box_t = dim::vector<double, dim::mech::length, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using time_t_ = dim::scalar<double, dim::mech::time>;
+
+    struct atom
+    {
+        point_t position;
+        std::uint64_t id;
+    };
+
+    using domain_t = dim::domain_decomposition<double, atom>;
+    using image_t = std::tuple<std::uint64_t, long, long, long>;
+
+    std::vector<atom> random_atoms(std::size_t count, double const (&extent)[3], unsigned seed)
+    {
+        std::mt19937 engine(seed);
+        std::vector<atom> atoms(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            for (unsigned k = 0; k < 3; ++k) {
+                std::uniform_real_distribution<double> coord(0, extent[k]);
+                atoms[i].position[k] = length_t{coord(engine)};
+            }
+            atoms[i].id = i;
+        }
+        return atoms;
+    }
+
+    dim::decomposition_parameters<double> make_params(
+        double box, unsigned gx, unsigned gy, unsigned gz, double halo)
+    {
+        dim::decomposition_parameters<double> params;
+        params.box = box_t{box, box, box};
+        params.grid[0] = gx;
+        params.grid[1] = gy;
+        params.grid[2] = gz;
+        params.halo_width = length_t{halo};
+        return params;
+    }
+
+    // Identifies a particle image by its id and its position rounded to a
+    // fine grid, so images compare equal regardless of summation order.
+    image_t image_key(std::uint64_t id, point_t const& p)
+    {
+        return image_t{id,
+            std::lround(p[0].value() * 1e6),
+            std::lround(p[1].value() * 1e6),
+            std::lround(p[2].value() * 1e6)};
+    }
+
+    // Periodic images of all particles lying within halo of the domain
+    // [lower, upper), except the particles owned by the domain itself.
+    std::vector<image_t> expected_ghosts(std::vector<atom> const& atoms,
+        point_t const& lower, point_t const& upper, double box, double halo)
+    {
+        std::vector<image_t> images;
+        for (atom const& a : atoms) {
+            for (int sx = -1; sx <= 1; ++sx) {
+                for (int sy = -1; sy <= 1; ++sy) {
+                    for (int sz = -1; sz <= 1; ++sz) {
+                        int const shift[3] = {sx, sy, sz};
+                        point_t image = a.position;
+                        bool inside = true;
+                        bool owned = sx == 0 && sy == 0 && sz == 0;
+                        for (unsigned k = 0; k < 3; ++k) {
+                            double const x = a.position[k].value() + shift[k] * box;
+                            image[k] = length_t{x};
+                            inside = inside && x >= lower[k].value() - halo && x < upper[k].value() + halo;
+                            owned = owned && x >= lower[k].value() && x < upper[k].value();
+                        }
+                        if (inside && !owned) {
+                            images.push_back(image_key(a.id, image));
+                        }
+                    }
+                }
+            }
+        }
+        std::sort(images.begin(), images.end());
+        return images;
+    }
+
+    std::vector<image_t> ghost_keys(std::vector<atom> const& ghosts)
+    {
+        std::vector<image_t> keys;
+        for (atom const& g : ghosts) {
+            keys.push_back(image_key(g.id, g.position));
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    struct rank_result
+    {
+        point_t lower;
+        point_t upper;
+        std::vector<atom> owned;
+        std::vector<atom> ghosts;
+    };
+}
+
+TEST_CASE("shared_memory_transport - delivers messages in order")
+{
+    std::vector<std::vector<int>> received(3);
+    std::vector<std::vector<double>> gathered(3);
+
+    dim::run_shared_memory(3, [&](dim::transport& comm) {
+        int const next = (comm.rank() + 1) % comm.size();
+        int const prev = (comm.rank() + comm.size() - 1) % comm.size();
+
+        for (unsigned char value = 1; value <= 3; ++value) {
+            comm.send(next, 7, dim::transport::message{value, static_cast<unsigned char>(comm.rank())});
+        }
+        comm.send(comm.rank(), 9, dim::transport::message{42});
+
+        auto& mine = received[std::size_t(comm.rank())];
+        mine.push_back(comm.receive(comm.rank(), 9).at(0));
+        for (int i = 0; i < 3; ++i) {
+            dim::transport::message const data = comm.receive(prev, 7);
+            mine.push_back(data.at(0));
+            mine.push_back(data.at(1));
+        }
+        gathered[std::size_t(comm.rank())] = comm.all_gather(1.5 * comm.rank());
+    });
+
+    for (int rank = 0; rank < 3; ++rank) {
+        int const prev = (rank + 2) % 3;
+        CHECK(received[std::size_t(rank)] == std::vector<int>{42, 1, prev, 2, prev, 3, prev});
+        CHECK(gathered[std::size_t(rank)] == std::vector<double>{0.0, 1.5, 3.0});
+    }
+}
+
+TEST_CASE("run_shared_memory - rethrows the first failure and unblocks other ranks")
+{
+    auto const failing = [](dim::transport& comm) {
+        if (comm.rank() == 1) {
+            throw std::logic_error("rank failed");
+        }
+        comm.receive(1, 0);
+    };
+    CHECK_THROWS_AS(dim::run_shared_memory(2, failing), std::logic_error);
+}
+
+TEST_CASE("domain_decomposition - rejects invalid parameters")
+{
+    dim::shared_memory_hub hub{2};
+    dim::shared_memory_transport comm{hub, 0};
+
+    CHECK_THROWS_AS(domain_t(comm, make_params(10, 1, 1, 1, 1)), std::invalid_argument);
+    CHECK_THROWS_AS(domain_t(comm, make_params(10, 2, 0, 1, 1)), std::invalid_argument);
+    CHECK_THROWS_AS(domain_t(comm, make_params(10, 2, 1, 1, 0)), std::invalid_argument);
+    CHECK_THROWS_AS(domain_t(comm, make_params(10, 2, 1, 1, 6)), std::invalid_argument);
+    CHECK_THROWS_AS(dim::shared_memory_transport(hub, 2), std::invalid_argument);
+
+    domain_t const domain(comm, make_params(10, 2, 1, 1, 5));
+    CHECK(domain.lower()[0].value() == 0);
+    CHECK(domain.upper()[0].value() == 5);
+    CHECK(domain.upper()[1].value() == 10);
+}
+
+TEST_CASE("domain_decomposition - exchange_halo finds every periodic image within the halo")
+{
+    double const box = 10;
+    double const halo = 2.5;
+    double const extent[3] = {box, box, box};
+    std::vector<atom> const atoms = random_atoms(600, extent, 1);
+
+    unsigned const grids[][3] = {{1, 1, 1}, {2, 1, 1}, {3, 1, 1}, {2, 2, 1}, {2, 2, 2}, {1, 3, 2}};
+
+    for (auto const& grid : grids) {
+        int const size = int(grid[0] * grid[1] * grid[2]);
+        std::vector<rank_result> results(static_cast<std::size_t>(size));
+
+        dim::run_shared_memory(size, [&](dim::transport& comm) {
+            auto domain = dim::make_domain_decomposition<atom>(
+                comm, make_params(box, grid[0], grid[1], grid[2], halo));
+            domain.distribute(atoms);
+            domain.exchange_halo();
+
+            rank_result& result = results[std::size_t(comm.rank())];
+            result.lower = domain.lower();
+            result.upper = domain.upper();
+            result.owned = domain.particles();
+            result.ghosts = domain.ghosts();
+        });
+
+        std::size_t owned = 0;
+        for (rank_result const& result : results) {
+            owned += result.owned.size();
+            CHECK(ghost_keys(result.ghosts) == expected_ghosts(atoms, result.lower, result.upper, box, halo));
+        }
+        CHECK(owned == atoms.size());
+    }
+}
+
+TEST_CASE("domain_decomposition - update_halo and reduce_halo move dimensioned arrays")
+{
+    double const box = 12;
+    double const halo = 3;
+    double const extent[3] = {box, box, box};
+    std::vector<atom> const atoms = random_atoms(500, extent, 2);
+    int const size = 4;
+
+    std::vector<rank_result> results(size);
+    std::vector<std::vector<force_t>> forwarded(size);
+    std::vector<std::vector<force_t>> reduced(size);
+
+    dim::run_shared_memory(size, [&](dim::transport& comm) {
+        auto domain = dim::make_domain_decomposition<atom>(comm, make_params(box, 2, 1, 2, halo));
+        domain.distribute(atoms);
+        domain.exchange_halo();
+
+        std::size_t const r = std::size_t(comm.rank());
+        std::size_t const owned = domain.particles().size();
+
+        std::vector<force_t> values;
+        for (atom const& a : domain.particles()) {
+            values.push_back(force_t{double(a.id), 1.0, 0.0});
+        }
+        domain.update_halo(values);
+        forwarded[r] = values;
+
+        std::vector<force_t> counts(owned + domain.ghosts().size(), force_t{0, 0, 0});
+        for (std::size_t i = owned; i < counts.size(); ++i) {
+            counts[i] = force_t{1, 0, 0};
+        }
+        domain.reduce_halo(counts);
+        counts.resize(owned);
+        reduced[r] = counts;
+
+        results[r].owned = domain.particles();
+        results[r].ghosts = domain.ghosts();
+    });
+
+    std::vector<int> copies(atoms.size(), 0);
+    for (rank_result const& result : results) {
+        for (atom const& g : result.ghosts) {
+            copies[g.id]++;
+        }
+    }
+
+    for (std::size_t r = 0; r < std::size_t(size); ++r) {
+        rank_result const& result = results[r];
+        REQUIRE(forwarded[r].size() == result.owned.size() + result.ghosts.size());
+        for (std::size_t i = 0; i < result.ghosts.size(); ++i) {
+            force_t const& value = forwarded[r][result.owned.size() + i];
+            CHECK(value[0].value() == double(result.ghosts[i].id));
+            CHECK(value[1].value() == 1.0);
+        }
+        for (std::size_t i = 0; i < result.owned.size(); ++i) {
+            CHECK(reduced[r][i][0].value() == copies[result.owned[i].id]);
+        }
+    }
+}
+
+TEST_CASE("domain_decomposition - refresh_ghosts follows owners without changing the ghost set")
+{
+    double const box = 10;
+    double const extent[3] = {box, box, box};
+    std::vector<atom> const atoms = random_atoms(300, extent, 3);
+    int const size = 2;
+
+    std::vector<std::vector<atom>> before(size);
+    std::vector<std::vector<atom>> after(size);
+
+    dim::run_shared_memory(size, [&](dim::transport& comm) {
+        auto domain = dim::make_domain_decomposition<atom>(comm, make_params(box, 2, 1, 1, 2));
+        domain.distribute(atoms);
+        domain.exchange_halo();
+        before[std::size_t(comm.rank())] = domain.ghosts();
+
+        for (atom& a : domain.particles()) {
+            a.position[1] += length_t{0.25};
+        }
+        domain.refresh_ghosts();
+        after[std::size_t(comm.rank())] = domain.ghosts();
+    });
+
+    for (int r = 0; r < size; ++r) {
+        REQUIRE(before[std::size_t(r)].size() == after[std::size_t(r)].size());
+        for (std::size_t i = 0; i < before[std::size_t(r)].size(); ++i) {
+            atom const& old = before[std::size_t(r)][i];
+            atom const& now = after[std::size_t(r)][i];
+            CHECK(now.id == old.id);
+            CHECK(now.position[0].value() == old.position[0].value());
+            CHECK(now.position[1].value() == doctest::Approx(old.position[1].value() + 0.25));
+        }
+    }
+}
+
+TEST_CASE("domain_decomposition - migrate hands particles to their new domains")
+{
+    double const box = 10;
+    double const extent[3] = {box, box, box};
+    std::vector<atom> const atoms = random_atoms(800, extent, 4);
+    int const size = 8;
+
+    std::vector<rank_result> results(size);
+
+    dim::run_shared_memory(size, [&](dim::transport& comm) {
+        auto domain = dim::make_domain_decomposition<atom>(comm, make_params(box, 2, 2, 2, 2));
+        domain.distribute(atoms);
+
+        std::mt19937 engine(unsigned(comm.rank()) + 10);
+        std::uniform_real_distribution<double> step(-2, 2);
+        for (int round = 0; round < 3; ++round) {
+            for (atom& a : domain.particles()) {
+                for (unsigned k = 0; k < 3; ++k) {
+                    a.position[k] += length_t{step(engine)};
+                }
+            }
+            domain.migrate();
+        }
+
+        rank_result& result = results[std::size_t(comm.rank())];
+        result.lower = domain.lower();
+        result.upper = domain.upper();
+        result.owned = domain.particles();
+    });
+
+    std::vector<int> seen(atoms.size(), 0);
+    for (rank_result const& result : results) {
+        for (atom const& a : result.owned) {
+            seen[a.id]++;
+            for (unsigned k = 0; k < 3; ++k) {
+                CHECK(a.position[k] >= result.lower[k]);
+                CHECK(a.position[k] < result.upper[k]);
+            }
+        }
+    }
+    CHECK(std::count(seen.begin(), seen.end(), 1) == long(atoms.size()));
+
+    CHECK_THROWS_AS(dim::run_shared_memory(4, [&](dim::transport& comm) {
+        auto domain = dim::make_domain_decomposition<atom>(comm, make_params(box, 4, 1, 1, 1));
+        domain.distribute(atoms);
+        std::vector<atom> far = domain.particles();
+        domain.particles().clear();
+        for (atom a : far) {
+            a.position[0] += length_t{box / 2};
+            domain.particles().push_back(a);
+        }
+        domain.migrate();
+    }), std::runtime_error);
+}
+
+TEST_CASE("domain_decomposition - balance evens out the load across slabs")
+{
+    double const box = 20;
+    double const dense[3] = {box / 4, box, box};
+    double const sparse[3] = {box, box, box};
+
+    std::vector<atom> atoms = random_atoms(900, dense, 5);
+    std::vector<atom> const rest = random_atoms(100, sparse, 6);
+    for (atom a : rest) {
+        a.id += atoms.size();
+        atoms.push_back(a);
+    }
+
+    int const size = 4;
+    double const halo = 1;
+    std::vector<std::size_t> initial(size);
+    std::vector<std::size_t> final(size);
+    std::vector<std::vector<double>> cuts(size);
+
+    dim::run_shared_memory(size, [&](dim::transport& comm) {
+        auto domain = dim::make_domain_decomposition<atom>(comm, make_params(box, 4, 1, 1, halo));
+        domain.distribute(atoms);
+        initial[std::size_t(comm.rank())] = domain.particles().size();
+
+        for (int round = 0; round < 30; ++round) {
+            // Cost proportional to the number of owned particles.
+            domain.balance(time_t_{1e-3 * double(domain.particles().size())});
+        }
+        final[std::size_t(comm.rank())] = domain.particles().size();
+        cuts[std::size_t(comm.rank())] = domain.boundaries(0);
+    });
+
+    std::size_t const mean = atoms.size() / size;
+    CHECK(*std::max_element(initial.begin(), initial.end()) > 3 * mean);
+    CHECK(*std::max_element(final.begin(), final.end()) < mean * 5 / 4);
+
+    std::size_t total = 0;
+    for (int r = 0; r < size; ++r) {
+        total += final[std::size_t(r)];
+        CHECK(cuts[std::size_t(r)] == cuts[0]);
+    }
+    CHECK(total == atoms.size());
+    for (std::size_t s = 0; s + 1 < cuts[0].size(); ++s) {
+        CHECK(cuts[0][s + 1] - cuts[0][s] >= halo);
+    }
+}
@@ -0,0 +1,136 @@
+#include <cmath>
+#include <type_traits>
+
+#include <dim.hpp>
+#include <dim_dual.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using displacement_t = dim::vector<double, dim::mech::length, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+
+    // Lennard-Jones energy written once for any number type.
+    template<typename T>
+    dim::scalar<T, dim::mech::energy> lennard_jones(dim::vector<T, dim::mech::length, 3> const& r)
+    {
+        dim::scalar<T, dim::mech::energy> const epsilon{1.5};
+        dim::scalar<T, dim::mech::length> const sigma{1.1};
+        auto const s6 = dim::pow<6>(sigma / dim::norm(r));
+        return 4.0 * epsilon * (s6 * s6 - s6);
+    }
+}
+
+TEST_CASE("dual: is trivially copyable")
+{
+    CHECK((std::is_trivially_copyable<dim::dual<double, 3>>::value));
+}
+
+TEST_CASE("dual: propagates derivatives through arithmetic")
+{
+    using dual_t = dim::dual<double, 2>;
+    dual_t const x = dual_t::variable(3, 0);
+    dual_t const y = dual_t::variable(2, 1);
+
+    dual_t const f = x * x * y - x / y + 1.0 - 2.0 * (y - x);
+    CHECK(f.value() == doctest::Approx(3 * 3 * 2 - 1.5 + 1 - 2 * (2 - 3)));
+    CHECK(f.derivative(0) == doctest::Approx(2 * 3 * 2 - 1 / 2.0 + 2));
+    CHECK(f.derivative(1) == doctest::Approx(3 * 3 + 3 / 4.0 - 2));
+
+    dual_t const g = 1.0 / x;
+    CHECK(g.derivative(0) == doctest::Approx(-1 / 9.0));
+    CHECK(g.derivative(1) == 0);
+}
+
+TEST_CASE("dual: propagates derivatives through math functions")
+{
+    using dual_t = dim::dual<double>;
+    double const x0 = 1.7;
+    dual_t const x = dual_t::variable(x0, 0);
+
+    CHECK(sqrt(x).derivative(0) == doctest::Approx(0.5 / std::sqrt(x0)));
+    CHECK(cbrt(x).derivative(0) == doctest::Approx(1 / (3 * std::cbrt(x0 * x0))));
+    CHECK(pow(x, 3).derivative(0) == doctest::Approx(3 * x0 * x0));
+    CHECK(pow(x, -2).derivative(0) == doctest::Approx(-2 / (x0 * x0 * x0)));
+    CHECK(pow(x, 0).derivative(0) == 0);
+    CHECK(exp(x).derivative(0) == doctest::Approx(std::exp(x0)));
+    CHECK(log(x).derivative(0) == doctest::Approx(1 / x0));
+    CHECK(sin(x).derivative(0) == doctest::Approx(std::cos(x0)));
+    CHECK(cos(x).derivative(0) == doctest::Approx(-std::sin(x0)));
+    CHECK(fabs(-x).derivative(0) == doctest::Approx(1));
+    CHECK(hypot(x, 2.0 * x).derivative(0) == doctest::Approx(std::sqrt(5.0)));
+}
+
+TEST_CASE("dual: works through dim math functions")
+{
+    using dual_t = dim::dual<double>;
+    using dual_length_t = dim::scalar<dual_t, dim::mech::length>;
+
+    dual_length_t const x = dim::seed(length_t{2});
+    dual_length_t const y{3};
+
+    auto const area = dim::pow<2>(x);
+    auto const side = dim::sqrt(area);
+    auto const diagonal = dim::hypot(x, y);
+
+    CHECK(dim::derivative<dim::mech::length>(area).value() == doctest::Approx(4));
+    CHECK(dim::derivative<dim::mech::length>(side).value() == doctest::Approx(1));
+    CHECK(dim::derivative<dim::mech::length>(diagonal).value()
+        == doctest::Approx(2 / std::sqrt(13.0)));
+    CHECK(dim::primal(diagonal).value() == doctest::Approx(std::sqrt(13.0)));
+}
+
+TEST_CASE("gradient: has the dimension of the derivative")
+{
+    displacement_t const r{0.7, -0.4, 1.2};
+    auto const energy = lennard_jones(dim::seed(r));
+    auto const gradient = dim::gradient<dim::mech::length>(energy);
+
+    CHECK((std::is_same<decltype(gradient), force_t const>::value));
+    CHECK(dim::primal(energy).value() == doctest::Approx(lennard_jones(r).value()));
+}
+
+TEST_CASE("differentiate: matches the analytic Lennard-Jones force")
+{
+    displacement_t const r{0.7, -0.4, 1.2};
+    auto const result =
+        dim::differentiate([](dim::vector<dim::dual<double, 3>, dim::mech::length, 3> const& x) {
+            return lennard_jones(x);
+        }, r);
+
+    CHECK((std::is_same<decltype(result.value), energy_t>::value));
+    CHECK((std::is_same<decltype(result.gradient), force_t>::value));
+
+    double const epsilon = 1.5;
+    double const sigma = 1.1;
+    double const r2 = dim::squared_norm(r).value();
+    double const s6 = std::pow(sigma * sigma / r2, 3);
+    double const scale = 24 * epsilon * (2 * s6 * s6 - s6) / r2;
+    force_t const force = -result.gradient;
+
+    for (unsigned i = 0; i < 3; ++i) {
+        CHECK(force[i].value() == doctest::Approx(scale * r[i].value()));
+    }
+    CHECK(result.value.value() == doctest::Approx(4 * epsilon * (s6 * s6 - s6)));
+}
+
+TEST_CASE("differentiate: accepts points")
+{
+    using position_t = dim::point<double, dim::mech::length, 2>;
+    using dual_position_t = dim::point<dim::dual<double, 2>, dim::mech::length, 2>;
+
+    position_t const center{1, 1};
+    position_t const x{4, 5};
+    auto const result = dim::differentiate(
+        [&](dual_position_t const& p) {
+            dual_position_t const c{center[0].value(), center[1].value()};
+            return dim::distance(p, c);
+        },
+        x);
+
+    CHECK(result.value.value() == doctest::Approx(5));
+    CHECK(result.gradient[0].value() == doctest::Approx(0.6));
+    CHECK(result.gradient[1].value() == doctest::Approx(0.8));
+}
@@ -0,0 +1,220 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_arena.hpp>
+#include <dim_ensemble.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using mass_t = dim::scalar<double, dim::mech::mass>;
+    using time_t_ = dim::scalar<double, dim::mech::time>;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using vector_t = dim::vector<double, dim::mech::length, 3>;
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+    using stiffness_dim = dim::quotient_dimension_t<dim::mech::force, dim::mech::length>;
+    using stiffness_t = dim::scalar<double, stiffness_dim>;
+
+    constexpr unsigned width = 4;
+
+    using lengths_t = dim::ensemble_scalar<double, dim::mech::length, width>;
+    using points_t = dim::ensemble_point<double, dim::mech::length, 3, width>;
+    using vectors_t = dim::ensemble_vector<double, dim::mech::length, 3, width>;
+    using forces_t = dim::ensemble_vector<double, dim::mech::force, 3, width>;
+    using stiffnesses_t = dim::ensemble_scalar<double, stiffness_dim, width>;
+    using ensemble_t = dim::ensemble<double, width>;
+
+    point_t random_point(std::mt19937& engine)
+    {
+        std::uniform_real_distribution<double> coord(-2, 2);
+        return point_t{coord(engine), coord(engine), coord(engine)};
+    }
+}
+
+TEST_CASE("ensemble_scalar - lanes are independent and interleaved")
+{
+    lengths_t x{length_t{1.5}};
+    for (unsigned l = 0; l < width; ++l) {
+        CHECK(x.lane(l).value() == 1.5);
+    }
+    x.set_lane(2, length_t{-3});
+    CHECK(x.data()[2] == -3);
+    CHECK(x.data()[1] == 1.5);
+    CHECK(reinterpret_cast<std::size_t>(x.data()) % (width * sizeof(double)) == 0);
+
+    auto const area = x * x;
+    static_assert(std::is_same<decltype(area.lane(0)),
+        dim::scalar<double, dim::power_dimension_t<dim::mech::length, 2>>>::value, "");
+    CHECK(area.lane(2).value() == 9);
+    CHECK(sqrt(area).lane(2).value() == 3);
+    CHECK((x - x).lane(3).value() == 0);
+    CHECK((-x).lane(0).value() == -1.5);
+    CHECK((x / x).lane(1).value() == 1);
+}
+
+TEST_CASE("ensemble_vector - dot, norm, cross and differences match per-lane results")
+{
+    std::mt19937 engine{1};
+    points_t p;
+    points_t q;
+    std::vector<point_t> ps;
+    std::vector<point_t> qs;
+    for (unsigned l = 0; l < width; ++l) {
+        ps.push_back(random_point(engine));
+        qs.push_back(random_point(engine));
+        p.set_lane(l, ps.back());
+        q.set_lane(l, qs.back());
+    }
+
+    vectors_t const d = p - q;
+    vectors_t const e = q - points_t{point_t{0, 0, 0}};
+    auto const c = cross(d, e);
+    auto const dots = dot(d, e);
+    auto const norms = norm(d);
+    auto const squared = squared_distance(p, q);
+    auto const distances = distance(p, q);
+    points_t const moved = q + d;
+
+    for (unsigned l = 0; l < width; ++l) {
+        vector_t const dl = ps[l] - qs[l];
+        vector_t const el = qs[l] - point_t{0, 0, 0};
+        CHECK(d.lane(l) == dl);
+        CHECK(dots.lane(l).value() == doctest::Approx(dot(dl, el).value()));
+        CHECK(norms.lane(l).value() == doctest::Approx(norm(dl).value()));
+        CHECK(squared.lane(l).value() == doctest::Approx(squared_distance(ps[l], qs[l]).value()));
+        CHECK(distances.lane(l).value() == doctest::Approx(distance(ps[l], qs[l]).value()));
+        for (unsigned k = 0; k < 3; ++k) {
+            CHECK(c.lane(l)[k].value() == doctest::Approx(cross(dl, el)[k].value()));
+            CHECK(moved.lane(l)[k].value() == doctest::Approx(ps[l][k].value()));
+        }
+    }
+}
+
+TEST_CASE("ensemble - rejects an empty ensemble")
+{
+    CHECK_THROWS_AS(ensemble_t(0, 3), std::invalid_argument);
+
+    ensemble_t const system(9, 2);
+    CHECK(system.batches() == 3);
+    CHECK(system.mass(8, 1).value() == 1);
+    CHECK(system.position(5, 0) == point_t{0, 0, 0});
+}
+
+TEST_CASE("ensemble - lockstep velocity Verlet matches replicas integrated one by one")
+{
+    // Particles on springs to the origin with a stiffness per replica, plus
+    // a spring between particles 0 and 1.
+    std::size_t const replicas = 13;
+    std::size_t const particles = 3;
+    time_t_ const dt{0.01};
+    int const steps = 200;
+
+    std::mt19937 engine{2};
+    std::uniform_real_distribution<double> uniform(0.5, 2.0);
+
+    ensemble_t system(replicas, particles);
+    std::vector<stiffness_t> stiffness(replicas);
+    std::vector<std::vector<point_t>> positions(replicas);
+    std::vector<std::vector<velocity_t>> velocities(replicas);
+    std::vector<std::vector<mass_t>> masses(replicas);
+
+    for (std::size_t r = 0; r < replicas; ++r) {
+        stiffness[r] = stiffness_t{uniform(engine)};
+        for (std::size_t i = 0; i < particles; ++i) {
+            positions[r].push_back(random_point(engine));
+            velocities[r].push_back(velocity_t{uniform(engine), 0.0, -uniform(engine)});
+            masses[r].push_back(mass_t{uniform(engine)});
+            system.set_position(r, i, positions[r][i]);
+            system.set_velocity(r, i, velocities[r][i]);
+            system.set_mass(r, i, masses[r][i]);
+        }
+    }
+
+    std::vector<stiffnesses_t, dim::aligned_allocator<stiffnesses_t, 64>> batch_stiffness(system.batches());
+    for (std::size_t r = 0; r < replicas; ++r) {
+        batch_stiffness[r / width].set_lane(unsigned(r % width), stiffness[r]);
+    }
+
+    auto const ensemble_forces = [&](std::size_t batch, points_t const* p, forces_t* f, std::size_t n) {
+        stiffnesses_t const& k = batch_stiffness[batch];
+        points_t const origin;
+        for (std::size_t i = 0; i < n; ++i) {
+            f[i] = -k * (p[i] - origin);
+        }
+        forces_t const bond = k * (p[1] - p[0]);
+        f[0] += bond;
+        f[1] -= bond;
+    };
+
+    auto const replica_forces = [&](std::size_t r, std::vector<point_t> const& p) {
+        std::vector<force_t> f(particles);
+        for (std::size_t i = 0; i < particles; ++i) {
+            f[i] = -stiffness[r] * (p[i] - point_t{0, 0, 0});
+        }
+        force_t const bond = stiffness[r] * (p[1] - p[0]);
+        f[0] += bond;
+        f[1] -= bond;
+        return f;
+    };
+
+    system.step(dt, ensemble_forces, steps / 2);
+    system.step(dt, ensemble_forces, steps / 2);
+
+    for (std::size_t r = 0; r < replicas; ++r) {
+        std::vector<force_t> f = replica_forces(r, positions[r]);
+        for (int s = 0; s < steps; ++s) {
+            for (std::size_t i = 0; i < particles; ++i) {
+                velocities[r][i] += dt / 2 * (f[i] / masses[r][i]);
+                positions[r][i] += dt * velocities[r][i];
+            }
+            f = replica_forces(r, positions[r]);
+            for (std::size_t i = 0; i < particles; ++i) {
+                velocities[r][i] += dt / 2 * (f[i] / masses[r][i]);
+            }
+        }
+
+        for (std::size_t i = 0; i < particles; ++i) {
+            for (unsigned k = 0; k < 3; ++k) {
+                CHECK(system.position(r, i)[k].value() == doctest::Approx(positions[r][i][k].value()));
+                CHECK(system.velocity(r, i)[k].value() == doctest::Approx(velocities[r][i][k].value()));
+                CHECK(system.force(r, i)[k].value() == doctest::Approx(f[i][k].value()));
+            }
+        }
+    }
+}
+
+TEST_CASE("ensemble - padding lanes stay finite")
+{
+    // A pair potential diverges for coincident particles; the unused lanes
+    // of the last batch must not hold them.
+    ensemble_t system(5, 2);
+    for (std::size_t r = 0; r < 5; ++r) {
+        system.set_position(r, 1, point_t{1.0 + 0.1 * double(r), 0.0, 0.0});
+    }
+
+    using strength_dim = dim::product_dimension_t<dim::mech::force, dim::power_dimension_t<dim::mech::length, 2>>;
+    dim::scalar<double, strength_dim> const strength{0.1};
+    bool finite = true;
+
+    system.step(time_t_{0.01}, [&](std::size_t, points_t const* p, forces_t* f, std::size_t) {
+        vectors_t const d = p[1] - p[0];
+        auto const r = norm(d);
+        f[1] = strength * (d / (r * r * r));
+        f[0] = -strength * (d / (r * r * r));
+        for (unsigned l = 0; l < width; ++l) {
+            finite = finite && std::isfinite(f[1][0].lane(l).value());
+        }
+    }, 10);
+
+    CHECK(finite);
+    for (std::size_t r = 0; r < 5; ++r) {
+        CHECK(system.position(r, 1)[0] > system.position(r, 0)[0]);
+    }
+}
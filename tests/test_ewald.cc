@@ -0,0 +1,110 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_ewald.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using pme_t = dim::particle_mesh_ewald<double>;
+    using params_t = dim::ewald_parameters<double>;
+    using point_t = pme_t::point_type;
+    using charge_t = pme_t::charge_type;
+    using force_t = pme_t::force_type;
+    using length_t = pme_t::length_type;
+
+    params_t make_params(double box, double cutoff, unsigned mesh, unsigned order)
+    {
+        params_t params;
+        params.box = decltype(params.box){box, box, box};
+        params.cutoff = length_t{cutoff};
+        params.splitting = pme_t::splitting_for(params.cutoff, 1e-10);
+        params.coupling = decltype(params.coupling){1};
+        params.mesh[0] = params.mesh[1] = params.mesh[2] = mesh;
+        params.spline_order = order;
+        return params;
+    }
+}
+
+TEST_CASE("fft: transforms a power-of-two sequence")
+{
+    std::vector<std::complex<double>> data = {1, 2, 3, 4, 0, 0, 0, 0};
+    dim::fft(data.data(), data.size(), -1);
+    CHECK(std::abs(data[0] - std::complex<double>(10, 0)) < 1e-12);
+    CHECK(std::abs(data[4] - std::complex<double>(-2, 0)) < 1e-12);
+
+    dim::fft(data.data(), data.size(), +1);
+    CHECK(std::abs(data[0] / 8.0 - std::complex<double>(1, 0)) < 1e-12);
+    CHECK(std::abs(data[3] / 8.0 - std::complex<double>(4, 0)) < 1e-12);
+    CHECK(std::abs(data[5] / 8.0) < 1e-12);
+}
+
+TEST_CASE("particle_mesh_ewald: rejects invalid parameters")
+{
+    CHECK_NOTHROW(pme_t{make_params(4, 2, 16, 4)});
+    CHECK_THROWS_AS(pme_t{make_params(4, 2, 12, 4)}, std::invalid_argument);
+    CHECK_THROWS_AS(pme_t{make_params(4, 2, 16, 2)}, std::invalid_argument);
+    CHECK_THROWS_AS(pme_t{make_params(4, 2.5, 16, 4)}, std::invalid_argument);
+}
+
+TEST_CASE("particle_mesh_ewald: reproduces the Madelung constant of rock salt")
+{
+    std::vector<point_t> positions;
+    std::vector<charge_t> charges;
+    for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+            for (int z = 0; z < 4; ++z) {
+                positions.push_back(point_t{double(x), double(y), double(z)});
+                charges.push_back(charge_t{(x + y + z) % 2 == 0 ? 1.0 : -1.0});
+            }
+        }
+    }
+
+    pme_t pme{make_params(4, 2, 32, 8)};
+    std::vector<force_t> forces;
+    auto const energy = pme.compute(positions, charges, forces);
+
+    double const madelung = 1.747564594633182;
+    double const expected = -madelung * double(positions.size()) / 2;
+    CHECK(std::fabs(energy.total().value() / expected - 1) < 1e-6);
+    for (auto const& force : forces) {
+        CHECK(dim::norm(force).value() < 1e-6);
+    }
+}
+
+TEST_CASE("particle_mesh_ewald: forces are energy gradients")
+{
+    std::mt19937 random;
+    std::uniform_real_distribution<double> coord{0, 6};
+
+    std::vector<point_t> positions;
+    std::vector<charge_t> charges;
+    for (int i = 0; i < 40; ++i) {
+        positions.push_back(point_t{coord(random), coord(random), coord(random)});
+        charges.push_back(charge_t{i % 2 == 0 ? 1.0 : -1.0});
+    }
+
+    for (double const cutoff : {1.5, 2.5}) {
+        pme_t pme{make_params(6, cutoff, 16, 6)};
+        std::vector<force_t> forces;
+        pme.compute(positions, charges, forces);
+
+        double const h = 1e-6;
+        std::vector<force_t> dummy;
+        for (std::size_t i = 0; i < 5; ++i) {
+            for (unsigned k = 0; k < 3; ++k) {
+                auto moved = positions;
+                moved[i][k] += length_t{h};
+                double const forward = pme.compute(moved, charges, dummy).total().value();
+                moved[i][k] -= length_t{2 * h};
+                double const backward = pme.compute(moved, charges, dummy).total().value();
+                double const expected = -(forward - backward) / (2 * h);
+                CHECK(std::fabs(forces[i][k].value() - expected) < 1e-5);
+            }
+        }
+    }
+}
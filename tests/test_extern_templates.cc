@@ -0,0 +1,50 @@
+// This translation unit declares the common quantity types extern, so the
+// members it calls must link against the explicit instantiations provided by
+// test_instantiation.cc.
+#define DIM_EXTERN_TEMPLATES
+
+#include <dim.hpp>
+#include <doctest.h>
+
+namespace
+{
+    template<typename D>
+    void check_quantity()
+    {
+        using scalar_t = dim::scalar<double, D>;
+        using vector_t = dim::vector<double, D, 3>;
+
+        scalar_t s{2};
+        s += scalar_t{1};
+        s *= 2;
+        CHECK(s.value() == 6);
+
+        vector_t v{scalar_t{1}, scalar_t{2}, scalar_t{3}};
+        v += vector_t{scalar_t{1}, scalar_t{1}, scalar_t{1}};
+        v *= 2;
+        CHECK(v[0].value() == 4);
+        CHECK(v[2].value() == 8);
+    }
+}
+
+TEST_CASE("DIM_EXTERN_TEMPLATES: links against the instantiated quantity types")
+{
+    check_quantity<dim::mech::number>();
+    check_quantity<dim::mech::length>();
+    check_quantity<dim::mech::mass>();
+    check_quantity<dim::mech::time>();
+    check_quantity<dim::mech::speed>();
+    check_quantity<dim::mech::acceleration>();
+    check_quantity<dim::mech::momentum>();
+    check_quantity<dim::mech::force>();
+    check_quantity<dim::mech::energy>();
+    check_quantity<dim::elec::charge>();
+
+    using position_t = dim::point<double, dim::mech::length, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    position_t x{1, 2, 3};
+    x += dim::vector<double, dim::mech::length, 3>{length_t{1}, length_t{1}, length_t{1}};
+    CHECK(x[1].value() == 3);
+    CHECK(x[2].value() == 4);
+}
@@ -0,0 +1,123 @@
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_geometry.hpp>
+#include <doctest.h>
+
+TEST_CASE("box: provides extent, center and containment test")
+{
+    using box_t = dim::box<double, dim::mech::length, 2>;
+    using point_t = dim::point<double, dim::mech::length, 2>;
+    using displace_t = dim::vector<double, dim::mech::length, 2>;
+
+    box_t const box{point_t{1, 2}, point_t{5, 4}};
+    CHECK(box.extent() == displace_t{4, 2});
+    CHECK(box.center() == point_t{3, 3});
+    CHECK(box.contains(point_t{1, 4}));
+    CHECK(box.contains(point_t{2, 3}));
+    CHECK_FALSE(box.contains(point_t{0, 3}));
+    CHECK_FALSE(box.contains(point_t{2, 5}));
+}
+
+TEST_CASE("bounding_box: computes the tightest box")
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using box_t = dim::box<double, dim::mech::length, 3>;
+
+    std::vector<point_t> const points = {
+        point_t{1, -2, 3},
+        point_t{-4, 5, 6},
+        point_t{7, 8, -9},
+    };
+    CHECK(dim::bounding_box(points) == box_t{point_t{-4, -2, -9}, point_t{7, 8, 6}});
+}
+
+TEST_CASE("bounding_box: handles large arrays split among threads")
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using box_t = dim::box<double, dim::mech::length, 3>;
+
+    std::vector<point_t> points;
+    for (int i = 0; i < 100000; ++i) {
+        points.push_back(point_t{double(i % 7), double(-(i % 11)), double(i % 100)});
+    }
+    points[54321] = point_t{-1, 1, 1000};
+    CHECK(dim::bounding_box(points) == box_t{point_t{-1, -10, 0}, point_t{6, 1, 1000}});
+}
+
+TEST_CASE("centroid: computes the mean point")
+{
+    using point_t = dim::point<double, dim::mech::length, 2>;
+
+    std::vector<point_t> const points = {
+        point_t{1, 2},
+        point_t{3, 6},
+        point_t{5, 4},
+        point_t{7, 0},
+    };
+    CHECK(dim::centroid(points) == point_t{4, 3});
+}
+
+TEST_CASE("radius_of_gyration: computes the RMS distance from the centroid")
+{
+    using point_t = dim::point<double, dim::mech::length, 2>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    std::vector<point_t> const points = {
+        point_t{10, 13},
+        point_t{16, 13},
+        point_t{13, 10},
+        point_t{13, 16},
+    };
+    CHECK(dim::radius_of_gyration(points) == length_t{3});
+}
+
+TEST_CASE("center_of_mass: computes the mass-weighted mean point")
+{
+    using point_t = dim::point<double, dim::mech::length, 2>;
+    using mass_t = dim::scalar<double, dim::mech::mass>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    std::vector<point_t> const points = {point_t{0, 0}, point_t{4, 8}};
+    std::vector<mass_t> const masses = {mass_t{3}, mass_t{1}};
+    CHECK(dim::center_of_mass(points, masses) == point_t{1, 2});
+
+    std::vector<point_t> const rod = {point_t{0, 0}, point_t{0, 4}};
+    std::vector<mass_t> const rod_masses = {mass_t{1}, mass_t{1}};
+    CHECK(dim::radius_of_gyration(rod, rod_masses) == length_t{2});
+}
+
+TEST_CASE("compute_statistics: agrees with the individual functions")
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+
+    std::vector<point_t> points;
+    for (int i = 0; i < 50000; ++i) {
+        points.push_back(point_t{double(i % 13), i % 17 * 0.5, double(-(i % 19))});
+    }
+
+    auto const stats = dim::compute_statistics(points);
+    CHECK(stats.bounds == dim::bounding_box(points));
+    CHECK(stats.centroid == dim::centroid(points));
+    CHECK(stats.radius_of_gyration == dim::radius_of_gyration(points));
+}
+
+TEST_CASE("compute_statistics: rejects empty arrays and mismatched masses")
+{
+    using point_t = dim::point<double, dim::mech::length, 2>;
+    using mass_t = dim::scalar<double, dim::mech::mass>;
+
+    std::vector<point_t> const empty;
+    CHECK_THROWS_AS(dim::compute_statistics(empty), std::invalid_argument);
+    CHECK_THROWS_AS(dim::bounding_box(empty), std::invalid_argument);
+    CHECK_THROWS_AS(dim::centroid(empty), std::invalid_argument);
+    CHECK_THROWS_AS(dim::radius_of_gyration(empty), std::invalid_argument);
+    CHECK_THROWS_AS(dim::center_of_mass(empty, std::vector<mass_t>{}), std::invalid_argument);
+
+    std::vector<point_t> const points = {point_t{0, 0}, point_t{4, 8}};
+    std::vector<mass_t> const masses = {mass_t{3}};
+    CHECK_THROWS_AS(dim::center_of_mass(points, masses), std::invalid_argument);
+    CHECK_THROWS_AS(dim::radius_of_gyration(points, masses), std::invalid_argument);
+}
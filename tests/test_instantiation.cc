@@ -0,0 +1,33 @@
+// This translation unit provides the explicit instantiations of common
+// quantity types, so all their members must compile.
+#define DIM_INSTANTIATE_TEMPLATES
+
+#include <type_traits>
+
+#include <dim.hpp>
+#include <doctest.h>
+
+TEST_CASE("DIM_INSTANTIATE_TEMPLATES: instantiates common quantity types")
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using number_t = dim::scalar<double, dim::mech::number>;
+    using time_t_ = dim::scalar<double, dim::mech::time>;
+    using position_t = dim::point<double, dim::mech::length, 3>;
+    using force_t = dim::vector<double, dim::mech::force, 3>;
+
+    CHECK((std::is_trivially_copyable<length_t>::value));
+    CHECK_FALSE((std::is_convertible<double, length_t>::value));
+    CHECK_FALSE((std::is_convertible<length_t, double>::value));
+    CHECK((std::is_convertible<double, number_t>::value));
+    CHECK((std::is_convertible<number_t, double>::value));
+    CHECK_FALSE((std::is_constructible<length_t, time_t_>::value));
+    CHECK_FALSE((std::is_constructible<number_t, time_t_>::value));
+    CHECK_FALSE((std::is_constructible<double, time_t_>::value));
+    CHECK_FALSE((std::is_default_constructible<dim::detail::disabled_constructor<double>>::value));
+
+    position_t x{1, 2, 3};
+    x += dim::vector<double, dim::mech::length, 3>{1, 1, 1};
+    force_t const f{0, 0, 2};
+    CHECK(x == position_t{2, 3, 4});
+    CHECK(dim::norm(f).value() == 2);
+}
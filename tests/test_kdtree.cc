@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_kdtree.hpp>
+#include <doctest.h>
+
+namespace
+{
+    template<unsigned N>
+    std::vector<dim::point<double, dim::mech::length, N>> random_points(std::size_t count)
+    {
+        std::mt19937 random;
+        std::uniform_real_distribution<double> coord{-1, 1};
+        std::vector<dim::point<double, dim::mech::length, N>> points(count);
+        for (auto& point : points) {
+            for (unsigned k = 0; k < N; ++k) {
+                point[k] = dim::scalar<double, dim::mech::length>{coord(random)};
+            }
+        }
+        return points;
+    }
+}
+
+TEST_CASE("kdtree: finds k nearest neighbors in ascending order")
+{
+    using point_t = dim::point<double, dim::mech::length, 2>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    std::vector<point_t> const points = {
+        point_t{0, 0},
+        point_t{3, 0},
+        point_t{0, 1},
+        point_t{5, 5},
+        point_t{-2, 0},
+    };
+    dim::kdtree<double, dim::mech::length, 2> const tree{points};
+    CHECK(tree.size() == 5);
+
+    auto const result = tree.knn(point_t{0, 0}, 3);
+    CHECK(result.size() == 3);
+    CHECK(result[0].index == 0);
+    CHECK(result[0].distance == length_t{0});
+    CHECK(result[1].index == 2);
+    CHECK(result[1].distance == length_t{1});
+    CHECK(result[2].index == 4);
+    CHECK(result[2].distance == length_t{2});
+
+    CHECK(tree.knn(point_t{0, 0}, 10).size() == 5);
+}
+
+TEST_CASE("kdtree: finds points within radius")
+{
+    using point_t = dim::point<double, dim::mech::length, 2>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    std::vector<point_t> const points = {
+        point_t{0, 0},
+        point_t{3, 4},
+        point_t{1, 1},
+        point_t{6, 8},
+    };
+    dim::kdtree<double, dim::mech::length, 2> const tree{points};
+
+    auto result = tree.radius_query(point_t{0, 0}, length_t{5});
+    std::sort(result.begin(), result.end(), [](decltype(result[0]) a, decltype(result[0]) b) {
+        return a.index < b.index;
+    });
+    CHECK(result.size() == 3);
+    CHECK(result[0].index == 0);
+    CHECK(result[1].index == 1);
+    CHECK(result[1].distance == length_t{5});
+    CHECK(result[2].index == 2);
+}
+
+TEST_CASE("kdtree: agrees with brute-force search")
+{
+    using tree_t = dim::kdtree<double, dim::mech::length, 4>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    auto const points = random_points<4>(3000);
+    auto const queries = random_points<4>(50);
+    tree_t const tree{points};
+
+    std::size_t const k = 7;
+    std::vector<tree_t::neighbor> batch(queries.size() * k);
+    tree.knn(queries.data(), queries.size(), k, batch.data());
+
+    tree_t::workspace work;
+    std::vector<tree_t::neighbor> found;
+
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        std::vector<length_t> distances;
+        for (auto const& point : points) {
+            distances.push_back(dim::distance(queries[q], point));
+        }
+        std::sort(distances.begin(), distances.end());
+
+        tree.knn(queries[q], k, work, found);
+        CHECK(found.size() == k);
+        for (std::size_t j = 0; j < k; ++j) {
+            CHECK(found[j].distance == distances[j]);
+            CHECK(batch[q * k + j].index == found[j].index);
+        }
+
+        length_t const radius{0.5};
+        auto const inside = std::upper_bound(distances.begin(), distances.end(), radius);
+        tree.radius_query(queries[q], radius, work, found);
+        CHECK(found.size() == std::size_t(inside - distances.begin()));
+    }
+}
+
+TEST_CASE("kdtree: runs batched radius queries")
+{
+    using tree_t = dim::kdtree<double, dim::mech::length, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+
+    auto const points = random_points<3>(1000);
+    tree_t const tree{points};
+
+    std::vector<std::size_t> counts(points.size());
+    tree.radius_query(points.data(), points.size(), length_t{0.2},
+        [&](std::size_t i, tree_t::neighbor const*, std::size_t n) { counts[i] = n; });
+
+    for (std::size_t i = 0; i < points.size(); i += 97) {
+        CHECK(counts[i] == tree.radius_query(points[i], length_t{0.2}).size());
+        CHECK(counts[i] >= 1);
+    }
+}
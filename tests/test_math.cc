@@ -0,0 +1,183 @@
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_math.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using number_t = dim::scalar<double, dim::mech::number>;
+
+    // Distance between a and b in units in the last place of b.
+    double ulp_error(double a, double b)
+    {
+        if (a == b) {
+            return 0;
+        }
+        double const ulp = std::nextafter(std::fabs(b), HUGE_VAL) - std::fabs(b);
+        return std::fabs(a - b) / ulp;
+    }
+
+    std::vector<number_t> make_grid(double lower, double upper, std::size_t count)
+    {
+        std::vector<number_t> grid;
+        for (std::size_t i = 0; i < count; ++i) {
+            grid.push_back(number_t{lower + (upper - lower) * double(i) / double(count - 1)});
+        }
+        return grid;
+    }
+
+    template<typename Batch, typename Reference>
+    double max_ulp_error(std::vector<number_t> const& x, Batch batch, Reference reference)
+    {
+        std::vector<number_t> y(x.size());
+        batch(x.data(), y.data(), x.size());
+        double worst = 0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            worst = std::fmax(worst, ulp_error(y[i].value(), reference(x[i].value())));
+        }
+        return worst;
+    }
+
+    template<typename Batch, typename Reference>
+    double max_relative_error(std::vector<number_t> const& x, Batch batch, Reference reference)
+    {
+        std::vector<number_t> y(x.size());
+        batch(x.data(), y.data(), x.size());
+        double worst = 0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            double const expected = reference(x[i].value());
+            worst = std::fmax(worst, std::fabs(y[i].value() - expected) / std::fabs(expected));
+        }
+        return worst;
+    }
+}
+
+TEST_CASE("exp: single scalars use the standard library")
+{
+    number_t const x{0.3};
+    CHECK((std::is_same<decltype(dim::exp(x)), number_t>::value));
+    CHECK(dim::exp(x).value() == std::exp(0.3));
+    CHECK(dim::log(x).value() == std::log(0.3));
+    CHECK(dim::erfc(x).value() == std::erfc(0.3));
+    CHECK(dim::tanh(x).value() == std::tanh(0.3));
+}
+
+TEST_CASE("exp: accurate batch is within documented ulp bounds")
+{
+    auto const exp = [](number_t const* x, number_t* y, std::size_t n) { dim::exp(x, y, n); };
+    auto const log = [](number_t const* x, number_t* y, std::size_t n) { dim::log(x, y, n); };
+    auto const tanh = [](number_t const* x, number_t* y, std::size_t n) { dim::tanh(x, y, n); };
+    auto const erfc = [](number_t const* x, number_t* y, std::size_t n) { dim::erfc(x, y, n); };
+
+    // The standard library itself may be off by up to one ulp.
+    CHECK(max_ulp_error(make_grid(-700, 700, 10001), exp, [](double v) { return std::exp(v); })
+        <= 2);
+    CHECK(max_ulp_error(make_grid(-1, 1, 10001), exp, [](double v) { return std::exp(v); }) <= 2);
+    CHECK(max_ulp_error(make_grid(1e-300, 1e3, 10001), log, [](double v) { return std::log(v); })
+        <= 4);
+    CHECK(max_ulp_error(make_grid(0.5, 2, 10001), log, [](double v) { return std::log(v); }) <= 4);
+    CHECK(max_ulp_error(make_grid(-20, 20, 10001), tanh, [](double v) { return std::tanh(v); })
+        <= 5);
+    CHECK(max_ulp_error(make_grid(-6, 26, 10001), erfc, [](double v) { return std::erfc(v); })
+        <= 9);
+    // Subnormal results down to the point where erfc rounds to zero.
+    CHECK(max_ulp_error(make_grid(26, 28, 10001), erfc, [](double v) { return std::erfc(v); })
+        <= 9);
+}
+
+TEST_CASE("exp: fast batch is within documented relative error")
+{
+    auto const exp = [](number_t const* x, number_t* y, std::size_t n) {
+        dim::fast::exp(x, y, n);
+    };
+    auto const log = [](number_t const* x, number_t* y, std::size_t n) {
+        dim::fast::log(x, y, n);
+    };
+    auto const tanh = [](number_t const* x, number_t* y, std::size_t n) {
+        dim::fast::tanh(x, y, n);
+    };
+    auto const erfc = [](number_t const* x, number_t* y, std::size_t n) {
+        dim::fast::erfc(x, y, n);
+    };
+
+    CHECK(max_relative_error(make_grid(-700, 700, 10001), exp,
+              [](double v) { return std::exp(v); })
+        <= 2e-7);
+    CHECK(max_relative_error(make_grid(0.01, 1e3, 10001), log,
+              [](double v) { return std::log(v); })
+        <= 1e-7);
+    CHECK(max_relative_error(make_grid(-20, 20, 10000), tanh,
+              [](double v) { return std::tanh(v); })
+        <= 5e-7);
+    CHECK(max_relative_error(make_grid(-6, 9, 10001), erfc,
+              [](double v) { return std::erfc(v); })
+        <= 3e-7);
+
+    CHECK(dim::fast::exp(number_t{1}).value() == doctest::Approx(std::exp(1.0)));
+    CHECK(dim::fast::erfc(number_t{1}).value() == doctest::Approx(std::erfc(1.0)));
+}
+
+TEST_CASE("exp: batch functions handle special values")
+{
+    double const inf = std::numeric_limits<double>::infinity();
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<number_t> const x = {
+        number_t{0}, number_t{-1}, number_t{inf}, number_t{-inf}, number_t{nan},
+        number_t{1000}, number_t{-1000}, number_t{4.9e-324}};
+    std::vector<number_t> y;
+
+    dim::exp(x, y);
+    CHECK(y[0].value() == 1);
+    CHECK(y[2].value() == inf);
+    CHECK(y[3].value() == 0);
+    CHECK(std::isnan(y[4].value()));
+    CHECK(y[5].value() == inf);
+    CHECK(y[6].value() == 0);
+
+    dim::log(x, y);
+    CHECK(y[0].value() == -inf);
+    CHECK(std::isnan(y[1].value()));
+    CHECK(y[2].value() == inf);
+    CHECK(std::isnan(y[3].value()));
+    CHECK(std::isnan(y[4].value()));
+    CHECK(y[7].value() == doctest::Approx(std::log(4.9e-324)));
+
+    dim::tanh(x, y);
+    CHECK(y[2].value() == 1);
+    CHECK(y[3].value() == -1);
+    CHECK(std::isnan(y[4].value()));
+    CHECK(y[7].value() == 4.9e-324);
+
+    dim::erfc(x, y);
+    CHECK(y[0].value() == 1);
+    CHECK(y[2].value() == 0);
+    CHECK(y[3].value() == 2);
+    CHECK(std::isnan(y[4].value()));
+}
+
+TEST_CASE("exp: batch functions work in place on any length and on floats")
+{
+    for (std::size_t count = 0; count < 10; ++count) {
+        std::vector<number_t> x = make_grid(-2, 2, count + 1);
+        x.resize(count);
+        std::vector<number_t> const original = x;
+        dim::exp(x.data(), x.data(), count);
+        for (std::size_t i = 0; i < count; ++i) {
+            CHECK(x[i].value() == doctest::Approx(std::exp(original[i].value())));
+        }
+    }
+
+    using single_t = dim::scalar<float, dim::mech::number>;
+    std::vector<single_t> const x = {single_t{0.5f}, single_t{-3}, single_t{2}, single_t{7},
+        single_t{0.25f}};
+    std::vector<single_t> y;
+    dim::erfc(x, y);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        CHECK(y[i].value() == doctest::Approx(std::erfc(x[i].value())).epsilon(1e-6));
+    }
+}
@@ -0,0 +1,198 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_monte_carlo.hpp>
+#include <doctest.h>
+
+#include "random_points.hpp"
+
+namespace
+{
+    using dim_test::random_points;
+    using params_t = dim::monte_carlo_parameters<double>;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using area_t = dim::scalar<double, dim::power_dimension_t<dim::mech::length, 2>>;
+
+    // Soft repulsion eps (1 - r^2 / rc^2)^2 vanishing smoothly at rc = 1.
+    struct soft_sphere
+    {
+        energy_t operator()(area_t r2) const
+        {
+            double const s = 1 - r2.value();
+            return energy_t{s * s};
+        }
+    };
+
+    struct no_interaction
+    {
+        energy_t operator()(area_t) const
+        {
+            return energy_t{0};
+        }
+    };
+
+    params_t make_params(double box, double cutoff, double step, double kT)
+    {
+        params_t params;
+        params.box = decltype(params.box){box, box, box};
+        params.cutoff = length_t{cutoff};
+        params.max_step = length_t{step};
+        params.thermal_energy = energy_t{kT};
+        return params;
+    }
+
+    // Total energy by all pairs with the minimum image convention.
+    double brute_force_energy(std::vector<point_t> const& points, double box)
+    {
+        double energy = 0;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            for (std::size_t j = i + 1; j < points.size(); ++j) {
+                double r2 = 0;
+                for (unsigned k = 0; k < 3; ++k) {
+                    double d = points[i][k].value() - points[j][k].value();
+                    d -= box * std::round(d / box);
+                    r2 += d * d;
+                }
+                if (r2 < 1) {
+                    energy += (1 - r2) * (1 - r2);
+                }
+            }
+        }
+        return energy;
+    }
+}
+
+TEST_CASE("monte_carlo: rejects invalid parameters")
+{
+    auto const points = random_points(10, 4, 1);
+    CHECK_NOTHROW(dim::make_monte_carlo(make_params(4, 1, 0.1, 1), soft_sphere{}, points));
+    CHECK_NOTHROW(dim::make_monte_carlo(make_params(4, 2, 0.1, 1), soft_sphere{}, points));
+    CHECK_THROWS_AS(
+        dim::make_monte_carlo(make_params(4, 2.5, 0.1, 1), soft_sphere{}, points), std::invalid_argument);
+    CHECK_THROWS_AS(
+        dim::make_monte_carlo(make_params(4, 0, 0.1, 1), soft_sphere{}, points), std::invalid_argument);
+}
+
+TEST_CASE("monte_carlo: computes the total energy with a cell list")
+{
+    // Box sizes give 2, 4 and 6 cells per axis (5.5 rounds down to 4).
+    for (double const box : {2.5, 5.5, 6.0}) {
+        auto const points = random_points(400, box, 2);
+        auto mc = dim::make_monte_carlo(make_params(box, 1, 0.1, 1), soft_sphere{}, points);
+        double const expected = brute_force_energy(points, box);
+        CHECK(mc.total_energy().value() == doctest::Approx(expected).epsilon(1e-12));
+        CHECK(mc.energy().value() == doctest::Approx(expected).epsilon(1e-12));
+    }
+}
+
+TEST_CASE("monte_carlo: energy change of a trial move matches total energies")
+{
+    double const box = 6;
+    auto points = random_points(300, box, 3);
+    auto mc = dim::make_monte_carlo(make_params(box, 1, 0.1, 1), soft_sphere{}, points);
+
+    std::mt19937 engine(4);
+    std::uniform_real_distribution<double> coord(-1, box + 1);
+    for (int trial = 0; trial < 20; ++trial) {
+        std::size_t const i = std::size_t(trial) * 13 % points.size();
+        point_t const target{coord(engine), coord(engine), coord(engine)};
+
+        double const before = brute_force_energy(points, box);
+        double const delta = mc.delta_energy(i, target).value();
+        points[i] = target;
+        double const after = brute_force_energy(points, box);
+        CHECK(delta == doctest::Approx(after - before).epsilon(1e-10));
+
+        // Actually moving the particle keeps the running energy in sync.
+        CHECK(mc.move(i, target).value() == doctest::Approx(delta).epsilon(1e-12));
+        CHECK(mc.energy().value() == doctest::Approx(after).epsilon(1e-10));
+    }
+}
+
+TEST_CASE("monte_carlo: evaluates a batch of trial moves")
+{
+    double const box = 6;
+    auto const points = random_points(300, box, 5);
+    auto const mc = dim::make_monte_carlo(make_params(box, 1, 0.1, 1), soft_sphere{}, points);
+
+    std::vector<std::size_t> indices;
+    auto const trials = random_points(50, box, 6);
+    for (std::size_t m = 0; m < trials.size(); ++m) {
+        indices.push_back(m * 5);
+    }
+    std::vector<energy_t> deltas(trials.size());
+    mc.delta_energy(indices.data(), trials.data(), trials.size(), deltas.data());
+
+    for (std::size_t m = 0; m < trials.size(); ++m) {
+        CHECK(deltas[m] == mc.delta_energy(indices[m], trials[m]));
+    }
+}
+
+TEST_CASE("monte_carlo: sweeps keep the running energy consistent")
+{
+    double const box = 6;
+    auto mc = dim::make_monte_carlo(make_params(box, 1, 0.2, 0.1), soft_sphere{}, random_points(500, box, 7));
+    double const initial = mc.energy().value();
+
+    std::mt19937_64 rng(8);
+    dim::move_statistics<double> total;
+    for (int sweep = 0; sweep < 20; ++sweep) {
+        total += mc.sweep(rng);
+    }
+    CHECK(total.attempted == 20 * 500);
+    CHECK(total.acceptance_ratio() > 0);
+    CHECK(total.acceptance_ratio() < 1);
+    CHECK(mc.energy().value() == doctest::Approx(initial + total.energy_change.value()).epsilon(1e-9));
+    CHECK(mc.energy().value() == doctest::Approx(mc.total_energy().value()).epsilon(1e-9));
+
+    // Overlapping repulsive particles at low temperature spread out.
+    CHECK(mc.energy().value() < initial);
+}
+
+TEST_CASE("monte_carlo: accepts every move without interactions")
+{
+    auto mc = dim::make_monte_carlo(make_params(4, 1, 0.5, 1), no_interaction{}, random_points(100, 4, 9));
+    std::mt19937_64 rng(10);
+    auto const stats = mc.sweep(rng, 1000);
+    CHECK(stats.attempted == 1000);
+    CHECK(stats.accepted == 1000);
+    for (auto const& p : mc.positions()) {
+        for (unsigned k = 0; k < 3; ++k) {
+            CHECK(p[k].value() >= 0);
+            CHECK(p[k].value() < 4);
+        }
+    }
+}
+
+TEST_CASE("monte_carlo: checkerboard sweeps are consistent and reproducible")
+{
+    double const box = 8;
+    auto const points = random_points(2000, box, 11);
+    auto mc1 = dim::make_monte_carlo(make_params(box, 1, 0.2, 0.1), soft_sphere{}, points);
+    auto mc2 = dim::make_monte_carlo(make_params(box, 1, 0.2, 0.1), soft_sphere{}, points);
+    double const initial = mc1.energy().value();
+
+    std::mt19937_64 rng1(12);
+    std::mt19937_64 rng2(12);
+    dim::move_statistics<double> total;
+    for (int sweep = 0; sweep < 10; ++sweep) {
+        total += mc1.checkerboard_sweep(rng1);
+        mc2.checkerboard_sweep(rng2);
+    }
+    CHECK(total.attempted == 10 * 2000);
+    CHECK(total.accepted > 0);
+    CHECK(mc1.energy().value() == doctest::Approx(mc1.total_energy().value()).epsilon(1e-9));
+    CHECK(mc1.energy().value() < initial);
+    CHECK(mc1.positions() == mc2.positions());
+
+    // Serial sweeps continue from the shifted cell grid.
+    std::mt19937_64 rng(13);
+    mc1.sweep(rng);
+    CHECK(mc1.energy().value() == doctest::Approx(mc1.total_energy().value()).epsilon(1e-9));
+}
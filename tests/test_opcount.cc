@@ -0,0 +1,104 @@
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include <dim.hpp>
+#include <dim_opcount.hpp>
+#include <doctest.h>
+
+TEST_CASE("instrumented: is the plain number type without the switch")
+{
+#if !defined(DIM_COUNT_OPERATIONS)
+    CHECK((std::is_same<dim::instrumented<double>, double>::value));
+#endif
+    CHECK((std::is_trivially_copyable<dim::counted<double>>::value));
+}
+
+TEST_CASE("counted: counts scalar operations through dim operators")
+{
+    using number_t = dim::counted<double>;
+    using length_t = dim::scalar<number_t, dim::mech::length>;
+    using duration_t = dim::scalar<number_t, dim::mech::time>;
+
+    length_t const x{3};
+    length_t const y{4};
+    duration_t const t{2};
+
+    dim::op_counts const start = dim::thread_op_counts();
+    auto const sum = x + y;
+    auto const diff = x - y;
+    auto const speed = x / t;
+    auto const area = x * y;
+    auto const root = dim::sqrt(area);
+    auto const cube = dim::cbrt(area * x);
+    auto const hyp = dim::hypot(x, y);
+    auto const squared = dim::pow<2>(x);
+    auto const magnitude = dim::abs(diff);
+    dim::op_counts const counts = dim::thread_op_counts() - start;
+
+    CHECK(counts.add == 1);
+    CHECK(counts.sub == 1);
+    CHECK(counts.mul == 2);
+    CHECK(counts.div == 1);
+    CHECK(counts.sqrt == 1);
+    CHECK(counts.cbrt == 1);
+    CHECK(counts.hypot == 1);
+    CHECK(counts.pow == 1);
+    CHECK(counts.abs == 1);
+    CHECK(counts.compare == 0);
+
+    CHECK(sum.value().value() == 7);
+    CHECK(speed.value().value() == 1.5);
+    CHECK(hyp == length_t{5});
+    CHECK(magnitude == length_t{1});
+    (void) root;
+    (void) cube;
+    (void) squared;
+}
+
+TEST_CASE("counted: counts vector operations")
+{
+    using number_t = dim::counted<double>;
+    using displace_t = dim::vector<number_t, dim::mech::length, 3>;
+
+    displace_t const v{1, 2, 2};
+    dim::op_counts const start = dim::thread_op_counts();
+    auto const length = dim::norm(v);
+    dim::op_counts const counts = dim::thread_op_counts() - start;
+
+    CHECK(counts.mul == 3);
+    CHECK(counts.add == 3);
+    CHECK(counts.sqrt == 1);
+    CHECK(length.value().value() == 3);
+}
+
+TEST_CASE("op_scope: accumulates counts per named scope")
+{
+    using number_t = dim::counted<double>;
+    using length_t = dim::scalar<number_t, dim::mech::length>;
+
+    dim::reset_op_counts();
+    length_t x{1};
+    for (int i = 0; i < 3; ++i) {
+        dim::op_scope scope{"kernel"};
+        x += length_t{1};
+        x = x * 2.0;
+    }
+    {
+        dim::op_scope scope{"other"};
+        x = dim::sqrt(x * x);
+    }
+
+    dim::op_counts const kernel = dim::scope_op_counts("kernel");
+    CHECK(kernel.add == 3);
+    CHECK(kernel.mul == 3);
+    CHECK(kernel.total() == 6);
+    CHECK(dim::scope_op_counts("other").sqrt == 1);
+    CHECK(dim::scope_op_counts("missing").total() == 0);
+
+    std::ostringstream out;
+    dim::dump_op_counts(out);
+    std::string const csv = out.str();
+    CHECK(csv.find("scope,add,sub,mul,div") == 0);
+    CHECK(csv.find("kernel,3,0,3,0,0,0,0,0,0,0,6\n") != std::string::npos);
+}
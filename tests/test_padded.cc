@@ -0,0 +1,144 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_arena.hpp>
+#include <dim_padded.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using packed_t = dim::vector<double, dim::mech::length, 3>;
+    using padded_t = dim::vector<double, dim::mech::length, 3, dim::padded>;
+    using padded_area_t = dim::padded_vector<double, dim::power_dimension_t<dim::mech::length, 2>>;
+    using padded_speed_t = dim::padded_vector<double, dim::mech::speed>;
+    using float_packed_t = dim::vector<float, dim::mech::force, 3>;
+    using float_padded_t = dim::padded_vector<float, dim::mech::force>;
+    using time_t_ = dim::scalar<double, dim::mech::time>;
+
+    template<typename V>
+    bool is_aligned(V const& v)
+    {
+        return reinterpret_cast<std::uintptr_t>(&v) % alignof(V) == 0;
+    }
+}
+
+TEST_CASE("padded vector - is four aligned lanes")
+{
+    CHECK(sizeof(padded_t) == 32);
+    CHECK(alignof(padded_t) == 32);
+    CHECK(sizeof(float_padded_t) == 16);
+    CHECK(alignof(float_padded_t) == 16);
+    CHECK((std::is_trivially_copyable<padded_t>::value));
+    CHECK((std::is_same<padded_t, dim::padded_vector<double, dim::mech::length>>::value));
+    CHECK(padded_t::dimension == 3);
+
+    std::vector<padded_t, dim::aligned_allocator<padded_t>> array(5);
+    for (auto const& v : array) {
+        CHECK(is_aligned(v));
+        CHECK(v == padded_t{});
+    }
+    CHECK(array[0].data()[3].value() == 0);
+}
+
+TEST_CASE("padded vector - converts from and to the packed layout")
+{
+    packed_t const packed{1, 2, 3};
+    padded_t const padded = packed;
+    CHECK(padded[0].value() == 1);
+    CHECK(padded[2].value() == 3);
+    CHECK(padded.data()[3].value() == 0);
+
+    packed_t const back = padded;
+    CHECK(back == packed);
+    CHECK((std::is_convertible<packed_t, padded_t>::value));
+    CHECK((std::is_convertible<padded_t, packed_t>::value));
+
+    padded_t const from_scalars{length_t{4}, length_t{5}, length_t{6}};
+    CHECK(from_scalars == padded_t{4, 5, 6});
+
+    point_t const p{1, 1, 1};
+    CHECK(p + padded == point_t{2, 3, 4});
+    CHECK(p - padded == point_t{0, -1, -2});
+}
+
+TEST_CASE("padded vector - ignores the pad lane")
+{
+    padded_t v{1, 2, 3};
+    padded_t w{1, 2, 3};
+    w.data()[3] = length_t{42};
+    CHECK(v == w);
+    CHECK_FALSE(v != w);
+    CHECK(dot(v, w).value() == 14);
+    CHECK(norm(w).value() == doctest::Approx(3.7416573867739413));
+
+    w[2] = length_t{4};
+    CHECK(v != w);
+
+    padded_t u{0, 0, 1};
+    u.data()[3] = length_t{7};
+    padded_area_t const c = cross(v, u);
+    CHECK(c == padded_area_t{2, -1, 0});
+    CHECK(c.data()[3].value() == 0);
+}
+
+TEST_CASE("padded vector - agrees exactly with the packed layout")
+{
+    std::mt19937 engine{1};
+    std::uniform_real_distribution<double> uniform{-10, 10};
+    time_t_ const dt{0.01};
+
+    for (int i = 0; i < 1000; ++i) {
+        packed_t const a{uniform(engine), uniform(engine), uniform(engine)};
+        packed_t const b{uniform(engine), uniform(engine), uniform(engine)};
+        padded_t const pa = a;
+        padded_t const pb = b;
+        double const k = uniform(engine);
+
+        CHECK(packed_t(pa + pb) == a + b);
+        CHECK(packed_t(pa - pb) == a - b);
+        CHECK(packed_t(-pa) == -a);
+        CHECK(packed_t(+pa) == +a);
+        CHECK(packed_t(pa * k) == a * k);
+        CHECK(packed_t(k * pa) == k * a);
+        CHECK(packed_t(pa / k) == a / k);
+
+        // Products may be fused into FMAs differently in the two layouts.
+        CHECK(dot(pa, pb).value() == doctest::Approx(dot(a, b).value()).epsilon(1e-14));
+        CHECK(squared_norm(pa).value() == doctest::Approx(squared_norm(a).value()).epsilon(1e-14));
+        CHECK(norm(pa).value() == doctest::Approx(norm(a).value()).epsilon(1e-14));
+        padded_area_t const c = cross(pa, pb);
+        auto const expected_cross = cross(a, b);
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            CHECK(c[axis].value() == doctest::Approx(expected_cross[axis].value()).epsilon(1e-13));
+        }
+
+        padded_speed_t const velocity = pa / dt;
+        CHECK(velocity[1].value() == a[1].value() / dt.value());
+        CHECK(velocity * dt == pa / dt * dt);
+        CHECK(dt * velocity == velocity * dt);
+
+        padded_t accumulated = pa;
+        accumulated += pb;
+        accumulated -= pa;
+        accumulated *= 2;
+        accumulated /= 4;
+        packed_t expected = a;
+        expected += b;
+        expected -= a;
+        expected *= 2;
+        expected /= 4;
+        CHECK(packed_t(accumulated) == expected);
+    }
+
+    float_packed_t const f{1.5f, -2, 0.25f};
+    float_padded_t const g = f;
+    CHECK(float_packed_t(g * 2.0f) == f * 2.0f);
+    CHECK(dot(g, g).value() == doctest::Approx(dot(f, f).value()));
+    CHECK(cross(g, float_padded_t{0, 0, 1}) == dim::padded_vector<float, dim::power_dimension_t<dim::mech::force, 2>>{-2, -1.5f, 0});
+}
@@ -1,4 +1,5 @@
 #include <type_traits>
+#include <vector>
 
 #include <dim.hpp>
 #include <doctest.h>
@@ -34,6 +35,18 @@ TEST_CASE("vector: is explicitly constructible with coordinate values")
     CHECK((std::is_constructible<point_t, double, double, double>::value));
 }
 
+TEST_CASE("point: is explicitly constructible from arrays and iterators")
+{
+    using position_t = dim::point<double, dim::mechanical_dimension<1, 0, 0>, 3>;
+
+    double const values[] = {1, 2, 3};
+    std::vector<double> const list = {1, 2, 3};
+
+    CHECK(position_t{values} == position_t{1, 2, 3});
+    CHECK(position_t{list.begin()} == position_t{1, 2, 3});
+    CHECK(position_t{values}.data() != nullptr);
+}
+
 TEST_CASE("point: is default constructed to zero")
 {
     using point_t = dim::point<double, dim::mechanical_dimension<1, 0, 0>, 3>;
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <dim.hpp>
+#include <dim_shared.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+
+    std::string unique_name(char const* tag)
+    {
+        return "/dim-test-" + std::to_string(::getpid()) + "-" + tag;
+    }
+}
+
+TEST_CASE("shared_array - readers see published frames without copying")
+{
+    std::string const name = unique_name("frames");
+    dim::shared_array_writer<point_t> writer{name, 4};
+    dim::shared_array_reader<point_t> reader{name};
+
+    CHECK(writer.capacity() == 4);
+    CHECK(reader.capacity() == 4);
+
+    std::vector<point_t> values;
+    dim::shared_frame<point_t> view;
+    CHECK_FALSE(reader.read(values));
+    CHECK_FALSE(reader.try_view(view));
+
+    std::vector<point_t> const first = {point_t{1, 2, 3}, point_t{4, 5, 6}, point_t{7, 8, 9}};
+    writer.publish(first);
+    CHECK(writer.frames() == 1);
+
+    std::uint64_t frame = 0;
+    REQUIRE(reader.read(values, &frame));
+    CHECK(frame == 1);
+    CHECK(values == first);
+
+    REQUIRE(reader.try_view(view));
+    CHECK(view.count == 3);
+    CHECK(view.frame == 1);
+    CHECK(view.data[2] == first[2]);
+    CHECK(reader.validate(view));
+
+    writer.update(1, [](point_t* data) { data[0] = point_t{-1, -1, -1}; });
+    CHECK_FALSE(reader.validate(view));
+    CHECK(reader.frames() == 2);
+
+    REQUIRE(reader.read(values, &frame));
+    CHECK(frame == 2);
+    REQUIRE(values.size() == 1);
+    CHECK(values[0] == point_t{-1, -1, -1});
+
+    CHECK_THROWS_AS(writer.publish(std::vector<point_t>(5)), std::invalid_argument);
+}
+
+TEST_CASE("shared_array - attaching checks the recorded quantity type")
+{
+    std::string const name = unique_name("types");
+    dim::shared_array_writer<point_t> writer{name, 8};
+
+    CHECK_THROWS_AS(dim::shared_array_writer<point_t>(name, 8), std::system_error);
+    CHECK_THROWS_AS(dim::shared_array_reader<point_t>(unique_name("missing")), std::system_error);
+
+    using float_point_t = dim::point<float, dim::mech::length, 3>;
+    using plane_point_t = dim::point<double, dim::mech::length, 2>;
+    using length_vector_t = dim::vector<double, dim::mech::length, 3>;
+    using speed_point_t = dim::point<double, dim::mech::speed, 3>;
+
+    CHECK_THROWS_AS(dim::shared_array_reader<float_point_t>{name}, std::runtime_error);
+    CHECK_THROWS_AS(dim::shared_array_reader<plane_point_t>{name}, std::runtime_error);
+    CHECK_THROWS_AS(dim::shared_array_reader<length_vector_t>{name}, std::runtime_error);
+    CHECK_THROWS_AS(dim::shared_array_reader<speed_point_t>{name}, std::runtime_error);
+    CHECK_THROWS_AS(dim::shared_array_reader<velocity_t>{name}, std::runtime_error);
+
+    std::string const energy_name = unique_name("energy");
+    dim::shared_array_writer<energy_t> energy_writer{energy_name, 1};
+    energy_writer.publish(std::vector<energy_t>{energy_t{2.5}});
+
+    dim::shared_array_reader<energy_t> energy_reader{energy_name};
+    std::vector<energy_t> energies;
+    REQUIRE(energy_reader.read(energies));
+    CHECK(energies.at(0).value() == 2.5);
+    using force_t = dim::scalar<double, dim::mech::force>;
+    CHECK_THROWS_AS(dim::shared_array_reader<force_t>{energy_name}, std::runtime_error);
+}
+
+TEST_CASE("shared_array - readers in another process never see torn frames")
+{
+    std::string const name = unique_name("process");
+    std::size_t const count = 2000;
+    std::uint64_t const last = 300;
+
+    dim::shared_array_writer<point_t> writer{name, count};
+
+    pid_t const child = ::fork();
+    REQUIRE(child >= 0);
+
+    if (child == 0) {
+        // Exit status: 0 if every frame read was consistent, 1 on a torn
+        // frame and 2 if the last frame did not arrive in time.
+        int status = 2;
+        try {
+            dim::shared_array_reader<point_t> reader{name};
+            std::vector<point_t> values;
+            auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::uint64_t frame = 0;
+                if (!reader.read(values, &frame)) {
+                    continue;
+                }
+                bool consistent = values.size() == count;
+                for (point_t const& p : values) {
+                    consistent = consistent && p[0].value() == double(frame) && p[2].value() == -double(frame);
+                }
+                if (!consistent) {
+                    status = 1;
+                    break;
+                }
+                if (frame == last) {
+                    status = 0;
+                    break;
+                }
+            }
+        } catch (...) {
+            status = 3;
+        }
+        ::_exit(status);
+    }
+
+    std::vector<point_t> values(count);
+    for (std::uint64_t frame = 1; frame <= last; ++frame) {
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] = point_t{double(frame), double(i), -double(frame)};
+        }
+        writer.publish(values);
+    }
+
+    int status = -1;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_spatial_hash.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using plane_point_t = dim::point<double, dim::mech::length, 2>;
+    using hash_t = dim::spatial_hash<double, dim::mech::length, 3>;
+    using plane_hash_t = dim::spatial_hash<double, dim::mech::length, 2>;
+
+    // Points in a few far-apart blobs, as in a sparse gas.
+    std::vector<point_t> sparse_points(std::size_t count, unsigned seed)
+    {
+        std::mt19937 engine{seed};
+        std::normal_distribution<double> blob(0, 3);
+        std::uniform_int_distribution<int> center(-4, 4);
+        std::vector<point_t> points;
+        for (std::size_t i = 0; i < count; ++i) {
+            double const cx = 1000.0 * center(engine);
+            double const cy = 1000.0 * center(engine);
+            points.push_back(point_t{cx + blob(engine), cy + blob(engine), blob(engine)});
+        }
+        return points;
+    }
+
+    std::set<hash_t::key_type> occupied_cells(hash_t const& hash, std::vector<point_t> const& points,
+        std::vector<bool> const& present)
+    {
+        std::set<hash_t::key_type> cells;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (present[i]) {
+                cells.insert(hash.cell_of(points[i]));
+            }
+        }
+        return cells;
+    }
+
+    void check_queries(hash_t const& hash, std::vector<point_t> const& points,
+        std::vector<bool> const& present, length_t radius)
+    {
+        for (std::size_t q = 0; q < points.size(); q += 37) {
+            std::vector<std::size_t> found = hash.radius_query(points[q], radius);
+            std::sort(found.begin(), found.end());
+
+            std::vector<std::size_t> expected;
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                if (present[i] && squared_distance(points[i], points[q]) <= radius * radius) {
+                    expected.push_back(i);
+                }
+            }
+            CHECK(found == expected);
+        }
+    }
+}
+
+TEST_CASE("spatial_hash - quantizes coordinates by the cell size")
+{
+    CHECK_THROWS_AS(hash_t(length_t{0}), std::invalid_argument);
+    CHECK_THROWS_AS(hash_t(length_t{-1}), std::invalid_argument);
+
+    hash_t const hash(length_t{0.5});
+    CHECK(hash.cell_size().value() == 0.5);
+    CHECK(hash.cell_of(point_t{0.2, -0.2, 1.1}) == hash_t::key_type{0, -1, 2});
+    CHECK(hash.cell_of(point_t{-1e9, 1e9, 0.0}) == hash_t::key_type{-2000000000, 2000000000, 0});
+}
+
+TEST_CASE("spatial_hash - insert, move and remove keep cells consistent")
+{
+    std::vector<point_t> points = sparse_points(3000, 1);
+    std::vector<bool> present(points.size(), false);
+    length_t const radius{1.5};
+    hash_t hash(radius);
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        hash.insert(i, points[i]);
+        present[i] = true;
+    }
+    CHECK(hash.size() == points.size());
+    CHECK(hash.cell_count() == occupied_cells(hash, points, present).size());
+    CHECK_THROWS_AS(hash.insert(5, points[5]), std::invalid_argument);
+    check_queries(hash, points, present, radius);
+    check_queries(hash, points, present, length_t{4});
+
+    // Random walk with removals and re-insertions; many moves cross cells
+    // and grow or empty them, which exercises pool compaction.
+    std::mt19937 engine{2};
+    std::normal_distribution<double> step(0, 0.7);
+    std::uniform_int_distribution<std::size_t> pick(0, points.size() - 1);
+
+    for (int round = 0; round < 20; ++round) {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (!present[i]) {
+                continue;
+            }
+            points[i] += dim::vector<double, dim::mech::length, 3>{step(engine), step(engine), step(engine)};
+            hash.move(i, points[i]);
+            CHECK(hash.position(i) == points[i]);
+        }
+        for (int k = 0; k < 100; ++k) {
+            std::size_t const i = pick(engine);
+            if (present[i]) {
+                hash.remove(i);
+            } else {
+                hash.insert(i, points[i]);
+            }
+            present[i] = !present[i];
+        }
+    }
+
+    std::size_t const count = std::size_t(std::count(present.begin(), present.end(), true));
+    CHECK(hash.size() == count);
+    CHECK(hash.cell_count() == occupied_cells(hash, points, present).size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        CHECK(hash.contains(i) == present[i]);
+    }
+    check_queries(hash, points, present, radius);
+
+    hash.compact();
+    check_queries(hash, points, present, radius);
+
+    std::size_t absent = 0;
+    while (present[absent]) {
+        absent++;
+    }
+    CHECK_THROWS_AS(hash.remove(absent), std::invalid_argument);
+    CHECK_THROWS_AS(hash.move(absent, points[0]), std::invalid_argument);
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (present[i]) {
+            hash.remove(i);
+        }
+    }
+    CHECK(hash.size() == 0);
+    CHECK(hash.cell_count() == 0);
+    CHECK(hash.radius_query(points[0], length_t{10}).empty());
+}
+
+TEST_CASE("spatial_hash - neighbor cells cover the points within a cell size")
+{
+    std::vector<point_t> const points = sparse_points(500, 3);
+    length_t const cell{2};
+    hash_t hash(cell);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        hash.insert(i, points[i]);
+    }
+
+    for (std::size_t q = 0; q < points.size(); q += 11) {
+        std::set<std::size_t> near;
+        hash.for_each_near(points[q], [&](std::size_t id) { near.insert(id); });
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (distance(points[i], points[q]) <= cell) {
+                CHECK(near.count(i) == 1);
+            }
+        }
+
+        std::size_t in_cell = 0;
+        hash.for_each_in_cell(hash.cell_of(points[q]), [&](std::size_t id) {
+            CHECK(hash.cell_of(points[id]) == hash.cell_of(points[q]));
+            in_cell++;
+        });
+        CHECK(in_cell >= 1);
+    }
+}
+
+TEST_CASE("spatial_hash - for_each_pair finds each close pair once")
+{
+    std::vector<point_t> const points = sparse_points(1500, 4);
+    length_t const radius{1};
+    hash_t hash(length_t{1.25});
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        hash.insert(i, points[i]);
+    }
+
+    std::set<std::pair<std::size_t, std::size_t>> found;
+    std::size_t calls = 0;
+    hash.for_each_pair(radius, [&](std::size_t i, std::size_t j) {
+        found.insert(std::make_pair(std::min(i, j), std::max(i, j)));
+        calls++;
+    });
+
+    std::set<std::pair<std::size_t, std::size_t>> expected;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        for (std::size_t j = i + 1; j < points.size(); ++j) {
+            if (distance(points[i], points[j]) <= radius) {
+                expected.insert(std::make_pair(i, j));
+            }
+        }
+    }
+    CHECK(calls == found.size());
+    CHECK(found == expected);
+    CHECK_THROWS_AS(hash.for_each_pair(length_t{2}, [](std::size_t, std::size_t) {}), std::invalid_argument);
+
+    // Same in two dimensions.
+    std::mt19937 engine{5};
+    std::uniform_real_distribution<double> coord(-30, 30);
+    std::vector<plane_point_t> plane;
+    plane_hash_t plane_hash(radius);
+    for (std::size_t i = 0; i < 800; ++i) {
+        plane.push_back(plane_point_t{coord(engine), coord(engine)});
+        plane_hash.insert(i, plane.back());
+    }
+    std::size_t plane_pairs = 0;
+    plane_hash.for_each_pair(radius, [&](std::size_t, std::size_t) { plane_pairs++; });
+    std::size_t plane_expected = 0;
+    for (std::size_t i = 0; i < plane.size(); ++i) {
+        for (std::size_t j = i + 1; j < plane.size(); ++j) {
+            plane_expected += distance(plane[i], plane[j]) <= radius ? 1 : 0;
+        }
+    }
+    CHECK(plane_pairs == plane_expected);
+}
@@ -0,0 +1,226 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_statistics.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using energy_t = dim::scalar<double, dim::mech::energy>;
+    using energy2_t = dim::scalar<double, dim::power_dimension_t<dim::mech::energy, 2>>;
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+    using velocity2_t = dim::vector<double, dim::power_dimension_t<dim::mech::speed, 2>, 3>;
+
+    // AR(1) series x[t] = phi x[t - 1] + noise with unit stationary variance.
+    // Its autocorrelation at lag k is phi^k.
+    std::vector<energy_t> ar1_series(std::size_t count, double phi, unsigned seed)
+    {
+        std::mt19937 engine{seed};
+        std::normal_distribution<double> noise(0, std::sqrt(1 - phi * phi));
+        std::vector<energy_t> series;
+        double x = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            x = phi * x + noise(engine);
+            series.push_back(energy_t{x + 5});
+        }
+        return series;
+    }
+}
+
+TEST_CASE("running_statistics - matches two-pass results and merges exactly")
+{
+    static_assert(std::is_same<dim::running_statistics<energy_t>::variance_type, energy2_t>::value,
+        "variance of energy has dimension energy^2");
+    static_assert(std::is_same<dim::running_statistics<velocity_t>::variance_type, velocity2_t>::value,
+        "variance of a vector is component-wise");
+
+    auto const series = ar1_series(50000, 0.5, 1);
+    double mean = 0;
+    for (auto const& x : series) {
+        mean += x.value();
+    }
+    mean /= double(series.size());
+    double squares = 0;
+    for (auto const& x : series) {
+        squares += (x.value() - mean) * (x.value() - mean);
+    }
+
+    dim::running_statistics<energy_t> whole;
+    dim::running_statistics<energy_t> first;
+    dim::running_statistics<energy_t> second;
+    for (std::size_t i = 0; i < series.size(); ++i) {
+        whole.add(series[i]);
+        (i < 12345 ? first : second).add(series[i]);
+    }
+    first.merge(second);
+
+    CHECK(whole.count() == series.size());
+    CHECK(whole.mean().value() == doctest::Approx(mean).epsilon(1e-12));
+    CHECK(whole.variance().value() == doctest::Approx(squares / double(series.size())).epsilon(1e-10));
+    CHECK(whole.sample_variance().value() == doctest::Approx(squares / double(series.size() - 1)).epsilon(1e-10));
+    CHECK(whole.standard_deviation().value() == doctest::Approx(std::sqrt(squares / double(series.size() - 1))));
+    CHECK(first.count() == whole.count());
+    CHECK(first.mean().value() == doctest::Approx(whole.mean().value()).epsilon(1e-12));
+    CHECK(first.variance().value() == doctest::Approx(whole.variance().value()).epsilon(1e-10));
+
+    auto const parallel = dim::accumulate_statistics(series);
+    CHECK(parallel.count() == whole.count());
+    CHECK(parallel.mean().value() == doctest::Approx(whole.mean().value()).epsilon(1e-12));
+    CHECK(parallel.variance().value() == doctest::Approx(whole.variance().value()).epsilon(1e-10));
+
+    dim::running_statistics<energy_t> empty;
+    empty.merge(whole);
+    CHECK(empty.mean() == whole.mean());
+}
+
+TEST_CASE("running_statistics - treats vectors component-wise")
+{
+    std::mt19937 engine{2};
+    std::normal_distribution<double> normal;
+    dim::running_statistics<velocity_t> stats;
+    for (int i = 0; i < 100000; ++i) {
+        stats.add(velocity_t{1 + normal(engine), 2 * normal(engine), -3 + 3 * normal(engine)});
+    }
+
+    velocity_t const mean = stats.mean();
+    velocity2_t const variance = stats.variance();
+    CHECK(mean[0].value() == doctest::Approx(1).epsilon(0.02));
+    CHECK(mean[2].value() == doctest::Approx(-3).epsilon(0.02));
+    CHECK(variance[0].value() == doctest::Approx(1).epsilon(0.02));
+    CHECK(variance[1].value() == doctest::Approx(4).epsilon(0.02));
+    CHECK(variance[2].value() == doctest::Approx(9).epsilon(0.02));
+    CHECK(stats.total_variance().value()
+        == doctest::Approx(variance[0].value() + variance[1].value() + variance[2].value()));
+    CHECK(stats.standard_deviation()[1].value() == doctest::Approx(2).epsilon(0.02));
+}
+
+TEST_CASE("block_average - estimates the error of correlated means")
+{
+    // The error of the mean of an AR(1) series is sqrt((1 + phi) / (1 - phi)
+    // / n) for unit variance, 4.36 times the naive estimate for phi = 0.9.
+    std::size_t const count = 1 << 18;
+    double const phi = 0.9;
+    auto const series = ar1_series(count, phi, 3);
+
+    dim::block_average<energy_t> blocks;
+    for (auto const& x : series) {
+        blocks.add(x);
+    }
+    CHECK(blocks.count() == count);
+    CHECK(blocks.levels() == 19);
+    CHECK(blocks.level(10).count() == count >> 10);
+    CHECK(blocks.mean().value() == doctest::Approx(5).epsilon(0.01));
+
+    double const naive = 1 / std::sqrt(double(count));
+    double const expected = std::sqrt((1 + phi) / (1 - phi) / double(count));
+    CHECK(blocks.level_error(0).value() == doctest::Approx(naive).epsilon(0.05));
+    CHECK(blocks.standard_error().value() == doctest::Approx(expected).epsilon(0.25));
+
+    // Merging a short remainder into a part whose length is a multiple of
+    // 2^levels reproduces a single accumulator, also for samples added later.
+    std::size_t const head = count / 2;
+    std::size_t const tail = head + 5000;
+    dim::block_average<energy_t> aligned;
+    dim::block_average<energy_t> remainder;
+    for (std::size_t i = 0; i < tail; ++i) {
+        (i < head ? aligned : remainder).add(series[i]);
+    }
+    aligned.merge(remainder);
+    for (std::size_t i = tail; i < count; ++i) {
+        aligned.add(series[i]);
+    }
+    CHECK(aligned.levels() == blocks.levels());
+    for (std::size_t level = 0; level + 1 < blocks.levels(); ++level) {
+        CHECK(aligned.level(level).count() == blocks.level(level).count());
+        CHECK(aligned.level_error(level).value() == doctest::Approx(blocks.level_error(level).value()));
+    }
+
+    // Unaligned parts lose at most one block per level at the junction.
+    dim::block_average<energy_t> first;
+    dim::block_average<energy_t> second;
+    for (std::size_t i = 0; i < count; ++i) {
+        (i < count / 4 + 3 ? first : second).add(series[i]);
+    }
+    first.merge(second);
+    CHECK(first.count() == blocks.count());
+    CHECK(first.mean().value() == doctest::Approx(blocks.mean().value()));
+    for (std::size_t level = 0; level < first.levels(); ++level) {
+        CHECK(first.level(level).count() + 1 >= blocks.level(level).count());
+    }
+    CHECK(first.standard_error().value() == doctest::Approx(blocks.standard_error().value()).epsilon(0.1));
+}
+
+TEST_CASE("multiple_tau_correlator - agrees with direct and FFT correlation")
+{
+    std::size_t const count = 20000;
+    double const phi = 0.8;
+    auto const series = ar1_series(count, phi, 4);
+
+    dim::multiple_tau_correlator<energy_t> correlator{8, 16, 2};
+    for (auto const& x : series) {
+        correlator.add(x);
+    }
+    auto const lags = correlator.lags();
+    auto const correlation = correlator.correlation();
+    auto const covariance = correlator.covariance();
+    static_assert(std::is_same<decltype(correlation)::value_type, energy2_t>::value,
+        "correlation of energy has dimension energy^2");
+
+    // Bounded memory: 16 lags at level 0 and 8 more on each further level.
+    CHECK(lags.size() == 16 + 7 * 8);
+    CHECK(lags[15] == 15);
+    CHECK(lags[16] == 16);
+    CHECK(lags.back() == 15 * 128);
+
+    auto const fft = dim::autocorrelation(series, 15);
+    auto const fft_covariance = dim::autocovariance(series, 64);
+    CHECK(fft.size() == 16);
+    CHECK(fft_covariance.size() == 65);
+    for (std::size_t lag = 0; lag < 16; ++lag) {
+        double direct = 0;
+        for (std::size_t t = lag; t < count; ++t) {
+            direct += series[t].value() * series[t - lag].value();
+        }
+        direct /= double(count - lag);
+        CHECK(correlation[lag].value() == doctest::Approx(direct).epsilon(1e-10));
+        CHECK(fft[lag].value() == doctest::Approx(direct).epsilon(1e-10));
+        CHECK(covariance[lag].value() == doctest::Approx(std::pow(phi, double(lag))).epsilon(0.1));
+    }
+
+    // Coarse levels track the exact covariance of the series until both are
+    // dominated by noise.
+    for (std::size_t i = 16; i < lags.size() && lags[i] <= 64; ++i) {
+        CHECK(covariance[i].value() == doctest::Approx(fft_covariance[lags[i]].value()).epsilon(0.02));
+    }
+
+    // Merging the correlator of an independent replica averages both.
+    dim::multiple_tau_correlator<energy_t> replica{8, 16, 2};
+    for (auto const& x : ar1_series(count, phi, 5)) {
+        replica.add(x);
+    }
+    replica.merge(correlator);
+    CHECK(replica.count() == 2 * count);
+    CHECK(replica.covariance()[1].value() == doctest::Approx(phi).epsilon(0.1));
+
+    CHECK_THROWS_AS((dim::multiple_tau_correlator<energy_t>{8, 15, 2}), std::invalid_argument);
+    CHECK_THROWS_AS(replica.merge(dim::multiple_tau_correlator<energy_t>{8, 16, 4}), std::invalid_argument);
+}
+
+TEST_CASE("autocorrelation - sums vector components")
+{
+    std::vector<velocity_t> series;
+    for (int i = 0; i < 100; ++i) {
+        series.push_back(velocity_t{double(i % 2), 1, 0});
+    }
+    auto const correlation = dim::autocorrelation(series, 3);
+    CHECK(correlation.size() == 4);
+    CHECK(correlation[0].value() == doctest::Approx(1.5));
+    CHECK(correlation[1].value() == doctest::Approx(1.0));
+    CHECK(correlation[2].value() == doctest::Approx(1.5));
+    CHECK(dim::autocorrelation(series.data(), 0, 3).empty());
+}
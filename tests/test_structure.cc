@@ -0,0 +1,224 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_structure.hpp>
+#include <doctest.h>
+
+#include "random_points.hpp"
+
+namespace
+{
+    using dim_test::random_points;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using box_t = dim::vector<double, dim::mech::length, 3>;
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using rdf_t = dim::radial_distribution<double>;
+    using sk_t = dim::structure_factor<double>;
+    using wavenumber_t = sk_t::wavenumber_type;
+
+    double const pi = 3.14159265358979323846;
+
+    std::vector<point_t> cubic_lattice(int cells, double spacing)
+    {
+        std::vector<point_t> points;
+        for (int x = 0; x < cells; ++x) {
+            for (int y = 0; y < cells; ++y) {
+                for (int z = 0; z < cells; ++z) {
+                    points.push_back(point_t{x * spacing, y * spacing, z * spacing});
+                }
+            }
+        }
+        return points;
+    }
+
+    // Pair histogram by all pairs with the minimum image convention.
+    std::vector<std::uint64_t> brute_force_counts(
+        std::vector<point_t> const& points, double box, double max_distance, std::size_t bins)
+    {
+        std::vector<std::uint64_t> counts(bins, 0);
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            for (std::size_t j = i + 1; j < points.size(); ++j) {
+                double r2 = 0;
+                for (unsigned k = 0; k < 3; ++k) {
+                    double d = points[i][k].value() - points[j][k].value();
+                    d -= box * std::round(d / box);
+                    r2 += d * d;
+                }
+                if (r2 < max_distance * max_distance) {
+                    std::size_t const bin = std::size_t(std::sqrt(r2) / max_distance * double(bins));
+                    counts[bin < bins ? bin : bins - 1]++;
+                }
+            }
+        }
+        return counts;
+    }
+}
+
+TEST_CASE("radial_distribution: rejects invalid ranges")
+{
+    CHECK_THROWS_AS(rdf_t(length_t{1}, 0), std::invalid_argument);
+    CHECK_THROWS_AS(rdf_t(length_t{0}, 10), std::invalid_argument);
+
+    rdf_t rdf{length_t{3}, 10};
+    auto const points = random_points(10, 5, 1);
+    dim::frame_view<double> frame{points.data(), points.size(), box_t{5, 5, 5}};
+    CHECK_THROWS_AS(rdf.accumulate(frame), std::invalid_argument);
+}
+
+TEST_CASE("radial_distribution: counts pairs like the all-pairs loop")
+{
+    // The first box is too small for a cell list.
+    for (double const box : {5.0, 12.0}) {
+        auto points = random_points(1500, box, 2);
+        points[0] = point_t{-0.5, box + 1, 2 * box};
+        dim::frame_view<double> frame{points.data(), points.size(), box_t{box, box, box}};
+
+        rdf_t rdf{length_t{2}, 40};
+        rdf.accumulate(frame);
+        CHECK(rdf.frames() == 1);
+        CHECK(rdf.counts() == brute_force_counts(points, box, 2, 40));
+    }
+}
+
+TEST_CASE("radial_distribution: is one for an ideal gas")
+{
+    double const box = 10;
+    rdf_t rdf{length_t{4}, 8};
+    for (unsigned seed = 0; seed < 10; ++seed) {
+        auto const points = random_points(2000, box, 10 + seed);
+        rdf.accumulate(dim::frame_view<double>{points.data(), points.size(), box_t{box, box, box}});
+    }
+    auto const g = rdf.values();
+    for (std::size_t b = 1; b < g.size(); ++b) {
+        CHECK(g[b] == doctest::Approx(1).epsilon(0.05));
+    }
+    CHECK(rdf.bin_center(0).value() == doctest::Approx(0.25));
+
+    rdf.reset();
+    CHECK(rdf.frames() == 0);
+    CHECK(rdf.values()[3] == 0);
+}
+
+TEST_CASE("radial_distribution: finds the shells of a cubic lattice")
+{
+    auto const points = cubic_lattice(8, 1.5);
+    rdf_t rdf{length_t{4}, 40};
+    rdf.accumulate(dim::frame_view<double>{points.data(), points.size(), box_t{12, 12, 12}});
+
+    // Each site has 6 neighbors at 1.5, 12 at 2.12 and 8 at 2.60.
+    auto const& counts = rdf.counts();
+    CHECK(counts[15] == 512 * 6 / 2);
+    CHECK(counts[21] == 512 * 12 / 2);
+    CHECK(counts[25] == 512 * 8 / 2);
+    CHECK(counts[10] == 0);
+}
+
+TEST_CASE("structure_factor: has Bragg peaks on a cubic lattice")
+{
+    auto const points = cubic_lattice(4, 1.0);
+    sk_t sk{wavenumber_t{7}, 70};
+    sk.accumulate(dim::frame_view<double>{points.data(), points.size(), box_t{4, 4, 4}});
+
+    // Reciprocal lattice vectors of length 2 pi give S = N. All the other
+    // wave vectors of the box give zero.
+    auto const s = sk.values();
+    std::size_t const peak = std::size_t(2 * pi / 0.1);
+    CHECK(s[peak] == doctest::Approx(64).epsilon(1e-9));
+    CHECK(sk.samples()[peak] == 3);
+    for (std::size_t b = 0; b < peak; ++b) {
+        CHECK(s[b] == doctest::Approx(0).epsilon(1e-9));
+    }
+}
+
+TEST_CASE("structure_factor: is one for an ideal gas")
+{
+    double const box = 10;
+    sk_t sk{wavenumber_t{6}, 6};
+    for (unsigned seed = 0; seed < 10; ++seed) {
+        auto const points = random_points(1000, box, 20 + seed);
+        sk.accumulate(dim::frame_view<double>{points.data(), points.size(), box_t{box, box, box}});
+    }
+    CHECK(sk.frames() == 10);
+    auto const s = sk.values();
+    for (std::size_t b = 1; b < s.size(); ++b) {
+        CHECK(s[b] == doctest::Approx(1).epsilon(0.15));
+    }
+}
+
+TEST_CASE("analyze: streams frames from a buffer without copying")
+{
+    double const box = 8;
+    std::size_t const count = 500;
+    std::vector<point_t> trajectory;
+    for (unsigned seed = 0; seed < 4; ++seed) {
+        auto const points = random_points(count, box, 30 + seed);
+        trajectory.insert(trajectory.end(), points.begin(), points.end());
+    }
+
+    dim::buffer_frame_source<double> source{trajectory.data(), 4, count, box_t{box, box, box}};
+    dim::frame_view<double> frame;
+    CHECK(source.next(frame));
+    CHECK(frame.positions == trajectory.data());
+    CHECK(frame.count == count);
+    source.reset();
+
+    rdf_t rdf{length_t{3}, 30};
+    sk_t sk{wavenumber_t{3}, 6};
+    CHECK(dim::analyze<double>(source, rdf, sk) == 4);
+    CHECK(rdf.frames() == 4);
+    CHECK(sk.frames() == 4);
+
+    rdf_t expected{length_t{3}, 30};
+    for (std::size_t f = 0; f < 4; ++f) {
+        expected.accumulate(dim::frame_view<double>{&trajectory[f * count], count, box_t{box, box, box}});
+    }
+    CHECK(rdf.counts() == expected.counts());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE("analyze: reads frames from a memory-mapped file")
+{
+    double const box = 8;
+    std::size_t const count = 300;
+    std::vector<double> raw;
+    for (unsigned seed = 0; seed < 3; ++seed) {
+        for (auto const& p : random_points(count, box, 40 + seed)) {
+            for (unsigned k = 0; k < 3; ++k) {
+                raw.push_back(p[k].value());
+            }
+        }
+    }
+
+    char const* const path = "test_structure_frames.bin";
+    std::FILE* file = std::fopen(path, "wb");
+    REQUIRE(file != nullptr);
+    std::fwrite(raw.data(), sizeof(double), raw.size(), file);
+    std::fclose(file);
+
+    rdf_t from_file{length_t{3}, 30};
+    {
+        dim::mapped_file mapping{path};
+        CHECK(mapping.size() == raw.size() * sizeof(double));
+        dim::buffer_frame_source<double> source{
+            mapping.data(), mapping.size(), count, box_t{box, box, box}};
+        CHECK(source.frame_count() == 3);
+        CHECK(from_file.accumulate_all(source) == 3);
+    }
+    std::remove(path);
+
+    rdf_t from_memory{length_t{3}, 30};
+    dim::buffer_frame_source<double> source{
+        static_cast<void const*>(raw.data()), raw.size() * sizeof(double), count, box_t{box, box, box}};
+    from_memory.accumulate_all(source);
+    CHECK(from_file.counts() == from_memory.counts());
+
+    CHECK_THROWS_AS(dim::mapped_file{"no/such/file"}, std::system_error);
+}
+#endif
@@ -0,0 +1,105 @@
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_tabulated.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using table_t = dim::tabulated_function<double>;
+    using area_t = table_t::argument_type;
+    using energy_t = table_t::value_type;
+
+    // Screened Coulomb-like potential exp(-r) / r.
+    energy_t yukawa(area_t r2)
+    {
+        double const r = std::sqrt(r2.value());
+        return energy_t{std::exp(-r) / r};
+    }
+
+    double yukawa_force_factor(double r2)
+    {
+        double const r = std::sqrt(r2);
+        return std::exp(-r) * (1 + r) / (r * r * r);
+    }
+}
+
+TEST_CASE("tabulated_function: reproduces polynomials of degree three exactly")
+{
+    auto const cubic = [](area_t x) {
+        double const s = x.value();
+        return energy_t{1 - 2 * s + 0.5 * s * s - 0.25 * s * s * s};
+    };
+    table_t const table{cubic, area_t{0}, area_t{4}, 8};
+    CHECK(table.size() == 8);
+    CHECK(table.lower() == area_t{0});
+    CHECK(table.upper() == area_t{4});
+    CHECK(table.max_error().value() < 1e-9);
+
+    auto const sample = table.evaluate(area_t{1.5});
+    CHECK(std::fabs(sample.value.value() - cubic(area_t{1.5}).value()) < 1e-9);
+    double const slope = -2 + 1.5 - 0.75 * 1.5 * 1.5;
+    CHECK(std::fabs(sample.force_factor.value() + 2 * slope) < 1e-6);
+}
+
+TEST_CASE("tabulated_function: interpolates smooth potentials accurately")
+{
+    table_t const table{yukawa, area_t{0.25}, area_t{9}, 2000};
+    CHECK(table.max_error().value() < 1e-8);
+
+    for (double r2 = 0.3; r2 < 9; r2 += 0.37) {
+        auto const sample = table.evaluate(area_t{r2});
+        CHECK(std::fabs(sample.value.value() - yukawa(area_t{r2}).value()) < 1e-8);
+        CHECK(std::fabs(sample.force_factor.value() - yukawa_force_factor(r2)) < 1e-5);
+
+        double const r = std::sqrt(r2);
+        CHECK(std::fabs(table.force_magnitude(area_t{r2}).value() - r * yukawa_force_factor(r2))
+            < 1e-5);
+    }
+}
+
+TEST_CASE("tabulated_function: clamps arguments to the table range")
+{
+    table_t const table{yukawa, area_t{1}, area_t{4}, 100};
+    CHECK(table(area_t{0.5}) == table(area_t{1}));
+    CHECK(table(area_t{5}) == table(area_t{4}));
+}
+
+TEST_CASE("tabulated_function: empty table evaluates to zero")
+{
+    table_t const table;
+    CHECK(table.size() == 0);
+    CHECK(table(area_t{2}).value() == 0);
+    CHECK(table.evaluate(area_t{2}).force_factor.value() == 0);
+
+    area_t const args[3] = {area_t{0}, area_t{1}, area_t{2}};
+    energy_t values[3] = {energy_t{1}, energy_t{1}, energy_t{1}};
+    table_t::force_factor_type factors[3];
+    table.evaluate(args, 3, values, factors);
+    for (int i = 0; i < 3; ++i) {
+        CHECK(values[i].value() == 0);
+        CHECK(factors[i].value() == 0);
+    }
+}
+
+TEST_CASE("tabulated_function: batch evaluation agrees with scalar evaluation")
+{
+    table_t const table{yukawa, area_t{0.25}, area_t{9}, 500};
+    table_t const copy = table;
+
+    std::vector<area_t> args;
+    for (int i = 0; i < 203; ++i) {
+        args.push_back(area_t{0.1 + 0.045 * i});
+    }
+    std::vector<energy_t> values(args.size());
+    std::vector<table_t::force_factor_type> factors(args.size());
+    copy.evaluate(args.data(), args.size(), values.data(), factors.data());
+
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        auto const sample = table.evaluate(args[i]);
+        CHECK(std::fabs(values[i].value() - sample.value.value()) < 1e-12);
+        CHECK(std::fabs(factors[i].value() - sample.force_factor.value()) < 1e-9);
+    }
+}
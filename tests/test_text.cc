@@ -0,0 +1,260 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_text.hpp>
+#include <doctest.h>
+
+namespace
+{
+    using length_t = dim::scalar<double, dim::mech::length>;
+    using point_t = dim::point<double, dim::mech::length, 3>;
+    using velocity_t = dim::vector<double, dim::mech::speed, 3>;
+    using force_t = dim::vector<float, dim::mech::force, 2>;
+
+    // Number of significant digits of the shortest %e output that parses
+    // back to value.
+    int shortest_digits(double value)
+    {
+        char buffer[64];
+        for (int digits = 1;; ++digits) {
+            std::snprintf(buffer, sizeof buffer, "%.*e", digits - 1, value);
+            if (std::strtod(buffer, nullptr) == value) {
+                return digits;
+            }
+        }
+    }
+
+    int significant_digits(std::string const& text)
+    {
+        std::string digits;
+        for (char const c : text.substr(0, text.find('e'))) {
+            if (c >= '0' && c <= '9') {
+                digits += c;
+            }
+        }
+        std::size_t const first = digits.find_first_not_of('0');
+        return first == std::string::npos ? 1 : int(digits.find_last_not_of('0') - first + 1);
+    }
+}
+
+TEST_CASE("format_number - writes shortest round-trip decimals")
+{
+    CHECK(dim::to_text(0.1) == "0.1");
+    CHECK(dim::to_text(1.0) == "1");
+    CHECK(dim::to_text(-2.5) == "-2.5");
+    CHECK(dim::to_text(100.0) == "100");
+    CHECK(dim::to_text(123456.789) == "123456.789");
+    CHECK(dim::to_text(0.001) == "0.001");
+    CHECK(dim::to_text(1e-7) == "1e-07");
+    CHECK(dim::to_text(1e17) == "1e+17");
+    CHECK(dim::to_text(5e-324) == "5e-324");
+    CHECK(dim::to_text(1.7976931348623157e308) == "1.7976931348623157e+308");
+    CHECK(dim::to_text(0.0) == "0");
+    CHECK(dim::to_text(-0.0) == "-0");
+    CHECK(dim::to_text(std::numeric_limits<double>::infinity()) == "inf");
+    CHECK(dim::to_text(-std::numeric_limits<double>::infinity()) == "-inf");
+    CHECK(dim::to_text(0.1f) == "0.1");
+    CHECK(dim::to_text(16777216.0f) == "16777216");
+    CHECK(dim::to_text(3.4028235e38f) == "3.4028235e+38");
+    // Integers wider than the shortest digits are written exactly.
+    CHECK(dim::to_text(3256937983961036488704.0) == "3256937983961036488704");
+    CHECK(dim::to_text(803843072.0f) == "803843072");
+    CHECK(dim::to_text(9007199254740993.0 * 4) == "36028797018963968");
+
+    std::mt19937_64 engine{1};
+    for (int i = 0; i < 20000; ++i) {
+        std::uint64_t const bits = engine();
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        if (value != value || value - value != 0) {
+            continue;
+        }
+        std::string const text = dim::to_text(value);
+        CHECK(std::strtod(text.c_str(), nullptr) == value);
+        if (text.find_first_of(".e") == std::string::npos && std::fabs(value) >= 9007199254740992.0) {
+            char exact[64];
+            std::snprintf(exact, sizeof exact, "%.0f", value);
+            CHECK(text == exact);
+        } else {
+            CHECK(significant_digits(text) == shortest_digits(value));
+        }
+    }
+}
+
+TEST_CASE("parse_number - parses exactly and reports the end")
+{
+    std::string const text = "-12.5e2,0.1 1e400 nan x";
+    char const* const last = text.data() + text.size();
+    double value = 0;
+
+    char const* p = dim::parse_number(text.data(), last, value);
+    CHECK(value == -1250.0);
+    CHECK(*p == ',');
+
+    p = dim::parse_number(p + 1, last, value);
+    CHECK(value == 0.1);
+
+    p = dim::parse_number(p + 1, last, value);
+    CHECK(value == std::numeric_limits<double>::infinity());
+
+    p = dim::parse_number(p + 1, last, value);
+    CHECK(value != value);
+
+    char const* const x = p + 1;
+    value = 7;
+    CHECK(dim::parse_number(x, last, value) == x);
+    CHECK(value == 7);
+
+    std::string const long_mantissa = "3.14159265358979323846264338327950288";
+    CHECK(dim::parse_number(long_mantissa.data(), long_mantissa.data() + long_mantissa.size(), value)
+        == long_mantissa.data() + long_mantissa.size());
+    CHECK(value == 3.141592653589793);
+
+    std::mt19937_64 engine{2};
+    std::uniform_real_distribution<double> uniform{-1e3, 1e3};
+    for (int i = 0; i < 10000; ++i) {
+        double const expected = uniform(engine);
+        std::string const formatted = dim::to_text(expected);
+        double parsed = 0;
+        dim::parse_number(formatted.data(), formatted.data() + formatted.size(), parsed);
+        CHECK(parsed == expected);
+    }
+}
+
+TEST_CASE("dimension_string - names base dimension exponents")
+{
+    CHECK(dim::dimension_string<dim::mech::length>() == "L");
+    CHECK(dim::dimension_string<dim::mech::force>() == "L M T^-2");
+    CHECK(dim::dimension_string<dim::elec::charge>() == "Q");
+    CHECK(dim::dimension_string<dim::mech::number>() == "1");
+}
+
+TEST_CASE("write_csv - round-trips columns with unit annotations")
+{
+    std::size_t const rows = 20000;
+    std::mt19937 engine{3};
+    std::normal_distribution<double> normal;
+    std::vector<length_t> radii;
+    std::vector<point_t> positions;
+    std::vector<velocity_t> velocities;
+    std::vector<force_t> forces;
+    for (std::size_t i = 0; i < rows; ++i) {
+        radii.push_back(length_t{std::abs(normal(engine))});
+        positions.push_back(point_t{normal(engine), normal(engine), normal(engine)});
+        velocities.push_back(velocity_t{normal(engine), normal(engine), 1e-30 * normal(engine)});
+        forces.push_back(force_t{float(normal(engine)), float(normal(engine))});
+    }
+
+    dim::csv_options options;
+    options.units = true;
+    std::ostringstream stream;
+    dim::write_csv(stream, rows, options, dim::make_csv_column("radius", radii),
+        dim::make_csv_column("position", positions), dim::make_csv_column("velocity", velocities),
+        dim::make_csv_column("force", forces));
+    std::string const text = stream.str();
+    CHECK(text.substr(0, text.find('\n'))
+        == "radius [L],position_x [L],position_y [L],position_z [L],velocity_x [L T^-1],"
+           "velocity_y [L T^-1],velocity_z [L T^-1],force_x [L M T^-2],force_y [L M T^-2]");
+
+    auto const table = dim::parse_csv<double>(text);
+    CHECK(table.rows == rows);
+    CHECK(table.columns == 9);
+
+    auto const parsed_radii = dim::extract_csv<length_t>(table, "radius");
+    auto const parsed_positions = dim::extract_csv<point_t>(table, "position");
+    auto const parsed_velocities = dim::extract_csv<velocity_t>(table, "velocity");
+    auto const parsed_forces = dim::extract_csv<force_t>(table, "force");
+    bool exact = true;
+    for (std::size_t i = 0; i < rows; ++i) {
+        exact = exact && parsed_radii[i] == radii[i] && parsed_positions[i] == positions[i]
+            && parsed_velocities[i] == velocities[i] && parsed_forces[i] == forces[i];
+    }
+    CHECK(exact);
+
+    CHECK_THROWS_AS(dim::extract_csv<point_t>(table, "velocity"), std::invalid_argument);
+    CHECK_THROWS_AS(dim::extract_csv<point_t>(table, "acceleration"), std::invalid_argument);
+}
+
+TEST_CASE("parse_csv - handles headerless text and reports malformed lines")
+{
+    dim::csv_options options;
+    options.header = false;
+    options.delimiter = ';';
+
+    auto const table = dim::parse_csv<float>("\n1; 2.5\r\n\n-3;4e1\n", options);
+    CHECK(table.header.empty());
+    CHECK(table.rows == 2);
+    CHECK(table.columns == 2);
+    CHECK(table(0, 1) == 2.5f);
+    CHECK(table(1, 0) == -3.0f);
+    CHECK(table(1, 1) == 40.0f);
+
+    auto const pairs = dim::extract_csv<force_t>(table, 0);
+    CHECK(pairs[1][1].value() == 40.0f);
+
+    try {
+        dim::parse_csv<double>("a,b\n1,2\n3,x\n");
+        CHECK(false);
+    } catch (std::runtime_error const& error) {
+        CHECK(std::string(error.what()) == "csv line 3: expected a number in column 2");
+    }
+    CHECK_THROWS_AS(dim::parse_csv<double>("a,b\n1,2,3\n"), std::runtime_error);
+    CHECK_THROWS_AS(dim::parse_csv<double>("a,b\n1\n"), std::runtime_error);
+}
+
+TEST_CASE("write_xyz - round-trips consecutive frames")
+{
+    std::mt19937 engine{4};
+    std::uniform_real_distribution<double> uniform{-50, 50};
+
+    dim::xyz_frame<double> first;
+    first.comment = "step 0";
+    first.symbols = {"Ar"};
+    for (int i = 0; i < 30000; ++i) {
+        first.positions.push_back(point_t{uniform(engine), uniform(engine), uniform(engine)});
+    }
+
+    dim::xyz_frame<double> second;
+    second.comment = "step 1";
+    second.symbols = {"O", "H", "H"};
+    second.positions = {point_t{0, 0, 0}, point_t{0.0957, 0, 0}, point_t{-0.024, 0.0927, 0}};
+
+    std::ostringstream stream;
+    dim::write_xyz(stream, first);
+    dim::write_xyz(stream, second);
+    std::string const text = stream.str();
+    CHECK(text.compare(0, 16, "30000\nstep 0\nAr ") == 0);
+
+    dim::xyz_frame<double> frame;
+    std::size_t const consumed = dim::parse_xyz(text, frame);
+    CHECK(frame.comment == "step 0");
+    CHECK(frame.symbols.size() == 30000);
+    CHECK(frame.symbols[29999] == "Ar");
+    CHECK(frame.positions == first.positions);
+
+    std::size_t const rest = dim::parse_xyz(text.data() + consumed, text.size() - consumed, frame);
+    CHECK(consumed + rest == text.size());
+    CHECK(frame.comment == "step 1");
+    CHECK(frame.symbols == second.symbols);
+    CHECK(frame.positions == second.positions);
+    CHECK(dim::parse_xyz(text.data() + consumed + rest, 0, frame) == 0);
+
+    try {
+        dim::parse_xyz(std::string("2\n\nC 0 0 0\nC 1 1\n"), frame);
+        CHECK(false);
+    } catch (std::runtime_error const& error) {
+        CHECK(std::string(error.what()) == "xyz line 4: expected three coordinates");
+    }
+    CHECK_THROWS_AS(dim::parse_xyz(std::string("3\n\nC 0 0 0\n"), frame), std::runtime_error);
+    CHECK_THROWS_AS(dim::write_xyz(stream, second.positions.data(), 3, "a\nb"), std::invalid_argument);
+}
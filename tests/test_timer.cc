@@ -0,0 +1,141 @@
+#define DIM_ENABLE_TIMERS
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <dim.hpp>
+#include <dim_kdtree.hpp>
+#include <dim_timer.hpp>
+#include <doctest.h>
+
+namespace
+{
+    dim::timer_report find_report(std::string const& name)
+    {
+        for (auto const& report : dim::collect_timers()) {
+            if (report.name == name) {
+                return report;
+            }
+        }
+        return dim::timer_report{};
+    }
+
+    void timed_kernel(std::uint64_t particles, std::uint64_t pairs)
+    {
+        DIM_TIMER_SCOPE("test_timer.kernel", particles, pairs);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+TEST_CASE("timer_report: throughputs are dimensioned rates")
+{
+    using rate_dim = dim::power_dimension_t<dim::mech::time, -1>;
+    CHECK((std::is_same<dim::timer_report::time_type, dim::scalar<double, dim::mech::time>>::value));
+    CHECK((std::is_same<dim::timer_report::rate_type, dim::scalar<double, rate_dim>>::value));
+}
+
+TEST_CASE("DIM_TIMER_SCOPE: accumulates calls, time and counts")
+{
+    dim::timer_report const before = find_report("test_timer.kernel");
+
+    timed_kernel(100, 1000);
+    timed_kernel(50, 500);
+
+    dim::timer_report const after = find_report("test_timer.kernel");
+    CHECK(after.name == "test_timer.kernel");
+    CHECK(after.calls - before.calls == 2);
+    CHECK(after.particles - before.particles == 150);
+    CHECK(after.pairs - before.pairs == 1500);
+    CHECK(after.total_time.value() - before.total_time.value() >= 0.003);
+    CHECK(after.particle_rate.value() > 0);
+    CHECK(after.pair_rate.value() == doctest::Approx(10 * after.particle_rate.value()));
+}
+
+TEST_CASE("scoped_timer: counts can be added during the scope")
+{
+    static dim::timer_kernel const kernel{"test_timer.incremental"};
+    {
+        dim::scoped_timer probe{kernel};
+        probe.add_particles(3);
+        probe.add_pairs(7);
+        probe.add_pairs(7);
+    }
+    dim::timer_report const report = find_report("test_timer.incremental");
+    CHECK(report.calls == 1);
+    CHECK(report.particles == 3);
+    CHECK(report.pairs == 14);
+}
+
+TEST_CASE("timer_kernel: same name shares an identifier")
+{
+    dim::timer_kernel const a{"test_timer.shared"};
+    dim::timer_kernel const b{"test_timer.shared"};
+    dim::timer_kernel const c{"test_timer.other"};
+    CHECK(a.id() == b.id());
+    CHECK(a.id() != c.id());
+}
+
+TEST_CASE("collect_timers: aggregates over live and exited threads")
+{
+    static dim::timer_kernel const kernel{"test_timer.threads"};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([] {
+            for (int j = 0; j < 10; ++j) {
+                dim::scoped_timer probe{kernel, 1, 2};
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    {
+        dim::scoped_timer probe{kernel, 1, 2};
+    }
+
+    dim::timer_report const report = find_report("test_timer.threads");
+    CHECK(report.calls == 41);
+    CHECK(report.particles == 41);
+    CHECK(report.pairs == 82);
+}
+
+TEST_CASE("dump_timers: writes CSV and JSON")
+{
+    timed_kernel(1, 1);
+
+    std::ostringstream csv;
+    dim::dump_timers_csv(csv);
+    CHECK(csv.str().find("kernel,calls,seconds,particles,pairs,") == 0);
+    CHECK(csv.str().find("\ntest_timer.kernel,") != std::string::npos);
+
+    std::ostringstream json;
+    dim::dump_timers_json(json);
+    CHECK(json.str().front() == '[');
+    CHECK(json.str().find("\"kernel\": \"test_timer.kernel\"") != std::string::npos);
+    CHECK(json.str().find("\"pairs_per_second\": ") != std::string::npos);
+}
+
+TEST_CASE("DIM_TIMER_SCOPE: library kernels are probed")
+{
+    // This instantiation is used by no other translation unit, so its probe
+    // is compiled with timers enabled.
+    using point_t = dim::point<float, dim::mech::mass, 2>;
+
+    std::vector<point_t> points;
+    for (int i = 0; i < 10; ++i) {
+        points.push_back(point_t{float(i), float(i * i)});
+    }
+
+    dim::timer_report const before = find_report("dim::kdtree::build");
+    dim::kdtree<float, dim::mech::mass, 2> const tree{points};
+    dim::timer_report const after = find_report("dim::kdtree::build");
+
+    CHECK(tree.size() == 10);
+    CHECK(after.calls - before.calls == 1);
+    CHECK(after.particles - before.particles == 10);
+}
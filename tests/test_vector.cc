@@ -1,4 +1,5 @@
 #include <type_traits>
+#include <vector>
 
 #include <dim.hpp>
 #include <doctest.h>
@@ -36,6 +37,40 @@ TEST_CASE("vector: is explicitly constructible with coordinate values")
     CHECK((std::is_constructible<displace_t, double, double, double>::value));
 }
 
+TEST_CASE("vector: is explicitly constructible from arrays and iterators")
+{
+    using displace_t = dim::vector<double, dim::mechanical_dimension<1, 0, 0>, 3>;
+    using scalar_t = displace_t::scalar_type;
+
+    double const values[] = {1, 2, 3};
+    scalar_t const scalars[] = {scalar_t{1}, scalar_t{2}, scalar_t{3}};
+    std::vector<double> const list = {1, 2, 3, 4};
+
+    CHECK(displace_t{values} == displace_t{1, 2, 3});
+    CHECK(displace_t{scalars} == displace_t{1, 2, 3});
+    CHECK(displace_t{list.begin()} == displace_t{1, 2, 3});
+    CHECK(displace_t{&scalars[0]} == displace_t{1, 2, 3});
+
+    CHECK_FALSE((std::is_convertible<double const (&)[3], displace_t>::value));
+    CHECK_FALSE((std::is_constructible<displace_t, int>::value));
+}
+
+TEST_CASE("vector: supports thousands of dimensions")
+{
+    using config_t = dim::vector<double, dim::mechanical_dimension<1, 0, 0>, 3000>;
+
+    std::vector<double> values(config_t::dimension);
+    for (unsigned i = 0; i < config_t::dimension; ++i) {
+        values[i] = double(i % 7);
+    }
+    config_t const x{values.data()};
+    config_t const y = x + x;
+
+    CHECK(x.data() + 1 == &x[1]);
+    CHECK(y[2999] == 2 * x[2999]);
+    CHECK(dim::squared_norm(y).value() == doctest::Approx(4 * dim::squared_norm(x).value()));
+}
+
 TEST_CASE("vector: is default constructed to zero")
 {
     using displace_t = dim::vector<double, dim::mechanical_dimension<1, 0, 0>, 3>;